@@ -34,6 +34,7 @@
 #include "rtc.h"
 #include "spi.h"
 #include "adxl.h"
+#include "event.h"
 
 
 /*
@@ -57,6 +58,11 @@
  */
 #define TIME_CONFIG_FIELDS 6
 
+/**
+ * @brief	Buttons sampling period (us). A change counts once seen in 2 samples in a row (debounce).
+ */
+#define BUTTON_SAMPLE_TIME (DEBOUNCE_TIME * 1000 / 2)
+
 /**
  * @brief	Necessary time to hold buttons, in order to enter/exit Configuration Mode.
  */
@@ -177,6 +183,24 @@ typedef enum
 	POSTGAME = 8 /*!< Screen that shows user's score. */
 } STATE;
 
+/**
+ * @brief	Event types (see event.h).
+ */
+typedef enum
+{
+	EV_ENTER, /*!< State was just entered (sent by changeState() only). */
+	EV_PUSH, /*!< Buttons pushed (data: bitmap of buttons). */
+	EV_RELEASE, /*!< Buttons released (data: bitmap of buttons). */
+	EV_HOLD_START, /*!< B1 and B2 are both held (sent by dispatch() only). */
+	EV_HOLD_END, /*!< B1 or B2 released, after EV_HOLD_START (sent by dispatch() only). */
+	EV_HOLD, /*!< B1 and B2 held for BUTTONS_HOLD_TIME. */
+	EV_BLINK, /*!< Highlight blink, every HIGHLIGHT_BLINK_TIME. */
+	EV_SCORE, /*!< Next best score, every SCORE_SHOW_TIME. */
+	EV_SECOND, /*!< RTC second. */
+	EV_FRAME, /*!< Game frame, every GAME_RATE. */
+	EV_POINTS /*!< Points and fuel update, every FUEL_RATE. */
+} EVENT_TYPE;
+
 /**
  * @brief	Char map for Car Back.
  */
@@ -308,7 +332,6 @@ volatile STATE state = IDLE;
  */
 char username[NAME_LENGTH+1];
 
-
 /**
  *
  *
@@ -319,19 +342,26 @@ char username[NAME_LENGTH+1];
 
 
 /**
- * @brief	State manager.
- * @note	Will decide which state to call, based in 'STATE' ENUM value stored in 'state'.
- * @note	Will clear the LCD display in every state transition.
+ * @brief	Leaves current state and enters 'next': stops state timers, clears the LCD display, and sends EV_ENTER to 'next'.
+ * @param   next: -> State to enter.
+ * @note	Buttons held at this point are ignored until released (no EV_RELEASE for them).
+ */
+void changeState(STATE next);
+
+/**
+ * @brief	Sends an event to the current state.
+ * @param   event: -> Event, from the event queue.
+ * @note	Keeps track of held buttons, and turns B1+B2 holds into EV_HOLD_START/EV_HOLD/EV_HOLD_END.
  */
-void stateMachine(void);
+void dispatch(const EVENT *event);
 
 /**
- * @brief	Prompts an input interface to the LCD, so the user can enter his name.
+ * @brief	Name input state. Prompts an input interface to the LCD, so the user can enter his name.
+ * @param   event: -> Event to handle.
  * @note	Use B1 and B2 to increment and decrement, respectively, each character field, using B3 to advance.
- * @note	This function doesn't clear the LCD display, upon exit.
- * @note    This function uses Timer0. However, it's guaranteed that Timer0 is no longer busy upon this function's return.
+ * @note	Goes to 'afterName' state when done.
  */
-void getUsername(void);
+void getUsername(const EVENT *event);
 
 /**
  * @brief	Will print RTC time to the LCD.
@@ -350,15 +380,12 @@ void printScore(Score *score, int n);
 
 /**
  * @brief	Idle Mode. The fundamental state of the program. Shows RTC time and best scores, alternately.
+ * @param   event: -> Event to handle.
  * @note	Use B1 and B2 to scroll between 'Time' and 'Best Scores'.
  * @note	Use B3 to enter Game Mode.
  * @note    Hold B1 and B2 for a certain amount of time to enter Configuration Mode.
- * @note	This function never clears the LCD display, upon exit.
- * @note    This function uses Timer0 and Timer1.
- * @note    When entering Game Mode, it's guaranteed both timers are no longer busy.
- * @note    When entering Configuration Mode, it's guaranteed that Timer0 is no longer busy, but not Timer1 (since it won't be used).
  */
-void idle(void);
+void idle(const EVENT *event);
 
 /**
  * @brief	Changes LCD row specified 'Car' is on.
@@ -434,56 +461,56 @@ bool checkForLoss(CAR *car, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]);
 
 /**
  * @brief	State to wait for user to ready up.
+ * @param   event: -> Event to handle.
  * @note	Hit any button to start the game.
  */
-void pregame(void);
+void pregame(const EVENT *event);
 
 /**
- * @brief	State that runs the actual game.
+ * @brief	State that runs the actual game, one frame per EV_FRAME.
+ * @param   event: -> Event to handle.
  * @note	Tilt the ADXL345 component to change the row the Car is on.
- * @note    This function uses Timer0 and Timer1.
  */
-void game(void);
+void game(const EVENT *event);
 
 /**
  * @brief	State to show user's score.
+ * @param   event: -> Event to handle.
  * @note	Hit any button to go to menu.
- * @note    This function waits for timer0 and timer1, both used in 'game()'.
  */
-void postgame(void);
+void postgame(const EVENT *event);
 
 /**
  * @brief	State in which the user can configure some features.
+ * @param   event: -> Event to handle.
  * @note	Use B1 and B2 to scroll through the different options.
  * @note    Use B3 to select highlighted option.
- * @note    This function uses Timer0.
- * @note    When selecting an option or going back to Idle Mode, it's guaranteed that Timer0 is no longer busy.
+ * @note    Hold B1 and B2 for a certain amount of time to go back to Idle Mode.
  */
-void config(void);
+void config(const EVENT *event);
 
 /**
  * @brief	State in which the user may configure RTC time.
+ * @param   event: -> Event to handle.
  * @note	Use B1 and B2 to increment and decrement, respectively, the highlighted time field.
  * @note    Use B3 advance to next time field.
- * @note    This function uses Timer0.
- * @note    When leaving this function, it's guaranteed that Timer0 is no longer busy.
  */
-void timeConfig(void);
+void timeConfig(const EVENT *event);
 
 /**
  * @brief	State that tells the user the scores were erased.
+ * @param   event: -> Event to handle.
  * @note	Hit any button to go back.
  */
-void scoresErased(void);
+void scoresErased(const EVENT *event);
 
 /**
- * @brief	Prompts the user with a 'Yes or No' interface, and runs the specified function if 'Yes' option is selected.
- * @param   f: -> Pointer to function that shall be ran upon selection of 'Yes' option.
- * @return  returns true if 'yes' was chosen, or false if 'no' was chosen.
+ * @brief	Prompts the user with a 'Yes or No' interface, and erases the scores if 'Yes' option is selected.
+ * @param   event: -> Event to handle.
  * @note	Use B1 and B2 to scroll through 'Yes' and 'No' options.
  * @note    Use B3 to select highlighted option.
  */
-bool yesOrNo(void(*f)(void));
+void eraseScores(const EVENT *event);
 
 
 /**
@@ -16,9 +16,62 @@
 
 
 /*
- * 	Dummy function.
+===========================================================================================================================================================
+===========================================================================================================================================================
+
+	EVENTS:
+
+===========================================================================================================================================================
+===========================================================================================================================================================
+*/
+
+/*
+ * 	Software timers. Their handlers run in interrupt context, so they only post events.
  */
-void dummy(void) {}
+WAIT_TIMER buttonTimer, holdTimer, blinkTimer, scoreTimer, frameTimer, pointsTimer;
+
+/*
+ * 	Last buttons sample, and last stable (debounced) buttons bitmap.
+ */
+uint32_t buttonsSample, buttonsStable;
+
+/*
+ * 	Buttons sampling handler. Posts EV_PUSH and EV_RELEASE for changes seen in 2 samples in a row.
+ */
+void buttonsHandler(void) {
+	uint32_t sample = BUTTON_Hit();
+	if ((sample == buttonsSample) && (sample != buttonsStable)) {
+		uint32_t changed = sample ^ buttonsStable;
+		if (changed & sample) EVENT_Post(EV_PUSH, changed & sample);
+		if (changed & buttonsStable) EVENT_Post(EV_RELEASE, changed & buttonsStable);
+		buttonsStable = sample;
+	}
+	buttonsSample = sample;
+}
+
+void holdHandler(void) {
+	EVENT_Post(EV_HOLD, 0);
+}
+
+void blinkHandler(void) {
+	EVENT_Post(EV_BLINK, 0);
+}
+
+void scoreHandler(void) {
+	EVENT_Post(EV_SCORE, 0);
+}
+
+void frameHandler(void) {
+	EVENT_Post(EV_FRAME, 0);
+}
+
+void pointsHandler(void) {
+	EVENT_Post(EV_POINTS, 0);
+}
+
+void secondHandler(void) {
+	EVENT_Post(EV_SECOND, 0);
+}
 
 
 /*
@@ -31,43 +84,93 @@ void dummy(void) {}
 ===========================================================================================================================================================
 */
 
-void stateMachine(void) {
+/*
+ * 	State handlers, by STATE.
+ */
+void (*const stateHandlers[])(const EVENT *event) = {
+	idle, // IDLE
+	config, // CONFIG
+	timeConfig, // CONFIG_DATE
+	getUsername, // CONFIG_NAME
+	eraseScores, // CONFIG_ERASE_SCORES
+	scoresErased, // SCORES_ERASED
+	pregame, // PREGAME
+	game, // GAME
+	postgame // POSTGAME
+};
+
+/*
+ * 	Buttons currently held, and buttons held since the current state was entered (no events for those).
+ */
+uint32_t held, ignored;
+
+/*
+ * 	True while B1 and B2 are both held (i.e. between EV_HOLD_START and EV_HOLD_END).
+ */
+bool holding;
+
+/*
+ * 	State to go to after the user name is entered.
+ */
+STATE afterName;
+
+void changeState(STATE next) {
+	// Events already queued by these timers are still delivered (to 'next'), so handlers ignore unexpected ones:
+	WAIT_WHEEL_Stop(&holdTimer);
+	WAIT_WHEEL_Stop(&blinkTimer);
+	WAIT_WHEEL_Stop(&scoreTimer);
+	WAIT_WHEEL_Stop(&frameTimer);
+	WAIT_WHEEL_Stop(&pointsTimer);
+
+	holding = false;
+	ignored = held; // Instead of waiting for buttons to be released
+
+	CLOCK_SetProfile((next == GAME) ? CLOCK_FULL : CLOCK_REDUCED); // Menus just wait for buttons
+
 	LCDText_Clear();
-	switch (state) {
-		case IDLE:
-			idle();
-			break;
-		case CONFIG:
-			config();
-			break;
-		case CONFIG_DATE:
-			timeConfig();
-			state = CONFIG;
-			break;
-		case CONFIG_ERASE_SCORES:
-			state = (yesOrNo(SCORE_Erase) ? SCORES_ERASED : CONFIG);
-			break;
-		case CONFIG_NAME:
-			getUsername();
-			state = CONFIG;
-			break;
-		case SCORES_ERASED:
-			scoresErased();
-			state = CONFIG;
+	state = next;
+
+	EVENT enter = {.type = EV_ENTER, .data = 0};
+	stateHandlers[state](&enter);
+}
+
+void dispatch(const EVENT *event) {
+	EVENT forward = *event;
+
+	switch (event->type) {
+		case EV_PUSH:
+			held |= event->data;
+			forward.data &= ~ignored;
 			break;
-		case PREGAME:
-			pregame();
-			state = GAME;
+		case EV_RELEASE:
+			held &= ~event->data;
+			forward.data &= ~ignored;
+			ignored &= ~event->data;
 			break;
-		case GAME:
-			game();
-			state = POSTGAME;
+		case EV_HOLD:
+			if (!holding) return; // Released in the meantime
 			break;
-		case POSTGAME:
-			postgame();
-			state = IDLE;
+		default:
 			break;
 	}
+	if (((forward.type == EV_PUSH) || (forward.type == EV_RELEASE)) && (forward.data == 0)) return;
+
+	stateHandlers[state](&forward); // Might change state
+
+	// Check for B1 and B2 being held (or not anymore):
+	bool both = ((held & ~ignored & (B1 | B2)) == (B1 | B2));
+	EVENT hold = {.type = EV_HOLD_START, .data = 0};
+	if (both && !holding) {
+		holding = true;
+		WAIT_WHEEL_Start(&holdTimer, BUTTONS_HOLD_TIME, 0, holdHandler);
+	}
+	else if (!both && holding) {
+		holding = false;
+		WAIT_WHEEL_Stop(&holdTimer);
+		hold.type = EV_HOLD_END;
+	}
+	else return;
+	stateHandlers[state](&hold);
 }
 
 
@@ -88,36 +191,36 @@ void stateMachine(void) {
 bool off;
 
 /*
- * 	Handler for the blinking delay.
- * 	Will invert 'off' (for blinking purposes).
+ * 	Current character: [0, NAME_LENGTH-1].
  */
-void blinkHandler(void) {
-	off = !off;
-}
-
-void getUsername(void) {
+int ch;
 
-	LCDText_Locate(1, 1);
-	LCDText_Printf("User name:");
-
-	off = false;
-	int volatile push_events = 0; // Buttons events
-	int ch = 0; // [0, 10] -> Character selected, 11 is the special character '\0'
+/*
+ * 	Prints the user name, with the current character blank if 'off'.
+ */
+void printUsername(void) {
 	char aux[NAME_LENGTH+1]; // Auxiliary variable for blinking
 
-	while (1) {
-		if (!WAIT_IsBusy(TIM0)) WAIT_IRQ0_Us(HIGHLIGHT_BLINK_TIME, blinkHandler); // If it's not busy, start counting
-
-		LCDText_Locate(2, 1);
-		if (off) {
-			strcpy(aux, username);
-			aux[ch] = ' ';
-			LCDText_Printf(aux);
-		}
-		else LCDText_Printf(username);
+	strcpy(aux, username);
+	if (off) aux[ch] = ' ';
+	LCDText_Locate(2, 1);
+	LCDText_Printf(aux);
+}
 
-		if ((push_events = BUTTON_GetButtonsReleaseEvents()) != 0) {
-			if (push_events & B1) { // Increment
+void getUsername(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			off = false;
+			ch = 0;
+			LCDText_Locate(1, 1);
+			LCDText_Printf("User name:");
+			WAIT_WHEEL_Start(&blinkTimer, HIGHLIGHT_BLINK_TIME, HIGHLIGHT_BLINK_TIME, blinkHandler);
+			break;
+		case EV_BLINK:
+			off = !off;
+			break;
+		case EV_RELEASE:
+			if (event->data & B1) { // Increment
 				switch (username[ch]) {
 					case 32:
 						username[ch] = 97;
@@ -130,7 +233,7 @@ void getUsername(void) {
 						break;
 				}
 			}
-			else if (push_events & B2) { // Decrement
+			else if (event->data & B2) { // Decrement
 				switch (username[ch]) {
 					case 32:
 						username[ch] = 122;
@@ -143,15 +246,18 @@ void getUsername(void) {
 						break;
 				}
 			}
-			else if (push_events & B3) { // Confirm value
+			else if (event->data & B3) { // Confirm value
 				if (ch == 0) username[0] -= 32; // First character must be upper case
 				if (++ch > (NAME_LENGTH-1)) { // If it's the last character
-					break; // Get out
+					changeState(afterName);
+					return;
 				}
 			}
-		}
+			break;
+		default:
+			return;
 	}
-	while (WAIT_IsBusy(TIM0)); // Wait for timer0
+	printUsername();
 }
 
 
@@ -272,94 +378,77 @@ void printScore(Score *score, int n) {
 */
 
 /*
- * 	Current score showing in LCD
+ * 	What idle shows: 0 for time, 1 for best scores.
  */
-int currentScore;
+int side;
 
 /*
- * 	Handler for current score delay.
- * 	Will increment current score.
+ * 	Current score showing in LCD
  */
-void currentScoreHandler(void) {
-	if (++currentScore > SCORE_NUM-1) currentScore = 0;
-}
+int currentScore;
 
 /*
- * 	Function to run in 'BUTTON_WaitRelease()'.
+ * 	Prints the current best score.
  */
-void idleWait(void) {
-	updateAndPrintTime(NONE);
+void printCurrentScore(void) {
+	Score bestScore;
+	SCORE_Get(&bestScore, currentScore);
+	printScore(&bestScore, currentScore);
 }
 
-void idle(void) {
-	currentScore = 0;
-
-   	int volatile side = 0; // 0 to show time, 1 to show bets score
-   	int volatile push_events = 0; // Buttons events
-
-   	BUTTON_WaitRelease(idleWait);
-
-   	while (1) {
-   		Score bestScore;
-
-   		// State Machine:
-   		switch (side) {
-   			case 0: // Showing time
-				updateAndPrintTime(NONE);
-				break;
-   			case 1: // Showing best score
-   				if (!WAIT_IsBusy(TIM1)) WAIT_IRQ1_Us(SCORE_SHOW_TIME, currentScoreHandler); // Call 'currentScoreHandler()' in 'SCORE_SHOW_TIME' microseconds
-   				SCORE_Get(&bestScore, currentScore);
-				printScore(&bestScore, currentScore);
-				break;
-   		}
-
-   		// Input Handler:
-   		if ((push_events = BUTTON_GetButtonsReleaseEvents()) != 0) {
-			if (push_events & B1) { // Show time
+void idle(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			side = 0;
+			currentScore = 0;
+			updateAndPrintTime(NONE);
+			break;
+		case EV_SECOND:
+			if ((side == 0) && !holding) updateAndPrintTime(NONE); // Not over "Entering config mode..."
+			break;
+		case EV_SCORE:
+			if (side != 1) break;
+			if (++currentScore > SCORE_NUM-1) currentScore = 0;
+			printCurrentScore();
+			break;
+		case EV_RELEASE:
+			if (event->data & B1) { // Show time
 				if (side != 0) {
 					side = 0;
+					WAIT_WHEEL_Stop(&scoreTimer);
 					LCDText_Clear();
+					updateAndPrintTime(NONE);
 				}
 			}
-			else if (push_events & B2) { // Show best score
+			else if (event->data & B2) { // Show best score
 				if (side != 1) {
 					side = 1;
+					WAIT_WHEEL_Start(&scoreTimer, SCORE_SHOW_TIME, SCORE_SHOW_TIME, scoreHandler);
 					LCDText_Clear();
+					printCurrentScore();
 				}
 			}
-			else if (push_events & B3) { // Start a game
-				LCDText_Clear();
-				while (WAIT_IsBusy(TIM0) || WAIT_IsBusy(TIM1)) { // Wait for Timer0 and Timer1 before starting game
-					LCDText_Locate(1, 1);
-					LCDText_Printf("Starting game...");
-				}
-				state = PREGAME;
-				return;
+			else if (event->data & B3) { // Start a game
+				changeState(PREGAME);
 			}
-   		}
-   		if ((BUTTON_Hit() & B1) && (BUTTON_Hit() & B2)) { // Check for buttons hold, and enter Configuration Mode
-
-			if (WAIT_IsBusy(TIM0)) continue; // If previous Timer0 interrupt hasn't arrived, get out
-
+			break;
+		case EV_HOLD_START: // Hold to enter Configuration Mode
 			LCDText_Clear();
 			LCDText_Locate(1, 1);
 			LCDText_Printf("Entering config");
 			LCDText_Locate(2, 1);
 			LCDText_Printf("mode...");
-
-			WAIT_IRQ0_Us(BUTTONS_HOLD_TIME, dummy); // Interrupt in BUTTONS_HOLD_TIME microseconds
-			while (WAIT_IsBusy(TIM0)) {
-				if (!(BUTTON_Hit() & B1) || !(BUTTON_Hit() & B2)) { // If any of the buttons were released
-					break;
-				}
-			}
-			if (!WAIT_IsBusy(TIM0)) {
-				state = CONFIG; // If user held the buttons until this point, enter Configuration Mode
-				return;
-			}
+			break;
+		case EV_HOLD_END: // Released too soon
 			LCDText_Clear();
-		}
+			if (side == 0) updateAndPrintTime(NONE);
+			else printCurrentScore();
+			break;
+		case EV_HOLD:
+			changeState(CONFIG);
+			break;
+		default:
+			break;
 	}
 }
 
@@ -385,12 +474,19 @@ int points;
 int fuel;
 
 /*
- * 	Interrupt handler for points increase delay:
+ * 	Car.
  */
-void busyPointsHandler(void) {
-	points++;
-	fuel--;
-}
+CAR gameCar;
+
+/*
+ * 	Array that represents all current obstacles in LCD DDRAM.
+ */
+int gameMap[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH];
+
+/*
+ * 	Column where fuel indicator is, currently.
+ */
+int gameFuelCol;
 
 void changeRow(CAR * car, int row) {
 	if ((row != 1) && (row != 2)) return;
@@ -548,84 +644,100 @@ bool checkForLoss(CAR *car, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]) {
 	return (map[car->row-1][car->back_column-1] == 1) || (map[car->row-1][car->front_column-1] == 1) || (fuel <= 0);
 }
 
-void pregame(void) {
-	LCDText_Locate(1, 1);
-	LCDText_Printf("Press any button");
-	LCDText_Locate(2, 1);
-	LCDText_Printf("to start.");
-
-	BUTTON_Read(); // Wait for user to ready up
+void pregame(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			LCDText_Locate(1, 1);
+			LCDText_Printf("Press any button");
+			LCDText_Locate(2, 1);
+			LCDText_Printf("to start.");
+			break;
+		case EV_PUSH: // User is ready
+			changeState(GAME);
+			break;
+		default:
+			break;
+	}
 }
 
-void game(void) {
-
-	// Car:
-	CAR car = {.row = 1, .last_row = 1, .front_column = CAR_POSITION + 1, .back_column = CAR_POSITION};
-
-	// Array that represents all current obstacles in LCD DDRAM
-	int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH] = {0};
-
-	int currentFuelCol = 1;
+/*
+ * 	Runs a game frame.
+ * 	Returns true if the game was lost.
+ */
+bool gameFrame(void) {
+	changeRow(&gameCar, getInclination());
+
+	// Refresh obstacles and fuel galleons:
+	if (gameCar.back_column == CAR_POSITION + (LCD_DDRAM_LENGTH/2)) { // If display is showing [21, 36]
+		// Refresh first 20:
+		randomiseObstacles(1, LCD_DDRAM_LENGTH/2, gameMap);
+		randomiseFuel(1, LCD_DDRAM_LENGTH/2, gameMap);
+	}
+	if (gameCar.back_column == CAR_POSITION) { // If display is showing [1, 16]
+		// Refresh last 20:
+		randomiseObstacles((LCD_DDRAM_LENGTH/2) + 1, LCD_DDRAM_LENGTH, gameMap);
+		randomiseFuel((LCD_DDRAM_LENGTH/2) + 1, LCD_DDRAM_LENGTH, gameMap);
+	}
 
-	points = 1;
-	fuel = MAX_FUEL;
+	// Shift car:
+	shiftCar(&gameCar);
 
-	randomiseObstacles(INITIAL_OBSTACLE_GAP, LCD_DDRAM_LENGTH, map); // Randomise obstacles
-	randomiseFuel(INITIAL_OBSTACLE_GAP, LCD_DDRAM_LENGTH, map); // Randomise fuel galleons
+	// Shift fuel indicator:
+	shiftFuelIndicator(&gameFuelCol);
 
-	while(1) {
-		changeRow(&car, getInclination());
-
-		if (!WAIT_IsBusy(TIM0)) {
-			// Refresh obstacles and fuel galleons:
-			if (car.back_column == CAR_POSITION + (LCD_DDRAM_LENGTH/2)) { // If display is showing [21, 36]
-				// Refresh first 20:
-				randomiseObstacles(1, LCD_DDRAM_LENGTH/2, map);
-				randomiseFuel(1, LCD_DDRAM_LENGTH/2, map);
-			}
-			if (car.back_column == CAR_POSITION) { // If display is showing [1, 16]
-				// Refresh last 20:
-				randomiseObstacles((LCD_DDRAM_LENGTH/2) + 1, LCD_DDRAM_LENGTH, map);
-				randomiseFuel((LCD_DDRAM_LENGTH/2) + 1, LCD_DDRAM_LENGTH, map);
-			}
+	// Shift display:
+	LCDText_ShiftDisplay(LEFT);
 
-			// Shift car:
-			shiftCar(&car);
+	// Verify if car hit an obstacle:
+	if (checkForLoss(&gameCar, gameMap)) return true; // Lose
 
-			// Shift fuel indicator:
-			shiftFuelIndicator(&currentFuelCol);
+	checkForFuelGrab(&gameCar, gameMap);
+	return false;
+}
 
-			// Shift display:
-			LCDText_ShiftDisplay(LEFT);
+void game(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			gameCar = (CAR) {.row = 1, .last_row = 1, .front_column = CAR_POSITION + 1, .back_column = CAR_POSITION};
+			memset(gameMap, 0, sizeof(gameMap));
+			gameFuelCol = 1;
 
-			// Verify if car hit an obstacle:
-			if (checkForLoss(&car, map)) break; // Lose
+			points = 1;
+			fuel = MAX_FUEL;
 
-			checkForFuelGrab(&car, map);
+			randomiseObstacles(INITIAL_OBSTACLE_GAP, LCD_DDRAM_LENGTH, gameMap); // Randomise obstacles
+			randomiseFuel(INITIAL_OBSTACLE_GAP, LCD_DDRAM_LENGTH, gameMap); // Randomise fuel galleons
 
-			// Game delay:
-			WAIT_IRQ0_Us(GAME_RATE, dummy);
-		}
-		if (!WAIT_IsBusy(TIM1)) WAIT_IRQ1_Us(FUEL_RATE, busyPointsHandler); // Points delay
+			WAIT_WHEEL_Start(&frameTimer, GAME_RATE, GAME_RATE, frameHandler); // Game delay
+			WAIT_WHEEL_Start(&pointsTimer, FUEL_RATE, FUEL_RATE, pointsHandler); // Points delay
+			break;
+		case EV_FRAME:
+			if (gameFrame()) changeState(POSTGAME);
+			break;
+		case EV_POINTS:
+			points++;
+			fuel--;
+			break;
+		default:
+			break;
 	}
 }
 
-void postgame(void) {
-	LCDText_Home();
-	LCDText_Printf("Game over. You");
-	LCDText_Locate(2, 1);
-	LCDText_Printf("scored %d!", points);
-
-	SCORE_Save(points, username, NAME_LENGTH+1);
-
-	BUTTON_WaitRelease(0);
-	BUTTON_Read();
+void postgame(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			LCDText_Home();
+			LCDText_Printf("Game over. You");
+			LCDText_Locate(2, 1);
+			LCDText_Printf("scored %d!", points);
 
-	while(WAIT_IsBusy(TIM0) || WAIT_IsBusy(TIM1)) { // Wait for Timer0 and Timer1
-		LCDText_Locate(1, 1);
-		LCDText_Printf("Returning");
-		LCDText_Locate(2, 1);
-		LCDText_Printf("to menu...");
+			SCORE_Save(points, username, NAME_LENGTH+1);
+			break;
+		case EV_PUSH: // Back to menu
+			changeState(IDLE);
+			break;
+		default:
+			break;
 	}
 }
 
@@ -634,105 +746,102 @@ void postgame(void) {
 ===========================================================================================================================================================
 ===========================================================================================================================================================
 
-	CONFIGURATION NAME
+	CONFIGURATION MODE:
 
 ===========================================================================================================================================================
 ===========================================================================================================================================================
 */
 
-void config(void) {
-	LCDText_Locate(1, 1);
-	LCDText_Printf("> Time Config");
-	LCDText_Locate(2, 1);
-	LCDText_Printf("  Score Config");
-
-	BUTTON_WaitRelease(0);
-
-	int volatile push_events = 0; // Buttons events
-	int volatile last_option = 0; // Last selected option
-	int volatile option = 0; // Current selected option
-
-	while (1) {
-		// State Machine:
-		switch (option) {
-			case 0: // Time Configuration option highlighted
-				LCDText_Locate(1, 1);
-				LCDText_Printf("> Time Config ");
-				LCDText_Locate(2, 1);
-				LCDText_Printf("  Score Config");
-				break;
-			case 1: // Best Score Configuration option highlighted
-				switch(last_option) {
-					case 0:
-						LCDText_Locate(1, 1);
-						LCDText_Printf("  Time Config ");
-						LCDText_Locate(2, 1);
-						LCDText_Printf("> Score Config");
-						break;
-					case 2:
-						LCDText_Locate(1, 1);
-						LCDText_Printf("> Score Config");
-						LCDText_Locate(2, 1);
-						LCDText_Printf("  Name Config ");
-						break;
-				}
-				break;
-			case 2:
-				LCDText_Locate(1, 1);
-				LCDText_Printf("  Score Config");
-				LCDText_Locate(2, 1);
-				LCDText_Printf("> Name Config ");
-		}
+/*
+ * 	Current and last selected options.
+ */
+int option, last_option;
+
+/*
+ * 	Prints the configuration menu, with the current option highlighted.
+ */
+void printConfig(void) {
+	switch (option) {
+		case 0: // Time Configuration option highlighted
+			LCDText_Locate(1, 1);
+			LCDText_Printf("> Time Config ");
+			LCDText_Locate(2, 1);
+			LCDText_Printf("  Score Config");
+			break;
+		case 1: // Best Score Configuration option highlighted
+			switch(last_option) {
+				case 0:
+					LCDText_Locate(1, 1);
+					LCDText_Printf("  Time Config ");
+					LCDText_Locate(2, 1);
+					LCDText_Printf("> Score Config");
+					break;
+				case 2:
+					LCDText_Locate(1, 1);
+					LCDText_Printf("> Score Config");
+					LCDText_Locate(2, 1);
+					LCDText_Printf("  Name Config ");
+					break;
+			}
+			break;
+		case 2:
+			LCDText_Locate(1, 1);
+			LCDText_Printf("  Score Config");
+			LCDText_Locate(2, 1);
+			LCDText_Printf("> Name Config ");
+	}
+}
 
-		// Input Handler:
-		if ((push_events = BUTTON_GetButtonsReleaseEvents()) != 0) {
-			if (push_events & B1) { // Go to upper option
+void config(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			last_option = 0;
+			option = 0;
+			printConfig();
+			break;
+		case EV_RELEASE:
+			if (event->data & B1) { // Go to upper option
 				last_option = option;
 				if (++option > (CONFIG_OPTIONS-1)) option = CONFIG_OPTIONS-1;
+				printConfig();
 			}
-			else if (push_events & B2) { // Go to lower option
+			else if (event->data & B2) { // Go to lower option
 				last_option = option;
 				if (--option < 0) option = 0;
+				printConfig();
 			}
-			else if (push_events & B3) { // Select option
+			else if (event->data & B3) { // Select option
 				switch (option) {
 					case 0: // Time Configuration:
-						while(WAIT_IsBusy(TIM0)); // Wait for Timer0
-						state = CONFIG_DATE;
-						return;
+						changeState(CONFIG_DATE);
+						break;
 					case 1: // Score Configuration:
-						while(WAIT_IsBusy(TIM0)); // Wait for Timer0
-						state = CONFIG_ERASE_SCORES;
-						return;
+						changeState(CONFIG_ERASE_SCORES);
+						break;
 					case 2: // Name Configuration:
-						while(WAIT_IsBusy(TIM0)); // Wait for Timer0
 						username[0] += 32; // Lower case
-						state = CONFIG_NAME;
-						return;
+						afterName = CONFIG;
+						changeState(CONFIG_NAME);
+						break;
 				}
 			}
-		}
-		if ((BUTTON_Hit() & B1) && (BUTTON_Hit() & B2)) { // Check for buttons hold, and go back to menu
-			if (WAIT_IsBusy(TIM0)) continue; // If previous interrupt hasn't arrived, get out
-
+			break;
+		case EV_HOLD_START: // Hold to go back to menu
 			LCDText_Clear();
 			LCDText_Locate(1, 1);
 			LCDText_Printf("Returning to");
 			LCDText_Locate(2, 1);
 			LCDText_Printf("menu...");
-
-			WAIT_IRQ0_Us(BUTTONS_HOLD_TIME, dummy); // Interrupt in 2 seconds
-			while (WAIT_IsBusy(TIM0)) {
-				if (!(BUTTON_Hit() & B1) || !(BUTTON_Hit() & B2)) { // If any of the buttons were released
-					break;
-				}
-			}
-			if (!WAIT_IsBusy(TIM0)) { // If user held the buttons until this point, return to Idle Mode
-				state = IDLE;
-				return;
-			}
+			break;
+		case EV_HOLD_END: // Released too soon
 			LCDText_Clear();
-		}
+			printConfig();
+			break;
+		case EV_HOLD:
+			changeState(IDLE);
+			break;
+		default:
+			break;
 	}
 }
 
@@ -747,37 +856,47 @@ void config(void) {
 ===========================================================================================================================================================
 */
 
-void timeConfig(void) {
-
-	RTC_Disable(); // Disable RTC counters, to stop the clock while adjusting it
-
-	int volatile push_events = 0; // Buttons events
-
-	int field = 0; // [0, 5] -> Every time field, excluding day of year and seconds
-	RTC_TIME_FIELD timeFields[TIME_CONFIG_FIELDS] = {YEAR, MONTH, DOM, DOW, HOUR, MIN};
-
-	while (1) {
-		if (!WAIT_IsBusy(TIM0)) WAIT_IRQ0_Us(HIGHLIGHT_BLINK_TIME, blinkHandler); // If it's not busy, start counting
-
-		if (off) updateAndPrintTime(timeFields[field]); // Set field to blank
-		else updateAndPrintTime(NONE); // Set field to its current value
+/*
+ * 	Current time field: [0, 5] -> Every time field, excluding day of year and seconds.
+ */
+int field;
 
-		if ((push_events = BUTTON_GetButtonsReleaseEvents()) != 0) {
-			if (push_events & B1) { // Increment
+/*
+ * 	Time fields to configure, in order.
+ */
+const RTC_TIME_FIELD timeFields[TIME_CONFIG_FIELDS] = {YEAR, MONTH, DOM, DOW, HOUR, MIN};
+
+void timeConfig(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			RTC_Disable(); // Disable RTC counters, to stop the clock while adjusting it
+			field = 0;
+			off = false;
+			WAIT_WHEEL_Start(&blinkTimer, HIGHLIGHT_BLINK_TIME, HIGHLIGHT_BLINK_TIME, blinkHandler);
+			break;
+		case EV_BLINK:
+			off = !off;
+			break;
+		case EV_RELEASE:
+			if (event->data & B1) { // Increment
 				RTC_IncrementField(timeFields[field]);
 			}
-			else if (push_events & B2) { // Decrement
+			else if (event->data & B2) { // Decrement
 				RTC_DecrementField(timeFields[field]);
 			}
-			else if (push_events & B3) { // Confirm value
+			else if (event->data & B3) { // Confirm value
 				if (++field > (TIME_CONFIG_FIELDS-1)) { // If it's the last field
 					RTC_Enable(); // Enable RTC counters again
-					break; // Get out
+					changeState(CONFIG);
+					return;
 				}
 			}
-		}
+			break;
+		default:
+			return;
 	}
-	while(WAIT_IsBusy(TIM0));
+	if (off) updateAndPrintTime(timeFields[field]); // Set field to blank
+	else updateAndPrintTime(NONE); // Set field to its current value
 }
 
 
@@ -791,64 +910,76 @@ void timeConfig(void) {
 ===========================================================================================================================================================
 */
 
-void scoresErased(void) {
-	LCDText_Locate(1, 1);
-	LCDText_Printf("Erased. Press");
-	LCDText_Locate(2, 1);
-	LCDText_Printf("any button.");
-
-	BUTTON_WaitRelease(0);
-	BUTTON_Read();
+void scoresErased(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			LCDText_Locate(1, 1);
+			LCDText_Printf("Erased. Press");
+			LCDText_Locate(2, 1);
+			LCDText_Printf("any button.");
+			break;
+		case EV_PUSH:
+			changeState(CONFIG);
+			break;
+		default:
+			break;
+	}
 }
 
-bool yesOrNo(void(*f)(void)) {
+/*
+ * 	Highlighted option: 0 for yes, 1 for no.
+ */
+int answer;
 
-	LCDText_Locate(1, 1);
-	LCDText_Printf("> Yes");
-	LCDText_Locate(2, 1);
-	LCDText_Printf("  No");
-
-	BUTTON_WaitRelease(0);
-
-	int volatile push_events = 0; // Buttons events
-	int volatile option = 0; // 0 for yes, 1 for no
-
-	while (1) {
-		// State Machine:
-		switch (option) {
-			case 0: // Yes option highlighted
-				LCDText_Locate(1, 1);
-				LCDText_Printf("> Yes");
-				LCDText_Locate(2, 1);
-				LCDText_Printf("  No");
-				break;
-			case 1: // No option highlighted
-				LCDText_Locate(1, 1);
-				LCDText_Printf("  Yes");
-				LCDText_Locate(2, 1);
-				LCDText_Printf("> No");
-				break;
-		}
+/*
+ * 	Prints the 'Yes or No' interface, with the current answer highlighted.
+ */
+void printYesOrNo(void) {
+	switch (answer) {
+		case 0: // Yes option highlighted
+			LCDText_Locate(1, 1);
+			LCDText_Printf("> Yes");
+			LCDText_Locate(2, 1);
+			LCDText_Printf("  No");
+			break;
+		case 1: // No option highlighted
+			LCDText_Locate(1, 1);
+			LCDText_Printf("  Yes");
+			LCDText_Locate(2, 1);
+			LCDText_Printf("> No");
+			break;
+	}
+}
 
-		// Input Handler:
-		if ((push_events = BUTTON_GetButtonsReleaseEvents()) != 0) {
-			if (push_events & B1) { // Go to upper option
-				if (++option > 1) option = 1;
+void eraseScores(const EVENT *event) {
+	switch (event->type) {
+		case EV_ENTER:
+			answer = 0;
+			printYesOrNo();
+			break;
+		case EV_RELEASE:
+			if (event->data & B1) { // Go to upper option
+				if (++answer > 1) answer = 1;
+				printYesOrNo();
 			}
-			else if (push_events & B2) { // Go to lower option
-				if (--option < 0) option = 0;
+			else if (event->data & B2) { // Go to lower option
+				if (--answer < 0) answer = 0;
+				printYesOrNo();
 			}
-			else if (push_events & B3) { // Select option
-				switch (option) {
+			else if (event->data & B3) { // Select option
+				switch (answer) {
 					case 0: // Yes:
-						(*f)();
-						BUTTON_WaitRelease(0);
-						return true;
+						SCORE_Erase();
+						changeState(SCORES_ERASED);
+						break;
 					case 1: // No:
-						return false;
+						changeState(CONFIG);
+						break;
 				}
 			}
-		}
+			break;
+		default:
+			break;
 	}
 }
 
@@ -869,18 +1000,17 @@ bool yesOrNo(void(*f)(void)) {
 int main(void) {
 
  	SystemInit();
+#ifdef TRACE
+	TRACE_Init();
+#endif
 	BUTTON_Init();
-	RTC_Init(0, INONE);
+	RTC_Init(0);
 	if (LCDText_Init() < 0) {
 		printf("LCD could not initialise.\n");
 		return 0;
 	}
-	if (WAIT_Init(IRQ0) < 0) {
-		printf("WAIT Resource 0 could not initialise.\n");
-		return 0;
-	}
-	if (WAIT_Init(IRQ1) < 0) {
-		printf("WAIT Resource 1 could not initialise.\n");
+	if (WAIT_Init(WHEEL) < 0) {
+		printf("WAIT timer wheel could not initialise.\n");
 		return 0;
 	}
 	ADXL_Init(0, 0);
@@ -900,10 +1030,18 @@ int main(void) {
 	}
 	username[NAME_LENGTH] = '\0';
 
-	getUsername();
+	// Event sources:
+	held = buttonsStable = buttonsSample = BUTTON_Hit();
+	WAIT_WHEEL_Start(&buttonTimer, BUTTON_SAMPLE_TIME, BUTTON_SAMPLE_TIME, buttonsHandler);
+	RTC_SetInterrupt(ISEC, secondHandler);
+
+	afterName = IDLE;
+	changeState(CONFIG_NAME);
 
+	EVENT event;
 	while(1) {
-		stateMachine();
+		EVENT_Wait(&event); // Sleeps until there's something to do
+		dispatch(&event);
 	}
 
     return 0 ;
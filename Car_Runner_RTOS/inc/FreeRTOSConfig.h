@@ -56,11 +56,10 @@ extern uint32_t SystemCoreClock;
 #define configUSE_PREEMPTION		1
 #define configUSE_IDLE_HOOK			0
 #define configMAX_PRIORITIES		( 5 )
-#define configUSE_TICK_HOOK			0
+#define configUSE_TICK_HOOK			1
 #define configCPU_CLOCK_HZ			( ( unsigned long ) SystemCoreClock )
 #define configTICK_RATE_HZ			( ( portTickType ) 1000 )
 #define configMINIMAL_STACK_SIZE	( ( unsigned short ) 100 )
-#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 12 * 1024 ) )
 #define configMAX_TASK_NAME_LEN		( 12 )
 #define configUSE_TRACE_FACILITY	1
 #define configUSE_16_BIT_TICKS		0
@@ -76,9 +75,23 @@ extern uint32_t SystemCoreClock;
 #define configUSE_RECURSIVE_MUTEXES		0
 #define configQUEUE_REGISTRY_SIZE		1
 #define configGENERATE_RUN_TIME_STATS	1
-#define configUSE_MALLOC_FAILED_HOOK	0
+#define configUSE_MALLOC_FAILED_HOOK	1
 #define configRECORD_STACK_HIGH_ADDRESS 1
 
+/* Set configSUPPORT_STATIC_ALLOCATION to 1 (e.g. -DconfigSUPPORT_STATIC_ALLOCATION=1, in every project)
+to create application tasks, queues and semaphores from statically sized buffers (see rtos_alloc.h). Nothing is
+allocated from the heap then (tests/Makefile links that build, and checks it), so the heap shrinks to a token size:
+dynamic allocation stays on only because heap_4.c is in the kernel project, and refuses to build without it. */
+#ifndef configSUPPORT_STATIC_ALLOCATION
+	#define configSUPPORT_STATIC_ALLOCATION	0
+#endif
+#define configSUPPORT_DYNAMIC_ALLOCATION	1
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+	#define configTOTAL_HEAP_SIZE		( ( size_t ) 256 )
+#else
+	#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 12 * 1024 ) )
+#endif
+
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
 
@@ -89,7 +102,8 @@ to exclude the API function. */
 #define INCLUDE_vTaskSuspend				1
 #define INCLUDE_vTaskDelayUntil				1
 #define INCLUDE_vTaskDelay					1
-#define INCLUDE_uxTaskGetStackHighWaterMark	0
+#define INCLUDE_uxTaskGetStackHighWaterMark	1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
 
 /* Use the system definition, if there is one */
 #ifdef __NVIC_PRIO_BITS
@@ -119,5 +133,31 @@ extern void vConfigureTimerForRunTimeStats( void );
 #define portGET_RUN_TIME_COUNTER_VALUE() LPC_TIM1->TC
 
 
+/*-----------------------------------------------------------
+ * Kernel trace macros, only with TRACE (see trace.h).
+ *-----------------------------------------------------------*/
+#ifdef TRACE
+	#include "trace.h"
+
+	#define traceTASK_CREATE( pxNewTCB ) TRACE_TaskName( ( pxNewTCB )->uxTCBNumber, ( pxNewTCB )->pcTaskName )
+	#define traceTASK_SWITCHED_IN() TRACE_Record( TRACE_TASK_IN, TRACE_NONE, pxCurrentTCB->uxTCBNumber )
+	#define traceTASK_SWITCHED_OUT() TRACE_Record( TRACE_TASK_OUT, TRACE_NONE, pxCurrentTCB->uxTCBNumber )
+	#define traceTASK_NOTIFY_GIVE_FROM_ISR() TRACE_Record( TRACE_NOTIFY, TRACE_NONE, pxTCB->uxTCBNumber )
+	#define traceTASK_NOTIFY_FROM_ISR() TRACE_Record( TRACE_NOTIFY, TRACE_NONE, pxTCB->uxTCBNumber )
+
+	#define traceQUEUE_SEND( pxQueue ) TRACE_QUEUE( TRACE_QUEUE_SEND, pxQueue )
+	#define traceQUEUE_SEND_FROM_ISR( pxQueue ) TRACE_QUEUE( TRACE_QUEUE_SEND, pxQueue )
+	#define traceQUEUE_RECEIVE( pxQueue ) TRACE_QUEUE( TRACE_QUEUE_RECEIVE, pxQueue )
+	#define traceQUEUE_RECEIVE_FROM_ISR( pxQueue ) TRACE_QUEUE( TRACE_QUEUE_RECEIVE, pxQueue )
+	#define traceBLOCKING_ON_QUEUE_SEND( pxQueue ) TRACE_QUEUE( TRACE_QUEUE_BLOCK, pxQueue )
+	#define traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue ) TRACE_QUEUE( TRACE_QUEUE_BLOCK, pxQueue )
+
+	#define traceSTREAM_BUFFER_SEND( xStreamBuffer, xBytesSent ) TRACE_QUEUE( TRACE_QUEUE_SEND, xStreamBuffer )
+	#define traceSTREAM_BUFFER_RECEIVE( xStreamBuffer, xReceivedLength ) TRACE_QUEUE( TRACE_QUEUE_RECEIVE, xStreamBuffer )
+	#define traceBLOCKING_ON_STREAM_BUFFER_SEND( xStreamBuffer ) TRACE_QUEUE( TRACE_QUEUE_BLOCK, xStreamBuffer )
+	#define traceBLOCKING_ON_STREAM_BUFFER_RECEIVE( xStreamBuffer ) TRACE_QUEUE( TRACE_QUEUE_BLOCK, xStreamBuffer )
+#endif
+
+
 #endif /* FREERTOS_CONFIG_H */
 
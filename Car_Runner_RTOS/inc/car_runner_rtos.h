@@ -41,10 +41,12 @@
 #include "button.h"
 #include "rtc.h"
 #include "led.h"
+#include "level.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
 #include "semphr.h"
+#include "rtos_alloc.h"
 
 
 
@@ -68,11 +70,6 @@
  */
 #define TASK_DATE_PRIORITY tskIDLE_PRIORITY + 1
 
-/**
- * @note	Points Task Priority.
- */
-#define TASK_POINTS_PRIORITY tskIDLE_PRIORITY + 1
-
 /**
  * @note	State Machine Task Priority.
  */
@@ -88,11 +85,6 @@
  */
 #define TASK_UPDATE_GAME_PRIORITY tskIDLE_PRIORITY + 1
 
-/**
- * @note	Fuel Task Priority.
- */
-#define TASK_FUEL_PRIORITY tskIDLE_PRIORITY + 1
-
 /**
  * @note	Blink Task Priority.
  */
@@ -123,12 +115,7 @@
 /**
  * @note	Date Task Stack Size.
  */
-#define TASK_DATE_STACK_SIZE configMINIMAL_STACK_SIZE*2
-
-/**
- * @note	Points Task Stack Size.
- */
-#define TASK_POINTS_STACK_SIZE configMINIMAL_STACK_SIZE*0.5
+#define TASK_DATE_STACK_SIZE configMINIMAL_STACK_SIZE
 
 /**
  * @note	State Machine Task Stack Size.
@@ -138,7 +125,7 @@
 /**
  * @note	Score Count Task Stack Size.
  */
-#define TASK_SCORE_COUNT_STACK_SIZE configMINIMAL_STACK_SIZE*0.5
+#define TASK_SCORE_COUNT_STACK_SIZE configMINIMAL_STACK_SIZE/2
 
 /**
  * @note	Update Game Task Stack Size.
@@ -146,19 +133,45 @@
 #define TASK_UPDATE_GAME_STACK_SIZE configMINIMAL_STACK_SIZE*5
 
 /**
- * @note	Fuel Task Stack Size.
+ * @note	Blink Task Stack Size.
  */
-#define TASK_FUEL_STACK_SIZE configMINIMAL_STACK_SIZE*0.5
+#define TASK_BLINK_STACK_SIZE configMINIMAL_STACK_SIZE/2
 
 /**
  * @note	Blink Task Stack Size.
  */
-#define TASK_BLINK_STACK_SIZE configMINIMAL_STACK_SIZE*0.5
+#define TASK_NETWORK_MANAGER_STACK_SIZE configMINIMAL_STACK_SIZE*2
 
 /**
- * @note	Blink Task Stack Size.
+ * @note	Number of frames Update Game Task can have pending.
  */
-#define TASK_NETWORK_MANAGER_STACK_SIZE configMINIMAL_STACK_SIZE*2
+#define UPDATE_GAME_QUEUE_LENGTH 8
+
+/**
+ * @note	Number of Date Time Strings Structures kept (latest only).
+ */
+#define DATE_QUEUE_LENGTH 1
+
+/**
+ * @note	Idle Task Stack Size (static allocation only).
+ */
+#define TASK_IDLE_STACK_SIZE configMINIMAL_STACK_SIZE
+
+/**
+ * @note	If 1, stack usage of every task is printed (printf) each time the state machine changes state.
+ * 			Go through every state (and play a game) to get the recommended stack sizes.
+ */
+#define STACK_REPORT 0
+
+/**
+ * @note	Recommended stack size margin, over the deepest stack use seen (percent).
+ */
+#define STACK_MARGIN_PERCENT 25
+
+/**
+ * @note	Recommended stack sizes are rounded up to a multiple of this (words).
+ */
+#define STACK_ROUND_WORDS 8
 
 /*
 ===========================================================================================================================================================
@@ -203,10 +216,63 @@
 #define POINTS_RATE 1000
 
 /**
- * @brief	Game update rate (i.e. time in us between each "frame"), in Game Mode.
+ * @brief	Game update rate (i.e. time in ms between each "frame"), in Game Mode, as the game starts.
  */
 #define GAME_RATE 300
 
+/**
+ * @brief	Fastest game update rate (ms), whatever the LCD can sustain.
+ */
+#define GAME_RATE_MIN 100
+
+/**
+ * @brief	Game update rate decrement (ms) per speed level.
+ */
+#define GAME_RATE_STEP 20
+
+/**
+ * @brief	Points needed to go up a speed level.
+ */
+#define GAME_SPEED_POINTS 15
+
+/**
+ * @brief	If 1, the game always runs at the fastest rate, and frame timing (i.e. dropped frames) is printed when each game ends.
+ * @note    Can be set from the build (-DGAME_SPEED_STRESS=1).
+ */
+#ifndef GAME_SPEED_STRESS
+	#define GAME_SPEED_STRESS 0
+#endif
+
+/**
+ * @brief	Worst case frames rendered at boot to measure the LCD flush time.
+ */
+#define CALIBRATION_FRAMES 4
+
+/**
+ * @brief	Frame period must be at least this many times the measured LCD flush time.
+ */
+#define FRAME_FLUSH_HEADROOM 2
+
+/**
+ * @brief	Frequency of the frame timing counter (TIMER1, also used for run-time stats), in Hz.
+ */
+#define FRAME_TIMER_HZ 10000UL
+
+/**
+ * @brief	Number of bins in each frame timing histogram. The last bin also holds everything above it.
+ */
+#define FRAME_HISTOGRAM_BINS 8
+
+/**
+ * @brief	Busy time histogram resolution, in bins per frame period (i.e. bins >= this are overruns).
+ */
+#define FRAME_BUSY_BINS_PER_PERIOD 4
+
+/**
+ * @brief	If 1, frame timing histograms are printed (printf) when each game ends.
+ */
+#define FRAME_STATS_DUMP 0
+
 /**
  * @brief	Fuel tank decrement rate, in Game Mode.
  */
@@ -218,9 +284,10 @@
 #define CAR_POSITION 3
 
 /**
- * @brief   Columns with no obstacles as of starting the game.
+ * @brief   Columns (from the first) with no obstacles as of starting the game.
+ * @note    Should be lower than LEVEL_SEGMENT_LENGTH.
  */
-#define INITIAL_OBSTACLE_GAP CAR_POSITION + 5
+#define INITIAL_OBSTACLE_GAP (CAR_POSITION + 7)
 
 /**
  * @brief   Maximum fuel.
@@ -228,6 +295,16 @@
  */
 #define MAX_FUEL 8
 
+/**
+ * @brief   Bit of a GAME_MAP row mask representing LCD DDRAM column 'col' (1 to LCD_DDRAM_LENGTH).
+ */
+#define MAP_COLUMN(col) (1ULL << ((col) - 1))
+
+/**
+ * @brief   Bits of a GAME_MAP row mask representing LCD DDRAM columns 'from' to 'to' (inclusive).
+ */
+#define MAP_RANGE(from, to) ((~0ULL >> (64 - ((to) - (from) + 1))) << ((from) - 1))
+
 /**
  * @brief	Value ADXL345's Y-Axis needs to surpass, to count as row change.
  */
@@ -345,11 +422,18 @@ typedef enum
  */
 typedef struct {
 	int row; /*!< Current LCD row car is in */
-	int last_row; /*!< LCD row car was last frame */
 	int front_column; /*!< Current column car front is in */
 	int back_column; /*!< Current column car back is in */
 } CAR;
 
+/**
+ * @brief	Objects currently in LCD DDRAM, one bit per column (see MAP_COLUMN).
+ */
+typedef struct {
+	uint64_t obstacles[LCD_DISPLAY_ROWS]; /*!< Columns with an obstacle, per row. */
+	uint64_t fuel[LCD_DISPLAY_ROWS]; /*!< Columns with a fuel galleon, per row. */
+} GAME_MAP;
+
 /**
  * @brief	Idle mode for Idle Task:
  */
@@ -357,8 +441,46 @@ typedef struct
 {
 	bool init; /*!< Initialising flag. */
 	uint32_t row; /*!< Row car is on. */
+	uint32_t period; /*!< Frame period, in ms. */
+	uint32_t time; /*!< Frame start, in FRAME_TIMER_HZ ticks. */
 } GAME_INFO;
 
+/**
+ * @brief	Frame timing of a game.
+ * @note    Times are in FRAME_TIMER_HZ ticks.
+ */
+typedef struct
+{
+	uint32_t frames; /*!< Frames started. */
+	uint32_t overruns; /*!< Frames started before the previous one was simulated. */
+	uint32_t maxJitter; /*!< Largest deviation of a frame interval from the period. */
+	uint32_t maxBusy; /*!< Longest frame (input sampling to end of render). */
+	uint32_t jitter[FRAME_HISTOGRAM_BINS]; /*!< Frame interval deviation, 1 ms per bin. */
+	uint32_t busy[FRAME_HISTOGRAM_BINS]; /*!< Frame busy time, 1/FRAME_BUSY_BINS_PER_PERIOD period per bin. */
+} FRAME_STATS;
+
+/**
+ * @brief	State of the current game, shared with other tasks.
+ * @note    Written by the Update Game task only (game() resets it before the first frame, while that task waits for
+ * 			frames). Other tasks read it field by field, lock-free
+ * 			(aligned 32-bit loads and stores are atomic).
+ */
+typedef struct
+{
+	volatile uint32_t points; /*!< Points scored, one every POINTS_RATE ms. */
+	volatile uint32_t fuel; /*!< Fuel left (0 to MAX_FUEL), one less every FUEL_RATE ms. */
+	volatile uint32_t ended; /*!< Whether the car has crashed (or run out of fuel). */
+} GAME_STATE;
+
+/**
+ * @brief	Configured stack size of a task, for the stack usage report.
+ */
+typedef struct
+{
+	const char * name; /*!< Task name, as given at creation (truncated to configMAX_TASK_NAME_LEN when matched). */
+	uint32_t size; /*!< Stack size, in words. */
+} TASK_STACK;
+
 /**
  * @brief	Date Time String Struct.
  */
@@ -506,15 +628,11 @@ const unsigned char fuel1_charmap[] = {
 */
 
 /**
- * @brief	Task to periodically get date from RTC, and overwrite queueDATE with the most recent object.
+ * @brief	Task to get date from RTC, and overwrite queueDATE with the most recent object.
+ * @note	Sleeps until notified: once per second by the RTC interrupt while someone is subscribed, or by dateRefresh().
  */
 void taskDATE(void *pvParameters);
 
-/**
- * @brief	Task to increment points variable, every POINTS_RATE ms.
- */
-void taskPOINTS(void *pvParameters);
-
 /**
  * @brief	Task to run application state machine.
  */
@@ -530,11 +648,6 @@ void taskSCORE_COUNT(void *pvParameters);
  */
 void taskUPDATE_GAME(void * pvParameters);
 
-/**
- * @brief	Task to decrement fuel, every FUEL_RATE ms.
- */
-void taskFUEL(void * pvParameters);
-
 /**
  * @brief	Task to invert blinked value, every HIGHLIGHT_BLINK_TIME ms. This variable indicates which score should be showing in idle mode.
  */
@@ -576,6 +689,36 @@ void getUsername(void);
 ===========================================================================================================================================================
 */
 
+/**
+ * @brief	Writes a number as a fixed number of decimal digits (zero padded, no terminator).
+ * @param   at: -> Where to write the digits.
+ * @param   value: -> Number to write (non-negative).
+ * @param   digits: -> Number of digits.
+ */
+void putDigits(char *at, int value, int digits);
+
+/**
+ * @brief	RTC handler, once per second. Wakes taskDATE, if anyone is subscribed.
+ * @note	Runs in interrupt context.
+ */
+void dateTick(void);
+
+/**
+ * @brief	Start keeping queueDATE up to date. Must be called before printDateTime().
+ * @note	Called by taskSTATE_MACHINE only, around the states that show the clock.
+ */
+void dateSubscribe(void);
+
+/**
+ * @brief	Stop keeping queueDATE up to date, once the last subscriber is gone.
+ */
+void dateUnsubscribe(void);
+
+/**
+ * @brief	Have taskDATE read the RTC now (e.g. after changing a field with counters disabled).
+ */
+void dateRefresh(void);
+
 /**
  * @brief	Receive current Date Time from queueDATE, and print to LCD.
  * @param   without: -> Field to blink. If blink isn't wanted, NONE should be passed.
@@ -645,54 +788,69 @@ void idle(void);
 void printToCol(int col, unsigned char c1, unsigned char c2);
 
 /**
- * @brief	Shift fuel indicator in LCD.
- * @param   currentFuelCol: -> Column where fuel indicator is, currently.
- * @note    Fuel indicator will be shifted to the right of 'currentFuelCol'.
- * @note	This function calls 'printToCol()' to print the fuel indicator to the next column.
- * @note    The LCD display is never shifted in this function. Only the fuel indicator is shifted.
+ * @brief	Draws the fuel indicator in a new LCD column.
+ * @param   previousCol: -> Column where fuel indicator was drawn last frame (erased).
+ * @param   col: -> Column where fuel indicator should be drawn.
+ * @note	This function calls 'printToCol()' to print the fuel indicator.
+ * @note    The LCD display is never shifted in this function.
+ */
+void drawFuelIndicator(int previousCol, int col);
+
+/**
+ * @brief	Moves the whole car (i.e. front and back) 1 column to the right, to a given row.
+ * @param   car: -> Pointer to Car.
+ * @param   row: -> Row car should be on.
+ * @note    Simulation only. Nothing is written to the LCD.
  */
-void shiftFuelIndicator(int * currentFuelCol);
+void moveCar(CAR *car, int row);
 
 /**
- * @brief	Shifts the whole car (i.e. front and back) 1 LCD column to the right.
+ * @brief	Erases the car where it was last frame, and draws it where it is now.
+ * @param   previous: -> Pointer to Car, as of last frame.
  * @param   car: -> Pointer to Car.
- * @note    The LCD display is never shifted in this function. Only the car is shifted.
+ * @note    The LCD display is never shifted in this function.
  */
-void shiftCar(CAR *car);
+void drawCar(const CAR *previous, const CAR *car);
 
 /**
- * @brief	Randomises a unique fuel galleon in a specified range of the LCD DDRAM. Also updates array 'o' with such information.
- * @param   from: -> Randomisation will start in this column.
- * @param   to: -> Randomisation will end in this column.
- * @param   map: -> Array representing all objects currently in LCD DDRAM (2 for fuel galleon, 1 for obstacle, 0 for nothing).
- * @note    Only places the fuel in a column where there's no obstacles in either row.
+ * @brief	Writes a road segment in a specified range of 'map'.
+ * @param   from: -> First column of the range (the range is LEVEL_SEGMENT_LENGTH columns long).
+ * @param   map: -> Pointer to map of all objects currently in LCD DDRAM.
+ * @param   segment: -> Segment taken from the level generator.
  */
-void randomiseFuel(int from, int to, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]);
+void mergeSegment(int from, GAME_MAP *map, const LEVEL_SEGMENT *segment);
 
 /**
- * @brief	Randomises new obstacles in a specified range of the LCD DDRAM. Also updates array 'o' with such information.
- * @param   from: -> Randomisation will start in this column.
- * @param   to: -> Randomisation will end in this column.
- * @param   map: -> Array representing all objects currently in LCD DDRAM (2 for fuel galleon, 1 for obstacle, 0 for nothing).
- * @note    A space of at least 2 columns is always left between each obstacle.
+ * @brief	Writes a road segment in a specified range of the LCD DDRAM.
+ * @param   from: -> First column of the range (the range is LEVEL_SEGMENT_LENGTH columns long).
+ * @param   segment: -> Segment taken from the level generator.
+ * @note    A single LCD string per row.
  */
-void randomiseObstacles(int from, int to, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]);
+void drawSegment(int from, const LEVEL_SEGMENT *segment);
+
+/**
+ * @brief	Clears a specified range of the LCD DDRAM. Also updates 'map' with such information.
+ * @param   from: -> First column of the range.
+ * @param   to: -> Last column of the range.
+ * @param   map: -> Pointer to map of all objects currently in LCD DDRAM.
+ */
+void clearColumns(int from, int to, GAME_MAP *map);
 
 /**
  * @brief	Checks if any part of the Car (i.e. front or body) has hit a fuel galleon.
  * @param   car: -> Pointer to Car.
- * @param   map: -> Array representing all objects currently in LCD DDRAM (2 for fuel galleon, 1 for obstacle, 0 for nothing).
+ * @param   map: -> Pointer to map of all objects currently in LCD DDRAM.
  * @note    If a galleon has been hit, fuel is added to the fuel indicator.
  */
-void checkForFuelGrab(CAR *car, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]);
+void checkForFuelGrab(CAR *car, GAME_MAP *map);
 
 /**
  * @brief	Checks if any part of the Car (i.e. front or body) has hit a obstacle.
  * @param   car: -> Pointer to Car.
- * @param   map: -> Array representing all objects currently in LCD DDRAM (2 for fuel galleon, 1 for obstacle, 0 for nothing).
+ * @param   map: -> Pointer to map of all objects currently in LCD DDRAM.
  * @return  If an obstacle has been hit, returns true. Else, returns false.
  */
-bool checkForLoss(CAR *car, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]);
+bool checkForLoss(CAR *car, GAME_MAP *map);
 
 /**
  * @brief	Animate explosion in car position.
@@ -713,6 +871,45 @@ void pregame(void);
  */
 void game(void);
 
+/**
+ * @brief	Measures how long the LCD takes to flush a worst case frame, and caps the game speed accordingly.
+ * @note	Writes to the LCD (clear it afterwards). Should be called once, at boot.
+ */
+void calibrateFrameRate(void);
+
+/**
+ * @brief	Game update rate for a given score.
+ * @param   points: -> Current points.
+ * @return  Frame period, in ms (GAME_RATE down to the calibrated rate, one GAME_RATE_STEP every GAME_SPEED_POINTS).
+ */
+uint32_t gamePeriod(uint32_t points);
+
+/**
+ * @brief	Samples player input (ADXL345 inclination) into a frame.
+ * @param   info: -> Frame to be sent to the game update task.
+ */
+void sampleInput(GAME_INFO *info);
+
+/**
+ * @brief	Records the start of a frame in the frame timing statistics.
+ * @param   interval: -> Time since the start of last frame.
+ * @param   period: -> Frame period the interval was due to take (the last frame's), in ms.
+ * @param   late: -> Whether last frame is still waiting to be simulated (overrun).
+ */
+void recordFrameStart(uint32_t interval, uint32_t period, bool late);
+
+/**
+ * @brief	Records how long a frame took (input sampling to end of render) in the frame timing statistics.
+ * @param   busy: -> Frame busy time.
+ * @param   period: -> Frame period, in ms.
+ */
+void recordFrameBusy(uint32_t busy, uint32_t period);
+
+/**
+ * @brief	Prints (printf) the frame timing statistics of the last game.
+ */
+void dumpFrameStats(void);
+
 /**
  * @brief	State to show user's score.
  * @note	Hit any button to go to menu.
@@ -790,6 +987,25 @@ bool yesOrNo(void(*f)(void));
 
 
 
+/*
+===========================================================================================================================================================
+===========================================================================================================================================================
+
+	FREERTOS UTILS:
+
+===========================================================================================================================================================
+===========================================================================================================================================================
+*/
+
+/**
+ * @brief	Prints (printf) the deepest stack use of every task so far, and a recommended stack size for each.
+ * @note	Recommended size is the deepest use plus STACK_MARGIN_PERCENT, rounded up to STACK_ROUND_WORDS.
+ * @note	Tasks not in the configured stack table are listed with size 0.
+ */
+void reportStackUsage(void);
+
+
+
 /**
  * @}
  */
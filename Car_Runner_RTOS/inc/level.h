@@ -0,0 +1,154 @@
+/*
+ * level.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: pedro
+ */
+
+#ifndef LEVEL_H_
+#define LEVEL_H_
+
+/** @defgroup LEVEL LEVEL
+ * This package provides the procedural level generator.
+ * @{
+ */
+
+/** @defgroup LEVEL_Public_Functions LEVEL Public Functions
+ * @{
+ */
+
+/*
+ * 	The road is built from segments of LEVEL_SEGMENT_LENGTH columns
+ * (half of LCD DDRAM). A background task generates the next segment
+ * while the game consumes the current one (double buffer), so the
+ * frame that reaches a segment boundary only swaps pointers.
+ *
+ * 	Segments follow a difficulty curve: as points grow, obstacles get
+ * closer and fuel galleons scarcer. Every segment is checked to be
+ * passable: there is never a pair of consecutive columns (the car's
+ * length) blocked in both rows, including across segment boundaries.
+ */
+
+
+#include "lcd.h"
+#include "adxl.h"
+#include "rtc.h"
+#include "prng.h"
+
+#include <stdbool.h>
+
+// Kernel includes.
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "rtos_alloc.h"
+
+
+/**
+ *
+ *
+ * CONSTANTS:
+ *
+ *
+ */
+
+/**
+ * @note	Level Task Priority.
+ */
+#define TASK_LEVEL_PRIORITY tskIDLE_PRIORITY + 1
+
+/**
+ * @note	Level Task Stack Size.
+ */
+#define TASK_LEVEL_STACK_SIZE configMINIMAL_STACK_SIZE*1
+
+/**
+ * @brief	Number of columns in a segment.
+ */
+#define LEVEL_SEGMENT_LENGTH (LCD_DDRAM_LENGTH/2)
+
+/**
+ * @brief	Points needed to move up one difficulty step.
+ */
+#define LEVEL_POINTS_PER_STEP 20
+
+/**
+ * @brief	Attempts to generate a passable segment, before falling back to a single row of obstacles.
+ */
+#define LEVEL_MAX_ATTEMPTS 8
+
+
+/**
+ *
+ *
+ * TYPES:
+ *
+ *
+ */
+
+/**
+ * @brief	Segment of road.
+ */
+typedef struct {
+	uint32_t obstacles[LCD_DISPLAY_ROWS]; /*!< Columns with an obstacle, per row (bit 0 is the first column). */
+	uint32_t fuel[LCD_DISPLAY_ROWS]; /*!< Columns with a fuel galleon, per row. */
+	char text[LCD_DISPLAY_ROWS][LEVEL_SEGMENT_LENGTH + 1]; /*!< Segment as LCD characters, per row. */
+} LEVEL_SEGMENT;
+
+/**
+ * @brief	Difficulty step.
+ */
+typedef struct {
+	uint8_t minSpacing; /*!< Minimum distance between obstacles (at least 2, to stay passable). */
+	uint8_t maxSpacing; /*!< Maximum distance between obstacles. */
+	uint8_t fuelChance; /*!< Chance (%) of a segment having a fuel galleon. */
+} LEVEL_STEP;
+
+
+/**
+ *
+ *
+ * FUNCTIONS:
+ *
+ *
+ */
+
+/**
+ * @brief	Initialises level generator.
+ * @param   obstacleChar: -> LCD character used for obstacles in segment text.
+ * @param   fuelChar: -> LCD character used for fuel galleons in segment text.
+ * @return  True if successful, false otherwise.
+ * @note    Must be called before the scheduler starts.
+ */
+bool LEVEL_Init(char obstacleChar, char fuelChar);
+
+/**
+ * @brief	Restarts the road, as of starting a game.
+ * @note    The segment already generated is discarded, and the next one is generated for the easiest step.
+ */
+void LEVEL_Restart(void);
+
+/**
+ * @brief	Takes the next segment, and lets the generator start on the one after it.
+ * @param   points: -> Current points, setting the difficulty of the segment generated next.
+ * @return  Next segment. Valid until the following call.
+ * @note    Only blocks if the generator is late (it has a whole segment's time to do its work).
+ */
+const LEVEL_SEGMENT * LEVEL_Swap(uint32_t points);
+
+/**
+ * @brief	Task generating segments in the background.
+ */
+void LEVEL_GeneratorTask(void *pvParameters);
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+#endif /* LEVEL_H_ */
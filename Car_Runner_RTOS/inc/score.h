@@ -18,22 +18,28 @@
  */
 
 /*
- * 	Memory will be used to store the best
+ * 	Memory will be used to store a leaderboard of the best
  * 	scores, and respective user name.
  *
- * ----------------------------------------
- * |         |         |         |
- * | score 1 | score 2 | score 3 |   ...
- * |         |         |         |
- * ----------------------------------------
- * \________/\________/\________/\________/
- *     16        16        16        208
- * \______________________________________/
- * 				     256
+ * --------------------------------------------------------------
+ * |        |                  |         |         |
+ * | header | rank list        | slot 0  | slot 1  |   ...
+ * |        | (slot per rank)  |         |         |
+ * --------------------------------------------------------------
+ * \_______/\_________________/\________/\________/
+ *     16    SCORE_BOARD_SIZE     16        16
+ *           (rounded to 16)
+ *
+ * 	Every Score lives in a fixed slot, and is never moved.
+ * 	The rank list holds the slot of each placement, best first,
+ * so a placement is found with a single slot read, and a new
+ * score only rewrites its own slot and the part of the rank list
+ * that was shifted by the insertion.
  *
  * 	The program will ask for user name.
  * 	There will be only one score registered per user
- * name. The best one.
+ * name. The best one. A small hashed index (kept in RAM, rebuilt
+ * at start-up) finds the slot of a user name.
  */
 
 
@@ -47,6 +53,8 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "semphr.h"
+#include "rtos_alloc.h"
 
 
 /**
@@ -67,11 +75,58 @@
  */
 #define TASK_SCORE_STACK_SIZE configMINIMAL_STACK_SIZE*1
 
+/**
+ * @note	Number of scores waiting to be saved.
+ */
+#define SCORE_QUEUE_LENGTH 8
+
 /**
  * @brief	Number of scores to be sequentially displayed in Idle Mode.
  */
 #define SCORE_NUM 3
 
+/**
+ * @brief	Number of scores kept in the leaderboard.
+ * @note    Should be lower than 256 (a slot is referenced by a single byte).
+ */
+#define SCORE_BOARD_SIZE 200
+
+/**
+ * @brief	Number of entries of the user name index.
+ * @note    Should be a power of 2, higher than SCORE_BOARD_SIZE.
+ */
+#define SCORE_INDEX_SIZE 256
+
+/**
+ * @brief	Value identifying a formatted leaderboard ("SCB1").
+ */
+#define SCORE_BOARD_MAGIC 0x31424353
+
+/**
+ * @brief	Leaderboard header address, relative to the start of the memory device.
+ */
+#define SCORE_HEADER_ADDRESS 0
+
+/**
+ * @brief	Leaderboard rank list address, relative to the start of the memory device.
+ */
+#define SCORE_RANK_ADDRESS (SCORE_HEADER_ADDRESS + sizeof(SCORE_BOARD_HEADER))
+
+/**
+ * @brief	Leaderboard first slot address, relative to the start of the memory device.
+ */
+#define SCORE_SLOT_ADDRESS (SCORE_RANK_ADDRESS + ((SCORE_BOARD_SIZE + 15) & ~15))
+
+/**
+ * @brief	Total size of the leaderboard in the memory device.
+ */
+#define SCORE_BOARD_LENGTH (SCORE_SLOT_ADDRESS + SCORE_BOARD_SIZE * sizeof(Score))
+
+/**
+ * @brief	Size of the RAM image used to rewrite the leaderboard in Flash (multiple of FLASH_MINIMAL_WRITE_SIZE).
+ */
+#define SCORE_FLASH_IMAGE_LENGTH ((SCORE_BOARD_LENGTH + FLASH_MINIMAL_WRITE_SIZE - 1) & ~(FLASH_MINIMAL_WRITE_SIZE - 1))
+
 /**
  * @brief	Flash sector to be used.
  */
@@ -96,6 +151,16 @@ typedef struct Score {
 	uint32_t score; /*!< His best score (4 bytes) */
 } Score;
 
+/**
+ * @brief	Leaderboard header, stored at the start of the memory device (16 bytes).
+ */
+typedef struct {
+	uint32_t magic; /*!< SCORE_BOARD_MAGIC, if leaderboard is formatted (4 bytes) */
+	uint16_t count; /*!< Number of slots in use (2 bytes) */
+	uint16_t capacity; /*!< SCORE_BOARD_SIZE the leaderboard was formatted with (2 bytes) */
+	uint8_t reserved[8]; /*!< Reserved (8 bytes) */
+} SCORE_BOARD_HEADER;
+
 /**
  * @brief	Type of memory device to be used.
  */
@@ -124,7 +189,10 @@ bool SCORE_Init(MEMORY_DEVICE device);
 /**
  * @brief	Writes the requested Score to given pointer.
  * @param   score: -> Pointer where Score shall be written.
- * @param   n: -> Index of Score requested [0, SCORE_NUM-1].
+ * @param   n: -> Placement of Score requested [0, SCORE_BOARD_SIZE-1].
+ * @return  0 if successful, -1 if placement is out of bounds.
+ * @note    If placement is not taken yet, an empty Score (score 0) is written.
+ * @note    Costs a single slot read, whatever the placement.
  */
 int SCORE_Get(Score * score, int n);
 
@@ -132,18 +200,19 @@ int SCORE_Get(Score * score, int n);
  * @brief	Sorts given array of Scores downwardly.
  * @param   scores: -> Array of scores.
  * @param   size: -> Size of the array.
+ * @note    Insertion sort. Linear on arrays that are already (almost) sorted.
  */
 void SCORE_Sort(Score * scores, int size);
 
 /**
- * @brief	If given score is one of the best 3, saves it to flash memory.
+ * @brief	Queues given score to be saved in the leaderboard (and published, if it reaches the podium).
  * @param   score: -> User's score.
  * @param   username: -> String username.
  */
 void SCORE_Save(uint32_t score, char * username);
 
 /**
- * @brief	Erases all scores from flash memory.
+ * @brief	Erases all scores from the leaderboard.
  */
 void SCORE_Erase(void);
 
@@ -40,42 +40,23 @@
 static STATE state = STATE_IDLE;
 
 static uint32_t bitmap = 0;
-static uint32_t points = 1;
-static uint32_t fuel = 0;
 static uint32_t scoreCount = 0;
 
 static char username[NAME_LENGTH+1]; // Name of current user.
 
 static bool blinked = false;
 
-static bool gameEnd = false;
+static GAME_STATE gameState = {.points = 1}; // Written by taskUPDATE_GAME only (and by game(), before it starts)
 
+static FRAME_STATS frameStats; // Frame timing of current game
 
+static uint32_t frameRateMin = GAME_RATE; // Fastest frame period (ms), set by calibrateFrameRate()
 
-/*
-===========================================================================================================================================================
-===========================================================================================================================================================
-
-	SEMAPHORES:
-
-===========================================================================================================================================================
-===========================================================================================================================================================
-*/
-
-/**
- * Binary semaphore to control access to global state.
- */
-SemaphoreHandle_t semGAME_END = NULL;
+static TaskHandle_t handleDATE = NULL;
 
-/**
- * Binary semaphore to control access to global state.
- */
-SemaphoreHandle_t semPOINTS = NULL;
+static volatile uint32_t dateSubscribers = 0; // Written by taskSTATE_MACHINE only
 
-/**
- * Binary semaphore to control access to global state.
- */
-SemaphoreHandle_t semFUEL = NULL;
+static const char daysOfWeek[7][4] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
 
 
 
@@ -100,11 +81,22 @@ QueueHandle_t queueACC = NULL;
 QueueHandle_t queueUPDATE_GAME = NULL;
 
 /**
- * Holds a uint8_t dummy value.
+ * Holds the latest DATE_TIME structure (kept up to date only while someone is subscribed, see dateSubscribe()).
  */
 QueueHandle_t queueDATE = NULL;
 
 
+RTOS_QUEUE_STORAGE(queueUPDATE_GAME, UPDATE_GAME_QUEUE_LENGTH, sizeof(GAME_INFO));
+RTOS_QUEUE_STORAGE(queueDATE, DATE_QUEUE_LENGTH, sizeof(DATE_TIME));
+
+RTOS_TASK_STORAGE(taskSTATE_MACHINE, TASK_STATE_MACHINE_STACK_SIZE);
+RTOS_TASK_STORAGE(taskDATE, TASK_DATE_STACK_SIZE);
+RTOS_TASK_STORAGE(taskSCORE_COUNT, TASK_SCORE_COUNT_STACK_SIZE);
+RTOS_TASK_STORAGE(taskUPDATE_GAME, TASK_UPDATE_GAME_STACK_SIZE);
+RTOS_TASK_STORAGE(taskBLINK, TASK_BLINK_STACK_SIZE);
+RTOS_TASK_STORAGE(taskNETWORK_MANAGER, TASK_NETWORK_MANAGER_STACK_SIZE);
+
+
 
 /*
 ===========================================================================================================================================================
@@ -119,6 +111,9 @@ QueueHandle_t queueDATE = NULL;
 int main(void) {
 
 	SystemInit();
+#ifdef TRACE
+	TRACE_Init(); // Before any task is created
+#endif
 
 	if (LCDText_Init() < 0) {
 		printf("LCD initialisation failed.");
@@ -139,6 +134,11 @@ int main(void) {
 
 	RTC_Init(0);
 
+	if (!LEVEL_Init(BARRIER_CHAR, FUEL_CHAR)) {
+		printf("LEVEL initialisation failed");
+		return 0;
+	}
+
 	NETWORK_Init();
 
 	LCDText_CreateChar(CAR_BACK_CHAR, car_back_charmap);
@@ -150,35 +150,16 @@ int main(void) {
 	LCDText_CreateChar(FUEL3_CHAR, fuel3_charmap);
 	LCDText_CreateChar(FUEL4_CHAR, fuel4_charmap);
 
-	/**
-	 * Semaphores:
-	 */
-
-	if ((semGAME_END = xSemaphoreCreateMutex()) == NULL) {
-		printf("Semaphore GAME_END could not be created.\n");
-		return 0;
-	}
-
-	if ((semPOINTS = xSemaphoreCreateMutex()) == NULL) {
-		printf("Semaphore POINTS could not be created.\n");
-		return 0;
-	}
-
-	if ((semFUEL = xSemaphoreCreateMutex()) == NULL) {
-		printf("Semaphore FUEL could not be created.\n");
-		return 0;
-	}
-
 	/**
 	 * Queues:
 	 */
 
-	if ((queueUPDATE_GAME = xQueueCreate(8, sizeof(GAME_INFO))) == NULL) {
+	if ((queueUPDATE_GAME = RTOS_QueueCreate(queueUPDATE_GAME, UPDATE_GAME_QUEUE_LENGTH, sizeof(GAME_INFO))) == NULL) {
 		printf("Queue for UPDATE_GAME could not be created.\n");
 		return 0;
 	}
 
-	if ((queueDATE = xQueueCreate(1, sizeof(DATE_TIME))) == NULL) {
+	if ((queueDATE = RTOS_QueueCreate(queueDATE, DATE_QUEUE_LENGTH, sizeof(DATE_TIME))) == NULL) {
 		printf("Queue for DATE could not be created.\n");
 		return 0;
 	}
@@ -187,46 +168,38 @@ int main(void) {
 	 * Tasks:
 	 */
 
-	if (xTaskCreate(taskSTATE_MACHINE, (const char * const) "TaskSTATE_MACHINE", TASK_STATE_MACHINE_STACK_SIZE, NULL, TASK_STATE_MACHINE_PRIORITY, NULL) != pdPASS) {
+	if (RTOS_TaskCreate(taskSTATE_MACHINE, taskSTATE_MACHINE, (const char * const) "TaskSTATE_MACHINE", TASK_STATE_MACHINE_STACK_SIZE, NULL, TASK_STATE_MACHINE_PRIORITY, NULL) != pdPASS) {
 		printf("TaskStateMachine could not be created.\n");
 		return 0;
 	}
 
-	if (xTaskCreate(taskPOINTS, (const char * const) "TaskPOINTS", TASK_POINTS_STACK_SIZE, NULL, TASK_POINTS_PRIORITY, NULL) != pdPASS) {
-		printf("TaskPOINTS could not be created.\n");
-		return 0;
-	}
-
-	if (xTaskCreate(taskDATE, (const char * const) "TaskDATE", TASK_DATE_STACK_SIZE, NULL, TASK_DATE_PRIORITY, NULL) != pdPASS) {
+	if (RTOS_TaskCreate(taskDATE, taskDATE, (const char * const) "TaskDATE", TASK_DATE_STACK_SIZE, NULL, TASK_DATE_PRIORITY, &handleDATE) != pdPASS) {
 		printf("TaskDATE could not be created.\n");
 		return 0;
 	}
 
-	if (xTaskCreate(taskSCORE_COUNT, (const char * const) "TaskSCORE_COUNT", TASK_SCORE_COUNT_STACK_SIZE, NULL, TASK_SCORE_COUNT_PRIORITY, NULL) != pdPASS) {
+	if (RTOS_TaskCreate(taskSCORE_COUNT, taskSCORE_COUNT, (const char * const) "TaskSCORE_COUNT", TASK_SCORE_COUNT_STACK_SIZE, NULL, TASK_SCORE_COUNT_PRIORITY, NULL) != pdPASS) {
 		printf("TaskSCORE_COUNT could not be created.\n");
 		return 0;
 	}
 
-	if (xTaskCreate(taskUPDATE_GAME, (const char * const) "TaskUPDATE_GAME", TASK_UPDATE_GAME_STACK_SIZE, NULL, TASK_UPDATE_GAME_PRIORITY, NULL) != pdPASS) {
+	if (RTOS_TaskCreate(taskUPDATE_GAME, taskUPDATE_GAME, (const char * const) "TaskUPDATE_GAME", TASK_UPDATE_GAME_STACK_SIZE, NULL, TASK_UPDATE_GAME_PRIORITY, NULL) != pdPASS) {
 		printf("TaskUPDATE_GAME could not be created.\n");
 		return 0;
 	}
 
-	if (xTaskCreate(taskFUEL, (const char * const) "TaskFUEL", TASK_FUEL_STACK_SIZE, NULL, TASK_FUEL_PRIORITY, NULL) != pdPASS) {
-		printf("TaskFUEL could not be created.\n");
-		return 0;
-	}
-
-	if (xTaskCreate(taskBLINK, (const char * const) "TaskBLINK", TASK_BLINK_STACK_SIZE, NULL, TASK_BLINK_PRIORITY, NULL) != pdPASS) {
+	if (RTOS_TaskCreate(taskBLINK, taskBLINK, (const char * const) "TaskBLINK", TASK_BLINK_STACK_SIZE, NULL, TASK_BLINK_PRIORITY, NULL) != pdPASS) {
 		printf("TaskBLINK could not be created.\n");
 		return 0;
 	}
 
-	if (xTaskCreate(taskNETWORK_MANAGER, (const char * const) "TaskNETWORK_MANAGER", TASK_NETWORK_MANAGER_STACK_SIZE, NULL, TASK_NETWORK_MANAGER_PRIORITY, NULL) != pdPASS) {
+	if (RTOS_TaskCreate(taskNETWORK_MANAGER, taskNETWORK_MANAGER, (const char * const) "TaskNETWORK_MANAGER", TASK_NETWORK_MANAGER_STACK_SIZE, NULL, TASK_NETWORK_MANAGER_PRIORITY, NULL) != pdPASS) {
 		printf("TaskNETWORK_MANAGER could not be created.\n");
 		return 0;
 	}
 
+	RTC_SetInterrupt(ISEC, dateTick); // Clock display follows the RTC, once per second
+
 	/**
 	 * Start
 	 */
@@ -255,19 +228,27 @@ void taskSTATE_MACHINE(void *pvParameters) {
 		username[i] = 'a';
 	}
 	username[NAME_LENGTH] = '\0';
+
+	calibrateFrameRate();
+	LCDText_Clear();
+
 	getUsername();
 
 	for (;;) {
 		LCDText_Clear();
 		switch (state) {
 			case STATE_IDLE:
+				dateSubscribe();
 				idle();
+				dateUnsubscribe();
 				break;
 			case STATE_CONFIG:
 				config();
 				break;
 			case STATE_CONFIG_DATE:
+				dateSubscribe();
 				timeConfig();
+				dateUnsubscribe();
 				state = STATE_CONFIG;
 				break;
 			case STATE_CONFIG_ERASE_SCORES:
@@ -294,80 +275,37 @@ void taskSTATE_MACHINE(void *pvParameters) {
 				state = STATE_IDLE;
 				break;
 		}
-	}
-
-	vTaskDelete(NULL);
-}
 
-/**
- * Increment variable points each POINTS_RATE ms, all the time.
- */
-void taskPOINTS(void *pvParameters) {
-	for (;;) {
-		WAIT_SYS_Ms(POINTS_RATE); // Delay of 1 second
-		xSemaphoreTake(semPOINTS, portMAX_DELAY);
-		points++; // Increment points.
-		xSemaphoreGive(semPOINTS);
+		if (STACK_REPORT) reportStackUsage();
 	}
 
 	vTaskDelete(NULL);
 }
 
 /**
- * Decrement variable fuel each FUEL_RATE ms, all the time.
- */
-void taskFUEL(void *pvParameters) {
-	for (;;) {
-		WAIT_SYS_Ms(FUEL_RATE); // Delay of 1 second
-		xSemaphoreTake(semFUEL, portMAX_DELAY);
-		fuel--; // Increment points.
-		xSemaphoreGive(semFUEL);
-	}
-
-	vTaskDelete(NULL);
-}
-
-/**
- * Put the most recent Date Time Strings Structure in queueDATE
+ * Woken by dateTick() (once per second) or dateRefresh(). Rewrites only the fields that changed since last time,
+ * and overwrites queueDATE with the result.
  */
 void taskDATE(void *pvParameters) {
-	DATE_TIME dateTimeStr;
+	DATE_TIME dateTimeStr = {.date = "      /  /    ", .time = "  :  :  "};
+	struct tm shown = {.tm_sec = -1, .tm_min = -1, .tm_hour = -1, .tm_mday = -1, .tm_mon = -1, .tm_year = -1, .tm_wday = -1};
 	struct tm dateTime; // Structure in which RTC time will be written
 
 	for (;;) {
-		RTC_GetValue(&dateTime); // Write RTC time to structure
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-		char dayOfWeek[4];
-		switch(dateTime.tm_wday) {
-			case 0:
-				strcpy(dayOfWeek, "Sun");
-				break;
-			case 1:
-				strcpy(dayOfWeek, "Mon");
-				break;
-			case 2:
-				strcpy(dayOfWeek, "Tue");
-				break;
-			case 3:
-				strcpy(dayOfWeek, "Wed");
-				break;
-			case 4:
-				strcpy(dayOfWeek, "Thu");
-				break;
-			case 5:
-				strcpy(dayOfWeek, "Fri");
-				break;
-			case 6:
-				strcpy(dayOfWeek, "Sat");
-				break;
-		}
+		RTC_GetValue(&dateTime); // Write RTC time to structure
 
-		sprintf(dateTimeStr.date, "%s %02d/%02d/%04d", dayOfWeek, dateTime.tm_mday, dateTime.tm_mon + 1, dateTime.tm_year + 1900);
-		//strftime(dateTimeStr.date, LCD_DISPLAY_COLUMNS, "%a %d/%m/%Y", &dateTime); // Send structure information to the buffer
+		if (dateTime.tm_wday != shown.tm_wday) memcpy(&dateTimeStr.date[0], daysOfWeek[dateTime.tm_wday % 7], 3);
+		if (dateTime.tm_mday != shown.tm_mday) putDigits(&dateTimeStr.date[4], dateTime.tm_mday, 2);
+		if (dateTime.tm_mon != shown.tm_mon) putDigits(&dateTimeStr.date[7], dateTime.tm_mon + 1, 2);
+		if (dateTime.tm_year != shown.tm_year) putDigits(&dateTimeStr.date[10], dateTime.tm_year + 1900, 4);
+		if (dateTime.tm_hour != shown.tm_hour) putDigits(&dateTimeStr.time[0], dateTime.tm_hour, 2);
+		if (dateTime.tm_min != shown.tm_min) putDigits(&dateTimeStr.time[3], dateTime.tm_min, 2);
+		if (dateTime.tm_sec != shown.tm_sec) putDigits(&dateTimeStr.time[6], dateTime.tm_sec, 2);
+		shown = dateTime;
 
-		sprintf(dateTimeStr.time, "%02d:%02d:%02d", dateTime.tm_hour, dateTime.tm_min, dateTime.tm_sec);
-		//strftime(dateTimeStr.time, LCD_DISPLAY_COLUMNS, "%H:%M:%S", &dateTime);
-		xQueueOverwrite(queueDATE, &dateTimeStr); // Block if not in Idle state
+		xQueueOverwrite(queueDATE, &dateTimeStr);
 	}
 
 	vTaskDelete(NULL);
@@ -400,20 +338,25 @@ void taskBLINK(void * pvParameters) {
 }
 
 /**
- * Update game. This is called every GAME_RATE ms.
+ * Update game. This is called every GAME_RATE ms: simulation step, then render.
  */
 void taskUPDATE_GAME(void * pvParameters) {
 	/*
-	 * Car:
+	 * Car (this frame, and last frame):
 	 */
-	CAR car;
+	CAR car, previous;
 
 	/*
-	 * Array that represents all current obstacles in LCD DDRAM
+	 * Bitmasks of all current obstacles and fuel galleons in LCD DDRAM
 	 */
-	int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH];
+	GAME_MAP map;
 
-	int currentFuelCol;
+	int currentFuelCol = 1, previousFuelCol;
+
+	/*
+	 * Next point, and next fuel decrement (ticks), set by the init frame that starts every game:
+	 */
+	TickType_t nextPoint = 0, nextFuel = 0;
 
 	GAME_INFO info;
 
@@ -423,66 +366,89 @@ void taskUPDATE_GAME(void * pvParameters) {
 
 		if (info.init) {
 			/*
-			 * Reset points:
-			 */
-			xSemaphoreTake(semPOINTS, portMAX_DELAY);
-			points = 1;
-			xSemaphoreGive(semPOINTS);
-
-			/*
-			 * Reset fuel:
+			 * Reset game state:
 			 */
-			xSemaphoreTake(semFUEL, portMAX_DELAY);
-			fuel = MAX_FUEL;
-			xSemaphoreGive(semFUEL);
+			gameState.points = 1;
+			gameState.fuel = MAX_FUEL;
+			gameState.ended = false;
+			nextPoint = xTaskGetTickCount() + pdMS_TO_TICKS(POINTS_RATE);
+			nextFuel = xTaskGetTickCount() + pdMS_TO_TICKS(FUEL_RATE);
 
 			car.row = 1;
-			car.last_row = 1;
 			car.front_column = CAR_POSITION + 1;
 			car.back_column = CAR_POSITION;
-			memset(map, 0, sizeof(map));
+			memset(&map, 0, sizeof(map));
 			currentFuelCol = 1;
 
-			randomiseObstacles(INITIAL_OBSTACLE_GAP, LCD_DDRAM_LENGTH, map); // Randomise obstacles
-			randomiseFuel(INITIAL_OBSTACLE_GAP, LCD_DDRAM_LENGTH, map); // Randomise fuel gallons
+			LEVEL_Restart();
+			const LEVEL_SEGMENT *first = LEVEL_Swap(gameState.points); // Last 20 are placed below
+			mergeSegment(1, &map, first);
+			drawSegment(1, first);
+			clearColumns(1, INITIAL_OBSTACLE_GAP, &map);
 		}
+		else if (gameState.ended) {
+			continue; // Queued before game() saw the end: the score is saved, and must stay as it was
+		}
+
+		/*
+		 * Simulation step:
+		 */
+
+		previous = car;
+		previousFuelCol = currentFuelCol;
 
-		// Update row:
-		car.last_row = car.row;
-		car.row = info.row;
+		// Points and fuel tank, as game time goes by:
+		TickType_t now = xTaskGetTickCount();
+		for (; (int32_t) (now - nextPoint) >= 0; nextPoint += pdMS_TO_TICKS(POINTS_RATE)) {
+			gameState.points++;
+		}
+		for (; (int32_t) (now - nextFuel) >= 0; nextFuel += pdMS_TO_TICKS(FUEL_RATE)) {
+			if (gameState.fuel > 0) gameState.fuel--;
+		}
 
 		// Refresh obstacles and fuel galleons:
+		const LEVEL_SEGMENT *segment = NULL;
+		int segmentFrom = 0;
 		if (car.back_column == CAR_POSITION + (LCD_DDRAM_LENGTH/2)) { // If display is showing [21, 36]
 			// Refresh first 20:
-			randomiseObstacles(1, LCD_DDRAM_LENGTH/2, map);
-			randomiseFuel(1, LCD_DDRAM_LENGTH/2, map);
+			segmentFrom = 1;
+			segment = LEVEL_Swap(gameState.points);
 		}
 		if (car.back_column == CAR_POSITION) { // If display is showing [1, 16]
 			// Refresh last 20:
-			randomiseObstacles((LCD_DDRAM_LENGTH/2) + 1, LCD_DDRAM_LENGTH, map);
-			randomiseFuel((LCD_DDRAM_LENGTH/2) + 1, LCD_DDRAM_LENGTH, map);
+			segmentFrom = (LCD_DDRAM_LENGTH/2) + 1;
+			segment = LEVEL_Swap(gameState.points);
 		}
+		if (segment != NULL) mergeSegment(segmentFrom, &map, segment);
 
-		// Shift car:
-		shiftCar(&car);
+		// Move car (row, and 1 column right):
+		moveCar(&car, info.row);
 
-		// Shift fuel indicator:
-		shiftFuelIndicator(&currentFuelCol);
-
-		// Shift display:
-		LCDText_ShiftDisplay(LEFT);
+		// Move fuel indicator:
+		if (++currentFuelCol > LCD_DDRAM_LENGTH) currentFuelCol = 1;
 
 		// Check if a fuel gallon was grabed:
-		checkForFuelGrab(&car, map);
+		checkForFuelGrab(&car, &map);
 
 		// Verify if car hit an obstacle:
-		if (checkForLoss(&car, map)) {
-			xSemaphoreTake(semGAME_END, portMAX_DELAY);
-			gameEnd = true;
-			xSemaphoreGive(semGAME_END);
-			SCORE_Save(points, username);
+		bool lost = checkForLoss(&car, &map);
+
+		/*
+		 * Render:
+		 */
+
+		if (segment != NULL) drawSegment(segmentFrom, segment);
+		drawCar(&previous, &car);
+		drawFuelIndicator(previousFuelCol, currentFuelCol);
+		LCDText_ShiftDisplay(LEFT);
+
+		if (lost) {
+			gameState.ended = true;
+			SCORE_Save(gameState.points, username);
 			explodeCar(&car);
 		}
+
+		recordFrameBusy(portGET_RUN_TIME_COUNTER_VALUE() - info.time, info.period);
 	}
 
 	vTaskDelete(NULL);
@@ -584,6 +550,35 @@ void getUsername(void) {
 ===========================================================================================================================================================
 */
 
+void putDigits(char *at, int value, int digits) {
+	while (digits-- > 0) {
+		at[digits] = '0' + (value % 10);
+		value /= 10;
+	}
+}
+
+void dateTick(void) {
+	if (dateSubscribers == 0) return; // Nobody is showing the clock
+
+	BaseType_t woken = pdFALSE;
+	vTaskNotifyGiveFromISR(handleDATE, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+void dateSubscribe(void) {
+	dateSubscribers++;
+	xQueueReset(queueDATE); // Whatever is there may be stale: wait for taskDATE
+	dateRefresh();
+}
+
+void dateUnsubscribe(void) {
+	if (dateSubscribers > 0) dateSubscribers--;
+}
+
+void dateRefresh(void) {
+	xTaskNotifyGive(handleDATE);
+}
+
 void printDateTime(RTC_TIME_FIELD without) {
 	DATE_TIME dateTime;
 	xQueuePeek(queueDATE, &dateTime, portMAX_DELAY);
@@ -779,143 +774,108 @@ void printToCol(int col, unsigned char c1, unsigned char c2) {
 	LCDText_WriteChar(c2);
 }
 
-void shiftFuelIndicator(int * currentFuelCol) {
+void drawFuelIndicator(int previousCol, int col) {
 	// Erase current fuel indicator:
-	LCDText_Locate(1, *currentFuelCol);
-	LCDText_WriteChar(' ');
-	LCDText_Locate(2, *currentFuelCol);
-	LCDText_WriteChar(' ');
-
-	// Increment fuel indicator position:
-	if (++*currentFuelCol > LCD_DDRAM_LENGTH) *currentFuelCol = 1;
+	printToCol(previousCol, ' ', ' ');
 
 	// Print fuel indicator to LCD:
-	switch(fuel) {
+	switch(gameState.fuel) {
 		case 8:
-			printToCol(*currentFuelCol, FUEL4_CHAR, FUEL4_CHAR);
+			printToCol(col, FUEL4_CHAR, FUEL4_CHAR);
 			break;
 		case 7:
-			printToCol(*currentFuelCol, FUEL3_CHAR, FUEL4_CHAR);
+			printToCol(col, FUEL3_CHAR, FUEL4_CHAR);
 			break;
 		case 6:
-			printToCol(*currentFuelCol, FUEL2_CHAR, FUEL4_CHAR);
+			printToCol(col, FUEL2_CHAR, FUEL4_CHAR);
 			break;
 		case 5:
-			printToCol(*currentFuelCol, FUEL1_CHAR, FUEL4_CHAR);
+			printToCol(col, FUEL1_CHAR, FUEL4_CHAR);
 			break;
 		case 4:
-			printToCol(*currentFuelCol, ' ', FUEL4_CHAR);
+			printToCol(col, ' ', FUEL4_CHAR);
 			break;
 		case 3:
-			printToCol(*currentFuelCol, ' ', FUEL3_CHAR);
+			printToCol(col, ' ', FUEL3_CHAR);
 			break;
 		case 2:
-			printToCol(*currentFuelCol, ' ', FUEL2_CHAR);
+			printToCol(col, ' ', FUEL2_CHAR);
 			break;
 		case 1:
-			printToCol(*currentFuelCol, ' ', FUEL1_CHAR);
+			printToCol(col, ' ', FUEL1_CHAR);
 			break;
 		default:
-			printToCol(*currentFuelCol, ' ', ' ');
+			printToCol(col, ' ', ' ');
 			break;
 	}
 }
 
-void shiftCar(CAR *car) {
-	// Erase current car:
-	LCDText_Locate(car->last_row, car->back_column);
-	LCDText_WriteChar(' ');
-	LCDText_Locate(car->last_row, car->front_column);
-	LCDText_WriteChar(' ');
+void moveCar(CAR *car, int row) {
+	car->row = row;
 
 	// Increment car position:
 	if (++car->back_column > LCD_DDRAM_LENGTH) car->back_column = 1;
 	if (++car->front_column > LCD_DDRAM_LENGTH) car->front_column = 1;
+}
+
+void drawCar(const CAR *previous, const CAR *car) {
+	// Erase car:
+	LCDText_Locate(previous->row, previous->back_column);
+	LCDText_WriteChar(' ');
+	LCDText_Locate(previous->row, previous->front_column);
+	LCDText_WriteChar(' ');
 
 	// Write car:
 	LCDText_Locate(car->row, car->back_column);
 	LCDText_WriteChar(CAR_BACK_CHAR);
 	LCDText_Locate(car->row, car->front_column);
 	LCDText_WriteChar(CAR_FRONT_CHAR);
-
-	// Update last_row:
-	car->last_row = car->row;
 }
 
-void randomiseFuel(int from, int to, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]) {
-	int gaps[LCD_DDRAM_LENGTH] = {0};
-	int ct = 0;
-	for (int i = from; i <= to; i++) {
-		if ((map[0][i-1] == 0) && (map[1][i-1] == 0)) {
-			gaps[ct++] = i-1;
-		}
-	}
-	srand(RTC_GetSeconds()); // Set randomiser seed to RTC time_t value
-
-	int col = gaps[rand()%ct];
-	int row = rand()%2;
+void mergeSegment(int from, GAME_MAP *map, const LEVEL_SEGMENT *segment) {
+	uint64_t range = MAP_RANGE(from, from + LEVEL_SEGMENT_LENGTH - 1);
 
-	// Write obstacle in LCD:
-	LCDText_Locate(row+1, col+1);
-	LCDText_WriteChar(FUEL_CHAR);
-
-	map[row][col] = 2;
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		map->obstacles[row] = (map->obstacles[row] & ~range) | ((uint64_t) segment->obstacles[row] << (from - 1));
+		map->fuel[row] = (map->fuel[row] & ~range) | ((uint64_t) segment->fuel[row] << (from - 1));
+	}
 }
 
-void randomiseObstacles(int from, int to, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]) {
-	for (int i = from; i <= to; i++) {
-		// Erase obstacles from array of obstacles:
-		map[0][i-1] = 0;
-		map[1][i-1] = 0;
-
-		// Erase obstacles from LCD:
-		LCDText_Locate(1, i);
-		LCDText_WriteChar(' ');
-		LCDText_Locate(2, i);
-		LCDText_WriteChar(' ');
+void drawSegment(int from, const LEVEL_SEGMENT *segment) {
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		LCDText_Locate(row + 1, from);
+		LCDText_WriteString((char *) segment->text[row]);
 	}
-	srand(RTC_GetSeconds()); // Set randomiser seed to RTC time_t value
-
-	// Randomise first column:
-	int col = from;
-	col += rand()%3+3; // Always leave a space of 2-4 columns between each obstacle
-
-	int row;
+}
 
-	while(col <= to) {
-		// Randomise row:
-		row = rand()%2+1;
+void clearColumns(int from, int to, GAME_MAP *map) {
+	char blank[LCD_DDRAM_LENGTH + 1];
+	memset(blank, ' ', to - from + 1);
+	blank[to - from + 1] = '\0';
 
-		// Write obstacle in LCD:
-		LCDText_Locate(row, col);
-		LCDText_WriteChar(BARRIER_CHAR);
-		// Write obstacle in array of obstacles:
-		map[row-1][col-1] = 1;
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		// Erase obstacles (and fuel) from map:
+		map->obstacles[row] &= ~MAP_RANGE(from, to);
+		map->fuel[row] &= ~MAP_RANGE(from, to);
 
-		// Randomise next column:
-		col += rand()%3+3; // Always leave a space of 2-4 columns between each obstacle
+		// Erase obstacles from LCD:
+		LCDText_Locate(row + 1, from);
+		LCDText_WriteString(blank);
 	}
 }
 
-void checkForFuelGrab(CAR *car, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]) {
-	if ((map[car->row-1][car->back_column-1] == 2)) {
-		xSemaphoreTake(semFUEL, portMAX_DELAY);
-		fuel += 3;
-		if (fuel > MAX_FUEL) fuel = MAX_FUEL;
-		map[car->row-1][car->back_column-1] = 0;
-		xSemaphoreGive(semFUEL);
-	}
-	else if ((map[car->row-1][car->front_column-1] == 2)) {
-		xSemaphoreTake(semFUEL, portMAX_DELAY);
-		fuel += 3;
-		if (fuel > MAX_FUEL) fuel = MAX_FUEL;
-		map[car->row-1][car->front_column-1] = 0;
-		xSemaphoreGive(semFUEL);
+void checkForFuelGrab(CAR *car, GAME_MAP *map) {
+	uint64_t grabbed = map->fuel[car->row-1] & (MAP_COLUMN(car->back_column) | MAP_COLUMN(car->front_column));
+
+	if (grabbed) {
+		if (grabbed & MAP_COLUMN(car->back_column)) grabbed = MAP_COLUMN(car->back_column); // One a frame: front one is next
+		gameState.fuel = (gameState.fuel + 3 > MAX_FUEL) ? MAX_FUEL : gameState.fuel + 3;
+		map->fuel[car->row-1] &= ~grabbed;
 	}
 }
 
-bool checkForLoss(CAR *car, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]) {
-	return (map[car->row-1][car->back_column-1] == 1) || (map[car->row-1][car->front_column-1] == 1) || (fuel <= 0);
+bool checkForLoss(CAR *car, GAME_MAP *map) {
+	return (map->obstacles[car->row-1] & (MAP_COLUMN(car->back_column) | MAP_COLUMN(car->front_column))) || (gameState.fuel == 0);
 }
 
 void explodeCar(CAR * car) {
@@ -939,31 +899,120 @@ void pregame(void) {
 }
 
 void game(void) {
-	AXIS axis;
-	GAME_INFO info = {.init = true, .row = 1};
+	GAME_INFO info = {.init = true, .row = 1, .period = GAME_SPEED_STRESS ? frameRateMin : GAME_RATE};
 
-	xSemaphoreTake(semGAME_END, portMAX_DELAY);
-	gameEnd = false;
-	xSemaphoreGive(semGAME_END);
+	memset(&frameStats, 0, sizeof(frameStats));
 
+	TickType_t wake = xTaskGetTickCount(); // Frames are due every period from here, whatever each one takes
+	uint32_t lastTime = portGET_RUN_TIME_COUNTER_VALUE();
+
+	// Reset here too, not only by the init frame: until taskUPDATE_GAME gets to it, the loop below would read the
+	// previous game's state (its points for the next period, and 'ended', which would stop this game at once).
+	// taskUPDATE_GAME is waiting for frames, so it is not writing them meanwhile.
+	gameState.points = 1;
+	gameState.fuel = MAX_FUEL;
+	gameState.ended = false;
+
+	// Queued ahead of every other frame, so game state is reset before anything else is simulated:
+	info.time = lastTime;
 	xQueueSend(queueUPDATE_GAME, &info, portMAX_DELAY);
 	info.init = false;
 
 	for (;;) {
-		WAIT_SYS_Ms(GAME_RATE);
-		if (gameEnd) break;
-		axis = ADXL_GetAxis();
-		if (axis.y < -INCLINATION_THRESHOLD) info.row = 1;
-		if (axis.y > INCLINATION_THRESHOLD) info.row = 2;
+		vTaskDelayUntil(&wake, pdMS_TO_TICKS(info.period));
+		info.time = portGET_RUN_TIME_COUNTER_VALUE();
+		recordFrameStart(info.time - lastTime, info.period, uxQueueMessagesWaiting(queueUPDATE_GAME) != 0); // Period waited
+		lastTime = info.time;
+		info.period = gamePeriod(gameState.points); // Next frame
+
+		if (gameState.ended) break;
+
+		// Input sampling:
+		sampleInput(&info);
+
 		xQueueSend(queueUPDATE_GAME, &info, portMAX_DELAY);
 	}
+
+	if (FRAME_STATS_DUMP || GAME_SPEED_STRESS) dumpFrameStats();
+}
+
+void calibrateFrameRate(void) {
+	CAR car = {.row = 1, .front_column = CAR_POSITION + 1, .back_column = CAR_POSITION};
+	LEVEL_SEGMENT blank;
+	uint32_t flush = 0;
+
+	memset(&blank, 0, sizeof(blank));
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		memset(blank.text[row], ' ', LEVEL_SEGMENT_LENGTH);
+	}
+
+	LCDText_Sync(); // Start with an empty LCD pipeline
+	for (int i = 0; i < CALIBRATION_FRAMES; i++) {
+		// Render a frame that refreshes a whole segment:
+		uint32_t start = portGET_RUN_TIME_COUNTER_VALUE();
+		drawSegment(1, &blank);
+		drawCar(&car, &car);
+		drawFuelIndicator(1, 1);
+		LCDText_ShiftDisplay(LEFT);
+		LCDText_Sync();
+		uint32_t elapsed = portGET_RUN_TIME_COUNTER_VALUE() - start;
+		if (elapsed > flush) flush = elapsed;
+	}
+
+	// In ms, rounded up:
+	frameRateMin = (flush * FRAME_FLUSH_HEADROOM + (FRAME_TIMER_HZ / 1000) - 1) / (FRAME_TIMER_HZ / 1000);
+	if (frameRateMin < GAME_RATE_MIN) frameRateMin = GAME_RATE_MIN;
+	if (frameRateMin > GAME_RATE) frameRateMin = GAME_RATE;
+}
+
+uint32_t gamePeriod(uint32_t points) {
+	if (GAME_SPEED_STRESS) return frameRateMin;
+
+	uint32_t speedup = (points / GAME_SPEED_POINTS) * GAME_RATE_STEP;
+	return (speedup < GAME_RATE - frameRateMin) ? GAME_RATE - speedup : frameRateMin;
+}
+
+void sampleInput(GAME_INFO *info) {
+	AXIS axis = ADXL_GetAxis();
+	if (axis.y < -INCLINATION_THRESHOLD) info->row = 1;
+	if (axis.y > INCLINATION_THRESHOLD) info->row = 2;
+}
+
+static void histogramAdd(uint32_t *histogram, uint32_t bin) {
+	histogram[(bin < FRAME_HISTOGRAM_BINS) ? bin : FRAME_HISTOGRAM_BINS - 1]++;
+}
+
+void recordFrameStart(uint32_t interval, uint32_t period, bool late) {
+	uint32_t expected = period * (FRAME_TIMER_HZ / 1000);
+	uint32_t jitter = (interval > expected) ? interval - expected : expected - interval;
+
+	frameStats.frames++;
+	if (late) frameStats.overruns++; // Previous frame not simulated yet
+	if (jitter > frameStats.maxJitter) frameStats.maxJitter = jitter;
+	histogramAdd(frameStats.jitter, jitter / (FRAME_TIMER_HZ / 1000));
+}
+
+void recordFrameBusy(uint32_t busy, uint32_t period) {
+	uint32_t expected = period * (FRAME_TIMER_HZ / 1000);
+
+	if (busy > frameStats.maxBusy) frameStats.maxBusy = busy;
+	histogramAdd(frameStats.busy, (busy * FRAME_BUSY_BINS_PER_PERIOD) / expected);
+}
+
+void dumpFrameStats(void) {
+	printf("frames %u overruns %u maxJitter %u maxBusy %u (1/%u ms)\n", (unsigned) frameStats.frames, (unsigned) frameStats.overruns,
+			(unsigned) frameStats.maxJitter, (unsigned) frameStats.maxBusy, (unsigned) (FRAME_TIMER_HZ / 1000));
+	printf("bin jitter(ms) busy(1/%u period)\n", (unsigned) FRAME_BUSY_BINS_PER_PERIOD);
+	for (int i = 0; i < FRAME_HISTOGRAM_BINS; i++) {
+		printf("%d %u %u\n", i, (unsigned) frameStats.jitter[i], (unsigned) frameStats.busy[i]);
+	}
 }
 
 void postgame(void) {
 	LCDText_Home();
 	LCDText_Printf("Game over. You");
 	LCDText_Locate(2, 1);
-	LCDText_Printf("scored %d!", points);
+	LCDText_Printf("scored %d!", (int) gameState.points);
 
 	BUTTON_WaitRelease(0);
 	BUTTON_Read();
@@ -1101,9 +1150,11 @@ void timeConfig(void) {
 		if ((push_events = BUTTON_GetButtonsReleaseEvents(&bitmap)) != 0) {
 			if (push_events & B1) { // Increment
 				RTC_IncrementField(timeFields[field]);
+				dateRefresh(); // Counters are stopped, so no tick will do it
 			}
 			else if (push_events & B2) { // Decrement
 				RTC_DecrementField(timeFields[field]);
+				dateRefresh();
 			}
 			else if (push_events & B3) { // Confirm value
 				if (++field > (TIME_CONFIG_FIELDS-1)) { // If it's the last field
@@ -1200,6 +1251,50 @@ bool yesOrNo(void(*f)(void)) {
 */
 
 
+/**
+ * Configured stack sizes, of every task in the application (and drivers).
+ */
+static const TASK_STACK stacks[] = {
+	{"TaskSTATE_MACHINE", TASK_STATE_MACHINE_STACK_SIZE},
+	{"TaskDATE", TASK_DATE_STACK_SIZE},
+	{"TaskSCORE_COUNT", TASK_SCORE_COUNT_STACK_SIZE},
+	{"TaskUPDATE_GAME", TASK_UPDATE_GAME_STACK_SIZE},
+	{"TaskBLINK", TASK_BLINK_STACK_SIZE},
+	{"TaskNETWORK_MANAGER", TASK_NETWORK_MANAGER_STACK_SIZE},
+	{"SCORE_SaveAndPublishTask", TASK_SCORE_STACK_SIZE},
+	{"LEVEL_GeneratorTask", TASK_LEVEL_STACK_SIZE},
+	{"LCD Writer Task", TASK_LCD_WRITER_STACK_SIZE},
+	{"ADXL Axis Task", TASK_ADXL_AXIS_STACK_SIZE},
+	{"SCORE Publisher Task", TASK_SCORE_PUBLISHER_STACK_SIZE},
+	{"IDLE", TASK_IDLE_STACK_SIZE}
+};
+
+#define STACKS (sizeof(stacks) / sizeof(stacks[0]))
+#define STACK_REPORT_MAX_TASKS 16
+
+void reportStackUsage(void) {
+	static TaskStatus_t status[STACK_REPORT_MAX_TASKS]; // Too big for the caller's stack
+	UBaseType_t count = uxTaskGetSystemState(status, STACK_REPORT_MAX_TASKS, NULL);
+	uint32_t total = 0, recommendedTotal = 0;
+
+	printf("task size used recommended (words)\n");
+	for (UBaseType_t i = 0; i < count; i++) {
+		uint32_t size = 0;
+		for (int j = 0; j < STACKS; j++) {
+			if (strncmp(status[i].pcTaskName, stacks[j].name, configMAX_TASK_NAME_LEN - 1) == 0) size = stacks[j].size;
+		}
+
+		uint32_t used = (size > status[i].usStackHighWaterMark) ? size - status[i].usStackHighWaterMark : 0;
+		uint32_t recommended = (used * (100 + STACK_MARGIN_PERCENT) + 99) / 100;
+		recommended = (recommended + STACK_ROUND_WORDS - 1) / STACK_ROUND_WORDS * STACK_ROUND_WORDS;
+
+		printf("%s %u %u %u\n", status[i].pcTaskName, (unsigned) size, (unsigned) used, (unsigned) recommended);
+		total += size;
+		recommendedTotal += recommended;
+	}
+	printf("total %u recommended %u (words)\n", (unsigned) total, (unsigned) recommendedTotal);
+}
+
 /*-----------------------------------------------------------*/
 
 void vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName) {
@@ -1212,6 +1307,26 @@ void vApplicationStackOverflowHook(TaskHandle_t pxTask, char *pcTaskName) {
 }
 /*-----------------------------------------------------------*/
 
+void vApplicationMallocFailedHook(void) {
+	/* This function will get called if pvPortMalloc() runs out of heap. */
+
+	for( ;; );
+}
+/*-----------------------------------------------------------*/
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize) {
+	/* Idle task is created by the scheduler, from these buffers. */
+	static StaticTask_t taskIDLETcb;
+	static StackType_t taskIDLEStack[TASK_IDLE_STACK_SIZE];
+
+	*ppxIdleTaskTCBBuffer = &taskIDLETcb;
+	*ppxIdleTaskStackBuffer = taskIDLEStack;
+	*pulIdleTaskStackSize = TASK_IDLE_STACK_SIZE;
+}
+/*-----------------------------------------------------------*/
+#endif
+
 /*-----------------------------------------------------------*/
 
 void vConfigureTimerForRunTimeStats(void) {
@@ -1235,7 +1350,7 @@ void vConfigureTimerForRunTimeStats(void) {
 
 	/* Prescale to a frequency that is good enough to get a decent resolution,
 	but not too fast so as to overflow all the time. */
-	LPC_TIM1->PR =  ( configCPU_CLOCK_HZ / 10000UL ) - 1UL;
+	LPC_TIM1->PR =  ( configCPU_CLOCK_HZ / FRAME_TIMER_HZ ) - 1UL;
 
 	/* Start the counter. */
 	LPC_TIM1->TCR = TCR_COUNT_ENABLE;
@@ -0,0 +1,173 @@
+/*
+ * level.c
+ *
+ *  Created on: Oct 2026
+ *      Author: pedro
+ */
+
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#endif
+
+
+#include "level.h"
+
+
+/**
+ * Given by the generator when the back segment is ready.
+ */
+static SemaphoreHandle_t semLEVEL_READY = NULL;
+
+static TaskHandle_t taskLEVEL = NULL;
+
+RTOS_TASK_STORAGE(taskLEVEL, TASK_LEVEL_STACK_SIZE);
+RTOS_SEMAPHORE_STORAGE(semLEVEL_READY);
+
+
+/**
+ * Difficulty curve, easiest first. Last step holds for ever.
+ */
+static const LEVEL_STEP steps[] = {
+	{3, 5, 100},
+	{3, 4, 100},
+	{2, 4, 100},
+	{2, 4, 75},
+	{2, 3, 75},
+	{2, 3, 50}
+};
+
+#define LEVEL_STEPS (sizeof(steps) / sizeof(steps[0]))
+
+#define LEVEL_SEGMENT_MASK ((1UL << LEVEL_SEGMENT_LENGTH) - 1)
+
+
+static LEVEL_SEGMENT segments[2];
+static LEVEL_SEGMENT * volatile back = &segments[0]; // Segment owned by the generator
+
+static volatile uint32_t nextPoints = 0; // Points setting the difficulty of the segment generated next
+static volatile bool restart = true; // Next segment starts a new road
+
+static uint32_t lastColumn[LCD_DISPLAY_ROWS]; // Obstacles in last column of previous segment (bit 0)
+
+static char obstacle = '#';
+static char fuel = '+';
+
+
+bool LEVEL_Init(char obstacleChar, char fuelChar) {
+	obstacle = obstacleChar;
+	fuel = fuelChar;
+
+	if ((semLEVEL_READY = RTOS_SemaphoreCreateBinary(semLEVEL_READY)) == NULL) {
+		printf("Semaphore LEVEL_READY could not be created.\n");
+		return false;
+	}
+
+	if (RTOS_TaskCreate(taskLEVEL, LEVEL_GeneratorTask, (const char * const) "LEVEL_GeneratorTask", TASK_LEVEL_STACK_SIZE, NULL, TASK_LEVEL_PRIORITY, &taskLEVEL) != pdPASS) {
+		printf("LEVEL_GeneratorTask could not be created.\n");
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Generator:
+ */
+
+static bool LEVEL_IsPassable(const LEVEL_SEGMENT * segment) {
+	uint32_t blocked = LEVEL_SEGMENT_MASK;
+
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		uint32_t columns = (segment->obstacles[row] << 1) | lastColumn[row]; // Bit 0 is previous segment's last column
+		blocked &= columns | (columns >> 1); // Car (2 columns) starting at bit k can't be in this row
+	}
+	return blocked == 0; // Some row is always free for the car
+}
+
+static uint32_t LEVEL_PickColumn(PRNG_STATE * rng, uint32_t columns) { // Random set bit of columns (not 0)
+	for (int n = PRNG_Range(rng, __builtin_popcount(columns)); n > 0; n--) {
+		columns &= columns - 1; // Drop lowest, until the chosen one is the lowest
+	}
+	return columns & -columns;
+}
+
+static void LEVEL_Generate(LEVEL_SEGMENT * segment, const LEVEL_STEP * step, PRNG_STATE * rng) {
+	int attempts = 0;
+
+	do {
+		memset(segment, 0, sizeof(LEVEL_SEGMENT));
+
+		for (int col = PRNG_Between(rng, step->minSpacing, step->maxSpacing); col < LEVEL_SEGMENT_LENGTH; col += PRNG_Between(rng, step->minSpacing, step->maxSpacing)) {
+			segment->obstacles[PRNG_Range(rng, LCD_DISPLAY_ROWS)] |= 1UL << col;
+		}
+	} while (!LEVEL_IsPassable(segment) && (++attempts < LEVEL_MAX_ATTEMPTS));
+
+	if (attempts == LEVEL_MAX_ATTEMPTS) { // Keep a row free
+		segment->obstacles[1] = 0;
+		if (!LEVEL_IsPassable(segment)) segment->obstacles[0] = 0; // Previous segment ends blocking row 2
+	}
+
+	if (PRNG_Range(rng, 100) < step->fuelChance) {
+		uint32_t gaps = LEVEL_SEGMENT_MASK & ~(segment->obstacles[0] | segment->obstacles[1]); // Columns with no obstacles in either row
+		if (gaps != 0) segment->fuel[PRNG_Range(rng, LCD_DISPLAY_ROWS)] = LEVEL_PickColumn(rng, gaps);
+	}
+
+	// Render segment:
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		for (int col = 0; col < LEVEL_SEGMENT_LENGTH; col++) {
+			if (segment->obstacles[row] & (1UL << col)) segment->text[row][col] = obstacle;
+			else if (segment->fuel[row] & (1UL << col)) segment->text[row][col] = fuel;
+			else segment->text[row][col] = ' ';
+		}
+		segment->text[row][LEVEL_SEGMENT_LENGTH] = '\0';
+
+		lastColumn[row] = segment->obstacles[row] >> (LEVEL_SEGMENT_LENGTH - 1);
+	}
+}
+
+void LEVEL_GeneratorTask(void *pvParameters) {
+	// Seeded once, from RTC and ADXL noise:
+	PRNG_STATE rng;
+	AXIS noise = ADXL_GetAxis();
+	PRNG_Seed(&rng, RTC_GetSeconds() ^ ((uint32_t) noise.x << 20) ^ ((uint32_t) noise.y << 10) ^ (uint32_t) noise.z);
+
+	for (;;) {
+		if (restart) {
+			restart = false;
+			memset(lastColumn, 0, sizeof(lastColumn)); // Road starts clear
+		}
+
+		uint32_t step = nextPoints / LEVEL_POINTS_PER_STEP;
+		if (step >= LEVEL_STEPS) step = LEVEL_STEPS - 1;
+
+		LEVEL_Generate(back, &steps[step], &rng);
+
+		xSemaphoreGive(semLEVEL_READY);
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Wait for segment to be taken
+	}
+
+	vTaskDelete(NULL);
+}
+
+/*
+ * Game side:
+ */
+
+void LEVEL_Restart(void) {
+	xSemaphoreTake(semLEVEL_READY, portMAX_DELAY); // Discard segment generated for the previous road
+	nextPoints = 0;
+	restart = true;
+	xTaskNotifyGive(taskLEVEL);
+}
+
+const LEVEL_SEGMENT * LEVEL_Swap(uint32_t points) {
+	xSemaphoreTake(semLEVEL_READY, portMAX_DELAY);
+
+	LEVEL_SEGMENT * ready = back;
+	back = (ready == &segments[0]) ? &segments[1] : &segments[0];
+
+	nextPoints = points;
+	xTaskNotifyGive(taskLEVEL);
+
+	return ready;
+}
@@ -18,22 +18,65 @@
  */
 static QueueHandle_t queueSCORE = NULL;
 
+/**
+ * Mutex to control access to the leaderboard (and memory device).
+ */
+static SemaphoreHandle_t semSCORE = NULL;
+
+RTOS_TASK_STORAGE(taskSCORE, TASK_SCORE_STACK_SIZE);
+RTOS_QUEUE_STORAGE(queueSCORE, SCORE_QUEUE_LENGTH, sizeof(Score));
+RTOS_SEMAPHORE_STORAGE(semSCORE);
+
 
 static MEMORY_DEVICE dev;
 
+static bool loaded = false; // Leaderboard was read from memory device
 
-bool SCORE_SaveLocally(int score, char * username);
+static uint16_t count; // Number of slots in use
+
+static uint8_t rank[SCORE_BOARD_SIZE]; // Slot of each placement, best first
+static uint8_t slotRank[SCORE_BOARD_SIZE]; // Placement of each slot
+static uint32_t slotScore[SCORE_BOARD_SIZE]; // Score of each slot
+static uint32_t slotHash[SCORE_BOARD_SIZE]; // User name hash of each slot
+
+static uint8_t nameIndex[SCORE_INDEX_SIZE]; // Open addressing table of (slot + 1), 0 if entry is empty
+
+static uint8_t * flashImage = NULL; // RAM image of the leaderboard, when using Flash
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+static uint8_t flashImageStorage[SCORE_FLASH_IMAGE_LENGTH] __attribute__((aligned(4))); // IAP copies from a word boundary
+#endif
+
+
+static int SCORE_SaveLocally(uint32_t score, char * username);
 
 
 bool SCORE_Init(MEMORY_DEVICE device) {
 	dev = device;
 
-	if (xTaskCreate(SCORE_SaveAndPublishTask, (const char * const) "SCORE_SaveAndPublishTask", TASK_SCORE_STACK_SIZE, NULL, TASK_SCORE_PRIORITY, NULL) != pdPASS) {
+	if (dev == FLASH) { // Flash can't be rewritten in place, so keep an image of the leaderboard to rewrite the sector
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+		flashImage = flashImageStorage;
+#else
+		if ((flashImage = pvPortMalloc(SCORE_FLASH_IMAGE_LENGTH)) == NULL) {
+			printf("Flash image for SCORE could not be allocated.\n");
+			return false;
+		}
+#endif
+		FLASH_Init(); // Vector table in RAM
+	}
+
+	if ((semSCORE = RTOS_SemaphoreCreateMutex(semSCORE)) == NULL) {
+		printf("Semaphore SCORE could not be created.\n");
+		return false;
+	}
+
+	if (RTOS_TaskCreate(taskSCORE, SCORE_SaveAndPublishTask, (const char * const) "SCORE_SaveAndPublishTask", TASK_SCORE_STACK_SIZE, NULL, TASK_SCORE_PRIORITY, NULL) != pdPASS) {
 		printf("SCORE_SaveAndPublishTask could not be created.\n");
 		return false;
 	}
 
-	if ((queueSCORE = xQueueCreate(8, sizeof(Score))) == NULL) {
+	if ((queueSCORE = RTOS_QueueCreate(queueSCORE, SCORE_QUEUE_LENGTH, sizeof(Score))) == NULL) {
 		printf("Queue for SCORE could not be created.\n");
 		return false;
 	}
@@ -41,76 +84,220 @@ bool SCORE_Init(MEMORY_DEVICE device) {
 	return true;
 }
 
-static void SCORE_FLASH_GetAll(Score * scores) {
-	memcpy(scores, (Score *)FLASH_START_ADDRESS_29, SCORE_NUM * sizeof(Score));
-}
+/*
+ * Memory device access:
+ */
 
-static void SCORE_EEPROM_GetAll(Score * scores) {
-	EEPROM_Read((char *)scores, SCORE_NUM * sizeof(Score));
+static int SCORE_ReadAt(int address, void * data, int size) {
+	switch(dev) {
+		case FLASH:
+			memcpy(data, (char *) FLASH_START_ADDRESS_29 + address, size);
+			return 0;
+		case EEPROM:
+			return EEPROM_ReadAt(address, (char *) data, size);
+	}
+	return -1;
 }
 
-static void SCORE_FLASH_SetAll(Score * scores) {
-	// Array of new scores to be written (FLASH):
-	Score toWrite[FLASH_MINIMAL_WRITE_SIZE/sizeof(Score)] = {0};
+static int SCORE_WriteAt(int address, void * data, int size) {
+	switch(dev) {
+		case FLASH:
+			memcpy(flashImage + address, data, size); // Written to the sector in SCORE_Commit()
+			return 0;
+		case EEPROM:
+			return EEPROM_WriteCached(address, (char *) data, size); // Written back in SCORE_Commit()
+	}
+	return -1;
+}
 
-	memcpy(toWrite, scores, SCORE_NUM * sizeof(Score));
+static void SCORE_Commit(void) {
+	if (dev == EEPROM) {
+		EEPROM_Flush(); // Write back cached pages
+		return;
+	}
 
 	// Erase sector before write:
 	FLASH_EraseSectors(FLASH_SECTOR, FLASH_SECTOR);
 
-	// Write updated scores:
-	FLASH_WriteData(FLASH_SECTOR, (void*) FLASH_START_ADDRESS_29, toWrite, FLASH_MINIMAL_WRITE_SIZE);
-	FLASH_VerifyData((void*) FLASH_START_ADDRESS_29, toWrite, FLASH_MINIMAL_WRITE_SIZE);
+	// Write updated leaderboard:
+	for (int i = 0; i < SCORE_FLASH_IMAGE_LENGTH; i += FLASH_MINIMAL_WRITE_SIZE) {
+		FLASH_WriteData(FLASH_SECTOR, (void*) (FLASH_START_ADDRESS_29 + i), flashImage + i, FLASH_MINIMAL_WRITE_SIZE);
+	}
+	FLASH_VerifyData((void*) FLASH_START_ADDRESS_29, flashImage, SCORE_FLASH_IMAGE_LENGTH);
 }
 
-static void SCORE_EEPROM_SetAll(Score * scores) {
-	EEPROM_Write((char *)scores, SCORE_NUM * sizeof(Score));
+static int SCORE_SlotAddress(int slot) {
+	return SCORE_SLOT_ADDRESS + slot * sizeof(Score);
 }
 
-int SCORE_Get(Score * score, int n) {
-	if ((n < 0) || (n > SCORE_NUM-1)) return -1;
+static void SCORE_WriteHeader(void) {
+	SCORE_BOARD_HEADER header = {.magic = SCORE_BOARD_MAGIC, .count = count, .capacity = SCORE_BOARD_SIZE};
+	SCORE_WriteAt(SCORE_HEADER_ADDRESS, &header, sizeof(SCORE_BOARD_HEADER));
+}
 
-	Score scores[SCORE_NUM] = {0};
+static void SCORE_WriteRanks(int from, int to) { // Persist placements [from, to]
+	if (from > to) return;
+	SCORE_WriteAt(SCORE_RANK_ADDRESS + from, &rank[from], to - from + 1);
+}
 
-	switch(dev) {
-		case FLASH:
-			SCORE_FLASH_GetAll(scores);
-			break;
-		case EEPROM:
-			SCORE_EEPROM_GetAll(scores);
-			break;
+/*
+ * User name index:
+ */
+
+static uint32_t SCORE_Hash(const char * username) { // FNV-1a
+	uint32_t hash = 2166136261u;
+	for (int i = 0; (i < NAME_LENGTH+1) && (username[i] != '\0'); i++) {
+		hash ^= (uint8_t) username[i];
+		hash *= 16777619u;
 	}
+	return hash;
+}
 
-	*score = scores[n];
+static void SCORE_IndexInsert(int slot) {
+	uint32_t i = slotHash[slot] & (SCORE_INDEX_SIZE - 1);
+	while (nameIndex[i] != 0) {
+		i = (i + 1) & (SCORE_INDEX_SIZE - 1);
+	}
+	nameIndex[i] = slot + 1;
+}
+
+static void SCORE_IndexRemove(int slot) {
+	uint32_t i = slotHash[slot] & (SCORE_INDEX_SIZE - 1);
+	while (nameIndex[i] != slot + 1) {
+		if (nameIndex[i] == 0) return; // Not indexed
+		i = (i + 1) & (SCORE_INDEX_SIZE - 1);
+	}
+
+	// Backward shift deletion, so no probe sequence is broken:
+	nameIndex[i] = 0;
+	uint32_t j = i;
+	for (;;) {
+		j = (j + 1) & (SCORE_INDEX_SIZE - 1);
+		if (nameIndex[j] == 0) break;
+		uint32_t home = slotHash[nameIndex[j] - 1] & (SCORE_INDEX_SIZE - 1);
+		if (((j > i) && ((home <= i) || (home > j))) || ((j < i) && (home <= i) && (home > j))) {
+			nameIndex[i] = nameIndex[j];
+			nameIndex[j] = 0;
+			i = j;
+		}
+	}
+}
+
+static int SCORE_IndexFind(const char * username, uint32_t hash) {
+	Score stored;
+	uint32_t i = hash & (SCORE_INDEX_SIZE - 1);
+	while (nameIndex[i] != 0) {
+		int slot = nameIndex[i] - 1;
+		if (slotHash[slot] == hash) { // Only read the slot if hash coincides
+			SCORE_ReadAt(SCORE_SlotAddress(slot), &stored, sizeof(Score));
+			if (strncmp(stored.name, username, NAME_LENGTH+1) == 0) return slot;
+		}
+		i = (i + 1) & (SCORE_INDEX_SIZE - 1);
+	}
+	return -1;
+}
+
+/*
+ * Rank list:
+ */
+
+static int SCORE_FindPlacement(uint32_t score, int size) { // First placement in [0, size) with a lower score
+	int low = 0;
+	int high = size;
+	while (low < high) {
+		int mid = (low + high) / 2;
+		if (slotScore[rank[mid]] >= score) low = mid + 1;
+		else high = mid;
+	}
+	return low;
+}
+
+static void SCORE_MoveSlot(int slot, int from, int to) { // Move slot from placement 'from' up to placement 'to' (to <= from)
+	for (int i = from; i > to; i--) {
+		rank[i] = rank[i-1];
+		slotRank[rank[i]] = i;
+	}
+	rank[to] = slot;
+	slotRank[slot] = to;
+}
+
+/*
+ * Leaderboard:
+ */
+
+static void SCORE_Load(void) {
+	SCORE_BOARD_HEADER header;
+	Score stored;
+
+	xSemaphoreTake(semSCORE, portMAX_DELAY);
+
+	if (dev == FLASH) {
+		memcpy(flashImage, (void *) FLASH_START_ADDRESS_29, SCORE_FLASH_IMAGE_LENGTH);
+	}
+
+	memset(nameIndex, 0, sizeof(nameIndex));
+	count = 0;
+
+	if ((SCORE_ReadAt(SCORE_HEADER_ADDRESS, &header, sizeof(SCORE_BOARD_HEADER)) < 0)
+			|| (header.magic != SCORE_BOARD_MAGIC) || (header.capacity != SCORE_BOARD_SIZE)) { // Format
+		SCORE_WriteHeader();
+		SCORE_Commit();
+	}
+	else {
+		count = (header.count > SCORE_BOARD_SIZE) ? SCORE_BOARD_SIZE : header.count;
+		SCORE_ReadAt(SCORE_RANK_ADDRESS, rank, count);
+		for (int i = 0; i < count; i++) {
+			int slot = rank[i];
+			SCORE_ReadAt(SCORE_SlotAddress(slot), &stored, sizeof(Score));
+			slotRank[slot] = i;
+			slotScore[slot] = stored.score;
+			slotHash[slot] = SCORE_Hash(stored.name);
+			SCORE_IndexInsert(slot);
+		}
+	}
+
+	loaded = true;
+
+	xSemaphoreGive(semSCORE);
+}
+
+int SCORE_Get(Score * score, int n) {
+	if ((n < 0) || (n > SCORE_BOARD_SIZE-1)) return -1;
+
+	memset(score, 0, sizeof(Score));
+
+	xSemaphoreTake(semSCORE, portMAX_DELAY);
+	if (loaded && (n < count)) {
+		SCORE_ReadAt(SCORE_SlotAddress(rank[n]), score, sizeof(Score));
+	}
+	xSemaphoreGive(semSCORE);
 
 	return 0;
 }
 
 void SCORE_Sort(Score * scores, int size) {
 	Score temp;
-	for (int i = 0; i < size-1; i++) {
-		for (int j = 0; j < size-i-1; j++) {
-			if (scores[j].score < scores[j+1].score) {
-				temp = scores[j];
-				scores[j] = scores[j+1];
-				scores[j+1] = temp;
-			}
+	for (int i = 1; i < size; i++) {
+		temp = scores[i];
+		int j = i - 1;
+		while ((j >= 0) && (scores[j].score < temp.score)) {
+			scores[j+1] = scores[j];
+			j--;
 		}
+		scores[j+1] = temp;
 	}
 }
 
 void SCORE_Erase(void) {
-	// Array of empty scores:
-	Score scores[SCORE_NUM] = {0};
+	xSemaphoreTake(semSCORE, portMAX_DELAY);
 
-	switch(dev) {
-		case FLASH:
-			SCORE_FLASH_SetAll(scores);
-			break;
-		case EEPROM:
-			SCORE_EEPROM_SetAll(scores);
-			break;
-	}
+	count = 0;
+	memset(nameIndex, 0, sizeof(nameIndex));
+
+	SCORE_WriteHeader();
+	SCORE_Commit();
+
+	xSemaphoreGive(semSCORE);
 }
 
 void SCORE_Save(uint32_t score, char * username) {
@@ -120,63 +307,65 @@ void SCORE_Save(uint32_t score, char * username) {
 	xQueueSend(queueSCORE, &scoreStruct, portMAX_DELAY);
 }
 
-bool SCORE_SaveLocally(int score, char * username) {
-	// Array of old scores to be read:
-	Score oldScores[SCORE_NUM] = {0};
+/*
+ * Returns placement of the score in leaderboard, or -1 if leaderboard was not changed.
+ */
+static int SCORE_SaveLocally(uint32_t score, char * username) {
+	if (score == 0) return -1; // Not a place on the leaderboard: printScore() shows a score of 0 as an empty one
 
-	// Array of new scores to be written:
-	Score newScores[SCORE_NUM] = {0};
+	Score scoreStruct;
+	strncpy(scoreStruct.name, username, NAME_LENGTH+1);
+	scoreStruct.score = score;
 
-	switch(dev) {
-		case FLASH:
-			SCORE_FLASH_GetAll(oldScores);
-			break;
-		case EEPROM:
-			SCORE_EEPROM_GetAll(oldScores);
-			break;
-	}
+	uint32_t hash = SCORE_Hash(username);
+	int slot = SCORE_IndexFind(username, hash);
+	int placement;
 
-	bool done = false;
-	int lowestScore = 0;
+	if (slot >= 0) { // If user name is registered...
+		if (slotScore[slot] >= score) return -1; // If the new score isn't better, no need to update memory
 
-	for (int i = 0; i < SCORE_NUM; i++) {
-		newScores[i] = oldScores[i];
-		if ((strncmp(newScores[i].name, username, NAME_LENGTH+1) == 0) && !done) { // If user name coincides...
-			if (newScores[i].score < score) { // If the new score is better...
-				newScores[i].score = score;
-				done = true;
-			}
-			else return false; // If not, return (no need to update flash)
-		}
-		else if ((newScores[i].score == 0) && !done) { // If there is space available...
-			strncpy(newScores[i].name, username, NAME_LENGTH+1);
-			newScores[i].score = score;
-			done = true;
-		}
-		if (newScores[i].score < newScores[lowestScore].score) {
-			lowestScore = i;
-		}
-	}
+		int from = slotRank[slot];
+		placement = SCORE_FindPlacement(score, from);
 
-	if (!done) { // If user name was not found, and there is no space available...
-		if (score > newScores[lowestScore].score) { // If score is higher than the lowest registered...
-			strncpy(newScores[lowestScore].name, username, NAME_LENGTH+1);
-			newScores[lowestScore].score = score;
-		}
+		slotScore[slot] = score;
+		SCORE_WriteAt(SCORE_SlotAddress(slot), &scoreStruct, sizeof(Score));
+
+		SCORE_MoveSlot(slot, from, placement);
+		SCORE_WriteRanks(placement, from);
+	}
+	else if (count < SCORE_BOARD_SIZE) { // If there is space available...
+		slot = count;
+		placement = SCORE_FindPlacement(score, count);
+
+		slotScore[slot] = score;
+		slotHash[slot] = hash;
+		SCORE_WriteAt(SCORE_SlotAddress(slot), &scoreStruct, sizeof(Score));
+		SCORE_IndexInsert(slot);
+
+		SCORE_MoveSlot(slot, count, placement);
+		count++;
+		SCORE_WriteRanks(placement, count - 1);
+		SCORE_WriteHeader();
 	}
+	else { // If user name was not found, and there is no space available...
+		slot = rank[count - 1];
+		if (slotScore[slot] >= score) return -1; // If score isn't higher than the lowest registered
 
-	SCORE_Sort(newScores, SCORE_NUM);
+		placement = SCORE_FindPlacement(score, count - 1);
 
-	switch(dev) {
-		case FLASH:
-			SCORE_FLASH_SetAll(newScores);
-			break;
-		case EEPROM:
-			SCORE_EEPROM_SetAll(newScores);
-			break;
+		SCORE_IndexRemove(slot); // Reuse lowest score's slot
+		slotScore[slot] = score;
+		slotHash[slot] = hash;
+		SCORE_WriteAt(SCORE_SlotAddress(slot), &scoreStruct, sizeof(Score));
+		SCORE_IndexInsert(slot);
+
+		SCORE_MoveSlot(slot, count - 1, placement);
+		SCORE_WriteRanks(placement, count - 1);
 	}
 
-	return true;
+	SCORE_Commit();
+
+	return placement;
 }
 
 void SCORE_SaveAndPublishTask(void *pvParameters) {
@@ -184,12 +373,18 @@ void SCORE_SaveAndPublishTask(void *pvParameters) {
 		EEPROM_Init();
 	}
 
+	SCORE_Load();
+
 	Score score;
 
 	for (;;) {
 		xQueueReceive(queueSCORE, &score, portMAX_DELAY);
 
-		if (SCORE_SaveLocally(score.score, score.name)) { // If score is on top 3:
+		xSemaphoreTake(semSCORE, portMAX_DELAY);
+		int placement = SCORE_SaveLocally(score.score, score.name);
+		xSemaphoreGive(semSCORE);
+
+		if ((placement >= 0) && (placement < SCORE_NUM)) { // If score is on the podium:
 			NETWORK_PublishScore(score.score);
 		}
 	}
@@ -30,6 +30,7 @@
 	#include "FreeRTOS.h"
 	#include "task.h"
 	#include "queue.h"
+	#include "rtos_alloc.h"
 #endif
 
 
@@ -57,12 +58,18 @@ typedef struct {
 	 * @brief	Stack size of ADXL Axis task.
 	 * @brief	Only needed in FreeRTOS environment.
 	 */
-	#define TASK_ADXL_AXIS_STACK_SIZE configMINIMAL_STACK_SIZE*0.5
+	#define TASK_ADXL_AXIS_STACK_SIZE configMINIMAL_STACK_SIZE/2
 	/**
 	 * @brief	Priority of ADXL Axis task.
 	 * @brief	Only needed in FreeRTOS environment.
 	 */
 	#define TASK_ADXL_AXIS_PRIORITY tskIDLE_PRIORITY + 1
+
+	/**
+	 * @brief	Number of samples kept by ADXL Axis task (latest only).
+	 * @brief	Only needed in FreeRTOS environment.
+	 */
+	#define ADXL_QUEUE_LENGTH 1
 #endif
 
 
@@ -0,0 +1,158 @@
+/*
+* @file		clock.h
+* @brief	Contains the clock API (CPU clock profiles and peripheral clocks).
+* @version	1.0
+* @date		Oct 2026
+* @author	PedroG
+*
+* Copyright(C) 2020-2025, PedroG
+* All rights reserved.
+*/
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+/** @defgroup CLOCK CLOCK
+ * This package owns the CPU clock (PLL0 and CCLKCFG) and the peripheral clocks (PCLKSEL0 and PCLKSEL1).
+ *
+ * SystemInit() starts with CLOCK_FULL (100 MHz, as configured in system_LPC17xx.c). CLOCK_SetProfile() switches
+ * between named profiles, e.g. CLOCK_FULL while playing and CLOCK_REDUCED in menus, to save power while idle.
+ * Drivers whose dividers depend on their PCLK (UART baud, SPI clock, I2C2 SCL, timer prescalers, SysTick) register
+ * a handler with CLOCK_AddHandler() in their init, and recompute them when the profile changes. I2C1 needs none:
+ * it computes its SCL dividers for every transaction.
+ *
+ * Switch profiles while UART, SPI and I2C are idle: a byte on the wire during the switch is lost.
+ * @{
+ */
+
+/** @defgroup CLOCK_Public_Functions CLOCK Public Functions
+ * @{
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ *
+ *
+ * Constants:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Maximum number of change handlers.
+ */
+#define CLOCK_MAX_HANDLERS 8
+
+/**
+ * @brief	Main oscillator (PLL0 input) frequency, in Hz.
+ */
+#define CLOCK_OSCILLATOR 12000000
+
+/**
+ * @brief	CPU clock profiles.
+ */
+typedef enum
+{
+	CLOCK_FULL = 0, /*!< 100 MHz (PLL0 at 400 MHz, divided by 4), as after SystemInit(). */
+	CLOCK_REDUCED = 1 /*!< 24 MHz (PLL0 at 288 MHz, divided by 12). */
+} CLOCK_PROFILE;
+
+/**
+ * @brief	Peripherals, by their PCLKSEL field (PCLKSEL0 for 0 to 15, PCLKSEL1 for 16 to 31).
+ */
+typedef enum
+{
+	CLOCK_WDT = 0, /*!< Watchdog timer. */
+	CLOCK_TIMER0 = 1, /*!< Timer0. */
+	CLOCK_TIMER1 = 2, /*!< Timer1. */
+	CLOCK_UART0 = 3, /*!< UART0. */
+	CLOCK_UART1 = 4, /*!< UART1. */
+	CLOCK_PWM1 = 6, /*!< PWM1. */
+	CLOCK_I2C0 = 7, /*!< I2C0. */
+	CLOCK_SPI = 8, /*!< SPI. */
+	CLOCK_SSP1 = 10, /*!< SSP1. */
+	CLOCK_DAC = 11, /*!< DAC. */
+	CLOCK_ADC = 12, /*!< ADC. */
+	CLOCK_I2C1 = 19, /*!< I2C1. */
+	CLOCK_SSP0 = 21, /*!< SSP0. */
+	CLOCK_TIMER2 = 22, /*!< Timer2. */
+	CLOCK_TIMER3 = 23, /*!< Timer3. */
+	CLOCK_UART2 = 24, /*!< UART2. */
+	CLOCK_UART3 = 25, /*!< UART3. */
+	CLOCK_I2C2 = 26, /*!< I2C2. */
+	CLOCK_RIT = 29 /*!< Repetitive interrupt timer. */
+} CLOCK_PERIPHERAL;
+
+/**
+ * @brief	Peripheral clock dividers (PCLK = CCLK / divider), as PCLKSEL field values.
+ */
+typedef enum
+{
+	CLOCK_DIV4 = 0x00, /*!< PCLK = CCLK/4 (reset value). */
+	CLOCK_DIV1 = 0x01, /*!< PCLK = CCLK. */
+	CLOCK_DIV2 = 0x02, /*!< PCLK = CCLK/2. */
+	CLOCK_DIV8 = 0x03 /*!< PCLK = CCLK/8. */
+} CLOCK_DIVIDER;
+
+
+/*
+ *
+ *
+ * Functions:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Switches the CPU clock to a profile, then calls every change handler.
+ * @param	profile: -> CLOCK_PROFILE.
+ * @return	0 if successful, -1 if profile is not valid.
+ * @note	Interrupts are disabled during the switch, handlers included, so no interrupt sees stale dividers.
+ * 			SystemCoreClock is up to date when handlers are called.
+ */
+int32_t CLOCK_SetProfile(CLOCK_PROFILE profile);
+
+/**
+ * @brief	Gets the current profile.
+ * @return	CLOCK_PROFILE.
+ */
+CLOCK_PROFILE CLOCK_GetProfile(void);
+
+/**
+ * @brief	Adds a change handler, called after every profile switch. Adding the same handler twice does nothing.
+ * @param	handler: -> Recomputes the caller's dividers from SystemCoreClock (or CLOCK_GetPCLK()).
+ * @return	0 if successful, -1 if there are already CLOCK_MAX_HANDLERS.
+ */
+int32_t CLOCK_AddHandler(void (*handler)(void));
+
+/**
+ * @brief	Sets a peripheral clock divider.
+ * @param	peripheral: -> CLOCK_PERIPHERAL.
+ * @param	divider: -> CLOCK_DIVIDER.
+ */
+void CLOCK_SetPCLK(CLOCK_PERIPHERAL peripheral, CLOCK_DIVIDER divider);
+
+/**
+ * @brief	Gets a peripheral clock frequency.
+ * @param	peripheral: -> CLOCK_PERIPHERAL.
+ * @return	PCLK, in Hz.
+ */
+uint32_t CLOCK_GetPCLK(CLOCK_PERIPHERAL peripheral);
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+#endif /* CLOCK_H_ */
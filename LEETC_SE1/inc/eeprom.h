@@ -17,6 +17,7 @@
  * @{
  */
 
+#include <stdbool.h>
 #include "i2c.h"
 
 
@@ -33,6 +34,11 @@
  */
 #define EEPROM_PAGE_LENGTH 32
 
+/**
+ * @brief	 EEPROM capacity (in bytes).
+ */
+#define EEPROM_SIZE 4096
+
 /**
  * @brief 	EEPROM address.
  */
@@ -43,6 +49,17 @@
  */
 #define EEPROM_FREQUENCY 400000
 
+/**
+ * @brief	 Maximum time (milliseconds) EEPROM may ignore its address while writing a page internally.
+ * @note	Datasheet's write cycle is 5 ms. Acknowledge polling gives up after this.
+ */
+#define EEPROM_WRITE_CYCLE_MS 10
+
+/**
+ * @brief	 Number of EEPROM pages kept in RAM (write-back cache).
+ */
+#define EEPROM_CACHE_PAGES 4
+
 
 /*
  *
@@ -54,6 +71,7 @@
 
 /*
  * @brief 	Initialise EEPROM driver.
+ * @note	Driver is not reentrant: tasks sharing EEPROM must serialise access.
  */
 void EEPROM_Init();
 
@@ -75,6 +93,48 @@ int EEPROM_Read(char * buffer, int size);
  */
 int EEPROM_Write(char * buffer, int size);
 
+/*
+ * @brief 	Read size bytes to given buffer from EEPROM, starting at address.
+ * @param	address: -> EEPROM address of the first byte to read.
+ * @param 	buffer: -> Pointer to buffer of bytes, where data is to be read to.
+ * @param	size: -> Number of bytes to read.
+ * @return 	0 if successful, -1 otherwise.
+ * @note	Cached pages are read from RAM. Partial pages are loaded to the cache, whole pages are not.
+ * @note	This function is blocking.
+ */
+int EEPROM_ReadAt(int address, char * buffer, int size);
+
+/*
+ * @brief 	Write size bytes to EEPROM from buffer, starting at address.
+ * @param	address: -> EEPROM address of the first byte to write.
+ * @param 	buffer: -> Pointer to buffer of bytes, where data is to be written from.
+ * @param	size: -> Number of bytes to write.
+ * @return	0 if successful, -1 otherwise.
+ * @note	Data has reached EEPROM (through the page cache) when this returns. See EEPROM_WriteCached() to batch writes.
+ * @note	This function is blocking.
+ */
+int EEPROM_WriteAt(int address, char * buffer, int size);
+
+/*
+ * @brief 	Write size bytes to the EEPROM page cache from buffer, starting at address.
+ * @param	address: -> EEPROM address of the first byte to write.
+ * @param 	buffer: -> Pointer to buffer of bytes, where data is to be written from.
+ * @param	size: -> Number of bytes to write.
+ * @return	0 if successful, -1 otherwise.
+ * @note	Pages reach EEPROM only when evicted or on EEPROM_Flush(): call it before the data must survive a reset.
+ * @note	This function is blocking (when a page has to be loaded or evicted).
+ */
+int EEPROM_WriteCached(int address, char * buffer, int size);
+
+/*
+ * @brief 	Write every modified cached page to EEPROM.
+ * @return	0 if successful, -1 otherwise.
+ * @note	Each page is written whole, so no write crosses an EEPROM page boundary.
+ * @note	Returns as soon as the last page is sent; the next access waits (acknowledge polling) for its write cycle.
+ * @note	This function is blocking.
+ */
+int EEPROM_Flush();
+
 
 /**
  * @}
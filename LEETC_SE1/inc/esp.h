@@ -32,6 +32,7 @@
 #ifdef FREERTOS
 	#include "FreeRTOS.h"
 	#include "semphr.h"
+	#include "rtos_alloc.h"
 #endif
 
 
@@ -68,6 +69,21 @@
  */
 #define AT_RESPONSE_MAX_LENGTH 1024
 
+/**
+ * @brief	ESP-8266 AT firmware baud rate after reset.
+ */
+#define ESP_BAUD 115200
+
+/**
+ * @brief	Baud rate negotiated by ESP_SetBaud() in NETWORK_ConnectToAP() (needs CLOCK_FULL: see uart_divisors.c).
+ */
+#define ESP_FAST_BAUD 921600
+
+/**
+ * @brief	Time for the ESP-8266 to switch baud rate, after its "OK" to AT+UART_CUR.
+ */
+#define ESP_BAUD_SWITCH_MS 20
+
 /**
  * @brief	ESP_01 Reset pins.
  */
@@ -172,6 +188,15 @@ bool ESP_Init(unsigned int baud);
  */
 uint32_t ESP_Test(void);
 
+/**
+ * @brief	Switch the link (both ends) to another baud rate, with AT+UART_CUR (not saved to flash).
+ * @param	baud: -> Baud rate (max: UART_MAX_BAUD).
+ * @return  0 if the module answers at the new baud rate, -1 otherwise (the link stays at the old one).
+ * @note	No flow control: the ESP-01 does not bring out the module's RTS/CTS, and the AT firmware has no XON/XOFF.
+ * 			The UART driver takes bursts into its (2 KB) RX Ring Buffer, and counts what it loses (UART_GetOverruns()).
+ */
+uint32_t ESP_SetBaud(uint32_t baud);
+
 /**
  * @brief	Restart ESP-8266 module.
  * @return  0 if it was properly restarted, -1 otherwise.
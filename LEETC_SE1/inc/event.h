@@ -0,0 +1,111 @@
+/*
+* @file		event.h
+* @brief	Contains the event queue API (bare metal event loop).
+* @version	1.0
+* @date		Oct 2026
+* @author	PedroG
+*
+* Copyright(C) 2020-2025, PedroG
+* All rights reserved.
+*/
+
+#ifndef EVENT_H_
+#define EVENT_H_
+
+/** @defgroup EVENT EVENT
+ * This package provides a single event queue, for run-to-completion event loops without an RTOS.
+ * Interrupt handlers (including timer wheel functions, see wait.h) post events, and the main loop takes them one
+ * at a time, sleeping (__WFI) while there are none:
+ *
+ * 		EVENT event;
+ * 		while (1) {
+ * 			EVENT_Wait(&event);
+ * 			handle(&event); // Must not block
+ * 		}
+ *
+ * Event types and data are defined by the application.
+ * @{
+ */
+
+/** @defgroup EVENT_Public_Functions EVENT Public Functions
+ * @{
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ *
+ *
+ * Constants:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Maximum number of pending events.
+ * @note	Must be a power of 2.
+ */
+#define EVENT_QUEUE_LENGTH 16
+
+/**
+ * @brief	Event.
+ */
+typedef struct
+{
+	uint32_t type; /*!< Application defined type. */
+	uint32_t data; /*!< Application defined data. */
+} EVENT;
+
+
+/*
+ *
+ *
+ * Functions:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Adds an event to the queue.
+ * @param	type: -> Event type.
+ * @param	data: -> Event data.
+ * @return	True if added, false if the queue was full (the event is dropped, see EVENT_GetDropped()).
+ * @note	Can be called from any interrupt handler, or from the main loop.
+ */
+bool EVENT_Post(uint32_t type, uint32_t data);
+
+/**
+ * @brief	Takes the oldest event from the queue, if any.
+ * @param	event: -> Where to write the event.
+ * @return	True if an event was taken, false if the queue was empty.
+ */
+bool EVENT_Poll(EVENT *event);
+
+/**
+ * @brief	Takes the oldest event from the queue, sleeping (__WFI) until there is one.
+ * @param	event: -> Where to write the event.
+ * @note	Bare metal only (under FreeRTOS, use a queue instead).
+ */
+void EVENT_Wait(EVENT *event);
+
+/**
+ * @brief	Number of events dropped because the queue was full, since start.
+ */
+uint32_t EVENT_GetDropped(void);
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+#endif /* EVENT_H_ */
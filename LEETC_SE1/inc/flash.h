@@ -22,6 +22,12 @@
  */
 
 #include <string.h>
+#include <stdbool.h>
+
+#ifdef FREERTOS
+	#include "FreeRTOS.h"
+	#include "task.h"
+#endif
 
 
 /*
@@ -58,11 +64,28 @@
  */
 #define FLASH_MINIMAL_COMPARE_SIZE 4
 
+/**
+ * @brief	Flash's size. Code at lower addresses can't run while flash is being erased/written.
+ */
+#define FLASH_SIZE 0x00080000
+
+/**
+ * @brief	Number of entries in LPC1769's vector table (16 system exceptions + 35 peripheral interrupts).
+ */
+#define FLASH_VECTOR_COUNT 51
+
 /**
  * @brief	Flash's IAP routine function.
  */
 typedef void (*IAP)(unsigned int [],unsigned int[]);
 
+/**
+ * @brief	Progress callback of long flash operations.
+ * @param	done: -> Sectors already processed.
+ * @param	total: -> Sectors to process.
+ */
+typedef void (*FLASH_PROGRESS)(unsigned int done, unsigned int total);
+
 /**
  * @brief	Flash related functions addresses.
  */
@@ -104,6 +127,21 @@ typedef enum {
  */
 
 
+/**
+ * @brief	Moves vector table to RAM, so interrupts with handlers in RAM keep running during flash operations.
+ * @note	Optional. Without it, every interrupt is treated as touching flash.
+ * @note	IAP commands always run from RAM, masking only interrupts whose handler lives in flash.
+ */
+void FLASH_Init();
+
+/**
+ * @brief	Installs an interrupt handler in RAM vector table.
+ * @param	irq: -> Interrupt (system exceptions are negative, as in CMSIS).
+ * @param	handler: -> New handler. If it lives in RAM, it stays enabled during flash operations.
+ * @return	0 if successful, -1 if FLASH_Init() wasn't called or irq is not valid.
+ */
+int FLASH_SetHandler(int irq, void (*handler)(void));
+
 /**
  * @brief	Erases all data from sector 'startSector' to 'endSector'.
  * @param   startSector: -> First sector.
@@ -111,9 +149,21 @@ typedef enum {
  * @return  CMD_SUCCESS: if sector was successfully erased.
  * @return  INVALID_SECTOR: if sector specified is not valid.
  * @note	To erase a single sector, the 2 parameters should hold the same value.
+ * @note	Sectors are erased one at a time (see FLASH_EraseSectorsProgress).
  */
 unsigned int FLASH_EraseSectors(unsigned int startSector, unsigned int endSector);
 
+/**
+ * @brief	Erases all data from sector 'startSector' to 'endSector', one sector at a time.
+ * @param   startSector: -> First sector.
+ * @param   endSector: -> Last sector.
+ * @param   progress: -> Called after each erased sector (may be NULL).
+ * @return  CMD_SUCCESS: if sectors were successfully erased.
+ * @return  INVALID_SECTOR: if sector specified is not valid.
+ * @note	On FreeRTOS, the calling task sleeps for a tick between sectors, so the scheduler keeps running.
+ */
+unsigned int FLASH_EraseSectorsProgress(unsigned int startSector, unsigned int endSector, FLASH_PROGRESS progress);
+
 /**
  * @brief	Write data in 'srcAddr' into 'dstAddr'.
  * @param   sector: -> Sector containing address 'dstAddr'.
@@ -0,0 +1,96 @@
+/*
+* @file		format.h
+* @brief	Contains the formatted output API (a small, reentrant printf core).
+* @version	1.0
+* @date		Oct 2026
+* @author	PedroG
+*
+* Copyright(C) 2020-2025, PedroG
+* All rights reserved.
+ */
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+/** @defgroup FORMAT FORMAT
+ * This package formats printf-style strings straight into a sink (one char at a time), with bounded output
+ * and no intermediate buffers. It keeps no state, so it can be used by several tasks at once.
+ *
+ * Supported: %d %u %x %X %c %s %%, with '-' (left justify) and '0' (zero pad) flags, a field width,
+ * and an 'l' length modifier (ignored, as long and int have the same size here).
+ * @{
+ */
+
+/** @defgroup FORMAT_Public_Functions FORMAT Public Functions
+ * @{
+ */
+
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/*
+ *
+ *
+ * Constants:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Pass as 'limit' for unbounded output.
+ */
+#define FORMAT_UNBOUNDED (-1)
+
+/**
+ * @brief	Receives formatted output, one char at a time.
+ * @param	context: -> Whatever was given to FORMAT_Print().
+ * @param	ch: -> Next char.
+ */
+typedef void (*FORMAT_SINK)(void * context, char ch);
+
+
+/*
+ *
+ *
+ * Functions:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Formats a string into a sink.
+ * @param	sink: -> Function receiving the output.
+ * @param	context: -> Passed to sink, as is.
+ * @param	limit: -> Maximum number of chars given to sink (FORMAT_UNBOUNDED for no limit).
+ * @param	format: -> Format string.
+ * @param	args: -> Arguments.
+ * @return	Number of chars given to sink (never more than 'limit').
+ * @note	No terminator is given to sink.
+ */
+int FORMAT_Print(FORMAT_SINK sink, void * context, int limit, const char * format, va_list args);
+
+/**
+ * @brief	Formats a string into a buffer, as snprintf() would.
+ * @param	buffer: -> Where to write the output. Always terminated (if size > 0).
+ * @param	size: -> Size of buffer, terminator included.
+ * @param	format: -> Format string.
+ * @param	args: -> Arguments.
+ * @return	Number of chars written, terminator excluded.
+ */
+int FORMAT_String(char * buffer, int size, const char * format, va_list args);
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+#endif /* FORMAT_H_ */
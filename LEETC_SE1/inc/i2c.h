@@ -25,7 +25,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include "wait.h"
+#include "trace.h"
+#include "clock.h"
 
+#ifdef FREERTOS
+	#include "FreeRTOS.h"
+	#include "task.h"
+#endif
 
 /*
  *
@@ -46,6 +52,26 @@
  */
 #define I2C_BUFFER_LENGTH 1024
 
+/**
+ * @brief	Maximum number of transactions that may be pending on I2C1 at the same time.
+ */
+#define I2C_QUEUE_LENGTH 8
+
+/**
+ * @brief	Task notification bit set by I2C1 handler when a transaction ends (FreeRTOS).
+ * @note	Set, not given: counts other code gives the same task (xTaskNotifyGive()) are left alone.
+ */
+#define I2C_NOTIFY_BIT (1UL << 31)
+
+#ifdef FREERTOS
+	/**
+	 * @brief	NVIC priority of I2C1 interrupt.
+	 * @brief	Must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY, since the handler notifies tasks.
+	 * @brief	Only needed in FreeRTOS environment.
+	 */
+	#define I2C1_IRQ_PRIORITY ((configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - configPRIO_BITS)) + 1)
+#endif
+
 /**
  * @brief	I2C's interface power/clock control bit.
  */
@@ -109,6 +135,37 @@ typedef enum {
 	I2C_DATAR_NACK = 0x58
 } I2C_STATUS_MODE;
 
+/**
+ * @brief	Result of an I2C1 transaction.
+ */
+typedef enum {
+	I2C_TRANSFER_PENDING = 1, /*!< Transaction is queued or on the bus. */
+	I2C_TRANSFER_DONE = 0, /*!< Transaction completed. */
+	I2C_TRANSFER_ERROR = -1, /*!< Data NACK, bus error, timeout or cancelled. */
+	I2C_TRANSFER_NACK = -2 /*!< Slave did not acknowledge its address. */
+} I2C_TRANSFER_RESULT;
+
+/**
+ * @brief	I2C1 transaction descriptor.
+ * @note	A transaction writes wSize bytes and, if rSize is not 0, reads rSize bytes after a repeated start.
+ * @note	With wSize 0 only the read is performed; with both sizes 0 the slave is just addressed.
+ * @note	The descriptor and its buffers must stay valid until the transaction is no longer pending.
+ */
+typedef struct {
+	uint8_t address; /*!< 7-bit slave address. */
+	int frequency; /*!< Rate of communication, in Hz. */
+	const char * wBuffer; /*!< Data to write (without SLA + W). */
+	int wSize; /*!< Size of data (in bytes) to write. */
+	char * rBuffer; /*!< Where read data is stored. */
+	int rSize; /*!< Size of data (in bytes) to read. */
+	volatile int result; /*!< I2C_TRANSFER_RESULT of the transaction. */
+#ifdef FREERTOS
+	TaskHandle_t task; /*!< Task notified on completion (NULL for none). Set by I2C1_Transfer, by the caller of I2C1_Submit. */
+#endif
+	int wIndex; /*!< Driver private. */
+	int rIndex; /*!< Driver private. */
+} I2C_TRANSACTION;
+
 
 /*
  *
@@ -131,6 +188,33 @@ void I2C1_Init();
  */
 void I2C2_Init();
 
+/**
+ * @brief 	Queues a transaction on I2C1 interface. Does not wait for it.
+ * @param	transaction: -> Transaction to perform.
+ * @return	0 if queued, -1 if arguments are invalid or the queue is full.
+ * @note	The whole transaction runs in I2C1 interrupt handler.
+ * @note	On FreeRTOS, transaction's task (if any) gets I2C_NOTIFY_BIT (xTaskNotifyFromISR, eSetBits) when it ends.
+ * 			The caller must set transaction->task, or NULL: only I2C1_Transfer fills it in.
+ */
+int I2C1_Submit(I2C_TRANSACTION * transaction);
+
+/**
+ * @brief 	Removes a transaction from I2C1 queue, aborting it if it is already on the bus.
+ * @param	transaction: -> Transaction to cancel.
+ * @return	Result of transaction, I2C_TRANSFER_ERROR if it was still pending.
+ */
+int I2C1_Cancel(I2C_TRANSACTION * transaction);
+
+/**
+ * @brief 	Performs a transaction on I2C1 interface and waits for it to end.
+ * @param	transaction: -> Transaction to perform.
+ * @return	I2C_TRANSFER_RESULT of transaction (I2C_TRANSFER_ERROR if timed out).
+ * @note	On FreeRTOS the calling task is blocked on a task notification (I2C_NOTIFY_BIT), not spinning.
+ * 			Other notifications wake it, but it keeps waiting, and leaves them to whoever takes them.
+ * @note	Times out after I2C_TIMEOUT_MS.
+ */
+int I2C1_Transfer(I2C_TRANSACTION * transaction);
+
 /**
  * @brief 	Configures I2C1 interface.
  * @param	frequency: -> Rate of I2C1 communication, in Hz.
@@ -138,6 +222,7 @@ void I2C2_Init();
  * @param   wBuffer: -> Data to write.
  * @param	wSize: -> Size of data (in bytes) to write.
  * @return	0 if successful, -1 if timed out.
+ * @note	Kept for compatibility, built on top of I2C1_Transfer.
  */
 int I2C1_Configure(int frequency, int rSize, char * wBuffer, int wSize);
 
@@ -154,6 +239,7 @@ int I2C2_Configure(int frequency, int rSize, char * wBuffer, int wSize);
 /**
  * @brief	Start a transmission in I2C1 interface (read or write).
  * @return	0 if successful, -1 if timed out.
+ * @note	Kept for compatibility, transmission is actually started by I2C1_Engine.
  */
 int I2C1_Start();
 
@@ -165,6 +251,7 @@ int I2C2_Start();
 
 /**
  * @brief	Ends a started transmission on interface I2C1.
+ * @note	Kept for compatibility, transactions already end with a STOP.
  */
 void I2C1_Stop();
 
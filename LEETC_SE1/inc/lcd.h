@@ -26,11 +26,15 @@
 #include <string.h>
 #include <stdarg.h>
 #include "wait.h"
+#include "format.h"
+#include "trace.h"
 
 #ifdef FREERTOS
 	#include "FreeRTOS.h"
 	#include "task.h"
-	#include "queue.h"
+	#include "semphr.h"
+	#include "message_buffer.h"
+	#include "rtos_alloc.h"
 #endif
 
 /*
@@ -53,6 +57,13 @@
 	 * @brief	Only needed in FreeRTOS environment.
 	 */
 	#define TASK_LCD_WRITER_PRIORITY tskIDLE_PRIORITY + 1
+
+	/**
+	 * @brief	Size (bytes) of the buffer holding commands for LCD Writer task.
+	 * @brief	Only needed in FreeRTOS environment.
+	 * @note	Each command takes 1 to 10 bytes (a string, 1 + its length), plus sizeof(size_t).
+	 */
+	#define LCD_BUFFER_SIZE 256
 #endif
 
 /**
@@ -103,30 +114,23 @@
 #define LCD_CHARMAP_LENGTH 8
 
 /**
- * @brief	Structure containing information to write to LCD:
+ * @brief	Longest LCD command message: command byte, and a whole DDRAM string.
  */
-typedef struct {
-	uint8_t cmd; // Type of command
-	char ch; // Character
-	char str[LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS]; // String
-	int row; // Row
-	int col; // Column
-	unsigned char location; // Location
-	unsigned char charmap[LCD_CHARMAP_LENGTH]; // Character Map
-} LCD_INFO;
+#define LCD_MESSAGE_MAX_LENGTH (1 + LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS)
 
 /**
- * @brief 	LCD Commands.
+ * @brief 	LCD Commands. Sent to LCD Writer task as the first byte of a message, followed by its arguments.
  */
 typedef enum {
-	LCD_CMD_WRITE_CHAR, /*!< Write char. */
-	LCD_CMD_WRITE_STRING, /*!< Write string. */
+	LCD_CMD_WRITE_CHAR, /*!< Write char. Argument: char. */
+	LCD_CMD_WRITE_STRING, /*!< Write string. Argument: the string, without terminator (rest of message). */
 	LCD_CMD_CLEAR, /*!< Clear. */
 	LCD_CMD_HOME, /*!< Home. */
-	LCD_CMD_LOCATE, /*!< Locate cursor. */
-	LCD_CMD_CREATE_CHAR, /*!< Create custom char. */
+	LCD_CMD_LOCATE, /*!< Locate cursor. Arguments: row, column. */
+	LCD_CMD_CREATE_CHAR, /*!< Create custom char. Arguments: location, LCD_CHARMAP_LENGTH bytes of char map. */
 	LCD_CMD_SHIFT_RIGHT, /*!< Shift right. */
-	LCD_CMD_SHIFT_LEFT /*!< Shift left. */
+	LCD_CMD_SHIFT_LEFT, /*!< Shift left. */
+	LCD_CMD_SYNC /*!< Signal that every previous command has been written. */
 } LCD_CMD_TYPE;
 
 
@@ -178,8 +182,8 @@ typedef enum {
  * @brief	Initialises the LCDText API.
  * @return  0 if succeeded, -1 if failed.
  * @note	This function must be called prior to any other LCDText functions.
- * @note    This function uses timer3 from "wait.h". If timer3 is already in use,
- * 			initialisation fails.
+ * @note    This function uses the timer wheel's clock from "wait.h" (timer2). If timer2 is already in use
+ * 			by something else, initialisation fails.
  */
 int32_t LCDText_Init(void);
 
@@ -247,6 +251,14 @@ void LCDText_Printf(char *fmt, ...);
  */
 void LCDText_ShiftDisplay(LCD_SHIFT_DIR dir);
 
+/**
+ * @brief	Waits until every previously issued command has been written to the LCD.
+ * @note	In FreeRTOS environment, blocks the calling task until LCD Writer task has drained its queue.
+ * 			Only one task should call this function at a time.
+ * @note	Outside FreeRTOS environment, commands are written synchronously, and this function returns immediately.
+ */
+void LCDText_Sync(void);
+
 /**
  * @}
  */
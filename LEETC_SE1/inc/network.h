@@ -34,6 +34,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "rtos_alloc.h"
 
 
 
@@ -109,6 +110,11 @@ typedef struct {
  */
 #define TASK_SCORE_PUBLISHER_PRIORITY tskIDLE_PRIORITY + 1
 
+/**
+ * @brief	Number of scores waiting to be published.
+ */
+#define NETWORK_QUEUE_LENGTH 8
+
 /**
  * @brief	Network State Machine states.
  */
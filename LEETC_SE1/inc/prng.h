@@ -0,0 +1,96 @@
+/*
+* @file		prng.h
+* @brief	Contains the pseudo-random number generator API.
+* @version	1.0
+* @date		Oct 2026
+* @author	PedroG
+*
+* Copyright(C) 2020-2025, PedroG
+* All rights reserved.
+ */
+
+#ifndef PRNG_H_
+#define PRNG_H_
+
+/** @defgroup PRNG PRNG
+ * This package provides a small, fast and reentrant pseudo-random number generator (xorshift32).
+ * @{
+ */
+
+/** @defgroup PRNG_Public_Functions PRNG Public Functions
+ * @{
+ */
+
+
+#include <stdint.h>
+
+
+/*
+ *
+ *
+ * Constants:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Generator state. Each task keeps its own, so no locking is needed.
+ */
+typedef struct {
+	uint32_t state; /*!< Never 0. */
+} PRNG_STATE;
+
+
+/*
+ *
+ *
+ * Functions:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Seeds a generator.
+ * @param	prng: -> Generator to seed.
+ * @param	seed: -> Any value (close seeds still give unrelated sequences).
+ */
+void PRNG_Seed(PRNG_STATE * prng, uint32_t seed);
+
+/**
+ * @brief	Gets next 32 random bits.
+ * @param	prng: -> Generator.
+ * @return	Random value.
+ */
+uint32_t PRNG_Next(PRNG_STATE * prng);
+
+/**
+ * @brief	Gets a random value in [0, n).
+ * @param	prng: -> Generator.
+ * @param	n: -> Number of possible values (0 gives 0).
+ * @return	Random value.
+ * @note	Uses a multiply and a shift instead of a division (bias is below n/2^32).
+ */
+uint32_t PRNG_Range(PRNG_STATE * prng, uint32_t n);
+
+/**
+ * @brief	Gets a random value in [min, max].
+ * @param	prng: -> Generator.
+ * @param	min: -> Lowest possible value.
+ * @param	max: -> Highest possible value. Must not be below min.
+ * @return	Random value.
+ */
+int PRNG_Between(PRNG_STATE * prng, int min, int max);
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+#endif /* PRNG_H_ */
@@ -25,6 +25,12 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <time.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef FREERTOS
+	#include "FreeRTOS.h"
+#endif
 
 
 /*
@@ -41,6 +47,21 @@
  */
 #define RTC_PCONP_ENABLE (1 << 9)
 
+/**
+ * @brief	Converts time fields (UTC) to seconds since Epoh (01/01/1970), as timegm() would.
+ * @param   dateTime: -> Time fields. Only tm_year (since 1900, not before), tm_mon, tm_mday, tm_hour, tm_min and tm_sec are read,
+ * 			and must be in range (no normalisation).
+ * @return	Seconds since Epoh (01/01/1970).
+ */
+time_t RTC_ToSeconds(const struct tm *dateTime);
+
+/**
+ * @brief	Converts seconds since Epoh (01/01/1970) to time fields (UTC), as gmtime_r() would.
+ * @param   seconds: -> Seconds since Epoh (01/01/1970), not before 1900.
+ * @param   dateTime: -> Where to write time fields (all of them).
+ */
+void RTC_FromSeconds(time_t seconds, struct tm *dateTime);
+
 /**
  * @brief	Enable RTC counters.
  */
@@ -56,6 +77,15 @@
  */
 #define RTC_IL_BIT 0x01
 
+#ifdef FREERTOS
+	/**
+	 * @brief	NVIC priority of RTC interrupt.
+	 * @brief	Must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY, so the handler may use FreeRTOS "FromISR" API.
+	 * @brief	Only needed in FreeRTOS environment.
+	 */
+	#define RTC_IRQ_PRIORITY ((configMAX_SYSCALL_INTERRUPT_PRIORITY >> (8 - configPRIO_BITS)) + 2)
+#endif
+
 /**
  * @brief	Field that will interrupt.
  */
@@ -87,6 +117,11 @@ typedef enum
 	SEC, /*!< Second field. */
 } RTC_TIME_FIELD;
 
+/**
+ * @brief	Function called (in interrupt context) on each counter increment interrupt.
+ */
+typedef void (*RTC_HANDLER)(void);
+
 
 /*
  *
@@ -100,12 +135,19 @@ typedef enum
 /**
  * @brief	Initialises the RTC API, with the desired time.
  * @param   seconds: -> Seconds since 01/01/1970.
- * @note    If parameter type is INONE, no handler is needed. Only the first 2 parameters will be read.
- * @note    Only the first 3 parameters can be read. Any other parameters will be ignored.
+ * @note	Enables the RTC interrupt, once per second (see RTC_GetSeconds() and RTC_SetInterrupt()).
  * @note	This function must be called prior to any other RTC functions.
  */
 void RTC_Init(time_t seconds);
 
+/**
+ * @brief	Sets the function to call when some counters are incremented.
+ * @param   fields: -> Bitmap of RTC_INTERRUPT_FIELD (e.g. ISEC, to be called once per second). INONE disables it.
+ * @param   handler: -> Function to call, from the RTC interrupt handler. Ignored if fields is INONE.
+ * @note    Counters are incremented only while enabled (see RTC_Disable()).
+ */
+void RTC_SetInterrupt(RTC_INTERRUPT_FIELD fields, RTC_HANDLER handler);
+
 /**
  * @brief	Sends current RTC time to desired location.
  * @param   dateTime: -> Desired location.
@@ -121,6 +163,7 @@ void RTC_SetValue(struct tm *dateTime);
 /**
  * @brief	Gets the RTC time value.
  * @return	Seconds since Epoh (01/01/1970).
+ * @note	Counted by the RTC interrupt. Time fields are only read (and converted) again after being written.
  */
 time_t RTC_GetSeconds(void);
 
@@ -0,0 +1,159 @@
+/*
+* @file		rtos_alloc.h
+* @brief	Contains the FreeRTOS object allocation API (static or heap).
+* @version	1.0
+* @date		Oct 2026
+* @author	PedroG
+*
+* Copyright(C) 2020-2025, PedroG
+* All rights reserved.
+ */
+
+#ifndef RTOS_ALLOC_H_
+#define RTOS_ALLOC_H_
+
+/** @defgroup RTOS_ALLOC RTOS_ALLOC
+ * This package creates tasks, queues, message buffers and semaphores either from statically sized buffers
+ * (configSUPPORT_STATIC_ALLOCATION == 1) or from the FreeRTOS heap, with the same calls.
+ *
+ * Each object gets a storage declaration at file scope, and is created by name:
+ *
+ * 		RTOS_TASK_STORAGE(taskX, TASK_X_STACK_SIZE);
+ * 		...
+ * 		if (RTOS_TaskCreate(taskX, taskXFunction, "TaskX", TASK_X_STACK_SIZE, NULL, TASK_X_PRIORITY, NULL) != pdPASS) ...
+ *
+ * In static mode, storage is named after the object (e.g. taskXStack, taskXTcb), so the RAM taken by each
+ * one shows up in the linker map (see tools/ram_report.py). In heap mode, storage declarations are empty.
+ * @{
+ */
+
+/** @defgroup RTOS_ALLOC_Public_Functions RTOS_ALLOC Public Functions
+ * @{
+ */
+
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "message_buffer.h"
+
+
+/*
+ *
+ *
+ * Functions:
+ *
+ *
+ */
+
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+
+	/**
+	 * @brief	Declares the stack and control block of a task.
+	 * @param	name: -> Object name, as given to RTOS_TaskCreate().
+	 * @param	stackSize: -> Stack size, in words.
+	 */
+	#define RTOS_TASK_STORAGE(name, stackSize) \
+		static StackType_t name##Stack[stackSize]; \
+		static StaticTask_t name##Tcb
+
+	/**
+	 * @brief	Declares the item storage and control block of a queue.
+	 * @param	name: -> Object name, as given to RTOS_QueueCreate().
+	 * @param	length: -> Maximum number of items.
+	 * @param	itemSize: -> Size of each item, in bytes.
+	 */
+	#define RTOS_QUEUE_STORAGE(name, length, itemSize) \
+		static uint8_t name##Storage[(length) * (itemSize)]; \
+		static StaticQueue_t name##Queue
+
+	/**
+	 * @brief	Declares the storage and control block of a message buffer.
+	 * @param	name: -> Object name, as given to RTOS_MessageBufferCreate().
+	 * @param	size: -> Buffer size, in bytes (each message also takes sizeof(size_t) for its length).
+	 */
+	#define RTOS_MESSAGE_BUFFER_STORAGE(name, size) \
+		static uint8_t name##Storage[(size) + 1]; \
+		static StaticMessageBuffer_t name##Buffer
+
+	/**
+	 * @brief	Declares the control block of a semaphore (binary or mutex).
+	 * @param	name: -> Object name, as given to RTOS_SemaphoreCreate...().
+	 */
+	#define RTOS_SEMAPHORE_STORAGE(name) \
+		static StaticSemaphore_t name##Semaphore
+
+	/**
+	 * @brief	Creates a task, as xTaskCreate() would.
+	 * @return  pdPASS if succeeded.
+	 */
+	#define RTOS_TaskCreate(name, function, label, stackSize, parameters, priority, handle) \
+		RTOS_TaskCreateStatic(function, label, stackSize, parameters, priority, handle, name##Stack, &name##Tcb)
+
+	/**
+	 * @brief	Creates a queue, as xQueueCreate() would.
+	 * @return  Queue handle, never NULL.
+	 */
+	#define RTOS_QueueCreate(name, length, itemSize) \
+		xQueueCreateStatic(length, itemSize, name##Storage, &name##Queue)
+
+	/**
+	 * @brief	Creates a message buffer, as xMessageBufferCreate() would.
+	 * @return  Message buffer handle, never NULL.
+	 */
+	#define RTOS_MessageBufferCreate(name, size) \
+		xMessageBufferCreateStatic(size, name##Storage, &name##Buffer)
+
+	/**
+	 * @brief	Creates a mutex, as xSemaphoreCreateMutex() would.
+	 * @return  Semaphore handle, never NULL.
+	 */
+	#define RTOS_SemaphoreCreateMutex(name) \
+		xSemaphoreCreateMutexStatic(&name##Semaphore)
+
+	/**
+	 * @brief	Creates a binary semaphore, as xSemaphoreCreateBinary() would.
+	 * @return  Semaphore handle, never NULL.
+	 */
+	#define RTOS_SemaphoreCreateBinary(name) \
+		xSemaphoreCreateBinaryStatic(&name##Semaphore)
+
+	/**
+	 * @brief	xTaskCreateStatic(), with the result and handle of xTaskCreate().
+	 */
+	static inline BaseType_t RTOS_TaskCreateStatic(TaskFunction_t function, const char * const label, uint32_t stackSize,
+			void * const parameters, UBaseType_t priority, TaskHandle_t * handle, StackType_t * stack, StaticTask_t * tcb)
+	{
+		TaskHandle_t task = xTaskCreateStatic(function, label, stackSize, parameters, priority, stack, tcb);
+		if (handle != NULL) *handle = task;
+		return (task != NULL) ? pdPASS : pdFAIL;
+	}
+
+#else
+
+	#define RTOS_TASK_STORAGE(name, stackSize) typedef int name##Storage
+	#define RTOS_QUEUE_STORAGE(name, length, itemSize) typedef int name##Storage
+	#define RTOS_MESSAGE_BUFFER_STORAGE(name, size) typedef int name##Storage
+	#define RTOS_SEMAPHORE_STORAGE(name) typedef int name##Storage
+
+	#define RTOS_TaskCreate(name, function, label, stackSize, parameters, priority, handle) \
+		xTaskCreate(function, label, stackSize, parameters, priority, handle)
+	#define RTOS_QueueCreate(name, length, itemSize) xQueueCreate(length, itemSize)
+	#define RTOS_MessageBufferCreate(name, size) xMessageBufferCreate(size)
+	#define RTOS_SemaphoreCreateMutex(name) xSemaphoreCreateMutex()
+	#define RTOS_SemaphoreCreateBinary(name) xSemaphoreCreateBinary()
+
+#endif
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+#endif /* RTOS_ALLOC_H_ */
@@ -23,6 +23,8 @@
 
 
 #include <stdbool.h>
+#include "trace.h"
+#include "clock.h"
 
 
 /*
@@ -0,0 +1,150 @@
+/*
+* @file		timestamp.h
+* @brief	Contains the timestamp API (cycle accurate, monotonic).
+* @version	1.0
+* @date		Oct 2026
+* @author	PedroG
+*
+* Copyright(C) 2020-2025, PedroG
+* All rights reserved.
+*/
+
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+/** @defgroup TIMESTAMP TIMESTAMP
+ * This package provides monotonic timestamps, in CPU cycles, from the Cortex-M3 DWT cycle counter (CYCCNT).
+ * CYCCNT has 32 bits, so it wraps every 2^32 cycles (about 43 s at 100 MHz): TIMESTAMP_Get() extends it to 64 bits,
+ * as long as it is called at least once per wrap. The 1 ms SysTick does it: SysTick_Handler() (wait.c, started by
+ * TIMESTAMP_Init()) or, with FreeRTOS, the kernel's tick hook (vApplicationTickHook() in wait.c, configUSE_TICK_HOOK 1).
+ * So with FreeRTOS, the 64-bit count is only kept once the scheduler runs: init code before it must take under one wrap.
+ *
+ * Short intervals (e.g. a driver call, or an ISR) only need the 32-bit counter, which is a single register read:
+ *
+ * 		uint32_t start = TIMESTAMP_GetCycles();
+ * 		LCDText_WriteChar(c);
+ * 		TIMESTAMP_HistogramAdd(&lcdLatency, TIMESTAMP_GetCycles() - start); // Wraps correctly
+ *
+ * Without CMSIS (host builds), the same API is backed by clock_gettime(CLOCK_MONOTONIC), with 1 ns "cycles" (so the 32-bit counter wraps every 4.3 s).
+ * @{
+ */
+
+/** @defgroup TIMESTAMP_Public_Functions TIMESTAMP Public Functions
+ * @{
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ *
+ *
+ * Constants:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Number of histogram buckets: bucket n counts intervals of [2^(n-1), 2^n) cycles (bucket 0 counts 0 cycles).
+ */
+#define TIMESTAMP_HISTOGRAM_BUCKETS 33
+
+/**
+ * @brief	Latency histogram (log2 buckets, in cycles).
+ * @note	Zero initialise it (e.g. a static variable) before use.
+ */
+typedef struct
+{
+	uint32_t bucket[TIMESTAMP_HISTOGRAM_BUCKETS]; /*!< Counts per bucket. */
+	uint32_t count; /*!< Total count. */
+	uint32_t min; /*!< Shortest interval (cycles), if count > 0. */
+	uint32_t max; /*!< Longest interval (cycles). */
+} TIMESTAMP_HISTOGRAM;
+
+
+/*
+ *
+ *
+ * Functions:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Initialises (and starts) the cycle counter.
+ * @note	Reads SystemCoreClock for conversions, and again after every CLOCK_SetProfile() (intervals spanning a profile
+ * 			change convert at the new frequency). Without FreeRTOS, also starts SysTick (WAIT_Init(SYS)).
+ * 			Conversions before TIMESTAMP_Init() hang, rather than use a wrong frequency.
+ */
+void TIMESTAMP_Init(void);
+
+/**
+ * @brief	Raw 32-bit cycle counter.
+ * @return  Cycles, modulo 2^32.
+ * @note	For intervals shorter than 2^32 cycles, subtract two readings (unsigned).
+ */
+uint32_t TIMESTAMP_GetCycles(void);
+
+/**
+ * @brief	64-bit cycle counter, since TIMESTAMP_Init().
+ * @return  Cycles.
+ * @note	Can be called from any context. Must be called at least once every 2^32 cycles, not to miss a wrap (the
+ * 			SysTick does it, see above).
+ */
+uint64_t TIMESTAMP_Get(void);
+
+/**
+ * @brief	Cycle counter frequency.
+ * @return  Cycles per second (0 before TIMESTAMP_Init()).
+ */
+uint32_t TIMESTAMP_GetHz(void);
+
+/**
+ * @brief	Converts cycles to microseconds (rounded down).
+ * @param	cycles: -> Cycles (e.g. a difference of two timestamps).
+ * @return  Microseconds.
+ */
+uint64_t TIMESTAMP_ToUs(uint64_t cycles);
+
+/**
+ * @brief	Converts cycles to nanoseconds (rounded down).
+ * @param	cycles: -> Cycles (e.g. a difference of two timestamps).
+ * @return  Nanoseconds.
+ */
+uint64_t TIMESTAMP_ToNs(uint64_t cycles);
+
+/**
+ * @brief	Converts microseconds to cycles.
+ * @param	micros: -> Microseconds.
+ * @return  Cycles.
+ */
+uint64_t TIMESTAMP_FromUs(uint64_t micros);
+
+/**
+ * @brief	Microseconds since TIMESTAMP_Init().
+ */
+uint64_t TIMESTAMP_GetUs(void);
+
+/**
+ * @brief	Adds an interval to a histogram.
+ * @param	histogram: -> Histogram.
+ * @param	cycles: -> Interval, in cycles.
+ * @note	Not reentrant: use a histogram per context (or mask interrupts around it).
+ */
+void TIMESTAMP_HistogramAdd(TIMESTAMP_HISTOGRAM *histogram, uint32_t cycles);
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+#endif /* TIMESTAMP_H_ */
@@ -0,0 +1,217 @@
+/*
+* @file		trace.h
+* @brief	Contains the trace API (timestamped records in a RAM ring buffer).
+* @version	1.0
+* @date		Oct 2026
+* @author	PedroG
+*
+* Copyright(C) 2020-2025, PedroG
+* All rights reserved.
+*/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/** @defgroup TRACE TRACE
+ * This package records what the target is doing (task switches, queue operations, driver calls and interrupts)
+ * into a RAM ring buffer, without stopping it. Each record takes 8 bytes and a few cycles.
+ *
+ * Tracing is compiled in only if TRACE is in properties pre-processor (e.g. -DTRACE, in every project). Otherwise,
+ * every TRACE_ macro expands to nothing. With FREERTOS, FreeRTOSConfig.h also wires the kernel trace macros.
+ *
+ * Call TRACE_Init() first thing in main(). To read the trace, halt the target at any point and dump 'traceRing'
+ * (e.g. in gdb: dump binary value trace.bin traceRing), then convert it with tools/trace_dump.py, which writes
+ * Chrome trace JSON (open it in chrome://tracing or ui.perfetto.dev).
+ * @{
+ */
+
+/** @defgroup TRACE_Public_Functions TRACE Public Functions
+ * @{
+ */
+
+
+#include <stdint.h>
+#include "timestamp.h"
+
+
+/*
+ *
+ *
+ * Constants:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Marks a valid ring ("TRC1"), for tools/trace_dump.py.
+ */
+#define TRACE_MAGIC 0x31435254
+
+/**
+ * @brief	Number of records in the ring (the oldest are overwritten).
+ * @note	Must be a power of 2.
+ */
+#define TRACE_LENGTH 512
+
+/**
+ * @brief	Number of task names kept (by FreeRTOS task number).
+ */
+#define TRACE_MAX_TASKS 16
+
+/**
+ * @brief	Task name length, terminator included (as configMAX_TASK_NAME_LEN).
+ */
+#define TRACE_NAME_LENGTH 12
+
+/**
+ * @brief	Record types.
+ * @note	tools/trace_dump.py reads this enum: only append to it.
+ */
+typedef enum
+{
+	TRACE_TASK_IN = 0, /*!< Task switched in (arg: task number). */
+	TRACE_TASK_OUT = 1, /*!< Task switched out (arg: task number). */
+	TRACE_FUNCTION_ENTER = 2, /*!< Driver function entered (id: TRACE_ID, arg: function specific). */
+	TRACE_FUNCTION_EXIT = 3, /*!< Driver function left (id: TRACE_ID). */
+	TRACE_INTERRUPT_ENTER = 4, /*!< Interrupt handler entered (id: TRACE_ID). */
+	TRACE_INTERRUPT_EXIT = 5, /*!< Interrupt handler left (id: TRACE_ID). */
+	TRACE_QUEUE_SEND = 6, /*!< Queue or message buffer written (arg: its address, low 16 bits). */
+	TRACE_QUEUE_RECEIVE = 7, /*!< Queue or message buffer read (arg: its address, low 16 bits). */
+	TRACE_QUEUE_BLOCK = 8, /*!< Task blocked on a queue or message buffer (arg: its address, low 16 bits). */
+	TRACE_NOTIFY = 9 /*!< Task notified from an interrupt. */
+} TRACE_TYPE;
+
+/**
+ * @brief	Traced driver functions and interrupt handlers.
+ * @note	tools/trace_dump.py reads this enum: only append to it.
+ */
+typedef enum
+{
+	TRACE_NONE = 0, /*!< No function (kernel records). */
+	TRACE_LCD_CHAR = 1, /*!< LCD char written (arg: char). */
+	TRACE_LCD_STRING = 2, /*!< LCD string written. */
+	TRACE_LCD_CLEAR = 3, /*!< LCD cleared. */
+	TRACE_LCD_HOME = 4, /*!< LCD cursor home. */
+	TRACE_LCD_LOCATE = 5, /*!< LCD cursor located (arg: row << 8 | column). */
+	TRACE_LCD_CREATE_CHAR = 6, /*!< LCD char created (arg: location). */
+	TRACE_LCD_SHIFT = 7, /*!< LCD display shifted. */
+	TRACE_UART_WRITE = 8, /*!< UART_WriteChar() or UART_WriteBuffer() (arg: length). */
+	TRACE_UART_READ = 9, /*!< UART_ReadBuffer() or UART_ReadString() (arg: length). */
+	TRACE_UART_IRQ = 10, /*!< UART interrupt handler. */
+	TRACE_I2C_TRANSFER = 11, /*!< I2C1_Transfer() (arg: bytes written << 8 | bytes read). */
+	TRACE_I2C_IRQ = 12, /*!< I2C interrupt handler. */
+	TRACE_SPI_TRANSFER = 13 /*!< SPI_Transfer() (arg: length). */
+} TRACE_ID;
+
+/**
+ * @brief	Trace record.
+ */
+typedef struct
+{
+	uint32_t cycles; /*!< TIMESTAMP_GetCycles(). */
+	uint8_t type; /*!< TRACE_TYPE. */
+	uint8_t id; /*!< TRACE_ID. */
+	uint16_t arg; /*!< Depends on type and id. */
+} TRACE_RECORD;
+
+/**
+ * @brief	Trace ring, as dumped from RAM.
+ */
+typedef struct
+{
+	uint32_t magic; /*!< TRACE_MAGIC, once initialised. */
+	uint32_t hz; /*!< Cycles per second. */
+	uint32_t length; /*!< TRACE_LENGTH. */
+	volatile uint32_t count; /*!< Records written since TRACE_Init() (next one goes to count % length). */
+	char names[TRACE_MAX_TASKS][TRACE_NAME_LENGTH]; /*!< Task names, by task number. */
+	TRACE_RECORD records[TRACE_LENGTH]; /*!< Records. */
+} TRACE_RING;
+
+#ifdef TRACE
+
+	/**
+	 * @brief	Records a driver function entry.
+	 * @param	id: -> TRACE_ID.
+	 * @param	arg: -> Function specific (16 bits).
+	 */
+	#define TRACE_ENTER(id, arg) TRACE_Record(TRACE_FUNCTION_ENTER, (id), (arg))
+
+	/**
+	 * @brief	Records a driver function exit.
+	 * @param	id: -> TRACE_ID, as given to TRACE_ENTER().
+	 */
+	#define TRACE_EXIT(id) TRACE_Record(TRACE_FUNCTION_EXIT, (id), 0)
+
+	/**
+	 * @brief	Records an interrupt handler entry.
+	 * @param	id: -> TRACE_ID.
+	 */
+	#define TRACE_ISR_ENTER(id) TRACE_Record(TRACE_INTERRUPT_ENTER, (id), 0)
+
+	/**
+	 * @brief	Records an interrupt handler exit.
+	 * @param	id: -> TRACE_ID, as given to TRACE_ISR_ENTER().
+	 */
+	#define TRACE_ISR_EXIT(id) TRACE_Record(TRACE_INTERRUPT_EXIT, (id), 0)
+
+	/**
+	 * @brief	Records a queue (or message buffer) operation.
+	 * @param	type: -> TRACE_QUEUE_SEND, TRACE_QUEUE_RECEIVE or TRACE_QUEUE_BLOCK.
+	 * @param	queue: -> Queue (or message buffer).
+	 */
+	#define TRACE_QUEUE(type, queue) TRACE_Record((type), TRACE_NONE, (uint16_t) (uintptr_t) (queue))
+
+#else
+
+	#define TRACE_ENTER(id, arg)
+	#define TRACE_EXIT(id)
+	#define TRACE_ISR_ENTER(id)
+	#define TRACE_ISR_EXIT(id)
+	#define TRACE_QUEUE(type, queue)
+
+#endif
+
+
+/*
+ *
+ *
+ * Functions:
+ *
+ *
+ */
+
+
+/**
+ * @brief	Initialises the ring (and the timestamps, see TIMESTAMP_Init()).
+ * @note	Call it before creating any task, or their names are lost.
+ */
+void TRACE_Init(void);
+
+/**
+ * @brief	Adds a record to the ring.
+ * @param	type: -> TRACE_TYPE.
+ * @param	id: -> TRACE_ID.
+ * @param	arg: -> Depends on type and id.
+ * @note	Can be called from any context. Use the TRACE_ macros instead, so it compiles out without TRACE.
+ */
+void TRACE_Record(uint8_t type, uint8_t id, uint16_t arg);
+
+/**
+ * @brief	Keeps a task name, for tools/trace_dump.py.
+ * @param	number: -> Task number (FreeRTOS uxTCBNumber).
+ * @param	name: -> Task name.
+ */
+void TRACE_TaskName(uint32_t number, const char *name);
+
+
+/**
+ * @}
+ */
+
+
+/**
+ * @}
+ */
+
+#endif /* TRACE_H_ */
@@ -26,6 +26,9 @@
 #include <string.h>
 
 #include "wait.h"
+#include "format.h"
+#include "trace.h"
+#include "clock.h"
 
 
 /*
@@ -104,9 +107,36 @@
 #define UART_TIMEOUT_MS 1000
 
 /**
- * @brief	UART PCLK.
+ * @brief	Maximum baud rate (needs CCLK of at least 29.5 MHz, e.g. CLOCK_FULL: see uart_divisors.c).
+ * @note	UART_Init() picks UART2's PCLK divider (CLOCK_DIV1 to CLOCK_DIV8) with the smallest baud rate error.
  */
-#define UART_PCLK_VAL 0x00
+#define UART_MAX_BAUD 921600
+
+/**
+ * @brief	TX FIFO depth (bytes written per THRE interrupt).
+ */
+#define UART_TX_FIFO_SIZE 16
+
+/**
+ * @brief	Software flow control characters.
+ */
+#define UART_XON 0x11
+#define UART_XOFF 0x13
+
+/**
+ * @brief	RX Ring Buffer fill at which XOFF is sent, and fill at which XON is sent after it (UART_FLOW_XONXOFF).
+ * @note	XOFF leaves room for what the other end sends before it stops (a FIFO or two, at any baud rate).
+ */
+#define UART_XOFF_LEVEL (UART_RBUFSIZE * 3 / 4)
+#define UART_XON_LEVEL (UART_RBUFSIZE / 4)
+
+/**
+ * @brief	Flow control.
+ */
+typedef enum {
+	UART_FLOW_NONE = 0, /*!< No flow control. */
+	UART_FLOW_XONXOFF = 1 /*!< Software flow control (XON/XOFF): for text only, as they are never stored nor sent as data. */
+} UART_FLOW;
 
 /**
  * @brief	UART DLL Register mask bit.
@@ -142,6 +172,30 @@
  */
 #define UART_LOAD_FDR(add, mul) ((uint32_t) ((add & 0x0F) | ((mul << 4) & 0xF0)) & UART_FDR_MASKBIT)
 
+/**
+ * @brief	Maximum baud rate error accepted by UART_Init(), in ppm (1.5%: the receiver at the other end has its own).
+ */
+#define UART_MAX_BAUD_ERROR 15000
+
+/**
+ * @brief	UART baud rate divisors: baud = pclk * mulVal / (16 * divisor * (mulVal + divAddVal)).
+ */
+typedef struct {
+	uint32_t pclk; /*!< UART PCLK. */
+	uint32_t baud; /*!< Requested baud rate. */
+	uint16_t divisor; /*!< DLM:DLL. */
+	uint8_t divAddVal; /*!< FDR DIVADDVAL. */
+	uint8_t mulVal; /*!< FDR MULVAL. */
+	int32_t error; /*!< Achieved baud rate error, in ppm (positive if faster than requested). */
+} UART_DIVISORS;
+
+/**
+ * @brief	Divisors for every PCLK the clock profiles give, and standard baud rate (uart_divisors.c).
+ * @note	Generated by tools/uart_divisors.py.
+ */
+extern const UART_DIVISORS uartDivisorTable[];
+extern const uint32_t uartDivisorTableLength;
+
 /**
  * @brief	UART Ring Buffer structure.
  */
@@ -171,7 +225,10 @@ typedef enum {
 	UART_FCR_RX_RS = 		(1 << 1), /*!< Clear all bytes in RX FIFO. */
 	UART_FCR_TX_RS = 		(1 << 2), /*!< Clear all bytes in TX FIFO. */
 	UART_FCR_DMA_SEL = 		(1 << 3), /*!< Select DMA Mode (if UART_FCR_FIFO_EN is set). */
-	UART_FCR_TRG_LEV0 = 	(0 << 6) /*!< Trigger RX level 0. */
+	UART_FCR_TRG_LEV0 = 	(0 << 6), /*!< Trigger RX level 0 (1 char). */
+	UART_FCR_TRG_LEV1 = 	(1 << 6), /*!< Trigger RX level 1 (4 chars). */
+	UART_FCR_TRG_LEV2 = 	(2 << 6), /*!< Trigger RX level 2 (8 chars). */
+	UART_FCR_TRG_LEV3 = 	(3 << 6) /*!< Trigger RX level 3 (14 chars). */
 } UART_FCR_BITS;
 
 /**
@@ -258,12 +315,53 @@ typedef enum {
 /**
  * @brief	Initialise UART.
  * @note	This function must be called prior to other UART functions.
- * @param	baud: -> Baud rate (max: 115200)
+ * @param	baud: -> Baud rate (max: UART_MAX_BAUD)
  * @note	If baud is passed as 0, default 9600 will be set.
- * @return	True if successful, false otherwise.
+ * @return	True if successful, false otherwise (e.g. error over UART_MAX_BAUD_ERROR).
  */
 bool UART_Init(uint32_t baud);
 
+/**
+ * @brief	Find the divisors closest to a baud rate: from uartDivisorTable, or else by an (integer only) search.
+ * @param	pclk: -> UART PCLK.
+ * @param	baud: -> Baud rate.
+ * @param	divisors: -> Divisors found (error included).
+ * @return	0 if successful, -1 if no divisors can give baud (e.g. baud is 0, or over pclk/16).
+ */
+int32_t UART_FindDivisors(uint32_t pclk, uint32_t baud, UART_DIVISORS *divisors);
+
+/**
+ * @brief	Check if a baud rate can be set at the current CCLK, within UART_MAX_BAUD_ERROR.
+ * @param	baud: -> Baud rate.
+ * @return	True if UART_Init(baud) would succeed.
+ */
+bool UART_IsBaudReachable(uint32_t baud);
+
+/**
+ * @brief	Get the achieved baud rate (which depends on PCLK).
+ * @return	Baud rate, 0 before UART_Init() or while stopped (a clock profile change left no divisors within
+ * 			UART_MAX_BAUD_ERROR: the UART neither sends nor receives until a profile that can give the baud rate).
+ */
+uint32_t UART_GetBaud(void);
+
+/**
+ * @brief	Get the achieved baud rate error.
+ * @return	Error in ppm (positive if faster than requested).
+ */
+int32_t UART_GetBaudError(void);
+
+/**
+ * @brief	Set flow control (UART_FLOW_NONE after UART_Init()).
+ * @param	flow: -> UART_FLOW.
+ */
+void UART_SetFlowControl(UART_FLOW flow);
+
+/**
+ * @brief	Get the number of received bytes lost since UART_Init(), to RX FIFO overruns or to a full Ring Buffer.
+ * @return	Bytes lost.
+ */
+uint32_t UART_GetOverruns(void);
+
 /**
  * @brief	Check if there is an unread character in RX FIFO.
  * @return	True if there's an unread character in RX, false otherwise.
@@ -329,6 +427,7 @@ uint32_t UART_WriteString(unsigned char *str);
 
 /**
  * @brief	Printf to TX FIFO.
+ * @note	Output is formatted straight into the TX ring buffer (see format.h), up to UART_MAX_SRING_LENGTH chars.
  * @param	format: -> Format String.
  * @param	...: -> Printf paramters.
  */
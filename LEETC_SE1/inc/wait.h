@@ -24,6 +24,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "clock.h"
 
 #ifdef FREERTOS
 	#include "FreeRTOS.h"
@@ -69,6 +71,26 @@
  */
 #define SYSTICK_FREQ (SystemCoreClock / 1000)
 
+/**
+ * @brief	Timer wheel: bits of time (us) per level, i.e. log2 of slots per level.
+ */
+#define WHEEL_LEVEL_BITS 5
+
+/**
+ * @brief	Timer wheel: slots per level.
+ */
+#define WHEEL_SLOTS (1 << WHEEL_LEVEL_BITS)
+
+/**
+ * @brief	Timer wheel: number of levels (enough to cover all 32 bits of time).
+ */
+#define WHEEL_LEVELS ((32 + WHEEL_LEVEL_BITS - 1) / WHEEL_LEVEL_BITS)
+
+/**
+ * @brief	Timer wheel: longest delay or period (us), about 35 minutes.
+ */
+#define WHEEL_MAX_US 0x7FFFFFFFUL
+
 /**
  * @brief	Type of resource to use in WAIT API.
  */
@@ -83,6 +105,7 @@ typedef enum
 	IRQ2, /*!< to use the IRQ (Interrupt Request) resource of timer2. */
 	TIM3, /*!< to use the TIMER resource of timer3. */
 	IRQ3, /*!< to use the IRQ (Interrupt Request) resource of timer3. */
+	WHEEL, /*!< to use the timer wheel (any number of software timers), on timer2. */
 } WAIT;
 
 /**
@@ -120,6 +143,24 @@ typedef enum
 } TIMER_PCLK_BITS;
 
 
+/**
+ * @brief	Software timer, run by the timer wheel.
+ * @note	Declare one per timer (static or global, as it is linked into the wheel while active).
+ * 			Fields are private to wait.c: only use WAIT_WHEEL functions on it.
+ */
+typedef struct WAIT_TIMER
+{
+	struct WAIT_TIMER * next; /*!< Next timer in the same slot. */
+	struct WAIT_TIMER ** link; /*!< Pointer pointing to this timer (slot head, or previous timer's 'next'). */
+	uint32_t expiry; /*!< Time (us) it expires at. */
+	uint32_t period; /*!< Period (us), or 0 if one-shot. */
+	void (*f)(void); /*!< Function to be executed upon expiry. */
+	uint8_t level; /*!< Wheel level it is in. */
+	uint8_t slot; /*!< Slot it is in. */
+	volatile bool active; /*!< Whether it is in the wheel. */
+} WAIT_TIMER;
+
+
 /*
  *
  *
@@ -207,6 +248,47 @@ void WAIT_TIM3_Us(uint32_t micros);
  */
 void WAIT_IRQ3_Us(uint32_t micros, void (*f)(void));
 
+/**
+ * @brief	Starts (or restarts) a software timer.
+ * @note	Requires timer wheel Initialisation [WHEEL].
+ * @param	timer : -> Timer to start. If already active, it is stopped first.
+ * @param	micros: -> The whole number of microseconds until it expires (at most WHEEL_MAX_US).
+ * @param	period: -> Then, expire every 'period' microseconds (at most WHEEL_MAX_US), or 0 to expire once.
+ * @param	f	  : -> Function to be executed upon expiry, in interrupt context.
+ * @note	Takes constant time, whatever the number of active timers. Can be called from 'f'.
+ */
+void WAIT_WHEEL_Start(WAIT_TIMER *timer, uint32_t micros, uint32_t period, void (*f)(void));
+
+/**
+ * @brief	Stops a software timer, if active.
+ * @note	Requires timer wheel Initialisation [WHEEL].
+ * @param	timer: -> Timer to stop.
+ * @note	Takes constant time, whatever the number of active timers. Can be called from any timer's function.
+ */
+void WAIT_WHEEL_Stop(WAIT_TIMER *timer);
+
+/**
+ * @brief	Ask if a software timer is active (waiting to expire).
+ * @param	timer: -> Timer requested.
+ * @return  True if requested timer is active, false if not.
+ */
+bool WAIT_WHEEL_IsActive(WAIT_TIMER *timer);
+
+/**
+ * @brief	Waits a number of microseconds, on the timer wheel's clock.
+ * @note	Requires timer wheel Initialisation [WHEEL]. Does not use any software timer.
+ * @param	micros: -> The whole number of microseconds to wait.
+ */
+void WAIT_WHEEL_Us(uint32_t micros);
+
+/**
+ * @brief	Get difference in microseconds from parameter, on the timer wheel's clock.
+ * @note	Requires timer wheel Initialisation [WHEEL].
+ * @param	start: -> if 0 get current microseconds.
+ * @return	Elapsed us since start.
+ */
+uint32_t WAIT_WHEEL_GetElapsedUs(uint32_t start);
+
 /**
  * @brief	Ask if a specified timer is busy (waiting to interrupt).
  * @param	timer: -> Timer requested.
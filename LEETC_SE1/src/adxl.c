@@ -16,6 +16,9 @@
 #ifdef FREERTOS
 	static QueueHandle_t queueADXL; // ADXL Queue
 	void ADXL_AxisTask(void *pvParameters); // ADXL Axis Updater Task
+
+	RTOS_TASK_STORAGE(taskADXL_AXIS, TASK_ADXL_AXIS_STACK_SIZE);
+	RTOS_QUEUE_STORAGE(queueADXL, ADXL_QUEUE_LENGTH, sizeof(AXIS));
 #endif
 
 
@@ -91,12 +94,12 @@ int32_t ADXL_Init(int frequency, int dataResolution) {
 	if (ADXL_Transfer(txBuffer, rxBuffer, 2) < 0) return -1;
 
 	#ifdef FREERTOS
-		if (xTaskCreate(ADXL_AxisTask, (const char * const) "ADXL Axis Task", TASK_ADXL_AXIS_STACK_SIZE, NULL, TASK_ADXL_AXIS_PRIORITY, NULL) != pdPASS) {
+		if (RTOS_TaskCreate(taskADXL_AXIS, ADXL_AxisTask, (const char * const) "ADXL Axis Task", TASK_ADXL_AXIS_STACK_SIZE, NULL, TASK_ADXL_AXIS_PRIORITY, NULL) != pdPASS) {
 			printf("ADXL Axis Task could not be created.\n");
 			return -1;
 		}
 
-		if ((queueADXL = xQueueCreate(1, sizeof(AXIS))) == NULL) {
+		if ((queueADXL = RTOS_QueueCreate(queueADXL, ADXL_QUEUE_LENGTH, sizeof(AXIS))) == NULL) {
 			printf("Could not initialise queueADXL");
 			return -1;
 		}
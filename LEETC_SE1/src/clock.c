@@ -0,0 +1,136 @@
+/*
+ * clock.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ */
+
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#endif
+
+#include "clock.h"
+
+
+#define PLL0CON_ENABLE (1 << 0)
+#define PLL0CON_CONNECT (1 << 1)
+#define PLL0STAT_ENABLED (1 << 24)
+#define PLL0STAT_CONNECTED (1 << 25)
+#define PLL0STAT_LOCKED (1 << 26)
+
+#define FLASHCFG_TIM_MASK (0x0F << 12)
+#define FLASHCFG_TIM(clocks) (((clocks) - 1) << 12) // Flash accesses take 'clocks' CPU clocks
+#define FLASHCFG_TIM_SAFE FLASHCFG_TIM(6) // Safe at any CPU clock
+
+/*
+ * Profile: PLL0 output = 2 * M * CLOCK_OSCILLATOR / N (275 to 550 MHz), and CCLK = PLL0 output / divider.
+ */
+typedef struct {
+	uint16_t m;
+	uint8_t n;
+	uint8_t divider;
+	uint8_t flashClocks; // 1 per 20 MHz of CCLK, or part of it
+} CLOCK_CONFIG;
+
+static const CLOCK_CONFIG profiles[] = {
+	[CLOCK_FULL] = {100, 6, 4, 5}, // 400 MHz / 4 = 100 MHz (PLL0CFG_Val and CCLKCFG_Val of system_LPC17xx.c)
+	[CLOCK_REDUCED] = {12, 1, 12, 2}, // 288 MHz / 12 = 24 MHz
+};
+
+static CLOCK_PROFILE current = CLOCK_FULL;
+
+static void (*handlers[CLOCK_MAX_HANDLERS])(void);
+static int handlerCount = 0;
+
+
+static void CLOCK_Feed(void) {
+	LPC_SC->PLL0FEED = 0xAA;
+	LPC_SC->PLL0FEED = 0x55;
+}
+
+int32_t CLOCK_SetProfile(CLOCK_PROFILE profile) {
+	if ((unsigned) profile >= sizeof(profiles) / sizeof(profiles[0])) return -1;
+	if (profile == current) return 0;
+
+	const CLOCK_CONFIG *config = &profiles[profile];
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	LPC_SC->FLASHCFG = (LPC_SC->FLASHCFG & ~FLASHCFG_TIM_MASK) | FLASHCFG_TIM_SAFE; // Before CCLK may go up
+
+	// PLL0 change sequence (UM10360, 4.5.13): disconnect, disable, configure, enable, lock, connect.
+	if (LPC_SC->PLL0STAT & PLL0STAT_CONNECTED) {
+		LPC_SC->PLL0CON = PLL0CON_ENABLE;
+		CLOCK_Feed();
+	}
+	LPC_SC->PLL0CON = 0;
+	CLOCK_Feed();
+
+	LPC_SC->PLL0CFG = ((config->n - 1) << 16) | (config->m - 1);
+	CLOCK_Feed();
+
+	LPC_SC->PLL0CON = PLL0CON_ENABLE;
+	CLOCK_Feed();
+
+	LPC_SC->CCLKCFG = config->divider - 1;
+
+	while (!(LPC_SC->PLL0STAT & PLL0STAT_LOCKED)); // Wait for lock
+
+	LPC_SC->PLL0CON = PLL0CON_ENABLE | PLL0CON_CONNECT;
+	CLOCK_Feed();
+
+	while ((LPC_SC->PLL0STAT & (PLL0STAT_ENABLED | PLL0STAT_CONNECTED)) != (PLL0STAT_ENABLED | PLL0STAT_CONNECTED)); // Wait until connected
+
+	LPC_SC->FLASHCFG = (LPC_SC->FLASHCFG & ~FLASHCFG_TIM_MASK) | FLASHCFG_TIM(config->flashClocks);
+
+	SystemCoreClockUpdate();
+	current = profile;
+
+	for (int i = 0; i < handlerCount; i++) {
+		(*handlers[i])(); // Recompute dividers
+	}
+
+	__set_PRIMASK(primask);
+	return 0;
+}
+
+CLOCK_PROFILE CLOCK_GetProfile(void) {
+	return current;
+}
+
+int32_t CLOCK_AddHandler(void (*handler)(void)) {
+	for (int i = 0; i < handlerCount; i++) {
+		if (handlers[i] == handler) return 0; // Already added
+	}
+	if (handlerCount >= CLOCK_MAX_HANDLERS) return -1;
+	handlers[handlerCount++] = handler;
+	return 0;
+}
+
+void CLOCK_SetPCLK(CLOCK_PERIPHERAL peripheral, CLOCK_DIVIDER divider) {
+	uint32_t shift = (peripheral & 0x0F) * 2;
+
+	if (peripheral < 16) {
+		LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 & ~(0x03 << shift)) | ((divider & 0x03) << shift);
+	} else {
+		LPC_SC->PCLKSEL1 = (LPC_SC->PCLKSEL1 & ~(0x03 << shift)) | ((divider & 0x03) << shift);
+	}
+}
+
+uint32_t CLOCK_GetPCLK(CLOCK_PERIPHERAL peripheral) {
+	uint32_t shift = (peripheral & 0x0F) * 2;
+	uint32_t select = (peripheral < 16) ? LPC_SC->PCLKSEL0 : LPC_SC->PCLKSEL1;
+
+	switch ((select >> shift) & 0x03) {
+		case CLOCK_DIV1:
+			return SystemCoreClock;
+		case CLOCK_DIV2:
+			return SystemCoreClock/2;
+		case CLOCK_DIV8:
+			return SystemCoreClock/8;
+		case CLOCK_DIV4:
+		default:
+			return SystemCoreClock/4;
+	}
+}
@@ -7,40 +7,171 @@
 
 #include "eeprom.h"
 
+typedef struct {
+	int page; // Page number, -1 if entry is empty
+	bool dirty; // Data differs from EEPROM
+	uint32_t used; // Last access stamp, for LRU replacement
+	char data[EEPROM_PAGE_LENGTH];
+} EEPROM_CACHE_ENTRY;
+
+static EEPROM_CACHE_ENTRY cache[EEPROM_CACHE_PAGES]; // Write-back page cache
+static uint32_t cacheClock; // Access stamp counter
+static bool cacheReady = false; // Entries emptied (zeroed entries would claim page 0)
+
+static void EEPROM_CacheReset(void) {
+	for (int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+		cache[i].page = -1;
+		cache[i].dirty = false;
+		cache[i].used = 0;
+	}
+	cacheClock = 0;
+	cacheReady = true;
+}
+
+static int EEPROM_Transfer(I2C_TRANSACTION * transaction) { // Acknowledge polling: retry while EEPROM is busy writing a page
+	uint32_t start = WAIT_SYS_GetElapsedMs(0);
+	int result;
+
+	do {
+		result = I2C1_Transfer(transaction);
+	} while ((result == I2C_TRANSFER_NACK) && (WAIT_SYS_GetElapsedMs(start) <= EEPROM_WRITE_CYCLE_MS));
+
+	return (result == I2C_TRANSFER_DONE) ? 0 : -1;
+}
+
+static int EEPROM_DeviceRead(int address, char * buffer, int size) {
+	char wBuffer[] = {(address >> 8), address};
+	I2C_TRANSACTION transaction = {
+		.address = EEPROM_ADDRESS,
+		.frequency = EEPROM_FREQUENCY,
+		.wBuffer = wBuffer,
+		.wSize = sizeof(wBuffer),
+		.rBuffer = buffer, // Read straight into caller's buffer
+		.rSize = size
+	};
+	return EEPROM_Transfer(&transaction);
+}
+
+static int EEPROM_DeviceWrite(int address, char * buffer, int size) { // Must not cross a page boundary
+	char wBuffer[EEPROM_PAGE_LENGTH + 2];
+	wBuffer[0] = (address >> 8);
+	wBuffer[1] = address;
+	memcpy(wBuffer + 2, buffer, size);
+
+	I2C_TRANSACTION transaction = {
+		.address = EEPROM_ADDRESS,
+		.frequency = EEPROM_FREQUENCY,
+		.wBuffer = wBuffer,
+		.wSize = size + 2
+	};
+	return EEPROM_Transfer(&transaction); // Waits for previous page, if still being written
+}
+
+static int EEPROM_CacheWriteBack(EEPROM_CACHE_ENTRY * entry) {
+	if (entry->page < 0 || !entry->dirty) return 0;
+	if (EEPROM_DeviceWrite(entry->page * EEPROM_PAGE_LENGTH, entry->data, EEPROM_PAGE_LENGTH) < 0) return -1;
+	entry->dirty = false;
+	return 0;
+}
+
+static EEPROM_CACHE_ENTRY * EEPROM_CacheFind(int page) { // Every cache access starts here
+	if (!cacheReady) EEPROM_CacheReset(); // Used before EEPROM_Init()
+	for (int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+		if (cache[i].page == page) {
+			cache[i].used = ++cacheClock;
+			return &cache[i];
+		}
+	}
+	return NULL;
+}
+
+static EEPROM_CACHE_ENTRY * EEPROM_CacheGet(int page, bool fill) { // Take least recently used entry for page, reading it if fill
+	EEPROM_CACHE_ENTRY * entry = &cache[0];
+	for (int i = 1; i < EEPROM_CACHE_PAGES; i++) {
+		if (cache[i].used < entry->used) entry = &cache[i];
+	}
+
+	if (EEPROM_CacheWriteBack(entry) < 0) return NULL;
+	entry->page = -1;
+
+	if (fill && EEPROM_DeviceRead(page * EEPROM_PAGE_LENGTH, entry->data, EEPROM_PAGE_LENGTH) < 0) return NULL;
+
+	entry->page = page;
+	entry->used = ++cacheClock;
+	return entry;
+}
+
 void EEPROM_Init() {
 	I2C1_Init();
+	EEPROM_CacheReset();
 }
 
 int EEPROM_Read(char * buffer, int size) {
-	char wBuffer[] = {EEPROM_ADDRESS << 1, 0x00, 0x00, (EEPROM_ADDRESS << 1) | 1};
-	I2C1_Configure(EEPROM_FREQUENCY, size, wBuffer, 3);
-	if (I2C1_Start() < 0) return -1;
-	if (I2C1_Engine() < 0) return -1;
-	I2C1_Stop();
-	I2C1_GetBuffer(buffer);
-	return 0;
+	return EEPROM_ReadAt(0, buffer, size);
 }
 
 int EEPROM_Write(char * buffer, int size) {
-	for (int16_t n = 0; n < size; n += 32) {
-		int pageLength = (size - n < 32) ? size - n : 32;
+	return EEPROM_WriteAt(0, buffer, size);
+}
 
-		char wBuffer[EEPROM_PAGE_LENGTH + 3];
-		wBuffer[0] = EEPROM_ADDRESS << 1;
-		wBuffer[1] = (n >> 8);
-		wBuffer[2] = n;
+int EEPROM_ReadAt(int address, char * buffer, int size) {
+	if ((address < 0) || (size < 0) || (address + size > EEPROM_SIZE)) return -1;
 
-		for (int i = 0; i < pageLength; i++) {
-			wBuffer[3 + i] = buffer[n + i];
+	for (int n = 0; n < size;) {
+		int page = (address + n) / EEPROM_PAGE_LENGTH;
+		int offset = (address + n) % EEPROM_PAGE_LENGTH;
+		int pageLength = (size - n < EEPROM_PAGE_LENGTH - offset) ? size - n : EEPROM_PAGE_LENGTH - offset;
+
+		EEPROM_CACHE_ENTRY * entry = EEPROM_CacheFind(page);
+		if (entry == NULL && pageLength == EEPROM_PAGE_LENGTH) { // Whole page not cached: don't let bulk reads flush the cache
+			if (EEPROM_DeviceRead(address + n, buffer + n, pageLength) < 0) return -1;
+		}
+		else {
+			if (entry == NULL && (entry = EEPROM_CacheGet(page, true)) == NULL) return -1;
+			memcpy(buffer + n, entry->data + offset, pageLength);
 		}
 
-		I2C1_Configure(EEPROM_FREQUENCY, 0, wBuffer, pageLength + 3);
-		if (I2C1_Start() < 0) return -1;
-		if (I2C1_Engine() < 0) return -1;
-		I2C1_Stop();
+		n += pageLength;
+	}
+
+	return 0;
+}
 
-		WAIT_SYS_Ms(5); // Wait between pages
+int EEPROM_WriteAt(int address, char * buffer, int size) {
+	if (EEPROM_WriteCached(address, buffer, size) < 0) return -1;
+	return EEPROM_Flush(); // Write through
+}
+
+int EEPROM_WriteCached(int address, char * buffer, int size) {
+	if ((address < 0) || (size < 0) || (address + size > EEPROM_SIZE)) return -1;
+
+	for (int n = 0; n < size;) {
+		int page = (address + n) / EEPROM_PAGE_LENGTH;
+		int offset = (address + n) % EEPROM_PAGE_LENGTH;
+		int pageLength = (size - n < EEPROM_PAGE_LENGTH - offset) ? size - n : EEPROM_PAGE_LENGTH - offset; // Never cross a page boundary
+
+		bool whole = false; // Entry was taken without reading the page, since it's completely overwritten
+		EEPROM_CACHE_ENTRY * entry = EEPROM_CacheFind(page);
+		if (entry == NULL) {
+			whole = (pageLength == EEPROM_PAGE_LENGTH);
+			if ((entry = EEPROM_CacheGet(page, !whole)) == NULL) return -1;
+		}
+
+		if (whole || memcmp(entry->data + offset, buffer + n, pageLength) != 0) { // Unchanged data costs no bus traffic
+			memcpy(entry->data + offset, buffer + n, pageLength);
+			entry->dirty = true;
+		}
+
+		n += pageLength;
 	}
 
 	return 0;
 }
+
+int EEPROM_Flush() {
+	int ret = 0;
+	for (int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+		if (EEPROM_CacheWriteBack(&cache[i]) < 0) ret = -1;
+	}
+	return ret;
+}
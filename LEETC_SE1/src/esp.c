@@ -18,11 +18,15 @@
 	 * Binary semaphore to control access to global state.
 	 */
 	static SemaphoreHandle_t semESP = NULL;
+
+	RTOS_SEMAPHORE_STORAGE(semESP);
 #endif
 
 
 static int len = 0;
 
+static uint32_t espBaud = ESP_BAUD; // Baud rate of the link
+
 static char AT_RECEIVING_BUFFER[AT_RESPONSE_MAX_LENGTH];
 
 static uint32_t ESP_ConfigListAP(bool sort) {
@@ -38,9 +42,10 @@ bool ESP_Init(unsigned int baud) {
 	WAIT_Init(SYS);
 
 	if (!UART_Init(baud)) return false;
+	espBaud = baud;
 
 	#ifdef FREERTOS
-		if ((semESP = xSemaphoreCreateMutex()) == NULL) {
+		if ((semESP = RTOS_SemaphoreCreateMutex(semESP)) == NULL) {
 			printf("Semaphore ESP could not be created.\n");
 			return 0;
 		}
@@ -68,6 +73,29 @@ uint32_t ESP_Test(void) {
     return (ESP_WaitForString(ESP_TIMEOUT_MS, 1, "OK"));
 }
 
+uint32_t ESP_SetBaud(uint32_t baud) {
+	if (!UART_IsBaudReachable(baud)) return -1; // Before the module switches
+
+	char command[48];
+	sprintf(command, "AT+UART_CUR=%u,8,1,0,0", (unsigned) baud); // 8 data bits, 1 stop bit, no parity, no flow control
+	ESP_WriteString(command);
+	ESP_WriteString(AT_CMD_SUFFIX);
+	if (ESP_WaitForString(ESP_TIMEOUT_MS, 2, "OK", "ERROR") != 0) return -1; // Still at the old baud rate
+
+	WAIT_SYS_Ms(ESP_BAUD_SWITCH_MS);
+	UART_Init(baud);
+
+	char temp;
+	while (ESP_GetChar(&temp)); // Anything garbled by the switch
+
+	if (ESP_Test() == 0) {
+		espBaud = baud;
+		return 0;
+	}
+	UART_Init(espBaud); // Module did not switch (or did not answer)
+	return -1;
+}
+
 uint32_t ESP_Restart(void) {
 	ESP_WriteString("AT+RST");
 	ESP_WriteString(AT_CMD_SUFFIX);
@@ -0,0 +1,60 @@
+/*
+ * event.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ */
+
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#endif
+
+#include "event.h"
+
+
+static EVENT queue[EVENT_QUEUE_LENGTH];
+static volatile uint32_t head = 0; // Next to take (main loop)
+static volatile uint32_t tail = 0; // Next to write (any context)
+static volatile uint32_t dropped = 0;
+
+
+bool EVENT_Post(uint32_t type, uint32_t data) {
+	bool posted = false;
+	uint32_t primask = __get_PRIMASK(); // Producers may preempt each other
+	__disable_irq();
+
+	if ((tail - head) < EVENT_QUEUE_LENGTH) {
+		EVENT *event = &queue[tail & (EVENT_QUEUE_LENGTH - 1)];
+		event->type = type;
+		event->data = data;
+		tail++;
+		posted = true;
+	}
+	else dropped++;
+
+	__set_PRIMASK(primask);
+	return posted;
+}
+
+bool EVENT_Poll(EVENT *event) {
+	if (head == tail) return false;
+	*event = queue[head & (EVENT_QUEUE_LENGTH - 1)];
+	head++; // Single consumer: only the slot is read before freeing it
+	return true;
+}
+
+void EVENT_Wait(EVENT *event) {
+	for (;;) {
+		__disable_irq(); // So no event slips in between the check and the sleep
+		if (EVENT_Poll(event)) {
+			__enable_irq();
+			return;
+		}
+		__WFI(); // Wakes up on a pending interrupt, even while masked
+		__enable_irq(); // Let it run
+	}
+}
+
+uint32_t EVENT_GetDropped(void) {
+	return dropped;
+}
@@ -14,10 +14,71 @@
 #include "flash.h"
 
 
+#define FLASH_RAMFUNC __attribute__ ((section(".ramfunc"), noinline, long_call)) // Copied to RAM at startup, like .data
+
+
 static unsigned int command[5];
 static unsigned int output[5];
 static IAP iap_entry =  (IAP) FLASH_IAP_LOCATION;
 
+__attribute__ ((section("vtable"), aligned(256)))
+static void (*vectors[FLASH_VECTOR_COUNT])(void); // RAM vector table (VTOR needs it aligned to a power of 2 above its size)
+
+static uint32_t irqMask[2]; // Peripheral interrupts to mask during an IAP command
+static uint32_t priorityMask; // BASEPRI during an IAP command (0 for none)
+static bool tickMask; // Disable SysTick interrupt during an IAP command
+
+static bool FLASH_InFlash(void (*handler)(void)) {
+	return ((uint32_t) handler) < FLASH_SIZE;
+}
+
+static void FLASH_ComputeMasks(void) { // Find interrupts whose handler would run from flash
+	void (**table)(void) = (void (**)(void)) SCB->VTOR;
+
+	irqMask[0] = 0;
+	irqMask[1] = 0;
+	for (int irq = 0; irq < FLASH_VECTOR_COUNT - 16; irq++) {
+		if (FLASH_InFlash(table[16 + irq])) irqMask[irq >> 5] |= 1 << (irq & 0x1F);
+	}
+
+	priorityMask = FLASH_InFlash(table[14]) ? SCB->SHP[10] : 0; // PendSV (priority 0 can't be masked, but then it's not used by a kernel)
+	tickMask = FLASH_InFlash(table[15]); // SysTick
+}
+
+FLASH_RAMFUNC static void FLASH_Execute(void) { // Runs IAP command (until not busy) without touching flash. Must not call flash code.
+	uint32_t primask = __get_PRIMASK();
+	uint32_t basepri = __get_BASEPRI();
+	uint32_t masked[2];
+	uint32_t ticking;
+
+	__disable_irq();
+	masked[0] = NVIC->ISER[0] & irqMask[0];
+	masked[1] = NVIC->ISER[1] & irqMask[1];
+	NVIC->ICER[0] = masked[0];
+	NVIC->ICER[1] = masked[1];
+	if (priorityMask != 0 && (basepri == 0 || priorityMask < basepri)) __set_BASEPRI(priorityMask);
+	ticking = tickMask ? (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk) : 0;
+	SysTick->CTRL &= ~ticking;
+	__set_PRIMASK(primask); // Interrupts with handlers in RAM may run
+
+	do {
+		iap_entry(command, output);
+	} while (output[0] == BUSY);
+
+	__disable_irq();
+	SysTick->CTRL |= ticking;
+	__set_BASEPRI(basepri);
+	NVIC->ISER[0] = masked[0];
+	NVIC->ISER[1] = masked[1];
+	__set_PRIMASK(primask);
+}
+
+static unsigned int FLASH_Run(void) {
+	FLASH_ComputeMasks();
+	FLASH_Execute();
+	return output[0];
+}
+
 static unsigned int FLASH_PrepareSectors(unsigned int startSector, unsigned int endSector) {
 	// Command parameters:
 	command[0] = PREPARE_SECTORS;
@@ -25,30 +86,59 @@ static unsigned int FLASH_PrepareSectors(unsigned int startSector, unsigned int
 	command[2] = endSector;
 
 	// Execute command:
-	do {
-		iap_entry(command, output);
-	} while (output[0] == BUSY);
-	return output[0];
+	return FLASH_Run();
+}
+
+void FLASH_Init() {
+	void (**table)(void) = (void (**)(void)) SCB->VTOR;
+	if (table == vectors) return; // Already in RAM
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	for (int i = 0; i < FLASH_VECTOR_COUNT; i++) {
+		vectors[i] = table[i];
+	}
+	SCB->VTOR = (uint32_t) vectors;
+	__DSB();
+	__set_PRIMASK(primask);
+}
+
+int FLASH_SetHandler(int irq, void (*handler)(void)) {
+	if ((void (**)(void)) SCB->VTOR != vectors) return -1;
+	if (irq < -14 || irq >= FLASH_VECTOR_COUNT - 16) return -1;
+
+	vectors[16 + irq] = handler;
+	return 0;
 }
 
 unsigned int FLASH_EraseSectors(unsigned int startSector, unsigned int endSector) {
+	return FLASH_EraseSectorsProgress(startSector, endSector, NULL);
+}
+
+unsigned int FLASH_EraseSectorsProgress(unsigned int startSector, unsigned int endSector, FLASH_PROGRESS progress) {
 	// Verify sectors:
 	if (endSector < startSector) return INVALID_SECTOR;
 
-	// Prepare sectors:
-	if (FLASH_PrepareSectors(startSector, endSector) == INVALID_SECTOR) return INVALID_SECTOR;
+	for (unsigned int sector = startSector; sector <= endSector; sector++) {
+		// Prepare sector:
+		if (FLASH_PrepareSectors(sector, sector) == INVALID_SECTOR) return INVALID_SECTOR;
 
-	// Command parameters:
-	command[0] = ERASE_SECTORS;
-	command[1] = startSector;
-	command[2] = endSector;
-	command[3] = SystemCoreClock/1000;
+		// Command parameters:
+		command[0] = ERASE_SECTORS;
+		command[1] = sector;
+		command[2] = sector;
+		command[3] = SystemCoreClock/1000;
 
-	// Execute command:
-	do {
-		iap_entry(command, output);
-	} while (output[0] == BUSY);
-	return output[0];
+		// Execute command:
+		if (FLASH_Run() != CMD_SUCCESS) return output[0];
+
+		if (progress != NULL) progress(sector - startSector + 1, endSector - startSector + 1);
+
+		#ifdef FREERTOS
+			if (sector < endSector) vTaskDelay(1); // Let other tasks (and ticks) run between sectors
+		#endif
+	}
+	return CMD_SUCCESS;
 }
 
 unsigned int FLASH_WriteData(unsigned int sector, void *dstAddr, void *srcAddr, unsigned int size) {
@@ -63,10 +153,7 @@ unsigned int FLASH_WriteData(unsigned int sector, void *dstAddr, void *srcAddr,
 	command[4] = SystemCoreClock/1000;
 
 	// Execute command:
-	do {
-		iap_entry(command, output);
-	} while (output[0] == BUSY);
-	return output[0];
+	return FLASH_Run();
 }
 
 unsigned int FLASH_VerifyData(void *dstAddr, void *srcAddr, unsigned int size) {
@@ -77,8 +164,5 @@ unsigned int FLASH_VerifyData(void *dstAddr, void *srcAddr, unsigned int size) {
 	command[3] = size;
 
 	// Execute command:
-	do {
-		iap_entry(command, output);
-	} while (output[0] == BUSY);
-	return output[0];
+	return FLASH_Run();
 }
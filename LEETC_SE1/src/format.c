@@ -0,0 +1,138 @@
+/*
+ * format.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ */
+
+#include "format.h"
+
+
+#define FORMAT_LEFT 1 // '-' flag
+#define FORMAT_ZERO 2 // '0' flag
+
+#define FORMAT_DIGITS 11 // Enough for a 32-bit int, sign included
+
+
+typedef struct {
+	FORMAT_SINK sink;
+	void * context;
+	int limit; // Chars left, or < 0 if unbounded
+	int count; // Chars given to sink
+} FORMAT_OUTPUT;
+
+
+static void FORMAT_Put(FORMAT_OUTPUT * out, char ch) {
+	if (out->limit == 0) return;
+	if (out->limit > 0) out->limit--;
+	out->sink(out->context, ch);
+	out->count++;
+}
+
+static void FORMAT_Pad(FORMAT_OUTPUT * out, char ch, int n) {
+	while (n-- > 0) FORMAT_Put(out, ch);
+}
+
+static void FORMAT_Field(FORMAT_OUTPUT * out, const char * str, int length, int width, int flags) {
+	int pad = (width > length) ? width - length : 0;
+
+	if (!(flags & FORMAT_LEFT)) FORMAT_Pad(out, ' ', pad);
+	while (length-- > 0) FORMAT_Put(out, *str++);
+	if (flags & FORMAT_LEFT) FORMAT_Pad(out, ' ', pad);
+}
+
+static void FORMAT_Number(FORMAT_OUTPUT * out, unsigned int value, bool negative, unsigned int base, char letter, int width, int flags) {
+	char digits[FORMAT_DIGITS];
+	int length = 0;
+
+	do { // Least significant first
+		unsigned int digit = value % base;
+		digits[length++] = (char) ((digit < 10) ? '0' + digit : letter + digit - 10);
+		value /= base;
+	} while (value != 0);
+
+	int size = length + (negative ? 1 : 0);
+	int pad = (width > size) ? width - size : 0;
+
+	if (!(flags & (FORMAT_LEFT | FORMAT_ZERO))) FORMAT_Pad(out, ' ', pad);
+	if (negative) FORMAT_Put(out, '-');
+	if ((flags & FORMAT_ZERO) && !(flags & FORMAT_LEFT)) FORMAT_Pad(out, '0', pad);
+	while (length > 0) FORMAT_Put(out, digits[--length]);
+	if (flags & FORMAT_LEFT) FORMAT_Pad(out, ' ', pad);
+}
+
+int FORMAT_Print(FORMAT_SINK sink, void * context, int limit, const char * format, va_list args) {
+	FORMAT_OUTPUT out = {.sink = sink, .context = context, .limit = limit, .count = 0};
+
+	for (; *format != '\0' && out.limit != 0; format++) {
+		if (*format != '%') {
+			FORMAT_Put(&out, *format);
+			continue;
+		}
+
+		int flags = 0, width = 0;
+
+		for (format++; *format == '-' || *format == '0'; format++) {
+			flags |= (*format == '-') ? FORMAT_LEFT : FORMAT_ZERO;
+		}
+		for (; *format >= '0' && *format <= '9'; format++) {
+			width = width * 10 + (*format - '0');
+		}
+		if (*format == 'l') format++;
+
+		switch (*format) {
+			case 'd': {
+				int value = va_arg(args, int);
+				FORMAT_Number(&out, (value < 0) ? 0U - (unsigned int) value : (unsigned int) value, value < 0, 10, 'a', width, flags);
+				break;
+			}
+			case 'u':
+				FORMAT_Number(&out, va_arg(args, unsigned int), false, 10, 'a', width, flags);
+				break;
+			case 'x':
+				FORMAT_Number(&out, va_arg(args, unsigned int), false, 16, 'a', width, flags);
+				break;
+			case 'X':
+				FORMAT_Number(&out, va_arg(args, unsigned int), false, 16, 'A', width, flags);
+				break;
+			case 'c': {
+				char ch = (char) va_arg(args, int);
+				FORMAT_Field(&out, &ch, 1, width, flags);
+				break;
+			}
+			case 's': {
+				const char * str = va_arg(args, const char *);
+				int length = 0;
+				if (str == NULL) str = "(null)";
+				while (str[length] != '\0') length++;
+				FORMAT_Field(&out, str, length, width, flags);
+				break;
+			}
+			case '%':
+				FORMAT_Put(&out, '%');
+				break;
+			case '\0':
+				return out.count; // Trailing '%'
+			default: // Unsupported: print it as is
+				FORMAT_Put(&out, '%');
+				FORMAT_Put(&out, *format);
+				break;
+		}
+	}
+
+	return out.count;
+}
+
+static void FORMAT_BufferSink(void * context, char ch) {
+	char ** cursor = (char **) context;
+	*(*cursor)++ = ch;
+}
+
+int FORMAT_String(char * buffer, int size, const char * format, va_list args) {
+	if (size <= 0) return 0;
+
+	char * cursor = buffer;
+	int count = FORMAT_Print(FORMAT_BufferSink, &cursor, size - 1, format, args); // Room for terminator
+	buffer[count] = '\0';
+	return count;
+}
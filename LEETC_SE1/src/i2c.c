@@ -13,40 +13,34 @@
 #include "i2c.h"
 
 
-static char I2C1WriteBuffer[I2C_BUFFER_LENGTH]; // Data being transmitted in I2C1 interface
+static char I2C1WriteBuffer[I2C_BUFFER_LENGTH]; // Data being transmitted in I2C1 interface (compatibility API)
 static char I2C2WriteBuffer[I2C_BUFFER_LENGTH]; // Data being transmitted in I2C2 interface
 
-static char I2C1ReadBuffer[I2C_BUFFER_LENGTH]; // Data being received in I2C1 interface
+static char I2C1ReadBuffer[I2C_BUFFER_LENGTH]; // Data being received in I2C1 interface (compatibility API)
 static char I2C2ReadBuffer[I2C_BUFFER_LENGTH]; // Data being received in I2C2 interface
 
-static int I2C1WriteLength; // Length of data to be transmitted in I2C1 interface in bytes
 static int I2C2WriteLength; // Length of data to be transmitted in I2C2 interface in bytes
 
-static int I2C1ReadLength; // Length of data to be received in I2C1 interface in bytes
 static int I2C2ReadLength; // Length of data to be received in I2C2 interface in bytes
 
-static int I2C1WriteIndex; // Current byte to be transmitted in I2C1 interface
 static int I2C2WriteIndex; // Current byte to be transmitted in I2C2 interface
 
-static int I2C1ReadIndex; // Current byte to be received in I2C1 interface
 static int I2C2ReadIndex; // Current byte to be received in I2C2 interface
 
-static I2C_STATE I2C1State; // Current state in I2C1 device driver
 static I2C_STATE I2C2State; // Current state in I2C2 device driver
+static int I2C2Frequency = 0; // Frequency given to I2C2_Configure(), for I2C2_ClockChanged()
 
-static uint32_t I2C_GetPCLK(void) {
-	switch ((LPC_SC->PCLKSEL0 >> 6) & 0x03) {
-		case 0x00:
-			return SystemCoreClock/4;
-		case 0x01:
-			return SystemCoreClock;
-		case 0x02:
-			return SystemCoreClock/2;
-		case 0x03:
-			return SystemCoreClock/8;
-		default:
-			return -1;
-	}
+static I2C_TRANSACTION * I2C1Queue[I2C_QUEUE_LENGTH]; // Pending transactions in I2C1 interface, head is on the bus
+static volatile int I2C1QueueHead; // Index of transaction on the bus
+static volatile int I2C1QueueCount; // Number of pending transactions
+
+static I2C_TRANSACTION I2C1Legacy; // Transaction used by I2C1 compatibility API
+
+static void I2C2_ClockChanged(void) { // I2C1 computes its dividers per transaction
+	if (I2C2Frequency == 0) return;
+	int freq_div = CLOCK_GetPCLK(CLOCK_I2C2)/I2C2Frequency;
+	LPC_I2C2->I2SCLH = freq_div >> 1; // Set duty cycle (high)
+	LPC_I2C2->I2SCLL = freq_div >> 1; // Set duty cycle (low)
 }
 
 static int I2C_IsEnabled(IRQn_Type IRQ) { // See if i2c interrupts are enabled
@@ -54,103 +48,144 @@ static int I2C_IsEnabled(IRQn_Type IRQ) { // See if i2c interrupts are enabled
 }
 
 
-void I2C1_IRQHandler(void) { // I2C1 interrupt handler
+static void I2C1_Lock(void) { // Keep I2C1 interrupt (and other tasks) away from the queue
+	#ifdef FREERTOS
+		taskENTER_CRITICAL();
+	#else
+		NVIC_DisableIRQ(I2C1_IRQn);
+	#endif
+}
+
+static void I2C1_Unlock(void) {
+	#ifdef FREERTOS
+		taskEXIT_CRITICAL();
+	#else
+		NVIC_EnableIRQ(I2C1_IRQn);
+	#endif
+}
+
+static void I2C1_Kick(void) { // Start transaction at the head of the queue (queue must not be empty)
+	I2C_TRANSACTION * transaction = I2C1Queue[I2C1QueueHead];
+
+	int freq_div = CLOCK_GetPCLK(CLOCK_I2C1)/transaction->frequency;
+	LPC_I2C1->I2SCLH = freq_div >> 1; // Set duty cycle (high)
+	LPC_I2C1->I2SCLL = freq_div >> 1; // Set duty cycle (low)
+
+	transaction->wIndex = 0;
+	transaction->rIndex = 0;
+
+	LPC_I2C1->I2CONSET = STA; // If STOP is still pending, START follows it
+}
+
+static I2C_TRANSACTION * I2C1_Finish(int result) { // Remove transaction at the head of the queue and set its result
+	I2C_TRANSACTION * transaction = I2C1Queue[I2C1QueueHead];
+
+	I2C1QueueHead = (I2C1QueueHead + 1) % I2C_QUEUE_LENGTH;
+	I2C1QueueCount--;
+
+	transaction->result = result;
+	return transaction;
+}
+
+static void I2C1_Handler(void) { // Runs whole transactions, one after the other.
+	I2C_TRANSACTION * transaction = (I2C1QueueCount > 0) ? I2C1Queue[I2C1QueueHead] : NULL;
+	int result = I2C_TRANSFER_PENDING;
+
+	if (transaction == NULL) { // Nothing on the bus (transaction was cancelled)
+		LPC_I2C1->I2CONSET = STO;
+		LPC_I2C1->I2CONCLR = STA | AA | SI;
+		return;
+	}
 
 	switch (LPC_I2C1->I2STAT) {
-		case I2C_START: // Start
-			I2C1WriteIndex = 0;
-			LPC_I2C1->I2DAT = I2C1WriteBuffer[I2C1WriteIndex++];
+		case I2C_START: // Start: [SLA + W], or [SLA + R] if there's nothing to write
+			LPC_I2C1->I2DAT = (transaction->address << 1) | ((transaction->wSize == 0) && (transaction->rSize > 0));
 			LPC_I2C1->I2CONCLR = STA;
-			I2C1State = I2C_BUSY;
 			break;
 
-		case I2C_REPEATED_START: // Repeated Start
-			I2C1ReadIndex = 0;
-			LPC_I2C1->I2DAT = I2C1WriteBuffer[I2C1WriteIndex++];
+		case I2C_REPEATED_START: // Repeated Start: [SLA + R]
+			LPC_I2C1->I2DAT = (transaction->address << 1) | 1;
 			LPC_I2C1->I2CONCLR = STA;
-			I2C1State = I2C_BUSY;
 			break;
 
 		case I2C_SLAW_ACK: // [SLA + W] transmitted and ACK received
-			if (I2C1WriteLength == 1) { // There's no data to send
-				LPC_I2C1->I2CONSET = STO; // Set STOP flag
-				I2C1State = I2C_IDLE;
+		case I2C_DATAW_ACK: // Data byte transmitted, ACK received
+			if (transaction->wIndex < transaction->wSize) {
+				LPC_I2C1->I2DAT = transaction->wBuffer[transaction->wIndex++]; // Keep transmitting
+			}
+			else if (transaction->rSize > 0) { // There's something to receive
+				LPC_I2C1->I2CONSET = STA; // Repeated start for read operation
 			}
 			else {
-				LPC_I2C1->I2DAT = I2C1WriteBuffer[I2C1WriteIndex++];
+				result = I2C_TRANSFER_DONE;
 			}
 			break;
 
 		case I2C_SLAW_NACK: // [SLA + W] transmitted and NACK received
-			LPC_I2C1->I2CONSET = STO;
-			I2C1State = I2C_IDLE;
-			break;
-
-		case I2C_DATAW_ACK: // Data byte transmitted, ACK received
-			if (I2C1WriteIndex < I2C1WriteLength) {
-				LPC_I2C1->I2DAT = I2C1WriteBuffer[I2C1WriteIndex++]; // Keep transmitting
-			}
-			else { // There's nothing more to transmit
-				if (I2C1ReadLength != 0) { // There's something to receive
-					LPC_I2C1->I2CONSET = STA; // Repeated start for read operation
-				}
-				else {
-					LPC_I2C1->I2CONSET = STO;
-					I2C1State = I2C_IDLE;
-				}
-			}
-			break;
-
-		case I2C_DATAW_NACK: // Data byte transmitted, NACK received
-			LPC_I2C1->I2CONSET = STO;
-			I2C1State = I2C_IDLE;
-			break;
-
-		case I2C_ARBITRATION_LOST: // Arbitration lost. This API doesn't handle with multiple Master operations.
-			LPC_I2C1->I2CONSET = STO;
-			I2C1State = I2C_IDLE;
+		case I2C_SLAR_NACK: // [SLA + R] transmitted and NACK received
+			result = I2C_TRANSFER_NACK;
 			break;
 
 		case I2C_SLAR_ACK: // [SLA + R] transmitted and ACK received
-			if (I2C1ReadLength > 0) {
-				// Will go to I2C_DATAR_ACK
-				LPC_I2C1->I2CONSET = AA; // Assert ACK
+			if (transaction->rSize > 1) {
+				LPC_I2C1->I2CONSET = AA; // Assert ACK, more bytes follow
 			}
 			else {
-				// Will go to I2C_DATAR_NACK
-				LPC_I2C1->I2CONCLR = AA; // Assert NACK
+				LPC_I2C1->I2CONCLR = AA; // Assert NACK on the only byte
 			}
 			break;
 
-		case I2C_SLAR_NACK: // [SLA + R] transmitted and NACK received.
-			LPC_I2C1->I2CONSET = STO;
-			I2C1State = I2C_IDLE;
-			break;
-
 		case I2C_DATAR_ACK: // Data byte received, ACK returned
-			I2C1ReadBuffer[I2C1ReadIndex++] = LPC_I2C1->I2DAT;
-			if (I2C1ReadIndex < I2C1ReadLength) {
+			transaction->rBuffer[transaction->rIndex++] = LPC_I2C1->I2DAT;
+			if (transaction->rIndex < transaction->rSize - 1) {
 				LPC_I2C1->I2CONSET = AA; // Assert ACK
 			}
 			else {
-				LPC_I2C1->I2CONCLR = AA; // Assert NACK
+				LPC_I2C1->I2CONCLR = AA; // Assert NACK on the last byte
 			}
 			break;
 
 		case I2C_DATAR_NACK: // Data byte received, NACK returned
-			I2C1ReadBuffer[I2C1ReadIndex++] = LPC_I2C1->I2DAT;
-			LPC_I2C1->I2CONSET = STO;
-			I2C1State = I2C_IDLE;
+			transaction->rBuffer[transaction->rIndex++] = LPC_I2C1->I2DAT;
+			result = I2C_TRANSFER_DONE;
 			break;
 
+		case I2C_DATAW_NACK: // Data byte transmitted, NACK received
+		case I2C_ARBITRATION_LOST: // Arbitration lost. This API doesn't handle with multiple Master operations.
 		default:
-			LPC_I2C1->I2CONSET = STO;
-			I2C1State = I2C_IDLE;
+			result = I2C_TRANSFER_ERROR;
 			break;
 	}
+
+	if (result != I2C_TRANSFER_PENDING) { // Transaction ended
+		#ifdef FREERTOS
+			TaskHandle_t task = transaction->task;
+		#endif
+
+		LPC_I2C1->I2CONSET = STO;
+		LPC_I2C1->I2CONCLR = AA;
+		I2C1_Finish(result);
+		if (I2C1QueueCount > 0) I2C1_Kick(); // Next transaction starts right after STOP
+		LPC_I2C1->I2CONCLR = SI;
+
+		#ifdef FREERTOS
+			if (task != NULL) {
+				BaseType_t woken = pdFALSE;
+				xTaskNotifyFromISR(task, I2C_NOTIFY_BIT, eSetBits, &woken);
+				portYIELD_FROM_ISR(woken);
+			}
+		#endif
+		return;
+	}
 	LPC_I2C1->I2CONCLR = SI;
 }
 
+void I2C1_IRQHandler(void) { // I2C1 interrupt handler
+	TRACE_ISR_ENTER(TRACE_I2C_IRQ);
+	I2C1_Handler();
+	TRACE_ISR_EXIT(TRACE_I2C_IRQ);
+}
+
 void I2C2_IRQHandler(void) { // I2C2 interrupt handler
 	switch (LPC_I2C2->I2STAT) {
 			case I2C_START: // Start
@@ -245,7 +280,7 @@ void I2C1_Init() {
 
 	LPC_SC->PCONP |= I2C1_PCONP_ENABLE;
 
-	LPC_SC->PCLKSEL1 &= ~(0x03 << 6); // Set PCLK to CCLK/4
+	CLOCK_SetPCLK(CLOCK_I2C1, CLOCK_DIV4); // Set PCLK to CCLK/4
 
 	LPC_PINCON->PINSEL1 &= ~(0x0F << 6); // Clear SDA1 and SCL1 PINSEL BITS
 	LPC_PINCON->PINSEL1 |= ((I2C1_PINSEL & 0x03) << 6); // SDA1
@@ -256,6 +291,13 @@ void I2C1_Init() {
 
 	LPC_PINCON->PINMODE_OD0 |= ((0x1<<19)|(0x1<<20));
 
+	I2C1QueueHead = 0;
+	I2C1QueueCount = 0;
+
+	#ifdef FREERTOS
+		NVIC_SetPriority(I2C1_IRQn, I2C1_IRQ_PRIORITY); // Handler uses FreeRTOS API
+	#endif
+
 	if (!I2C_IsEnabled(I2C1_IRQn)) { // If it's not already enabled:
 		NVIC_EnableIRQ(I2C1_IRQn); // Enable interrupts for I2C1 interface
 	}
@@ -270,7 +312,8 @@ void I2C2_Init() {
 
 	LPC_SC->PCONP |= I2C2_PCONP_ENABLE;
 
-	LPC_SC->PCLKSEL1 &= ~(0x03 << 20); // Set PCLK to CCLK/4
+	CLOCK_SetPCLK(CLOCK_I2C2, CLOCK_DIV4); // Set PCLK to CCLK/4
+	CLOCK_AddHandler(I2C2_ClockChanged);
 
 	LPC_PINCON->PINSEL0 &= ~(0x0F << 20); // Clear SDA1 and SCL1 PINSEL BITS
 	LPC_PINCON->PINSEL0 |= ((I2C2_PINSEL & 0x03) << 20); // SDA1
@@ -290,17 +333,102 @@ void I2C2_Init() {
 	LPC_I2C2->I2CONSET = I2EN; // Enable interrupts
 }
 
+int I2C1_Submit(I2C_TRANSACTION * transaction) {
+	if (transaction == NULL || transaction->frequency <= 0) return -1;
+	if (transaction->wSize < 0 || (transaction->wSize > 0 && transaction->wBuffer == NULL)) return -1;
+	if (transaction->rSize < 0 || (transaction->rSize > 0 && transaction->rBuffer == NULL)) return -1;
+
+	transaction->result = I2C_TRANSFER_PENDING;
+
+	I2C1_Lock();
+	if (I2C1QueueCount == I2C_QUEUE_LENGTH) { // Queue is full
+		I2C1_Unlock();
+		transaction->result = I2C_TRANSFER_ERROR;
+		return -1;
+	}
+	I2C1Queue[(I2C1QueueHead + I2C1QueueCount) % I2C_QUEUE_LENGTH] = transaction;
+	I2C1QueueCount++;
+	if (I2C1QueueCount == 1) I2C1_Kick(); // Bus was idle
+	I2C1_Unlock();
+
+	return 0;
+}
+
+int I2C1_Cancel(I2C_TRANSACTION * transaction) {
+	I2C1_Lock();
+	for (int i = 0; (i < I2C1QueueCount) && (transaction->result == I2C_TRANSFER_PENDING); i++) {
+		if (I2C1Queue[(I2C1QueueHead + i) % I2C_QUEUE_LENGTH] != transaction) continue;
+
+		if (i == 0) { // On the bus: abort it
+			LPC_I2C1->I2CONSET = STO;
+			LPC_I2C1->I2CONCLR = STA | AA | SI;
+			I2C1_Finish(I2C_TRANSFER_ERROR);
+			if (I2C1QueueCount > 0) I2C1_Kick();
+		}
+		else { // Still waiting: close the gap
+			for (; i < I2C1QueueCount - 1; i++) {
+				I2C1Queue[(I2C1QueueHead + i) % I2C_QUEUE_LENGTH] = I2C1Queue[(I2C1QueueHead + i + 1) % I2C_QUEUE_LENGTH];
+			}
+			I2C1QueueCount--;
+			transaction->result = I2C_TRANSFER_ERROR;
+		}
+	}
+	I2C1_Unlock();
+
+	return transaction->result;
+}
+
+int I2C1_Transfer(I2C_TRANSACTION * transaction) {
+	TRACE_ENTER(TRACE_I2C_TRANSFER, ((transaction->wSize & 0xFF) << 8) | (transaction->rSize & 0xFF));
+
+	#ifdef FREERTOS
+		transaction->task = xTaskGetCurrentTaskHandle();
+	#endif
+
+	if (I2C1_Submit(transaction) < 0) {
+		TRACE_EXIT(TRACE_I2C_TRANSFER);
+		return I2C_TRANSFER_ERROR;
+	}
+
+	#ifdef FREERTOS
+		TickType_t start = xTaskGetTickCount();
+		TickType_t timeout = pdMS_TO_TICKS(I2C_TIMEOUT_MS);
+		while (transaction->result == I2C_TRANSFER_PENDING) { // Any notification wakes it: not only I2C1 handler's
+			TickType_t elapsed = xTaskGetTickCount() - start;
+			if (elapsed >= timeout) { // Timed out
+				I2C1_Cancel(transaction);
+				break;
+			}
+			xTaskNotifyWait(0, I2C_NOTIFY_BIT, NULL, timeout - elapsed); // Blocked until I2C1 handler is done with it
+		}
+		xTaskNotifyWait(I2C_NOTIFY_BIT, I2C_NOTIFY_BIT, NULL, 0); // Drop the bit, if it was not taken (e.g. ended while cancelling)
+	#else
+		uint32_t start = WAIT_SYS_GetElapsedMs(0);
+		while (transaction->result == I2C_TRANSFER_PENDING) {
+			if (WAIT_SYS_GetElapsedMs(start) > I2C_TIMEOUT_MS) { // Timed out
+				I2C1_Cancel(transaction);
+				break;
+			}
+			__WFI(); // Sleep until next interrupt
+		}
+	#endif
+
+	TRACE_EXIT(TRACE_I2C_TRANSFER);
+	return transaction->result;
+}
+
 int I2C1_Configure(int frequency, int rSize, char * wBuffer, int wSize) {
 	if (rSize < 0 || wSize < 1) return -1;
+	if (rSize > I2C_BUFFER_LENGTH || wSize > I2C_BUFFER_LENGTH) return -1;
 
-	int freq_div = I2C_GetPCLK()/frequency;
-	LPC_I2C1->I2SCLH = freq_div >> 1; // Set duty cycle (high)
-	LPC_I2C1->I2SCLL = freq_div >> 1; // Set duty cycle (low)
-
-	memcpy(I2C1WriteBuffer, wBuffer, wSize + (rSize != 0)); // Copy data. (rSize != 0) represents the SLA + R byte, if a read operation is to be performed
-	I2C1WriteLength = wSize;
+	memcpy(I2C1WriteBuffer, wBuffer + 1, wSize - 1); // First byte is SLA + W. SLA + R (if any) is implied by address.
 
-	I2C1ReadLength = rSize;
+	I2C1Legacy.address = ((uint8_t) wBuffer[0]) >> 1;
+	I2C1Legacy.frequency = frequency;
+	I2C1Legacy.wBuffer = I2C1WriteBuffer;
+	I2C1Legacy.wSize = wSize - 1;
+	I2C1Legacy.rBuffer = I2C1ReadBuffer;
+	I2C1Legacy.rSize = rSize;
 
 	return 0;
 }
@@ -308,9 +436,8 @@ int I2C1_Configure(int frequency, int rSize, char * wBuffer, int wSize) {
 int I2C2_Configure(int frequency, int rSize, char * wBuffer, int wSize) {
 	if (rSize < 0 || wSize < 1) return -1;
 
-	int freq_div = I2C_GetPCLK()/frequency;
-	LPC_I2C2->I2SCLH = freq_div >> 1; // Set duty cycle (high)
-	LPC_I2C2->I2SCLL = freq_div >> 1; // Set duty cycle (low)
+	I2C2Frequency = frequency;
+	I2C2_ClockChanged();
 
 	memcpy(I2C2WriteBuffer, wBuffer, wSize + (rSize != 0)); // Copy data. (rSize != 0) represents the SLA + R byte, if a read operation is to be performed
 	I2C2WriteLength = wSize;
@@ -321,13 +448,7 @@ int I2C2_Configure(int frequency, int rSize, char * wBuffer, int wSize) {
 }
 
 int I2C1_Start() {
-	LPC_I2C1->I2CONSET = STA;
-
-	uint32_t start = WAIT_SYS_GetElapsedMs(0);
-	while (1) {
-		if (I2C1State == I2C_BUSY) return 0; // Started
-		if (WAIT_SYS_GetElapsedMs(start) > I2C_TIMEOUT_MS) return -1; // Timed out
-	}
+	return 0; // Started by I2C1_Engine, as a whole transaction
 }
 
 int I2C2_Start() {
@@ -342,12 +463,7 @@ int I2C2_Start() {
 
 
 void I2C1_Stop() {
-	LPC_I2C1->I2CONSET = STO; // Set STOP flag
-	LPC_I2C1->I2CONCLR = SI; // Clear SI flag
-
-	while (LPC_I2C1->I2CONSET & STO); // Wait for STOP to be cleared
-
-	I2C1State = I2C_IDLE;
+	// Transactions end with STOP on their own
 }
 
 void I2C2_Stop() {
@@ -360,20 +476,7 @@ void I2C2_Stop() {
 }
 
 int I2C1_Engine() {
-	LPC_I2C1->I2CONSET = STA; // Set START flag
-
-	I2C1State = I2C_BUSY;
-
-	uint32_t start = WAIT_SYS_GetElapsedMs(0);
-	while (I2C1State == I2C_BUSY) {
-		if (WAIT_SYS_GetElapsedMs(start) > I2C_TIMEOUT_MS) { // Timed out
-			I2C1State = I2C_IDLE;
-			return -1;
-		}
-	}
-	LPC_I2C1->I2CONCLR = STA; // Clear START;
-
-	return 0;
+	return (I2C1_Transfer(&I2C1Legacy) == I2C_TRANSFER_DONE) ? 0 : -1;
 }
 
 int I2C2_Engine() {
@@ -394,7 +497,7 @@ int I2C2_Engine() {
 }
 
 void I2C1_GetBuffer(char * buffer) {
-	memcpy(buffer, I2C1ReadBuffer, I2C1ReadLength);
+	memcpy(buffer, I2C1ReadBuffer, I2C1Legacy.rSize);
 }
 
 void I2C2_GetBuffer(char * buffer) {
@@ -16,14 +16,28 @@
 /**
  *
  *
- * USES TIMER3
+ * USES TIMER2 (TIMER WHEEL CLOCK)
  *
  *
  */
 
 #ifdef FREERTOS
-	static QueueHandle_t queueLCD; // LCD queue
+	static MessageBufferHandle_t bufferLCD; // LCD commands (see LCD_CMD_TYPE)
+	static SemaphoreHandle_t semLCD; // Message buffers take a single writer at a time
+	static SemaphoreHandle_t semLCD_SYNC; // Given by LCD writer task on LCD_CMD_SYNC
 	void LCD_WriterTask(void *pvParameters); // LCD writer task
+
+	RTOS_TASK_STORAGE(taskLCD_WRITER, TASK_LCD_WRITER_STACK_SIZE);
+	RTOS_MESSAGE_BUFFER_STORAGE(bufferLCD, LCD_BUFFER_SIZE);
+	RTOS_SEMAPHORE_STORAGE(semLCD);
+	RTOS_SEMAPHORE_STORAGE(semLCD_SYNC);
+
+	static void LCD_Send(const uint8_t *message, size_t length)
+	{
+		xSemaphoreTake(semLCD, portMAX_DELAY);
+		xMessageBufferSend(bufferLCD, message, length, portMAX_DELAY);
+		xSemaphoreGive(semLCD);
+	}
 #endif
 
 
@@ -43,9 +57,9 @@ static void LCD_SetNibble(int rs, int nib)
 static void LCD_PulseEnable(int us)
 {
 	LPC_GPIO0->FIOSET = (1 << EN);
-	WAIT_TIM3_Us(us);
+	WAIT_WHEEL_Us(us);
 	LPC_GPIO0->FIOCLR = (1 << EN);
-	WAIT_TIM3_Us(us);
+	WAIT_WHEEL_Us(us);
 }
 
 static void LCD_WriteCommand(char cmd)
@@ -61,6 +75,8 @@ static void LCD_WriteCommand(char cmd)
 
 static void LCD_WriteChar(char ch)
 {
+	TRACE_ENTER(TRACE_LCD_CHAR, (uint8_t) ch);
+
 	// High nibble (1st 4 bits):
 	LCD_SetNibble(1, ((ch >> 4) & LCD_LOW_NIBBLE));
 	LCD_PulseEnable(LCD_STD_TIME);
@@ -68,37 +84,53 @@ static void LCD_WriteChar(char ch)
 	// High nibble (1st 4 bits):
 	LCD_SetNibble(1, (ch & LCD_LOW_NIBBLE));
 	LCD_PulseEnable(LCD_STD_TIME);
+
+	TRACE_EXIT(TRACE_LCD_CHAR);
 }
 
 static void LCD_WriteString(char *str)
 {
+	TRACE_ENTER(TRACE_LCD_STRING, 0);
+
 	int i = 0;
 	char ch = '0';
 	while((ch = *(str + (i++))) != '\0') {
 		LCD_WriteChar(ch);
 	}
+
+	TRACE_EXIT(TRACE_LCD_STRING);
 }
 
 static void LCD_Clear(void)
 {
+	TRACE_ENTER(TRACE_LCD_CLEAR, 0);
+
 	LCD_SetNibble(0, (CLEAR >> 4) & LCD_LOW_NIBBLE);
 	LCD_PulseEnable(LCD_EXC_TIME);
 
 	LCD_SetNibble(0, CLEAR & LCD_LOW_NIBBLE);
 	LCD_PulseEnable(LCD_EXC_TIME);
+
+	TRACE_EXIT(TRACE_LCD_CLEAR);
 }
 
 static void LCD_Home(void)
 {
+	TRACE_ENTER(TRACE_LCD_HOME, 0);
+
 	LCD_SetNibble(0, (HOME >> 4) & LCD_LOW_NIBBLE);
 	LCD_PulseEnable(LCD_EXC_TIME);
 
 	LCD_SetNibble(0, HOME & LCD_LOW_NIBBLE);
 	LCD_PulseEnable(LCD_EXC_TIME);
+
+	TRACE_EXIT(TRACE_LCD_HOME);
 }
 
 static void LCD_Locate(int row, int column)
 {
+	TRACE_ENTER(TRACE_LCD_LOCATE, ((row & 0xFF) << 8) | (column & 0xFF));
+
 	// Verify parameters
 	row = (row > 2 || row < 1) ? ((row > 2) ? 2 : 1) : row;
 	column = (column > (LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS) || column < 1)
@@ -114,10 +146,14 @@ static void LCD_Locate(int row, int column)
 	cmd += (column - 1);
 
 	LCD_WriteCommand(cmd);
+
+	TRACE_EXIT(TRACE_LCD_LOCATE);
 }
 
 static void LCD_CreateChar(unsigned char location, const unsigned char charmap[])
 {
+	TRACE_ENTER(TRACE_LCD_CREATE_CHAR, location);
+
 	// Validate location:
 	location = (location >= LCD_CHARMAP_LENGTH || location < 0) ? ((location >= LCD_CHARMAP_LENGTH) ? (LCD_CHARMAP_LENGTH - 1) : 0) : location;
 
@@ -126,35 +162,39 @@ static void LCD_CreateChar(unsigned char location, const unsigned char charmap[]
 	for (int i = 0; i < LCD_CHARMAP_LENGTH; i++) {
 		LCD_WriteChar(charmap[i]);
 	}
+
+	TRACE_EXIT(TRACE_LCD_CREATE_CHAR);
 }
 
 static void LCD_ShiftDisplay(LCD_SHIFT_DIR dir)
 {
+	TRACE_ENTER(TRACE_LCD_SHIFT, 0);
 	LCD_WriteCommand(dir);
+	TRACE_EXIT(TRACE_LCD_SHIFT);
 }
 
 int32_t LCDText_Init(void)
 {
 	LPC_GPIO0->FIODIR |= LCD_PINS_MASK;
 
-	if (WAIT_Init(TIM3) < 0) return -1;
-	WAIT_TIM3_Us(41000);
+	if (WAIT_Init(WHEEL) < 0) return -1;
+	WAIT_WHEEL_Us(41000);
 
 	LCD_SetNibble(0, 0x03);
 	LCD_PulseEnable(LCD_STD_TIME);
-	WAIT_TIM3_Us(5000);
+	WAIT_WHEEL_Us(5000);
 
 	LCD_SetNibble(0, 0x03);
 	LCD_PulseEnable(LCD_STD_TIME);
-	WAIT_TIM3_Us(200);
+	WAIT_WHEEL_Us(200);
 
 	LCD_SetNibble(0, 0x03);
 	LCD_PulseEnable(LCD_STD_TIME);
-	WAIT_TIM3_Us(200);
+	WAIT_WHEEL_Us(200);
 
 	LCD_SetNibble(0, HOME);
 	LCD_PulseEnable(LCD_STD_TIME);
-	WAIT_TIM3_Us(200);
+	WAIT_WHEEL_Us(200);
 
 	LCD_WriteCommand(FUNCTION_SET); // Select 4-bit data bus interface length and two-line display
 	LCD_WriteCommand(OFF); // Turn off display and cursor
@@ -164,13 +204,23 @@ int32_t LCDText_Init(void)
 	LCD_Locate(1, 1);
 
 	#ifdef FREERTOS
-		if (xTaskCreate(LCD_WriterTask, (const char * const) "LCD Writer Task", TASK_LCD_WRITER_STACK_SIZE, NULL, TASK_LCD_WRITER_PRIORITY, NULL) != pdPASS) {
+		if (RTOS_TaskCreate(taskLCD_WRITER, LCD_WriterTask, (const char * const) "LCD Writer Task", TASK_LCD_WRITER_STACK_SIZE, NULL, TASK_LCD_WRITER_PRIORITY, NULL) != pdPASS) {
 			printf("LCD Writer Task could not be created.\n");
 			return -1;
 		}
 
-		if ((queueLCD = xQueueCreate(16, sizeof(LCD_INFO))) == NULL) {
-			printf("Could not initialise queueLCD");
+		if ((bufferLCD = RTOS_MessageBufferCreate(bufferLCD, LCD_BUFFER_SIZE)) == NULL) {
+			printf("Could not initialise bufferLCD");
+			return -1;
+		}
+
+		if ((semLCD = RTOS_SemaphoreCreateMutex(semLCD)) == NULL) {
+			printf("Could not initialise semLCD");
+			return -1;
+		}
+
+		if ((semLCD_SYNC = RTOS_SemaphoreCreateBinary(semLCD_SYNC)) == NULL) {
+			printf("Could not initialise semLCD_SYNC");
 			return -1;
 		}
 	#endif
@@ -181,10 +231,8 @@ int32_t LCDText_Init(void)
 void LCDText_WriteChar(char ch)
 {
 	#ifdef FREERTOS
-		LCD_INFO info;
-		info.cmd = LCD_CMD_WRITE_CHAR;
-		info.ch = ch;
-		xQueueSend(queueLCD, &info, portMAX_DELAY);
+		uint8_t message[] = {LCD_CMD_WRITE_CHAR, ch};
+		LCD_Send(message, sizeof(message));
 	#else
 		LCD_WriteChar(ch);
 	#endif
@@ -193,11 +241,12 @@ void LCDText_WriteChar(char ch)
 void LCDText_WriteString(char *str)
 {
 	#ifdef FREERTOS
-		if (strlen(str) > LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS) return;
-		LCD_INFO info;
-		info.cmd = LCD_CMD_WRITE_STRING;
-		strcpy(info.str, str);
-		xQueueSend(queueLCD, &info, portMAX_DELAY);
+		size_t length = strlen(str);
+		if (length > LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS) return;
+		uint8_t message[LCD_MESSAGE_MAX_LENGTH];
+		message[0] = LCD_CMD_WRITE_STRING;
+		memcpy(&message[1], str, length);
+		LCD_Send(message, 1 + length);
 	#else
 		LCD_WriteString(str);
 	#endif
@@ -206,9 +255,8 @@ void LCDText_WriteString(char *str)
 void LCDText_Clear(void)
 {
 	#ifdef FREERTOS
-		LCD_INFO info;
-		info.cmd = LCD_CMD_CLEAR;
-		xQueueSend(queueLCD, &info, portMAX_DELAY);
+		uint8_t message[] = {LCD_CMD_CLEAR};
+		LCD_Send(message, sizeof(message));
 	#else
 		LCD_Clear();
 	#endif
@@ -217,9 +265,8 @@ void LCDText_Clear(void)
 void LCDText_Home(void)
 {
 	#ifdef FREERTOS
-		LCD_INFO info;
-		info.cmd = LCD_CMD_HOME;
-		xQueueSend(queueLCD, &info, portMAX_DELAY);
+		uint8_t message[] = {LCD_CMD_HOME};
+		LCD_Send(message, sizeof(message));
 	#else
 		LCD_Home();
 	#endif
@@ -228,11 +275,8 @@ void LCDText_Home(void)
 void LCDText_Locate(int row, int column)
 {
 	#ifdef FREERTOS
-		LCD_INFO info;
-		info.cmd = LCD_CMD_LOCATE;
-		info.row = row;
-		info.col = column;
-		xQueueSend(queueLCD, &info, portMAX_DELAY);
+		uint8_t message[] = {LCD_CMD_LOCATE, row, column}; // Both fit in a byte (see LCD_Locate())
+		LCD_Send(message, sizeof(message));
 	#else
 		LCD_Locate(row, column);
 	#endif
@@ -241,11 +285,9 @@ void LCDText_Locate(int row, int column)
 void LCDText_CreateChar(unsigned char location, const unsigned char charmap[])
 {
 	#ifdef FREERTOS
-		LCD_INFO info;
-		info.cmd = LCD_CMD_CREATE_CHAR;
-		info.location = location;
-		memcpy(info.charmap, charmap, LCD_CHARMAP_LENGTH);
-		xQueueSend(queueLCD, &info, portMAX_DELAY);
+		uint8_t message[2 + LCD_CHARMAP_LENGTH] = {LCD_CMD_CREATE_CHAR, location};
+		memcpy(&message[2], charmap, LCD_CHARMAP_LENGTH);
+		LCD_Send(message, sizeof(message));
 	#else
 		LCD_CreateChar(location, charmap);
 	#endif
@@ -254,54 +296,71 @@ void LCDText_CreateChar(unsigned char location, const unsigned char charmap[])
 void LCDText_ShiftDisplay(LCD_SHIFT_DIR dir)
 {
 	#ifdef FREERTOS
-		LCD_INFO info;
-		switch (dir) {
-			case RIGHT:
-				info.cmd = LCD_CMD_SHIFT_RIGHT;
-			case LEFT:
-				info.cmd = LCD_CMD_SHIFT_LEFT;
-		}
-		xQueueSend(queueLCD, &info, portMAX_DELAY);
+		uint8_t message[] = {(dir == RIGHT) ? LCD_CMD_SHIFT_RIGHT : LCD_CMD_SHIFT_LEFT};
+		LCD_Send(message, sizeof(message));
 	#else
 		LCD_ShiftDisplay(dir);
 	#endif
 }
 
+#ifdef FREERTOS
+	static void LCD_PrintfSink(void *context, char ch)
+	{
+		uint8_t **cursor = (uint8_t **) context;
+		*(*cursor)++ = ch;
+	}
+#else
+	static void LCD_PrintfSink(void *context, char ch)
+	{
+		LCD_WriteChar(ch);
+	}
+#endif
+
 void LCDText_Printf(char *fmt, ...)
 {
 	va_list arg;
-	char str[LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS]; // LCD DDRAM has 80 addresses
 
 	va_start (arg, fmt);
 
-	vsprintf(str, fmt, arg);
+	#ifdef FREERTOS
+		// Format straight into the command message:
+		uint8_t message[LCD_MESSAGE_MAX_LENGTH];
+		uint8_t *cursor = &message[1];
+		message[0] = LCD_CMD_WRITE_STRING;
+		int length = FORMAT_Print(LCD_PrintfSink, &cursor, LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS, fmt, arg);
+		LCD_Send(message, 1 + length);
+	#else
+		FORMAT_Print(LCD_PrintfSink, NULL, LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS, fmt, arg); // LCD DDRAM has 80 addresses
+	#endif
 
 	va_end (arg);
+}
 
+void LCDText_Sync(void)
+{
 	#ifdef FREERTOS
-		LCD_INFO info;
-		info.cmd = LCD_CMD_WRITE_STRING;
-		strcpy(info.str, str);
-		xQueueSend(queueLCD, &info, portMAX_DELAY);
-	#else
-		LCD_WriteString(str);
+		uint8_t message[] = {LCD_CMD_SYNC};
+		LCD_Send(message, sizeof(message));
+		xSemaphoreTake(semLCD_SYNC, portMAX_DELAY);
 	#endif
 }
 
 #ifdef FREERTOS
 	void LCD_WriterTask(void *pvParameters) {
-		LCD_INFO info;
+		uint8_t message[LCD_MESSAGE_MAX_LENGTH + 1]; // Room for a string terminator
+		size_t length;
 
 		for (;;) {
 			// Block waiting for things to write
-			xQueueReceive(queueLCD, &info, portMAX_DELAY);
+			if ((length = xMessageBufferReceive(bufferLCD, message, LCD_MESSAGE_MAX_LENGTH, portMAX_DELAY)) == 0) continue;
 
-			switch(info.cmd) {
+			switch(message[0]) {
 				case LCD_CMD_WRITE_CHAR:
-					LCD_WriteChar(info.ch);
+					LCD_WriteChar(message[1]);
 					break;
 				case LCD_CMD_WRITE_STRING:
-					LCD_WriteString(info.str);
+					message[length] = '\0';
+					LCD_WriteString((char *) &message[1]);
 					break;
 				case LCD_CMD_CLEAR:
 					LCD_Clear();
@@ -310,10 +369,10 @@ void LCDText_Printf(char *fmt, ...)
 					LCD_Home();
 					break;
 				case LCD_CMD_LOCATE:
-					LCD_Locate(info.row, info.col);
+					LCD_Locate(message[1], message[2]);
 					break;
 				case LCD_CMD_CREATE_CHAR:
-					LCD_CreateChar(info.location, info.charmap);
+					LCD_CreateChar(message[1], &message[2]);
 					break;
 				case LCD_CMD_SHIFT_RIGHT:
 					LCD_ShiftDisplay(RIGHT);
@@ -321,8 +380,10 @@ void LCDText_Printf(char *fmt, ...)
 				case LCD_CMD_SHIFT_LEFT:
 					LCD_ShiftDisplay(LEFT);
 					break;
+				case LCD_CMD_SYNC:
+					xSemaphoreGive(semLCD_SYNC);
+					break;
 			}
 		}
 	}
 #endif
-
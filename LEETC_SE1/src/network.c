@@ -15,6 +15,9 @@
 
 static QueueHandle_t queuePUBLISH_SCORE = NULL;
 
+RTOS_TASK_STORAGE(taskSCORE_PUBLISHER, TASK_SCORE_PUBLISHER_STACK_SIZE);
+RTOS_QUEUE_STORAGE(queuePUBLISH_SCORE, NETWORK_QUEUE_LENGTH, sizeof(int));
+
 static int score = 0;
 
 void NETWORK_ScorePublisherTask(void *pvParameters);
@@ -35,12 +38,12 @@ static void MQTT_GetInitialiser(MQTTString * copyTo) {
 }
 
 bool NETWORK_Init(void) {
-	if (xTaskCreate(NETWORK_ScorePublisherTask, (const char * const) "SCORE Publisher Task", TASK_SCORE_PUBLISHER_STACK_SIZE, NULL, TASK_SCORE_PUBLISHER_PRIORITY, NULL) != pdPASS) {
+	if (RTOS_TaskCreate(taskSCORE_PUBLISHER, NETWORK_ScorePublisherTask, (const char * const) "SCORE Publisher Task", TASK_SCORE_PUBLISHER_STACK_SIZE, NULL, TASK_SCORE_PUBLISHER_PRIORITY, NULL) != pdPASS) {
 		printf("SCORE Publisher Task could not be created.\n");
 		return false;
 	}
 
-	if ((queuePUBLISH_SCORE = xQueueCreate(8, sizeof(int))) == NULL) {
+	if ((queuePUBLISH_SCORE = RTOS_QueueCreate(queuePUBLISH_SCORE, NETWORK_QUEUE_LENGTH, sizeof(int))) == NULL) {
 		printf("Could not initialise queueSCORE");
 		return false;
 	}
@@ -49,9 +52,10 @@ bool NETWORK_Init(void) {
 }
 
 bool NETWORK_ConnectToAP(char * ssid, char * password) {
-	if (ESP_Init(115200)) {
+	if (ESP_Init(ESP_BAUD)) {
 		if (ESP_EnableEcho(false) == 0) {
 			//printf("Echo Successful!\n");
+			if (ESP_SetBaud(ESP_FAST_BAUD) != 0) printf("Baud Rate Failed (staying at %d).\n", ESP_BAUD);
 			if (ESP_Mode(ESP_BOTH, false) == 0) {
 				//printf("Mode Successful!\n");
 				if (ESP_ConfigureConnection(ESP_SINGLE) == 0) {
@@ -0,0 +1,37 @@
+/*
+ * prng.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ */
+
+#include "prng.h"
+
+
+void PRNG_Seed(PRNG_STATE * prng, uint32_t seed) {
+	// Mix seed (murmur3 finaliser), so neighbouring seeds don't give neighbouring states:
+	seed ^= seed >> 16;
+	seed *= 0x85EBCA6B;
+	seed ^= seed >> 13;
+	seed *= 0xC2B2AE35;
+	seed ^= seed >> 16;
+
+	prng->state = (seed != 0) ? seed : 0x9E3779B9; // xorshift never leaves 0
+}
+
+uint32_t PRNG_Next(PRNG_STATE * prng) {
+	uint32_t x = prng->state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	prng->state = x;
+	return x;
+}
+
+uint32_t PRNG_Range(PRNG_STATE * prng, uint32_t n) {
+	return (uint32_t) (((uint64_t) PRNG_Next(prng) * n) >> 32); // Single UMULL on Cortex-M3
+}
+
+int PRNG_Between(PRNG_STATE * prng, int min, int max) {
+	return min + (int) PRNG_Range(prng, (uint32_t) (max - min) + 1);
+}
@@ -12,6 +12,37 @@
 #include "rtc.h"
 
 static int getDaysInMonth();
+static int daysInMonth(int year, int month);
+static int32_t daysFromCivil(int year, int month, int day);
+
+static RTC_HANDLER handlerRTC = NULL;
+static RTC_INTERRUPT_FIELD fieldsRTC = INONE;
+
+static volatile uint32_t epochRTC = 0; // Seconds since 01/01/1970, counted by RTC_IRQHandler (32 bits: atomic, and enough until 2106)
+static volatile bool epochValid = false; // Cleared whenever time fields are written
+
+
+static uint32_t incrementedFields(void) // Fields that have just been incremented (RTC_INTERRUPT_FIELD bitmap), right after a second increment
+{
+	uint32_t fields = ISEC;
+	if (LPC_RTC->SEC != 0) return fields;
+	fields |= IMIN;
+	if (LPC_RTC->MIN != 0) return fields;
+	fields |= IHOUR;
+	if (LPC_RTC->HOUR != 0) return fields;
+	fields |= IDOM | IDOW | IDOY;
+	if (LPC_RTC->DOM != 1) return fields;
+	fields |= IMONTH;
+	if (LPC_RTC->DOY != 1) return fields;
+	return fields | IYEAR;
+}
+
+void RTC_IRQHandler(void)
+{
+	LPC_RTC->ILR = RTC_IL_BIT; // Clear counter increment interrupt flag (write one to clear)
+	if (epochValid) epochRTC++;
+	if (handlerRTC != NULL && (incrementedFields() & fieldsRTC) != 0) handlerRTC();
+}
 
 
 void RTC_Init(time_t seconds)
@@ -20,12 +51,27 @@ void RTC_Init(time_t seconds)
 
 	LPC_RTC->CCR = RTC_DISABLE; // Disable RTC time counters
 	LPC_RTC->AMR = 0x00; // Disable alarms
-	LPC_RTC->CIIR = 0x00; // Disable interrupts
+	LPC_RTC->CIIR = ISEC; // Interrupt every second (keeps the epoch counter, see RTC_GetSeconds())
+	LPC_RTC->ILR = RTC_IL_BIT;
 
 	RTC_SetSeconds(seconds); // Set RTC time
+
+	#ifdef FREERTOS
+		NVIC_SetPriority(RTC_IRQn, RTC_IRQ_PRIORITY); // Handler may use FreeRTOS API
+	#endif
+	NVIC_EnableIRQ(RTC_IRQn);
+
 	RTC_Enable(); // Enable RTC time counters
 }
 
+void RTC_SetInterrupt(RTC_INTERRUPT_FIELD fields, RTC_HANDLER handler)
+{
+	NVIC_DisableIRQ(RTC_IRQn);
+	fieldsRTC = fields;
+	handlerRTC = (fields != INONE) ? handler : NULL;
+	NVIC_EnableIRQ(RTC_IRQn);
+}
+
 void RTC_GetValue(struct tm *dateTime)
 {
 	dateTime->tm_sec = LPC_RTC->SEC;
@@ -40,6 +86,7 @@ void RTC_GetValue(struct tm *dateTime)
 
 void RTC_SetValue(struct tm *dateTime)
 {
+	epochValid = false;
 	LPC_RTC->SEC = dateTime->tm_sec;
 	LPC_RTC->MIN = dateTime->tm_min;
 	LPC_RTC->HOUR = dateTime->tm_hour;
@@ -52,14 +99,64 @@ void RTC_SetValue(struct tm *dateTime)
 
 time_t RTC_GetSeconds(void)
 {
-	struct tm dateTime = {0};
-	RTC_GetValue(&dateTime); // Write RTC time to structure tm
-	return mktime(&dateTime); // mktime() -> returns the seconds since Epoh (01/01/1970), given a structure tm
+	if (!epochValid) { // Fields were written: count from them again
+		struct tm dateTime;
+
+		NVIC_DisableIRQ(RTC_IRQn);
+		do { // Read until no second increment happened meanwhile, so the pending interrupt (if any) comes after the read
+			LPC_RTC->ILR = RTC_IL_BIT;
+			NVIC_ClearPendingIRQ(RTC_IRQn);
+			RTC_GetValue(&dateTime);
+		} while (LPC_RTC->ILR & RTC_IL_BIT);
+		epochRTC = (uint32_t) RTC_ToSeconds(&dateTime);
+		epochValid = true;
+		NVIC_EnableIRQ(RTC_IRQn);
+	}
+	return (time_t) epochRTC;
 }
 
 void RTC_SetSeconds(time_t seconds)
 {
-	RTC_SetValue(localtime(&seconds));
+	struct tm dateTime;
+	RTC_FromSeconds(seconds, &dateTime);
+	RTC_SetValue(&dateTime);
+}
+
+time_t RTC_ToSeconds(const struct tm *dateTime)
+{
+	int32_t days = daysFromCivil(dateTime->tm_year + 1900, dateTime->tm_mon + 1, dateTime->tm_mday);
+	return (time_t) days * 86400 + dateTime->tm_hour * 3600 + dateTime->tm_min * 60 + dateTime->tm_sec;
+}
+
+void RTC_FromSeconds(time_t seconds, struct tm *dateTime)
+{
+	int32_t days = (int32_t) (seconds / 86400);
+	int32_t rest = (int32_t) (seconds % 86400);
+	if (rest < 0) { // Before 1970
+		rest += 86400;
+		days--;
+	}
+
+	dateTime->tm_hour = rest / 3600;
+	dateTime->tm_min = (rest / 60) % 60;
+	dateTime->tm_sec = rest % 60;
+	dateTime->tm_wday = (int) ((days % 7 + 11) % 7); // 01/01/1970 was a Thursday
+
+	// Civil date from day count, with years starting on March 1st (leap day last), in 400-year eras:
+	uint32_t shifted = (uint32_t) (days + 719468); // Days since 01/03/0000
+	uint32_t era = shifted / 146097;
+	uint32_t dayOfEra = shifted - era * 146097; // [0 : 146096]
+	uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365; // [0 : 399]
+	uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100); // [0 : 365], from March 1st
+	uint32_t monthFromMarch = (5 * dayOfYear + 2) / 153; // [0 : 11]
+	int month = (monthFromMarch < 10) ? monthFromMarch + 3 : monthFromMarch - 9; // [1 : 12]
+	int year = (int) (era * 400 + yearOfEra) + (month <= 2);
+
+	dateTime->tm_mday = dayOfYear - (153 * monthFromMarch + 2) / 5 + 1;
+	dateTime->tm_mon = month - 1;
+	dateTime->tm_year = year - 1900;
+	dateTime->tm_yday = (int) (days - daysFromCivil(year, 1, 1));
+	dateTime->tm_isdst = 0;
 }
 
 void RTC_Enable(void) {
@@ -74,6 +171,7 @@ void RTC_IncrementField(RTC_TIME_FIELD field)
 {
 	int aux;
 
+	epochValid = false;
 	switch(field) {
 		case YEAR:
 			aux = (LPC_RTC->YEAR)+1; // Increment
@@ -111,6 +209,8 @@ void RTC_IncrementField(RTC_TIME_FIELD field)
 void RTC_DecrementField(RTC_TIME_FIELD field)
 {
 	int aux;
+
+	epochValid = false;
 	switch(field) {
 		case YEAR:
 			aux = (LPC_RTC->YEAR)-1; // Decrement
@@ -146,15 +246,20 @@ void RTC_DecrementField(RTC_TIME_FIELD field)
 }
 
 static int getDaysInMonth() {
-	int february_days = 28;
-	int year = LPC_RTC->YEAR;
-	int month = LPC_RTC->MONTH + 1;
+	return daysInMonth(LPC_RTC->YEAR + 1900, LPC_RTC->MONTH + 1);
+}
 
-	if ((year%4 == 0) && (year%100 != 0)) {
-		february_days = 29;
-	}
+static int daysInMonth(int year, int month) { // month: [1 : 12]
+	if (month == 2) return ((year%4 == 0 && year%100 != 0) || year%400 == 0) ? 29 : 28;
+	else if (month == 4 || month == 6 || month == 9 || month == 11) return 30;
+	else return 31;
+}
 
-	if (month == 2) return february_days;
-	else if (month == 1 || month == 3 || month == 5 || month == 8 || month == 10 || month == 12) return 31;
-	else return 30;
+static int32_t daysFromCivil(int year, int month, int day) { // Days since 01/01/1970. year >= 0, month: [1 : 12]
+	uint32_t y = year - (month <= 2); // Years start on March 1st, so the leap day is the last one
+	uint32_t era = y / 400;
+	uint32_t yearOfEra = y - era * 400; // [0 : 399]
+	uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0 : 365]
+	uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear; // [0 : 146096]
+	return (int32_t) (era * 146097 + dayOfEra) - 719468;
 }
@@ -13,22 +13,13 @@
 #include "spi.h"
 
 
-static uint32_t SPI_GetPCLK(void);
-
-
-static uint32_t SPI_GetPCLK(void) {
-	switch ((LPC_SC->PCLKSEL0 >> 16) & 0x03) {
-		case 0x00:
-			return SystemCoreClock/4;
-		case 0x01:
-			return SystemCoreClock;
-		case 0x02:
-			return SystemCoreClock/2;
-		case 0x03:
-			return SystemCoreClock/8;
-		default:
-			return -1;
-	}
+static uint32_t spiFrequency = 0; // Frequency given to SPI_ConfigTransfer(), for SPI_ClockChanged()
+
+static void SPI_ClockChanged(void);
+
+
+static void SPI_ClockChanged(void) {
+	if (spiFrequency != 0) LPC_SPI->SPCCR = ((CLOCK_GetPCLK(CLOCK_SPI)/spiFrequency) & SPI_CCR_MASK);
 }
 
 void SPI_Init(void) {
@@ -36,7 +27,8 @@ void SPI_Init(void) {
 	LPC_PINCON->PINSEL1 |= ((SPI_PIN_FUNTION & 0x03) << 2); // MISO
 	LPC_PINCON->PINSEL1 |= ((SPI_PIN_FUNTION & 0x03) << 4); // MOSI
 
-	LPC_SC->PCLKSEL0 &= ~(0x03 << 16); // Set PCLK to CCLK/4
+	CLOCK_SetPCLK(CLOCK_SPI, CLOCK_DIV4); // Set PCLK to CCLK/4
+	CLOCK_AddHandler(SPI_ClockChanged);
 
 	LPC_SC->PCONP |= SPI_PCONP_ENABLE;
 
@@ -48,7 +40,8 @@ int32_t SPI_ConfigTransfer(int frequency, int bitData, int mode) {
 	if ((bitData < 8) || (bitData > 16)) return -1;
 
 	// PCLK cycles that make up an SPI clock:
-	LPC_SPI->SPCCR = ((SPI_GetPCLK()/frequency) & SPI_CCR_MASK);
+	LPC_SPI->SPCCR = ((CLOCK_GetPCLK(CLOCK_SPI)/frequency) & SPI_CCR_MASK);
+	spiFrequency = frequency;
 
 	// SPI Control register:
 	LPC_SPI->SPCR = 0; // Clear everything
@@ -58,20 +51,25 @@ int32_t SPI_ConfigTransfer(int frequency, int bitData, int mode) {
 }
 
 int32_t SPI_Transfer(unsigned short *txBuffer, unsigned short *rxBuffer, int length) {
+	TRACE_ENTER(TRACE_SPI_TRANSFER, length);
 	for (int i=0; i<length; i++) {
 		// Write:
 		LPC_SPI->SPDR = txBuffer[i];
 		while ((LPC_SPI->SPSR & SPIF_MASK) == 0) { // Wait for transfer completed flag
-			if ((LPC_SPI->SPSR & SPI_STATUS_ERROR_MASK) != 0) return -1;
+			if ((LPC_SPI->SPSR & SPI_STATUS_ERROR_MASK) != 0) {
+				TRACE_EXIT(TRACE_SPI_TRANSFER);
+				return -1;
+			}
 		}
 		// Read:
 		rxBuffer[i] = LPC_SPI->SPDR;
 	}
+	TRACE_EXIT(TRACE_SPI_TRANSFER);
 	return 0;
 }
 
 int SPI_VerifyFrequency(int frequency) {
-	int pclk = SPI_GetPCLK();
+	int pclk = CLOCK_GetPCLK(CLOCK_SPI);
 	if (pclk/frequency % 2) return -1;
 	if (pclk/frequency < 8) return -1;
 	return 0;
@@ -0,0 +1,141 @@
+/*
+ * timestamp.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ */
+
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#include "clock.h"
+#include "wait.h"
+#else
+#include <time.h>
+#endif
+
+#include "timestamp.h"
+
+
+#ifdef __USE_CMSIS
+static uint32_t hz = 0; // Cycles per second (0 until TIMESTAMP_Init(), see TIMESTAMP_CheckInit())
+#else
+static uint32_t hz = 1000000000;
+#endif
+static volatile uint32_t high = 0; // Wraps of the 32-bit counter
+static volatile uint32_t last = 0; // Last 32-bit reading
+
+
+#ifdef __USE_CMSIS
+
+	static void TIMESTAMP_ClockChanged(void) {
+		hz = SystemCoreClock;
+	}
+
+	void TIMESTAMP_Init(void) {
+		SystemCoreClockUpdate();
+		hz = SystemCoreClock;
+		CLOCK_AddHandler(TIMESTAMP_ClockChanged);
+
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // Enable DWT
+		DWT->CYCCNT = 0;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+		high = 0;
+		last = 0;
+
+		#ifndef FREERTOS
+			WAIT_Init(SYS); // SysTick_Handler() keeps the 64-bit count (fails harmlessly if SysTick already runs)
+		#endif
+	}
+
+	uint32_t TIMESTAMP_GetCycles(void) {
+		return DWT->CYCCNT;
+	}
+
+	static void TIMESTAMP_CheckInit(void) { // Stops here, rather than converting with a made up frequency
+		if (hz == 0) {
+			for (;;); // TIMESTAMP_Init() was not called
+		}
+	}
+
+#else
+
+	static uint64_t origin;
+
+	static uint64_t TIMESTAMP_Ns(void) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+	}
+
+	void TIMESTAMP_Init(void) {
+		hz = 1000000000;
+		origin = TIMESTAMP_Ns();
+		high = 0;
+		last = 0;
+	}
+
+	uint32_t TIMESTAMP_GetCycles(void) {
+		return (uint32_t) (TIMESTAMP_Ns() - origin);
+	}
+
+	static void TIMESTAMP_CheckInit(void) {
+	}
+
+#endif
+
+uint64_t TIMESTAMP_Get(void) {
+	#ifdef __USE_CMSIS
+		uint32_t primask = __get_PRIMASK(); // 'high' and 'last' go together
+		__disable_irq();
+	#endif
+
+	uint32_t now = TIMESTAMP_GetCycles();
+	if (now < last) high++; // Wrapped since last reading
+	last = now;
+	uint64_t cycles = ((uint64_t) high << 32) | now;
+
+	#ifdef __USE_CMSIS
+		__set_PRIMASK(primask);
+	#endif
+	return cycles;
+}
+
+uint32_t TIMESTAMP_GetHz(void) {
+	return hz;
+}
+
+uint64_t TIMESTAMP_ToUs(uint64_t cycles) {
+	TIMESTAMP_CheckInit();
+	return (cycles / hz) * 1000000u + ((cycles % hz) * 1000000u) / hz; // No overflow, whatever the value
+}
+
+uint64_t TIMESTAMP_ToNs(uint64_t cycles) {
+	TIMESTAMP_CheckInit();
+	return (cycles / hz) * 1000000000u + ((cycles % hz) * 1000000000u) / hz;
+}
+
+uint64_t TIMESTAMP_FromUs(uint64_t micros) {
+	TIMESTAMP_CheckInit();
+	return (micros / 1000000u) * hz + ((micros % 1000000u) * hz) / 1000000u;
+}
+
+uint64_t TIMESTAMP_GetUs(void) {
+	return TIMESTAMP_ToUs(TIMESTAMP_Get());
+}
+
+void TIMESTAMP_HistogramAdd(TIMESTAMP_HISTOGRAM *histogram, uint32_t cycles) {
+	uint32_t n = 0;
+	if (cycles != 0) {
+		#ifdef __USE_CMSIS
+			n = 32 - __CLZ(cycles);
+		#else
+			n = 32 - __builtin_clz(cycles);
+		#endif
+	}
+	histogram->bucket[n]++;
+
+	if (histogram->count == 0 || cycles < histogram->min) histogram->min = cycles;
+	if (cycles > histogram->max) histogram->max = cycles;
+	histogram->count++;
+}
@@ -0,0 +1,53 @@
+/*
+ * trace.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ */
+
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#endif
+
+#include "trace.h"
+
+
+TRACE_RING traceRing; // Not static: dumped by name
+
+
+void TRACE_Init(void) {
+	TIMESTAMP_Init();
+
+	traceRing.hz = TIMESTAMP_GetHz();
+	traceRing.length = TRACE_LENGTH;
+	traceRing.count = 0;
+	traceRing.magic = TRACE_MAGIC;
+}
+
+void TRACE_Record(uint8_t type, uint8_t id, uint16_t arg) {
+	#ifdef __USE_CMSIS
+		uint32_t primask = __get_PRIMASK(); // Records may come from any context
+		__disable_irq();
+	#endif
+
+	TRACE_RECORD *record = &traceRing.records[traceRing.count & (TRACE_LENGTH - 1)];
+	record->cycles = TIMESTAMP_GetCycles();
+	record->type = type;
+	record->id = id;
+	record->arg = arg;
+	traceRing.count++;
+
+	#ifdef __USE_CMSIS
+		__set_PRIMASK(primask);
+	#endif
+}
+
+void TRACE_TaskName(uint32_t number, const char *name) {
+	if (number >= TRACE_MAX_TASKS) return;
+
+	int i;
+	for (i = 0; (i < TRACE_NAME_LENGTH - 1) && (name[i] != '\0'); i++) {
+		traceRing.names[number][i] = name[i];
+	}
+	traceRing.names[number][i] = '\0';
+}
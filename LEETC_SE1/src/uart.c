@@ -12,7 +12,8 @@
 
 #include "uart.h"
 
-#define MARGIN(p1, p2) (p1 > p2 ? p1 - p2 : p2 - p1)
+#define RBUF_FILL(head, tail) (((head) - (tail)) & RBUF_MASK)
+
 
 
 static LPC_UART_TypeDef* UARTx;
@@ -21,6 +22,16 @@ static bool intrTxStatus;
 
 static UART_RBUF_Type rbuffer;
 
+static uint32_t uartBaud; // Baud rate given to UART_Init(), for UART_ClockChanged()
+static UART_DIVISORS uartDivisors; // Current divisors
+static bool uartStopped; // The clock cannot give uartBaud (see UART_ClockChanged())
+
+static UART_FLOW uartFlow; // Flow control
+static volatile bool txPaused; // XOFF received
+static volatile bool xoffSent; // XOFF sent: XON is due once the RX Ring Buffer drains to UART_XON_LEVEL
+static volatile unsigned char txControl; // XON or XOFF waiting to be sent (0 if none)
+static volatile uint32_t overruns; // Received bytes lost
+
 
 /********************************************************************************
  *
@@ -37,29 +48,39 @@ static UART_RBUF_Type rbuffer;
  */
 
 /*
- * Get UART PCLK:
+ * Check if UART interrupt interface is enabled:
  */
-static uint32_t UART_GetPCLK(void);
+static int UART_IsEnabled(IRQn_Type IRQ);
 
 /*
- * Check if UART interrupt interface is enabled:
+ * Achieved baud rate error of divisors, in ppm:
  */
-static int UART_IsEnabled(IRQn_Type IRQ);
+static int32_t UART_BaudError(uint32_t pclk, uint32_t baud, uint32_t divisor, uint32_t divAddVal, uint32_t mulVal);
 
 /*
- * Set divisors for baud rate:
+ * Search divisors for baud rate (if not in table):
  */
-static uint8_t UART_SetDivisors(uint32_t baud);
+static int32_t UART_SearchDivisors(uint32_t pclk, uint32_t baud, UART_DIVISORS *divisors);
 
 /*
- * Error handler (simple infinite loop):
+ * Choose PCLK divider and divisors for baud rate:
  */
-static void UART_ErrorHandler(uint8_t error_type);
+static int32_t UART_ChooseDivisors(uint32_t baud, CLOCK_DIVIDER *divider, UART_DIVISORS *divisors);
+
+/*
+ * Set PCLK and divisors for baud rate:
+ */
+static int32_t UART_SetDivisors(uint32_t baud);
 
 /*
- * Check if UART interface is busy:
+ * Recompute divisors after a clock profile change:
  */
-static bool UART_CheckBusy();
+static void UART_ClockChanged(void);
+
+/*
+ * Error handler (simple infinite loop):
+ */
+static void UART_ErrorHandler(uint8_t error_type);
 
 /*
  * Function to receive content to ring buffer:
@@ -71,6 +92,16 @@ static void UART_IntReceive();
  */
 static void UART_IntTransmit();
 
+/*
+ * Send XON or XOFF, ahead of the TX Ring Buffer:
+ */
+static void UART_SendControl(unsigned char ch);
+
+/*
+ * Send XON if XOFF was sent, and the RX Ring Buffer has drained:
+ */
+static void UART_CheckXon(void);
+
 /**
  *
  *
@@ -79,90 +110,120 @@ static void UART_IntTransmit();
  *
  */
 
-static uint32_t UART_GetPCLK(void) {
-	switch ((LPC_SC->PCLKSEL1 >> 16) & 0x03) {
-		case 0x00:
-			return SystemCoreClock/4;
-		case 0x01:
-			return SystemCoreClock;
-		case 0x02:
-			return SystemCoreClock/2;
-		case 0x03:
-			return SystemCoreClock/8;
-		default:
-			return -1;
-	}
-}
-
 static int UART_IsEnabled(IRQn_Type IRQ) { // See if i2c interrupts are enabled
 	return NVIC->ISER[((uint32_t)(IRQ) >> 5)] & (1 << ((uint32_t)(IRQ) & 0x1F));
 }
 
-static uint8_t UART_SetDivisors(uint32_t baud) {
-	if (baud > 115200) return -1;
-	if (baud == 0) baud = 9600;
-
-	int pclk = UART_GetPCLK();
+static int32_t UART_BaudError(uint32_t pclk, uint32_t baud, uint32_t divisor, uint32_t divAddVal, uint32_t mulVal) {
+	int64_t achieved = (int64_t) pclk * mulVal; // Baud rate, times 'cycles'
+	int64_t cycles = (int64_t) 16 * divisor * (mulVal + divAddVal) * baud;
+	return (int32_t) ((achieved - cycles) * 1000000 / cycles);
+}
 
-	double d = (double) pclk / (16 * baud); // 27,1267 with PCLK = 50 MHz and baud = 115200
-	int i = (int) d;
+static int32_t UART_SearchDivisors(uint32_t pclk, uint32_t baud, UART_DIVISORS *divisors) {
+	// baud = pclk * mulVal / (16 * divisor * (mulVal + divAddVal)): for each fraction, try the divisors around the exact one
+	uint64_t bestDiff = 1, bestCycles = 0; // Error is bestDiff / bestCycles (worse than anything, to begin with)
 
+	for (uint32_t mulVal = 1; mulVal <= 15; mulVal++) {
+		for (uint32_t divAddVal = 0; divAddVal < mulVal; divAddVal++) {
+			if (divAddVal == 0 && mulVal > 1) continue; // No fraction: once only
 
-	// Best results:
-	int best[2] = {0, 1}; // Pre-scaler values, divisor and multiplier (default is 0, 1)
-	double bestMargin = 0xFFFFFFFF; // Best margin between real fraction and pre-scaler generated margin
-	int bestIntVal = 0; // Best integer value
+			uint64_t scaled = (uint64_t) pclk * mulVal;
+			uint64_t exact = scaled / ((uint64_t) 16 * baud * (mulVal + divAddVal));
 
-	double currentFraction;
-	double currentMargin;
+			for (uint64_t divisor = exact; divisor <= exact + 1; divisor++) {
+				if (divisor < ((divAddVal == 0) ? 1 : 3) || divisor > 0xFFFF) continue; // DLM:DLL >= 3 with a fraction
 
-	// i * (1 + fraction) = d <=> fraction = (d - i) / i
-	for (int intVal = i/2; intVal <= i; intVal++) {
-		currentFraction = (double) (d - intVal) / intVal;
-		for (int divAddVal = 0; divAddVal <= 14; divAddVal++) {
-			for (int mulVal = divAddVal + 1; mulVal <= 15; mulVal++) {
-				if ((currentMargin = (double) MARGIN(currentFraction, (double) divAddVal/mulVal)) < bestMargin) {
-					best[0] = divAddVal;
-					best[1] = mulVal;
-					bestMargin = currentMargin;
-					bestIntVal = intVal;
+				uint64_t cycles = 16 * divisor * (mulVal + divAddVal);
+				uint64_t diff = (scaled > baud * cycles) ? scaled - baud * cycles : baud * cycles - scaled;
+				if (diff * bestCycles < bestDiff * cycles) { // diff / cycles < bestDiff / bestCycles
+					divisors->divisor = divisor;
+					divisors->divAddVal = divAddVal;
+					divisors->mulVal = mulVal;
+					bestDiff = diff;
+					bestCycles = cycles;
 				}
 			}
 		}
 	}
+	if (bestCycles == 0) return -1;
+
+	divisors->pclk = pclk;
+	divisors->baud = baud;
+	divisors->error = UART_BaudError(pclk, baud, divisors->divisor, divisors->divAddVal, divisors->mulVal);
+	return 0;
+}
 
-	//printf("Asked Baud Rate: %f\nReal Baud Rate:  %f\n", (double) baud, (double) pclk / (16 * bestIntVal * (1 + ((double) best[0] / best[1]))));
+static int32_t UART_ChooseDivisors(uint32_t baud, CLOCK_DIVIDER *divider, UART_DIVISORS *divisors) {
+	static const CLOCK_DIVIDER dividers[] = {CLOCK_DIV8, CLOCK_DIV4, CLOCK_DIV2, CLOCK_DIV1}; // Slowest PCLK first, kept on ties
+	static const uint32_t factors[] = {8, 4, 2, 1};
+	int32_t bestError = UART_MAX_BAUD_ERROR + 1;
 
-	UARTx->LCR |= UART_LCR_DLAB_EN; // Set DLAB
+	if (baud > UART_MAX_BAUD) return -1;
+	if (baud == 0) baud = 9600;
+
+	for (int i = 0; i < sizeof(dividers) / sizeof(dividers[0]); i++) {
+		UART_DIVISORS candidate;
+		if (UART_FindDivisors(SystemCoreClock / factors[i], baud, &candidate) < 0) continue;
+
+		int32_t error = (candidate.error < 0) ? -candidate.error : candidate.error;
+		if (error < bestError) {
+			*divider = dividers[i];
+			*divisors = candidate;
+			bestError = error;
+		}
+	}
+	return (bestError <= UART_MAX_BAUD_ERROR) ? 0 : -1;
+}
 
-	// Clean registers:
-	UARTx->DLL &= ~(0xFF);
-	UARTx->DLM &= ~(0xFF);
-	UARTx->FDR &= ~(0xFF);
+static int32_t UART_SetDivisors(uint32_t baud) {
+	CLOCK_DIVIDER divider;
+	UART_DIVISORS divisors;
+	if (UART_ChooseDivisors(baud, &divider, &divisors) < 0) return -1;
+
+	CLOCK_SetPCLK(CLOCK_UART2, divider);
+
+	UARTx->LCR |= UART_LCR_DLAB_EN; // Set DLAB
 
-	// Write values:
-	UARTx->DLL = UART_LOAD_DLL(bestIntVal);
-	UARTx->DLM = UART_LOAD_DLM(bestIntVal);
-	UARTx->FDR = UART_LOAD_FDR(best[0], best[1]);
+	UARTx->DLL = UART_LOAD_DLL(divisors.divisor);
+	UARTx->DLM = UART_LOAD_DLM(divisors.divisor);
+	UARTx->FDR = UART_LOAD_FDR(divisors.divAddVal, divisors.mulVal);
 
 	UARTx->LCR &= ~UART_LCR_DLAB_EN; // Clear DLAB
+
+	uartDivisors = divisors;
 	return 0;
 }
 
+static void UART_ClockChanged(void) {
+	if (UART_SetDivisors(uartBaud) == 0) {
+		if (uartStopped) { // Clock can give the baud rate again
+			uartStopped = false;
+			UARTx->TER = UART_TER_TXEN;
+			UARTx->IER |= UART_IER_RBRINT_EN | UART_IER_RLSINT_EN;
+			if (!RBUF_IS_EMPTY(rbuffer.txWrite, rbuffer.txRead)) UART_IntTransmit();
+		}
+		return;
+	}
+	// Stale divisors would send and receive garbage: stop until the clock changes again
+	uartStopped = true;
+	uartDivisors.divisor = 0;
+	UARTx->IER = 0;
+	UARTx->TER = 0;
+	intrTxStatus = false;
+}
+
 static void UART_ErrorHandler(uint8_t error_type) {
-	printf("Error: %x\n", error_type);
+	if (error_type & UART_LSR_OE) { // At least a byte lost: counted, not printed (it would lose more)
+		overruns++;
+		error_type &= ~UART_LSR_OE;
+	}
+	if (error_type) printf("Error: %x\n", error_type);
 	/*while (1) {
 		error_type = error_type;
 	}*/
 }
 
-static bool UART_CheckBusy() {
-	if (UARTx->LSR & UART_LSR_TEMT) { // THR and TSR are empty
-		return false;
-	}
-	return true;
-}
-
 /*static bool UART_RBR_IsChar(void) {
 	return (UARTx->LSR & UART_LSR_RDR) != 0;
 }*/
@@ -171,12 +232,6 @@ static bool UART_RB_IsChar(void) {
 	return !RBUF_IS_EMPTY(rbuffer.rxWrite, rbuffer.rxRead);
 }
 
-static unsigned char UART_RBR_ReadChar(void) {
-	while ((UARTx->LSR & UART_LSR_RDR) == 0); // Wait until data is received
-	char ch = UARTx->RBR;
-	return ch;
-}
-
 static bool UART_RB_ReadChar(unsigned char *ch, uint32_t timeout) {
 	uint32_t start = WAIT_SYS_GetElapsedMs(0);
 	while (RBUF_IS_EMPTY(rbuffer.rxWrite, rbuffer.rxRead)) {
@@ -186,6 +241,7 @@ static bool UART_RB_ReadChar(unsigned char *ch, uint32_t timeout) {
 	}
 	*ch = rbuffer.rx[rbuffer.rxRead];
 	RBUF_INCR(rbuffer.rxRead);
+	UART_CheckXon();
 	return true;
 }
 
@@ -201,14 +257,10 @@ static bool UART_RB_GetChar(unsigned char *ch) {
 		return false;
 	*ch = rbuffer.rx[rbuffer.rxRead];
 	RBUF_INCR(rbuffer.rxRead);
+	UART_CheckXon();
 	return true;
 }
 
-static void UART_THR_WriteChar(unsigned char ch) {
-	while ((UARTx->LSR & UART_LSR_THRE) == 0); // Wait for previous transmission
-	UARTx->THR = ch;
-}
-
 static void UART_RB_WriteChar(unsigned char ch) {
 	while (RBUF_IS_FULL(rbuffer.txWrite, rbuffer.txRead));
 	rbuffer.tx[rbuffer.txWrite] = ch;
@@ -216,30 +268,49 @@ static void UART_RB_WriteChar(unsigned char ch) {
 }
 
 static void UART_IntReceive() {
-	UARTx->IER &= (~UART_IER_RBRINT_EN) & UART_IER_BITMASK; // Disable RBRINT Interrupts
-
-	// Read RBR char to Ring Buffer:
-	rbuffer.rx[rbuffer.rxWrite] = UART_RBR_ReadChar();
-	RBUF_INCR(rbuffer.rxWrite);
+	uint32_t lsr;
+	while ((lsr = UARTx->LSR) & UART_LSR_RDR) { // Drain RX FIFO
+		if (lsr & UART_LSR_OE) overruns++; // Reading LSR clears it
+		unsigned char ch = UARTx->RBR;
+
+		if ((uartFlow == UART_FLOW_XONXOFF) && ((ch == UART_XON) || (ch == UART_XOFF))) {
+			txPaused = (ch == UART_XOFF);
+			if (!txPaused && !intrTxStatus) UART_IntTransmit(); // Resume
+			continue;
+		}
+		if (RBUF_IS_FULL(rbuffer.rxWrite, rbuffer.rxRead)) { // Lost
+			overruns++;
+			continue;
+		}
+		rbuffer.rx[rbuffer.rxWrite] = ch;
+		RBUF_INCR(rbuffer.rxWrite);
+	}
 
-	UARTx->IER |= UART_IER_RBRINT_EN; // Re-enable RBRINT Interrupts
+	if ((uartFlow == UART_FLOW_XONXOFF) && !xoffSent && (RBUF_FILL(rbuffer.rxWrite, rbuffer.rxRead) >= UART_XOFF_LEVEL)) {
+		xoffSent = true;
+		UART_SendControl(UART_XOFF);
+	}
 }
 
 static void UART_IntTransmit() {
-	while (UART_CheckBusy()); // Wait until UART isn't busy
-
 	UARTx->IER &= (~UART_IER_THREINT_EN) & UART_IER_BITMASK;
 
-	while (!RBUF_IS_EMPTY(rbuffer.txWrite, rbuffer.txRead)
-			&& ((UARTx->LSR & UART_LSR_THRE) != 0)) {
-		// Write next Ring Buffer char to THR:
-		UART_THR_WriteChar((unsigned char) rbuffer.tx[rbuffer.txRead]);
-		RBUF_INCR(rbuffer.txRead);
+	if ((UARTx->LSR & UART_LSR_THRE) != 0) { // TX FIFO is empty: fill it
+		int room = UART_TX_FIFO_SIZE;
+		if (txControl != 0) {
+			UARTx->THR = txControl;
+			txControl = 0;
+			room--;
+		}
+		while ((room > 0) && !txPaused && !RBUF_IS_EMPTY(rbuffer.txWrite, rbuffer.txRead)) {
+			UARTx->THR = rbuffer.tx[rbuffer.txRead];
+			RBUF_INCR(rbuffer.txRead);
+			room--;
+		}
 	}
 
-	if (RBUF_IS_EMPTY(rbuffer.txWrite, rbuffer.txRead)) { // Ring Buffer is empty:
-		intrTxStatus = false;
-		UARTx->IER &= (~UART_IER_THREINT_EN) & UART_IER_BITMASK; // Disable THRE Interrupts
+	if ((txControl == 0) && (txPaused || RBUF_IS_EMPTY(rbuffer.txWrite, rbuffer.txRead))) { // Nothing to send (now):
+		intrTxStatus = false; // THRE Interrupts stay disabled
 	}
 	else { // Ring Buffer still has data:
 		intrTxStatus = true;
@@ -247,6 +318,20 @@ static void UART_IntTransmit() {
 	}
 }
 
+static void UART_SendControl(unsigned char ch) {
+	NVIC_DisableIRQ(UART2_IRQn); // Called by both the handler and the reader
+	txControl = ch;
+	if (!intrTxStatus) UART_IntTransmit();
+	NVIC_EnableIRQ(UART2_IRQn);
+}
+
+static void UART_CheckXon(void) {
+	if (xoffSent && (RBUF_FILL(rbuffer.rxWrite, rbuffer.rxRead) <= UART_XON_LEVEL)) {
+		xoffSent = false;
+		UART_SendControl(UART_XON);
+	}
+}
+
 
 /********************************************************************************
  *
@@ -256,6 +341,7 @@ static void UART_IntTransmit() {
 
 void UART2_IRQHandler(void) {
 	uint32_t iir, lsr;
+	TRACE_ISR_ENTER(TRACE_UART_IRQ);
 	while (!((iir = UARTx->IIR) & UART_IIR_INTSTAT_PEND)) {
 		switch (iir & UART_IIR_INTID_MASK) {
 			case UART_IIR_INTID_RLS: // Error of some kind:
@@ -275,6 +361,34 @@ void UART2_IRQHandler(void) {
 				break;
 		}
 	}
+	TRACE_ISR_EXIT(TRACE_UART_IRQ);
+}
+
+int32_t UART_FindDivisors(uint32_t pclk, uint32_t baud, UART_DIVISORS *divisors) {
+	if (baud == 0) return -1;
+	for (uint32_t i = 0; i < uartDivisorTableLength; i++) {
+		if (uartDivisorTable[i].pclk == pclk && uartDivisorTable[i].baud == baud) {
+			*divisors = uartDivisorTable[i];
+			return 0;
+		}
+	}
+	return UART_SearchDivisors(pclk, baud, divisors);
+}
+
+bool UART_IsBaudReachable(uint32_t baud) {
+	CLOCK_DIVIDER divider;
+	UART_DIVISORS divisors;
+	return UART_ChooseDivisors(baud, &divider, &divisors) == 0;
+}
+
+uint32_t UART_GetBaud(void) {
+	if (uartDivisors.divisor == 0) return 0;
+	return (uint32_t) (((uint64_t) uartDivisors.pclk * uartDivisors.mulVal) /
+			(16 * (uint32_t) uartDivisors.divisor * (uartDivisors.mulVal + uartDivisors.divAddVal)));
+}
+
+int32_t UART_GetBaudError(void) {
+	return uartDivisors.error;
 }
 
 bool UART_Init(uint32_t baud) {
@@ -293,9 +407,6 @@ bool UART_Init(uint32_t baud) {
 	LPC_PINCON->PINMODE_OD0 &= ~((1 << 10) | (1 << 11)); // Select normal mode (not open drain) for P0[10] and P0[11] (TX2 and RX2)
 
 	LPC_SC->PCONP |= UART2_PCONP_ENABLE; // Enable UART2
-	LPC_SC->PCLKSEL1 &= ~(0x03 << 16); // Clean PCLK of UART2
-	LPC_SC->PCLKSEL1 |= (UART_PCLK_VAL << 16); // Set PCLK of UART2 to CCLK/2
-
 	// FIFOs are empty
 	UARTx->FCR = (UART_FCR_FIFO_EN | UART_FCR_RX_RS | UART_FCR_TX_RS);
 	//UARTx->FCR = 0; // Disable FIFO
@@ -312,7 +423,10 @@ bool UART_Init(uint32_t baud) {
 
 	tmp = UARTx->LSR; // Clean status
 
-	if (UART_SetDivisors(baud) < 0) return false;
+	if (UART_SetDivisors(baud) < 0) return false; // Sets PCLK too
+	uartBaud = baud;
+	uartStopped = false;
+	CLOCK_AddHandler(UART_ClockChanged);
 
 	tmp = (UARTx->LCR & (UART_LCR_DLAB_EN | UART_LCR_BREAK_EN)) & UART_LCR_BITMASK;
 	tmp |= 0x03;
@@ -320,9 +434,14 @@ bool UART_Init(uint32_t baud) {
 	UARTx->LCR = (uint8_t) (tmp & UART_LCR_BITMASK);
 	UARTx->TER |= UART_TER_TXEN;
 
-	UARTx->FCR = UART_FCR_FIFO_EN | UART_FCR_TRG_LEV0;
+	UARTx->FCR = UART_FCR_FIFO_EN | UART_FCR_TRG_LEV2; // 8 bytes per interrupt (and the rest on character time-out)
 	UARTx->IER = UART_IER_RBRINT_EN | UART_IER_RLSINT_EN;
 	intrTxStatus = false;
+	uartFlow = UART_FLOW_NONE;
+	txPaused = false;
+	xoffSent = false;
+	txControl = 0;
+	overruns = 0;
 	RBUF_RESET(rbuffer.rxWrite);
 	RBUF_RESET(rbuffer.rxRead);
 	RBUF_RESET(rbuffer.txWrite);
@@ -342,6 +461,19 @@ bool UART_Init(uint32_t baud) {
 	return true;
 }
 
+void UART_SetFlowControl(UART_FLOW flow) {
+	uartFlow = flow;
+	xoffSent = false;
+	if (txPaused) {
+		txPaused = false;
+		if (!intrTxStatus) UART_IntTransmit();
+	}
+}
+
+uint32_t UART_GetOverruns(void) {
+	return overruns;
+}
+
 bool UART_IsChar(void) {
 	return UART_RB_IsChar();
 }
@@ -355,6 +487,7 @@ bool UART_GetChar(unsigned char *ch) {
 }
 
 void UART_WriteChar(unsigned char ch) {
+	TRACE_ENTER(TRACE_UART_WRITE, 1);
 	UART_RB_WriteChar(ch);
 	// If there's still data in Ring Buffer:
 	if (!RBUF_IS_EMPTY(rbuffer.txWrite, rbuffer.txRead)) {
@@ -363,12 +496,15 @@ void UART_WriteChar(unsigned char ch) {
 			UART_IntTransmit();
 		}
 	}
+	TRACE_EXIT(TRACE_UART_WRITE);
 }
 
 uint32_t UART_WriteBuffer(unsigned char *buffer, uint32_t len) {
 	unsigned char *data = (unsigned char *) buffer;
 	uint32_t bytes = 0;
 
+	TRACE_ENTER(TRACE_UART_WRITE, len);
+
 	// Write buffer to Ring Buffer:
 	while ((len > 0) && (!RBUF_IS_FULL(rbuffer.txWrite, rbuffer.txRead))) { // While there's data, and RBUF is not full:
 		UART_RB_WriteChar(*data);
@@ -385,6 +521,7 @@ uint32_t UART_WriteBuffer(unsigned char *buffer, uint32_t len) {
 		}
 	}
 
+	TRACE_EXIT(TRACE_UART_WRITE);
 	return bytes;
 }
 
@@ -392,11 +529,16 @@ uint32_t UART_ReadBuffer(unsigned char *buffer, uint32_t len, uint32_t timeout)
 	unsigned char *data = (unsigned char *) buffer;
 	uint32_t bytes = 0;
 
+	TRACE_ENTER(TRACE_UART_READ, len);
+
 	//UARTx->IER &= (~UART_IER_RBRINT_EN) & UART_IER_BITMASK; // Disable RBRINT Interrupts
 
 	while ((len > 0)) { // && (!(RBUF_IS_EMPTY(rbuffer.rxWrite, rbuffer.rxRead)))) { // While there's data, and RBUF is not empty:
 		// Read data from RBUF:
-		if (!UART_RB_ReadChar(data, timeout)) return -1;
+		if (!UART_RB_ReadChar(data, timeout)) {
+			TRACE_EXIT(TRACE_UART_READ);
+			return -1;
+		}
 		data++;
 		bytes++;
 		len--;
@@ -404,6 +546,7 @@ uint32_t UART_ReadBuffer(unsigned char *buffer, uint32_t len, uint32_t timeout)
 
 	//UARTx->IER |= UART_IER_RBRINT_EN; // Re-enable RBRINT Interrupts
 
+	TRACE_EXIT(TRACE_UART_READ);
 	return bytes;
 }
 
@@ -415,10 +558,15 @@ uint32_t UART_ReadString(unsigned char *str, uint32_t timeout) {
 	unsigned char ch;
 	uint32_t len = 0;
 
+	TRACE_ENTER(TRACE_UART_READ, 0);
+
 	//UARTx->IER &= (~UART_IER_RBRINT_EN) & UART_IER_BITMASK; // Disable RBRINT Interrupts
 
 	while(1) {
-		if (!UART_RB_ReadChar(&ch, timeout)) return -1; // Read character from Ring Buffer
+		if (!UART_RB_ReadChar(&ch, timeout)) { // Read character from Ring Buffer
+			TRACE_EXIT(TRACE_UART_READ);
+			return -1;
+		}
 		if ((ch == '\r') || (ch == '\n')) { // Read until \r or \n
 			if (len != 0) { // Wait until at least 1 char is received
 			   str[len] = 0; // Once enter key is pressed, null terminate the string and break the loop
@@ -436,18 +584,20 @@ uint32_t UART_ReadString(unsigned char *str, uint32_t timeout) {
 
 	//UARTx->IER |= UART_IER_RBRINT_EN; // Re-enable RBRINT Interrupts
 
+	TRACE_EXIT(TRACE_UART_READ);
 	return len;
 }
 
 
+static void UART_PrintfSink(void *context, char ch) {
+	UART_WriteChar((unsigned char) ch);
+}
+
 void UART_Printf(char *format, ...) {
 	va_list arg;
-	char str[UART_MAX_SRING_LENGTH];
 
 	va_start(arg, format);
-	vsprintf(str, format, arg);
+	FORMAT_Print(UART_PrintfSink, NULL, UART_MAX_SRING_LENGTH, format, arg);
 	va_end(arg);
-
-	UART_WriteString((unsigned char *) str);
 }
 
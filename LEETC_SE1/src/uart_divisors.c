@@ -0,0 +1,83 @@
+/*
+ * uart_divisors.c
+ *
+ *  Generated by tools/uart_divisors.py: do not edit.
+ */
+
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#endif
+
+#include "uart.h"
+
+
+const UART_DIVISORS uartDivisorTable[] = {
+	// CLOCK_FULL:
+	{100000000, 9600, 514, 4, 15, -38},
+	{100000000, 19200, 257, 4, 15, -38},
+	{100000000, 38400, 92, 10, 13, -54},
+	{100000000, 57600, 62, 3, 4, 64},
+	{100000000, 115200, 31, 3, 4, 64},
+	{100000000, 230400, 19, 3, 7, -593},
+	{100000000, 460800, 10, 5, 14, -593},
+	{100000000, 921600, 5, 5, 14, -593},
+	{50000000, 9600, 257, 4, 15, -38},
+	{50000000, 19200, 92, 10, 13, -54},
+	{50000000, 38400, 46, 10, 13, -54},
+	{50000000, 57600, 31, 3, 4, 64},
+	{50000000, 115200, 19, 3, 7, -593},
+	{50000000, 230400, 10, 5, 14, -593},
+	{50000000, 460800, 5, 5, 14, -593},
+	{50000000, 921600, 3, 2, 15, -2693},
+	{25000000, 9600, 92, 10, 13, -54},
+	{25000000, 19200, 46, 10, 13, -54},
+	{25000000, 38400, 23, 10, 13, -54},
+	{25000000, 57600, 19, 3, 7, -593},
+	{25000000, 115200, 10, 5, 14, -593},
+	{25000000, 230400, 5, 5, 14, -593},
+	{25000000, 460800, 3, 2, 15, -2693},
+	{25000000, 921600, 2, 0, 1, -152289},
+	{12500000, 9600, 46, 10, 13, -54},
+	{12500000, 19200, 23, 10, 13, -54},
+	{12500000, 38400, 19, 1, 14, -593},
+	{12500000, 57600, 10, 5, 14, -593},
+	{12500000, 115200, 5, 5, 14, -593},
+	{12500000, 230400, 3, 2, 15, -2693},
+	{12500000, 460800, 2, 0, 1, -152289},
+	{12500000, 921600, 1, 0, 1, -152289},
+	// CLOCK_REDUCED:
+	{24000000, 9600, 125, 1, 4, 0},
+	{24000000, 19200, 71, 1, 10, 320},
+	{24000000, 38400, 23, 7, 10, -959},
+	{24000000, 57600, 23, 2, 15, -959},
+	{24000000, 115200, 13, 0, 1, 1602},
+	{24000000, 230400, 4, 5, 8, 1602},
+	{24000000, 460800, 3, 1, 12, 1602},
+	{24000000, 921600, 2, 0, 1, -186197},
+	{12000000, 9600, 71, 1, 10, 320},
+	{12000000, 19200, 23, 7, 10, -959},
+	{12000000, 38400, 16, 2, 9, -1242},
+	{12000000, 57600, 13, 0, 1, 1602},
+	{12000000, 115200, 4, 5, 8, 1602},
+	{12000000, 230400, 3, 1, 12, 1602},
+	{12000000, 460800, 2, 0, 1, -186197},
+	{12000000, 921600, 1, 0, 1, -186197},
+	{6000000, 9600, 23, 7, 10, -959},
+	{6000000, 19200, 16, 2, 9, -1242},
+	{6000000, 38400, 8, 2, 9, -1242},
+	{6000000, 57600, 4, 5, 8, 1602},
+	{6000000, 115200, 3, 1, 12, 1602},
+	{6000000, 230400, 2, 0, 1, -186197},
+	{6000000, 460800, 1, 0, 1, -186197},
+	{6000000, 921600, 1, 0, 1, -593098},
+	{3000000, 9600, 16, 2, 9, -1242},
+	{3000000, 19200, 8, 2, 9, -1242},
+	{3000000, 38400, 4, 2, 9, -1242},
+	{3000000, 57600, 3, 1, 12, 1602},
+	{3000000, 115200, 2, 0, 1, -186197},
+	{3000000, 230400, 1, 0, 1, -186197},
+	{3000000, 460800, 1, 0, 1, -593098},
+	{3000000, 921600, 1, 0, 1, -796549},
+};
+
+const uint32_t uartDivisorTableLength = sizeof(uartDivisorTable) / sizeof(uartDivisorTable[0]);
@@ -11,6 +11,7 @@
 
 
 #include "wait.h"
+#include "timestamp.h"
 
 
 
@@ -39,11 +40,38 @@ static int32_t WAIT_TIM2_Init(void);
 static int32_t WAIT_IRQ2_Init(void);
 static int32_t WAIT_TIM3_Init(void);
 static int32_t WAIT_IRQ3_Init(void);
+static int32_t WAIT_WHEEL_Init(void);
+static void WAIT_WHEEL_Run(void);
+static void WAIT_ClockChanged(void);
+
+static uint32_t prescaled = 0; // Timers whose prescaler was set here (by PCONP_ENABLE bit), for WAIT_ClockChanged()
+
+/*
+ * Timer wheel (on timer2, free running at 1 MHz):
+ *
+ * Timers are kept in WHEEL_LEVELS levels of WHEEL_SLOTS slots. A timer goes to the level of the highest bit in which
+ * its expiry differs from wheelNow, and to the slot given by its expiry's bits at that level. So level 0 slots hold
+ * timers due at exactly that microsecond, and higher level slots hold timers that will be moved down (cascaded) once
+ * wheelNow reaches the start of their slot. Insert and remove are constant time. The next event is the first used slot
+ * of the lowest used level (one bit scan), which is programmed into MR0: there is no periodic tick.
+ */
+static WAIT_TIMER *wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static uint32_t wheelUsed[WHEEL_LEVELS]; // Bitmap of non empty slots, per level
+static uint32_t wheelNow; // Time (us) the wheel has been run up to. Never ahead of TC.
+static uint32_t wheelCount; // Active timers
+static bool wheelRunning = false; // Inside WAIT_WHEEL_Run()
+static bool wheelTim2 = false; // Timer2 is running the wheel
 
 #ifndef FREERTOS // If FREERTOS is not in properties pre-processor...
 	void SysTick_Handler(void)
 	{
 		__ms++;
+		TIMESTAMP_Get(); // Keeps the 64-bit cycle count, which needs a reading per CYCCNT wrap (see timestamp.h)
+	}
+#else
+	void vApplicationTickHook(void) // The kernel owns SysTick (configUSE_TICK_HOOK)
+	{
+		TIMESTAMP_Get(); // As SysTick_Handler()
 	}
 #endif
 
@@ -66,6 +94,10 @@ void TIMER1_IRQHandler(void) // Original interrupt handler
 void TIMER2_IRQHandler(void) // Original interrupt handler
 {
 	LPC_TIM2->IR = TIMER_IR_MR0; // Reset interrupt bit
+	if (wheelTim2) {
+		WAIT_WHEEL_Run();
+		return;
+	}
 	LPC_TIM2->TCR = DISABLE_RESET;
 	busyTim2 = false;
 	if (h2 != 0) (*h2)(); // Call custom interrupt handler
@@ -82,6 +114,8 @@ void TIMER3_IRQHandler(void) // Original interrupt handler
 int32_t WAIT_Init(WAIT mode)
 {
 	SystemCoreClockUpdate();
+	CLOCK_AddHandler(WAIT_ClockChanged);
+	if (mode == WHEEL && wheelTim2) return 0; // The wheel is shared
 	if (setBusy(mode) < 0) return -1;
 	switch (mode) {
 		case SYS:
@@ -102,6 +136,8 @@ int32_t WAIT_Init(WAIT mode)
 			return WAIT_TIM3_Init();
 		case IRQ3:
 			return WAIT_IRQ3_Init();
+		case WHEEL:
+			return WAIT_WHEEL_Init();
 		default:
 			return -1;
 	}
@@ -128,6 +164,8 @@ static int32_t setBusy(WAIT mode)
 			return (busy[4] ? -1 : (busy[4] = 1));
 		case IRQ3:
 			return (busy[4] ? -1 : (busy[4] = 1));
+		case WHEEL:
+			return (busy[3] ? -1 : (busy[3] = 1));
 		default:
 			return -1;
 	}
@@ -137,6 +175,36 @@ static int WAIT_IsEnabled(IRQn_Type IRQ) { // See if timer interrupts are enable
 	return NVIC->ISER[((uint32_t)(IRQ) >> 5)] & (1 << ((uint32_t)(IRQ) & 0x1F));
 }
 
+static void WAIT_ClockChanged(void) // Recompute SysTick reload and timer prescalers, after a clock profile change
+{
+	#ifdef FREERTOS
+		SysTick->LOAD = (configCPU_CLOCK_HZ / configTICK_RATE_HZ) - 1UL; // The kernel's tick
+	#else
+		SysTick->LOAD = SYSTICK_FREQ - 1;
+	#endif
+	SysTick->VAL = 0;
+
+	// Integer TIMER_PCLK*TIMER_RES - 1 (no soft float with interrupts disabled). PC is cleared with PR: past a smaller
+	// PR, it would count up to 2^32 before TC moves again.
+	uint32_t prescale = SystemCoreClock/4/1000000 - 1;
+	if (prescaled & PCONP_ENABLE_TIM0) {
+		LPC_TIM0->PR = prescale;
+		LPC_TIM0->PC = 0;
+	}
+	if (prescaled & PCONP_ENABLE_TIM1) {
+		LPC_TIM1->PR = prescale;
+		LPC_TIM1->PC = 0;
+	}
+	if (prescaled & PCONP_ENABLE_TIM2) { // The wheel keeps counting microseconds
+		LPC_TIM2->PR = prescale;
+		LPC_TIM2->PC = 0;
+	}
+	if (prescaled & PCONP_ENABLE_TIM3) {
+		LPC_TIM3->PR = prescale;
+		LPC_TIM3->PC = 0;
+	}
+}
+
 static int32_t WAIT_SYS_Init(void) // Initialise Systick:
 {
 	#ifndef FREERTOS // Not FREERTOS
@@ -153,6 +221,7 @@ static int32_t WAIT_TIM0_Init(void) // Initialise Timer0
 
     LPC_SC->PCLKSEL0 &= ~(BITS_PCLK_TIM0); // Set PCLK to 1/4, "00" (bits[3:2] correspond to timer0)
     LPC_TIM0->PR = TIMER_PCLK*TIMER_RES - 1; // Prescale for time resolution of 1 microsecond and pclk=cclk/4
+    prescaled |= PCONP_ENABLE_TIM0;
 
     LPC_TIM0->MCR = 0x0; // Disable all match registers
     LPC_TIM0->MCR |= 0x3; // Set MR0 to reset and interrupt
@@ -180,6 +249,7 @@ static int32_t WAIT_TIM1_Init(void) // Initialise Timer0
 
     LPC_SC->PCLKSEL0 &= ~(BITS_PCLK_TIM1); // Set PCLK to 1/4, "00" (bits[5:4] correspond to timer1)
     LPC_TIM1->PR = TIMER_PCLK*TIMER_RES - 1; // Prescale for time resolution of 1 microsecond and pclk=cclk/4
+    prescaled |= PCONP_ENABLE_TIM1;
 
     LPC_TIM1->MCR = 0x0; // Disable all match registers
     LPC_TIM1->MCR |= 0x3; // Set MR0 to reset and interrupt
@@ -207,6 +277,7 @@ static int32_t WAIT_TIM2_Init(void) // Initialise Timer0
 
     LPC_SC->PCLKSEL1 &= ~(BITS_PCLK_TIM2); // Set PCLK to 1/4, "00" (bits[13:12] correspond to timer2)
     LPC_TIM2->PR = TIMER_PCLK*TIMER_RES - 1; // Prescale for time resolution of 1 microsecond and pclk=cclk/4
+    prescaled |= PCONP_ENABLE_TIM2;
 
     LPC_TIM2->MCR = 0x0; // Disable all match registers
     LPC_TIM2->MCR |= 0x3; // Set MR0 to reset and interrupt
@@ -234,6 +305,7 @@ static int32_t WAIT_TIM3_Init(void) // Initialise Timer0
 
     LPC_SC->PCLKSEL1 &= ~(BITS_PCLK_TIM3); // Set PCLK to 1/4, "00" (bits[15:14] correspond to timer3)
     LPC_TIM3->PR = TIMER_PCLK*TIMER_RES - 1; // Prescale for time resolution of 1 microsecond and pclk=cclk/4
+    prescaled |= PCONP_ENABLE_TIM3;
 
     LPC_TIM3->MCR = 0x0; // Disable all match registers
     LPC_TIM3->MCR |= 0x3; // Set MR0 to reset and interrupt
@@ -254,6 +326,156 @@ static int32_t WAIT_IRQ3_Init(void) // Initialise Timer0 with Interrupt Request
 	return ret;
 }
 
+static int32_t WAIT_WHEEL_Init(void) // Initialise Timer2 as the timer wheel's clock
+{
+	WAIT_TIM2_Init();
+
+	LPC_TIM2->MCR = 0x1; // MR0 interrupts only: TC keeps running, as the wheel's clock
+	LPC_TIM2->TCR = RESET;
+	LPC_TIM2->TCR = ENABLE;
+
+	wheelTim2 = true;
+	if (!WAIT_IsEnabled(TIMER2_IRQn)) { // If it's not already enabled:
+		NVIC_EnableIRQ(TIMER2_IRQn);
+	}
+	return 0;
+}
+
+static void WAIT_WHEEL_Insert(WAIT_TIMER *timer)
+{
+	uint32_t diff = timer->expiry ^ wheelNow;
+	uint32_t level = (diff == 0) ? 0 : (31 - __CLZ(diff)) / WHEEL_LEVEL_BITS;
+	uint32_t slot = (timer->expiry >> (level * WHEEL_LEVEL_BITS)) & (WHEEL_SLOTS - 1);
+
+	timer->level = level;
+	timer->slot = slot;
+	timer->link = &wheel[level][slot];
+	timer->next = wheel[level][slot];
+	if (timer->next != NULL) timer->next->link = &timer->next;
+	wheel[level][slot] = timer;
+	wheelUsed[level] |= (1UL << slot);
+	wheelCount++;
+	timer->active = true;
+}
+
+static void WAIT_WHEEL_Remove(WAIT_TIMER *timer)
+{
+	*timer->link = timer->next;
+	if (timer->next != NULL) timer->next->link = timer->link;
+	if (wheel[timer->level][timer->slot] == NULL) wheelUsed[timer->level] &= ~(1UL << timer->slot);
+	wheelCount--;
+	timer->active = false;
+}
+
+static bool WAIT_WHEEL_Next(uint32_t *next, uint32_t *level) // Time of next event (expiry at level 0, cascade above), and its level
+{
+	for (uint32_t l = 0; l < WHEEL_LEVELS; l++) {
+		if (wheelUsed[l] == 0) continue;
+
+		uint32_t shift = l * WHEEL_LEVEL_BITS;
+		uint32_t current = (wheelNow >> shift) & (WHEEL_SLOTS - 1);
+		uint32_t ahead = wheelUsed[l] & (~0UL << current);
+		uint32_t slot = __CLZ(__RBIT(ahead != 0 ? ahead : wheelUsed[l])); // Only the top level may wrap around
+
+		uint32_t top = shift + WHEEL_LEVEL_BITS;
+		uint32_t base = (top >= 32) ? 0 : wheelNow & ~((1UL << top) - 1); // Bits above this level are wheelNow's
+		*next = base | (slot << shift);
+		*level = l;
+		return true;
+	}
+	return false;
+}
+
+static void WAIT_WHEEL_Advance(uint32_t now, uint32_t level) // Run the wheel's event at 'now'
+{
+	wheelNow = now;
+
+	if (level == 0) { // Expire
+		WAIT_TIMER **slot = &wheel[0][now & (WHEEL_SLOTS - 1)];
+		WAIT_TIMER *timer;
+		while ((timer = *slot) != NULL) {
+			WAIT_WHEEL_Remove(timer);
+			if (timer->period != 0) {
+				timer->expiry += timer->period;
+				WAIT_WHEEL_Insert(timer);
+			}
+			if (timer->f != 0) (*timer->f)(); // Call custom handler
+		}
+	}
+	else { // Cascade: every timer of this slot goes to a lower level
+		uint32_t index = (now >> (level * WHEEL_LEVEL_BITS)) & (WHEEL_SLOTS - 1);
+		WAIT_TIMER *timer = wheel[level][index];
+		wheel[level][index] = NULL;
+		wheelUsed[level] &= ~(1UL << index);
+		while (timer != NULL) {
+			WAIT_TIMER *next = timer->next;
+			wheelCount--;
+			WAIT_WHEEL_Insert(timer);
+			timer = next;
+		}
+	}
+}
+
+static void WAIT_WHEEL_Run(void) // Run every due event, then program the next one
+{
+	uint32_t next, level;
+
+	wheelRunning = true;
+	while (WAIT_WHEEL_Next(&next, &level)) {
+		if ((int32_t) (LPC_TIM2->TC - next) < 0) { // Not due yet
+			LPC_TIM2->MR0 = next;
+			if ((int32_t) (LPC_TIM2->TC - next) < 0) break; // Match still ahead: it will interrupt
+			continue; // TC went past it meanwhile
+		}
+		WAIT_WHEEL_Advance(next, level);
+	}
+	wheelRunning = false;
+}
+
+void WAIT_WHEEL_Start(WAIT_TIMER *timer, uint32_t micros, uint32_t period, void (*f)(void))
+{
+	NVIC_DisableIRQ(TIMER2_IRQn);
+
+	if (timer->active) WAIT_WHEEL_Remove(timer);
+	if (wheelCount == 0 && !wheelRunning) wheelNow = LPC_TIM2->TC; // Nothing pending: catch up
+
+	timer->expiry = LPC_TIM2->TC + micros;
+	timer->period = period;
+	timer->f = f;
+	WAIT_WHEEL_Insert(timer);
+
+	uint32_t next, level;
+	if (!wheelRunning && WAIT_WHEEL_Next(&next, &level)) { // (When running, WAIT_WHEEL_Run() does it)
+		LPC_TIM2->MR0 = next;
+		if ((int32_t) (LPC_TIM2->TC - next) >= 0) NVIC_SetPendingIRQ(TIMER2_IRQn); // Already due
+	}
+
+	NVIC_EnableIRQ(TIMER2_IRQn);
+}
+
+void WAIT_WHEEL_Stop(WAIT_TIMER *timer)
+{
+	NVIC_DisableIRQ(TIMER2_IRQn);
+	if (timer->active) WAIT_WHEEL_Remove(timer); // MR0 is left as is: an early interrupt finds nothing due
+	NVIC_EnableIRQ(TIMER2_IRQn);
+}
+
+bool WAIT_WHEEL_IsActive(WAIT_TIMER *timer)
+{
+	return timer->active;
+}
+
+void WAIT_WHEEL_Us(uint32_t micros)
+{
+	uint32_t start = LPC_TIM2->TC;
+	while ((LPC_TIM2->TC - start) < micros);
+}
+
+uint32_t WAIT_WHEEL_GetElapsedUs(uint32_t start)
+{
+	return LPC_TIM2->TC - start;
+}
+
 void WAIT_SYS_Ms(uint32_t millis)
 {
 	#ifdef FREERTOS // Not FREERTOS
@@ -0,0 +1,226 @@
+/*
+===============================================================================
+ Name        : testBenchmark.c
+ Author      : PedroG
+ Version     : 1.0
+ Copyright   : PedroG
+ Description : Driver micro-benchmarks (cycles and bytes per second)
+===============================================================================
+*/
+
+#ifdef __USE_CMSIS
+#include "LPC17xx.h"
+#endif
+
+#include <cr_section_macros.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wait.h"
+#include "lcd.h"
+#include "spi.h"
+#include "adxl.h"
+#include "uart.h"
+#include "i2c.h"
+#include "eeprom.h"
+#include "flash.h"
+#include "timestamp.h"
+
+/*
+ * 	Results go to semihosting (printf) as CSV, one line per benchmark, between BENCH_BEGIN and BENCH_END lines, so a
+ * 	script can cut the table out of the console log and compare it against a previous run:
+ *
+ * 		name,iterations,bytes,min_cycles,mean_cycles,max_cycles,bytes_per_s,status
+ *
+ * 	bytes is per iteration, and bytes_per_s is taken from mean_cycles. status is "ok", or "fail" if any iteration
+ * 	failed (e.g. no UART loopback jumper, no EEPROM, or received UART bytes lost to overruns), in which case the
+ * 	timings are meaningless. The UART round trips run at UART_BAUD, then (sustained, for overruns) at UART_FAST_BAUD.
+ *
+ * 	Hardware: LCD, ADXL345 (SPI), 24LC32 EEPROM (I2C1), and a jumper between UART2 TX and RX.
+ * 	Flash sector FLASH_SECTOR is erased and overwritten.
+ */
+
+#define UART_BAUD 115200
+#define UART_FAST_BAUD UART_MAX_BAUD
+#define UART_BYTES 1024
+#define UART_TIMEOUT_MS 1000
+
+#define SPI_BYTES 7 // Command and 6 data registers (ADXL345 axis burst read)
+#define ADXL_DATAX0 0x32
+
+#define EEPROM_BENCH_ADDRESS 0x0F00 // Last 8 pages (not used by SCORE)
+#define EEPROM_BENCH_PAGES 8
+
+#define FLASH_SECTOR 29
+#define FLASH_SECTOR_SIZE (FLASH_END_ADDRESS_29 - FLASH_START_ADDRESS_29 + 1)
+
+/*
+ * 	One benchmark: 'operation' runs once per iteration, and returns 0 if successful.
+ */
+typedef struct {
+	const char *name;
+	int (*operation)(int iteration);
+	int iterations;
+	uint32_t bytes;
+} BENCH;
+
+/*
+ * 	Shared data buffers.
+ */
+unsigned char txData[UART_BYTES];
+unsigned char rxData[UART_BYTES];
+unsigned int flashData[FLASH_MINIMAL_WRITE_SIZE / sizeof(unsigned int)];
+
+
+/*
+ * 	Operations:
+ */
+
+int lcdChar(int iteration) {
+	LCDText_Locate(1, 1);
+	LCDText_WriteChar('0' + (iteration % 10));
+	return 0;
+}
+
+int spiTransfer(int iteration) {
+	unsigned short tx[SPI_BYTES] = {ADXL_DATAX0 | ADXL_READ_BIT | ADXL_MB_BIT};
+	unsigned short rx[SPI_BYTES];
+
+	LPC_GPIO0->FIOCLR = (1 << CS); // Select ADXL345
+	int32_t result = SPI_Transfer(tx, rx, SPI_BYTES);
+	LPC_GPIO0->FIOSET = (1 << CS);
+	return result;
+}
+
+int uartRoundTrip(int iteration) {
+	uint32_t sent = 0, received = 0;
+	uint32_t start = WAIT_SYS_GetElapsedMs(0);
+	uint32_t overruns = UART_GetOverruns();
+
+	while (received < UART_BYTES) {
+		if (sent < UART_BYTES) sent += UART_WriteBuffer(&txData[sent], UART_BYTES - sent); // As much as the ring takes
+		while ((received < sent) && UART_GetChar(&rxData[received])) received++;
+		if (WAIT_SYS_GetElapsedMs(start) > UART_TIMEOUT_MS) return -1; // No loopback
+	}
+	if (UART_GetOverruns() != overruns) return -1;
+	return (memcmp(txData, rxData, UART_BYTES) == 0) ? 0 : -1;
+}
+
+int uartFastRoundTrip(int iteration) {
+	if ((iteration == 0) && !UART_Init(UART_FAST_BAUD)) return -1;
+	return uartRoundTrip(iteration);
+}
+
+int eepromPageWrite(int iteration) {
+	int address = EEPROM_BENCH_ADDRESS + (iteration % EEPROM_BENCH_PAGES) * EEPROM_PAGE_LENGTH;
+	if (EEPROM_WriteCached(address, (char *) txData, EEPROM_PAGE_LENGTH) < 0) return -1;
+	return EEPROM_Flush(); // The write cycle is waited for by the next access (so it counts from the 2nd iteration on)
+}
+
+int i2cRead(int iteration) {
+	char wBuffer[] = {(EEPROM_BENCH_ADDRESS >> 8), (EEPROM_BENCH_ADDRESS & 0xFF)};
+	I2C_TRANSACTION transaction = {
+		.address = EEPROM_ADDRESS,
+		.frequency = EEPROM_FREQUENCY,
+		.wBuffer = wBuffer,
+		.wSize = sizeof(wBuffer),
+		.rBuffer = (char *) rxData,
+		.rSize = EEPROM_PAGE_LENGTH
+	};
+	return (I2C1_Transfer(&transaction) == I2C_TRANSFER_DONE) ? 0 : -1; // Straight to the bus (no EEPROM cache)
+}
+
+int flashSectorWrite(int iteration) {
+	if (FLASH_EraseSectors(FLASH_SECTOR, FLASH_SECTOR) != 0) return -1;
+
+	for (uint32_t offset = 0; offset < FLASH_SECTOR_SIZE; offset += FLASH_MINIMAL_WRITE_SIZE) {
+		void *address = (void *) (FLASH_START_ADDRESS_29 + offset);
+		if (FLASH_WriteData(FLASH_SECTOR, address, flashData, FLASH_MINIMAL_WRITE_SIZE) != 0) return -1;
+	}
+	return 0;
+}
+
+/*
+ * 	Benchmarks, in order.
+ */
+const BENCH benchmarks[] = {
+	{"lcd_char", lcdChar, 100, 1},
+	{"spi_transfer_7", spiTransfer, 1000, SPI_BYTES},
+	{"uart_round_trip_1k", uartRoundTrip, 10, UART_BYTES},
+	{"uart_round_trip_1k_921600", uartFastRoundTrip, 100, UART_BYTES}, // Leaves the UART at UART_FAST_BAUD
+	{"i2c_read_page", i2cRead, 100, EEPROM_PAGE_LENGTH}, // Before the page writes: the EEPROM ignores reads in a write cycle
+	{"eeprom_page_write", eepromPageWrite, 16, EEPROM_PAGE_LENGTH},
+	{"flash_sector_write", flashSectorWrite, 4, FLASH_SECTOR_SIZE},
+};
+
+/*
+ * 	Runs a benchmark and prints its line. Returns true if every iteration succeeded.
+ */
+bool run(const BENCH *bench) {
+	TIMESTAMP_HISTOGRAM histogram;
+	uint64_t total = 0;
+	bool ok = true;
+
+	memset(&histogram, 0, sizeof(histogram));
+	for (int i = 0; i < bench->iterations; i++) {
+		uint32_t start = TIMESTAMP_GetCycles();
+		if (bench->operation(i) != 0) ok = false;
+		uint32_t cycles = TIMESTAMP_GetCycles() - start;
+
+		TIMESTAMP_HistogramAdd(&histogram, cycles);
+		total += cycles;
+	}
+
+	uint32_t mean = (uint32_t) (total / bench->iterations);
+	uint32_t rate = (mean == 0) ? 0 : (uint32_t) (((uint64_t) bench->bytes * TIMESTAMP_GetHz()) / mean);
+
+	printf("%s,%d,%u,%u,%u,%u,%u,%s\n", bench->name, bench->iterations, (unsigned) bench->bytes,
+			(unsigned) histogram.min, (unsigned) mean, (unsigned) histogram.max, (unsigned) rate, ok ? "ok" : "fail");
+	return ok;
+}
+
+/*
+ * 	Initialises the devices and the data. Returns false if the LCD could not initialise.
+ */
+bool init(void) {
+	SystemInit();
+	TIMESTAMP_Init();
+	WAIT_Init(SYS);
+	if (LCDText_Init() < 0) {
+		printf("LCD could not initialise.\n");
+		return false;
+	}
+	ADXL_Init(0, 0); // Default SPI frequency
+	UART_Init(UART_BAUD);
+	EEPROM_Init();
+	FLASH_Init();
+
+	for (int i = 0; i < UART_BYTES; i++) txData[i] = i;
+	for (int i = 0; i < sizeof(flashData) / sizeof(flashData[0]); i++) flashData[i] = i;
+	return true;
+}
+
+/*
+ * 	Runs every benchmark, between the BENCH_BEGIN and BENCH_END lines. Returns the number that failed.
+ */
+int runAll(void) {
+	int failed = 0;
+
+	printf("BENCH_BEGIN %u Hz\n", (unsigned) TIMESTAMP_GetHz());
+	printf("name,iterations,bytes,min_cycles,mean_cycles,max_cycles,bytes_per_s,status\n");
+	for (int i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+		if (!run(&benchmarks[i])) failed++;
+	}
+	printf("BENCH_END\n");
+	return failed;
+}
+
+int main(void) {
+
+	if (!init()) return 0;
+	runAll();
+
+    while(1) {}
+    return 0 ;
+}
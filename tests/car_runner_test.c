@@ -0,0 +1,433 @@
+/*
+ * car_runner_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Bare metal Car Runner (car_runner.c) on its real event loop: event.c, and the timer wheel of wait.c on timer2,
+ *  with simulated interrupts (see shim.h). Time is virtual: whenever the loop sleeps (EVENT_Wait(), __WFI), the idle
+ *  hook moves timer2 up to its next match, and raises the RTC interrupt once per second. The LCD, buttons, RTC,
+ *  clock profiles and scores are stubs: the LCD keeps its DDRAM, so the tests check what the player sees.
+ *
+ *  First the event queue on its own (order, overflow, posts from interrupts), then the game from power up: user name,
+ *  idle screens, debounce, the hold to enter and leave configuration, buttons held across a state change, and two
+ *  games to the end.
+ */
+
+#include "test.h"
+#include "shim.h"
+
+#include <setjmp.h>
+
+#define main CAR_RUNNER_Main // Run by the test, which leaves its loop when time is up
+#include "../Car_Runner/src/car_runner.c"
+#undef main
+
+
+#define MS 1000 // Timer2 counts microseconds
+#define SECOND 1000000
+
+static uint32_t buttons; // Buttons pushed, as BUTTON_Hit() reads them
+
+static char ddram[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH + 1];
+static int cursorRow, cursorColumn;
+
+static RTC_HANDLER rtcHandler;
+static bool rtcEnabled;
+static time_t rtcSeconds;
+
+static void (*clockHandlers[CLOCK_MAX_HANDLERS])(void);
+static CLOCK_PROFILE profile = CLOCK_FULL;
+
+static int savedScore = -1;
+static int saves, erases;
+
+static jmp_buf loopExit;
+static bool started; // CAR_RUNNER_Main() already initialised everything
+static uint32_t deadline, nextSecond;
+
+
+/*
+ * Stubs of the devices (and of what the test does not cover: RTC, clock and scores):
+ */
+
+int32_t LCDText_Init(void) {
+	LCDText_Clear();
+	return 0;
+}
+
+void LCDText_Locate(int row, int column) {
+	cursorRow = row - 1;
+	cursorColumn = column - 1;
+}
+
+void LCDText_WriteChar(char ch) {
+	if (cursorRow < 0 || cursorRow >= LCD_DISPLAY_ROWS) return;
+	ddram[cursorRow][cursorColumn % LCD_DDRAM_LENGTH] = (ch >= ' ') ? ch : '#'; // Custom chars as '#'
+	cursorColumn++;
+}
+
+void LCDText_WriteString(char *str) {
+	while (*str) LCDText_WriteChar(*str++);
+}
+
+void LCDText_Clear(void) {
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		memset(ddram[row], ' ', LCD_DDRAM_LENGTH);
+		ddram[row][LCD_DDRAM_LENGTH] = '\0';
+	}
+	LCDText_Locate(1, 1);
+}
+
+void LCDText_Home(void) {
+	LCDText_Locate(1, 1);
+}
+
+void LCDText_CreateChar(unsigned char location, const unsigned char charmap[]) {
+}
+
+void LCDText_Printf(char *fmt, ...) {
+	char text[LCD_MESSAGE_MAX_LENGTH];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(text, sizeof(text), fmt, args);
+	va_end(args);
+	LCDText_WriteString(text);
+}
+
+void LCDText_ShiftDisplay(LCD_SHIFT_DIR dir) {
+}
+
+void BUTTON_Init(void) {
+}
+
+int32_t BUTTON_Hit(void) {
+	return buttons;
+}
+
+int32_t ADXL_Init(int frequency, int dataResolution) {
+	return 0;
+}
+
+AXIS ADXL_GetAxis() {
+	return (AXIS) {0, 0, 0};
+}
+
+void RTC_Init(time_t seconds) {
+	rtcSeconds = seconds;
+	rtcEnabled = true;
+	NVIC_EnableIRQ(RTC_IRQn);
+}
+
+void RTC_IRQHandler(void) {
+	if (!rtcEnabled) return;
+	rtcSeconds++;
+	if (rtcHandler != NULL) rtcHandler();
+}
+
+void RTC_SetInterrupt(RTC_INTERRUPT_FIELD fields, RTC_HANDLER handler) {
+	rtcHandler = (fields != INONE) ? handler : NULL;
+}
+
+void RTC_GetValue(struct tm *dateTime) {
+	gmtime_r(&rtcSeconds, dateTime);
+}
+
+time_t RTC_GetSeconds(void) {
+	return rtcSeconds;
+}
+
+void RTC_Enable(void) {
+	rtcEnabled = true;
+}
+
+void RTC_Disable(void) {
+	rtcEnabled = false;
+}
+
+void RTC_IncrementField(RTC_TIME_FIELD field) {
+	if (field == MIN) rtcSeconds += 60;
+}
+
+void RTC_DecrementField(RTC_TIME_FIELD field) {
+	if (field == MIN) rtcSeconds -= 60;
+}
+
+int32_t CLOCK_AddHandler(void (*handler)(void)) {
+	for (int i = 0; i < CLOCK_MAX_HANDLERS; i++) {
+		if (clockHandlers[i] == handler) return 0;
+		if (clockHandlers[i] == NULL) {
+			clockHandlers[i] = handler;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+int32_t CLOCK_SetProfile(CLOCK_PROFILE next) {
+	profile = next;
+	SystemCoreClock = (next == CLOCK_FULL) ? 100000000 : 24000000;
+	for (int i = 0; i < CLOCK_MAX_HANDLERS && clockHandlers[i] != NULL; i++) {
+		clockHandlers[i]();
+	}
+	return 0;
+}
+
+uint64_t TIMESTAMP_Get(void) {
+	return 0;
+}
+
+void SCORE_Init(MEMORY_DEVICE device) {
+}
+
+int SCORE_Get(Score *score, int n) {
+	memset(score, 0, sizeof(Score));
+	if (n == 0 && savedScore >= 0) {
+		strcpy(score->name, "Best");
+		score->score = savedScore;
+	}
+	return 0;
+}
+
+void SCORE_Save(int score, char *name, int size) {
+	savedScore = score;
+	saves++;
+}
+
+void SCORE_Erase(void) {
+	savedScore = -1;
+	erases++;
+}
+
+
+/*
+ * Virtual time:
+ */
+
+static void advanceTime(void) { // __WFI(), interrupts masked: move time on to the next interrupt, or leave the loop
+	uint32_t now = LPC_TIM2->TC;
+	if (now == deadline) longjmp(loopExit, 1);
+
+	uint32_t step = deadline - now;
+	uint32_t toMatch = LPC_TIM2->MR0 - now; // Next wheel event (0: just matched, a wrap away)
+	if (toMatch != 0 && toMatch < step) step = toMatch;
+	if (nextSecond - now < step) step = nextSecond - now;
+
+	SHIM_TimerAdvance(LPC_TIM2, step);
+	if (LPC_TIM2->TC == nextSecond) {
+		SHIM_Raise(RTC_IRQn); // Pending until EVENT_Wait() unmasks interrupts
+		nextSecond += SECOND;
+	}
+}
+
+static void run(uint32_t micros) { // Runs the game's event loop for some time
+	EVENT event;
+
+	deadline = LPC_TIM2->TC + micros;
+	if (setjmp(loopExit) == 0) {
+		if (!started) {
+			started = true;
+			CAR_RUNNER_Main();
+		}
+		while (1) { // As CAR_RUNNER_Main()
+			EVENT_Wait(&event);
+			dispatch(&event);
+		}
+	}
+	__enable_irq(); // Left from inside EVENT_Wait()
+}
+
+static void push(uint32_t pushed, uint32_t micros) { // Pushes buttons for some time, then releases them
+	buttons |= pushed;
+	run(micros);
+	buttons &= ~pushed;
+	run(100 * MS);
+}
+
+static bool onScreen(const char *text) {
+	return strstr(ddram[0], text) != NULL || strstr(ddram[1], text) != NULL;
+}
+
+
+/*
+ * Event queue:
+ */
+
+void EINT3_IRQHandler(void) {
+	EVENT_Post(100, 1);
+}
+
+static void raiseEint3(void) { // __WFI(): the interrupt comes while the loop sleeps
+	SHIM_Raise(EINT3_IRQn);
+}
+
+static void testEventQueue(void) {
+	EVENT event;
+
+	SHIM_Reset();
+	CHECK(!EVENT_Poll(&event));
+
+	for (uint32_t i = 0; i < EVENT_QUEUE_LENGTH; i++) {
+		CHECK(EVENT_Post(i, i * 10));
+	}
+	CHECK(!EVENT_Post(99, 0)); // Full: dropped
+	CHECK(EVENT_GetDropped() == 1);
+	for (uint32_t i = 0; i < EVENT_QUEUE_LENGTH; i++) {
+		CHECK(EVENT_Poll(&event) && event.type == i && event.data == i * 10);
+	}
+	CHECK(!EVENT_Poll(&event));
+
+	// Posted from an interrupt while the loop sleeps (masked): EVENT_Wait() wakes up with it
+	NVIC_EnableIRQ(EINT3_IRQn);
+	shimIdle = raiseEint3;
+	EVENT_Wait(&event);
+	CHECK(event.type == 100 && event.data == 1);
+	CHECK(__get_PRIMASK() == 0);
+	CHECK(!EVENT_Poll(&event));
+	NVIC_DisableIRQ(EINT3_IRQn);
+}
+
+
+/*
+ * Game:
+ */
+
+static void testUserName(void) {
+	SHIM_Reset();
+	shimIdle = advanceTime;
+	nextSecond = SECOND;
+
+	run(10 * MS);
+	CHECK(state == CONFIG_NAME);
+	CHECK(profile == CLOCK_REDUCED);
+	CHECK(onScreen("User name:"));
+	CHECK(onScreen("aaaaaaaaaaa"));
+
+	run(HIGHLIGHT_BLINK_TIME); // Blinks the current character
+	CHECK(onScreen(" aaaaaaaaaa"));
+	run(HIGHLIGHT_BLINK_TIME);
+	CHECK(onScreen("aaaaaaaaaaa"));
+
+	buttons = B1; // A bounce, shorter than a sample period: ignored
+	run(BUTTON_SAMPLE_TIME / 2);
+	buttons = 0;
+	run(100 * MS);
+	CHECK(username[0] == 'a');
+
+	push(B1, 100 * MS); // On release
+	CHECK(username[0] == 'b');
+	push(B2, 100 * MS);
+	push(B2, 100 * MS);
+	CHECK(username[0] == ' ');
+	push(B2, 100 * MS); // Wraps around
+	CHECK(username[0] == 'z');
+
+	for (int i = 0; i < NAME_LENGTH; i++) {
+		push(B3, 100 * MS);
+	}
+	CHECK(strcmp(username, "Zaaaaaaaaaa") == 0);
+	CHECK(state == IDLE);
+}
+
+static void testIdle(void) {
+	CHECK(onScreen("01/01/1970"));
+
+	time_t before = rtcSeconds;
+	run(3 * SECOND); // Redrawn every RTC second
+	CHECK(rtcSeconds == before + 3);
+	char clock[16];
+	strftime(clock, sizeof(clock), "%H:%M:%S", gmtime(&rtcSeconds));
+	CHECK(onScreen(clock));
+
+	push(B2, 100 * MS); // Best scores
+	CHECK(onScreen("1st place:") && onScreen("Not defined."));
+	run(SCORE_SHOW_TIME);
+	CHECK(onScreen("2nd place:"));
+	push(B1, 100 * MS); // Back to the time
+	CHECK(onScreen("01/01/1970"));
+	run(2 * SCORE_SHOW_TIME);
+	CHECK(onScreen("01/01/1970")); // Score rotation stopped
+}
+
+static void testConfig(void) {
+	buttons = B1 | B2; // Held, but released too soon
+	run(BUTTONS_HOLD_TIME / 2);
+	CHECK(onScreen("Entering config"));
+	buttons = 0;
+	run(100 * MS);
+	CHECK(state == IDLE && !onScreen("Entering config"));
+
+	buttons = B1 | B2; // Held for long enough
+	run(BUTTONS_HOLD_TIME + 100 * MS);
+	CHECK(state == CONFIG);
+	CHECK(onScreen("> Time Config"));
+	buttons = 0; // Releases of buttons held since the state was entered are ignored
+	run(100 * MS);
+	CHECK(option == 0 && onScreen("> Time Config"));
+
+	push(B1, 100 * MS);
+	CHECK(option == 1 && onScreen("> Score Config"));
+	push(B3, 100 * MS); // Erase scores? Yes
+	CHECK(state == CONFIG_ERASE_SCORES && onScreen("> Yes"));
+	push(B3, 100 * MS);
+	CHECK(erases == 1 && state == SCORES_ERASED);
+	push(B1, 100 * MS);
+	CHECK(state == CONFIG);
+
+	push(B3, 100 * MS); // Time configuration: the clock stops meanwhile
+	CHECK(state == CONFIG_DATE && !rtcEnabled);
+	time_t stopped = rtcSeconds;
+	run(2 * SECOND);
+	CHECK(rtcSeconds == stopped);
+	for (int i = 0; i < TIME_CONFIG_FIELDS - 1; i++) {
+		push(B3, 100 * MS);
+	}
+	push(B1, 100 * MS); // Minutes up
+	CHECK(rtcSeconds == stopped + 60);
+	push(B3, 100 * MS);
+	CHECK(state == CONFIG && rtcEnabled);
+
+	buttons = B1 | B2; // Hold to leave
+	run(BUTTONS_HOLD_TIME + 100 * MS);
+	CHECK(state == IDLE);
+	buttons = 0;
+	run(100 * MS);
+	CHECK(state == IDLE);
+}
+
+static void testGame(int game) {
+	push(B3, 100 * MS);
+	CHECK(state == PREGAME && onScreen("Press any button"));
+	push(B1, 100 * MS);
+	CHECK(state == GAME);
+	CHECK(profile == CLOCK_FULL && SystemCoreClock == 100000000);
+	CHECK(fuel == MAX_FUEL);
+	CHECK(points == 1); // Started afresh
+
+	for (int i = 0; i < 120 && state == GAME; i++) { // Out of fuel, at the latest, if it never hits a barrier
+		run(SECOND / 2);
+	}
+	CHECK(state == POSTGAME);
+	CHECK(saves == game && savedScore == points);
+	CHECK(onScreen("Game over."));
+	CHECK(profile == CLOCK_REDUCED);
+
+	push(B2, 100 * MS);
+	CHECK(state == IDLE);
+}
+
+
+int main(void) {
+	testEventQueue();
+	testUserName();
+	testIdle();
+	testConfig();
+	testGame(1);
+	testGame(2);
+
+	CHECK(EVENT_GetDropped() == 1); // Only the one testEventQueue() dropped
+	printf("played two games: %d points the last one, at %u.%03u s of virtual time\n", savedScore,
+			LPC_TIM2->TC / SECOND, (LPC_TIM2->TC % SECOND) / MS);
+
+	return TEST_Result("car_runner_test");
+}
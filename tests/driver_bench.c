@@ -0,0 +1,84 @@
+/*
+ * driver_bench.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  TestBenchmark's driver micro-benchmarks (testBenchmark.c), run on the shim: the real LCD, SPI and ADXL345, UART2,
+ *  I2C1 and EEPROM, flash and timestamp drivers, with a jumper between UART2 TX and RX (loopback), a 24LC32 on I2C1
+ *  and the simulated IAP. Every benchmark must pass, and leave on the line, the bus and the IAP log what it did. Its
+ *  table is in cycles of virtual time (bus and line times, waits): it shows the benchmarks work, not what they take
+ *  on the target.
+ *
+ *  uart.c is built with WATCH (see shim.h). Built with -no-pie: flash.c hands the IAP 32-bit addresses.
+ */
+
+#include "test.h"
+#include "shim.h"
+#include "eeprom24.h"
+
+#include "../LEETC_SE1/src/flash.c" // iap_entry is static
+
+#define main TEST_BENCHMARK_Main
+#include "../TestBenchmark/src/testBenchmark.c"
+#undef main
+
+
+#define WRITE_CYCLE_NS 5000000 // Datasheet's 5 ms
+#define IDLE_NS 100000 // Virtual time a __WFI() takes
+#define POLL_NS 1000 // Virtual time a WAIT_SYS_GetElapsedMs() takes
+
+static SHIM_EEPROM eeprom;
+static void (*flashTable[FLASH_VECTOR_COUNT])(void); // Vector table at reset (handlers "in RAM": above FLASH_SIZE)
+
+
+/*
+ * Stubs of wait.c, on virtual time (its timers and SysTick do not run on the shim):
+ */
+
+int32_t WAIT_Init(WAIT mode) {
+	return 0;
+}
+
+void WAIT_WHEEL_Us(uint32_t micros) {
+	shimNs += (uint64_t) micros * 1000;
+}
+
+uint32_t WAIT_SYS_GetElapsedMs(uint32_t start) {
+	shimNs += POLL_NS;
+	return (uint32_t) (shimNs / 1000000) - start;
+}
+
+
+static void idle(void) {
+	shimNs += IDLE_NS;
+}
+
+static void ramHandler(void) {
+}
+
+
+int main(void) {
+	SHIM_Reset();
+	shimIdle = idle;
+	shimUART2Line.loopback = true;
+	SHIM_EEPROM_Attach(&eeprom, EEPROM_ADDRESS);
+	eeprom.writeCycleNs = WRITE_CYCLE_NS;
+	iap_entry = SHIM_IAP;
+	for (int i = 0; i < FLASH_VECTOR_COUNT; i++) {
+		flashTable[i] = ramHandler;
+	}
+	SCB->VTOR = (uint32_t) (uintptr_t) flashTable;
+
+	CHECK(init());
+	CHECK(runAll() == 0);
+
+	// What the benchmarks did:
+	CHECK(shimUART2Line.sent == (10 + 100) * UART_BYTES && shimUART2Line.lost == 0); // Both round trips
+	CHECK(UART_GetBaud() > UART_FAST_BAUD * 99 / 100 && UART_GetOverruns() == 0);
+	CHECK(eeprom.pageWrites == 16 && memcmp(&eeprom.memory[EEPROM_BENCH_ADDRESS], txData, EEPROM_PAGE_LENGTH) == 0);
+	CHECK(shimIAPCount == 4 * (2 + 2 * FLASH_SECTOR_SIZE / FLASH_MINIMAL_WRITE_SIZE)); // Prepare and erase, prepare and copy
+	CHECK(shimI2C1Bus.nacks == eeprom.busyNacks); // Only acknowledge polling
+
+	return TEST_Result("driver_bench");
+}
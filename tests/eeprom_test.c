@@ -0,0 +1,196 @@
+/*
+ * eeprom_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  EEPROM driver (eeprom.c, bare metal) over the I2C1 driver, on a simulated 24LC32 (eeprom24.h) whose page writes
+ *  take a write cycle of virtual time. Acknowledge polling: an access right after a page write is retried until the
+ *  write cycle ends, and given up after EEPROM_WRITE_CYCLE_MS. Then the page cache, by the bytes it puts on the bus:
+ *  none for unchanged data, no read for whole pages, least recently used pages written back first, and write through
+ *  in EEPROM_WriteAt().
+ */
+
+#include "test.h"
+#include "shim.h"
+#include "eeprom24.h"
+
+#include "eeprom.h"
+
+
+#define WRITE_CYCLE_NS 5000000 // Datasheet's 5 ms
+#define IDLE_NS 100000 // Virtual time a __WFI() takes
+
+#define PAGE_READ_BYTES (1 + 2 + 1 + EEPROM_PAGE_LENGTH) // SLA + W, address, SLA + R, page
+#define PAGE_WRITE_BYTES (1 + 2 + EEPROM_PAGE_LENGTH) // SLA + W, address, page
+
+static SHIM_EEPROM eeprom;
+
+
+/*
+ * Stubs of the modules eeprom.c and i2c.c use (not under test):
+ */
+
+int32_t WAIT_Init(WAIT mode) {
+	return 0;
+}
+
+uint32_t WAIT_SYS_GetElapsedMs(uint32_t start) {
+	return (uint32_t) (shimNs / 1000000) - start;
+}
+
+int32_t CLOCK_AddHandler(void (*handler)(void)) {
+	return 0;
+}
+
+void CLOCK_SetPCLK(CLOCK_PERIPHERAL peripheral, CLOCK_DIVIDER divider) {
+}
+
+uint32_t CLOCK_GetPCLK(CLOCK_PERIPHERAL peripheral) {
+	return SystemCoreClock / 4;
+}
+
+
+static void idle(void) {
+	shimNs += IDLE_NS;
+}
+
+static void reset(void) {
+	SHIM_Reset();
+	shimIdle = idle;
+	SHIM_EEPROM_Attach(&eeprom, EEPROM_ADDRESS);
+	eeprom.writeCycleNs = WRITE_CYCLE_NS;
+	EEPROM_Init();
+}
+
+static void fill(char *buffer, int size, int seed) {
+	for (int i = 0; i < size; i++) {
+		buffer[i] = (char) (seed + 7 * i);
+	}
+}
+
+
+static void testAcknowledgePolling(void) {
+	reset();
+	char data[EEPROM_PAGE_LENGTH], read[EEPROM_PAGE_LENGTH];
+	fill(data, sizeof(data), 1);
+
+	CHECK(EEPROM_WriteAt(3 * EEPROM_PAGE_LENGTH, data, sizeof(data)) == 0);
+	CHECK(eeprom.pageWrites == 1 && eeprom.busyNacks == 0);
+	uint64_t written = shimNs;
+
+	// Right after the page: NACKed until the write cycle ends, then read (another page: that one is cached)
+	CHECK(EEPROM_ReadAt(10 * EEPROM_PAGE_LENGTH, read, sizeof(read)) == 0);
+	CHECK(memcmp(read, eeprom.memory + 10 * EEPROM_PAGE_LENGTH, sizeof(read)) == 0);
+	CHECK(eeprom.busyNacks > 10); // Polled, not waited for once
+	CHECK(shimNs >= written + WRITE_CYCLE_NS);
+	CHECK(shimNs < written + WRITE_CYCLE_NS + 1000000); // Soon after: a poll, and the read (0.8 ms at 400 kHz)
+	printf("acknowledge polling: %u NACKs, read %.3f ms after the page write\n", eeprom.busyNacks,
+			(shimNs - written) / 1e6);
+
+	// Not writing: no NACK
+	uint32_t nacks = eeprom.busyNacks;
+	CHECK(EEPROM_ReadAt(0, read, sizeof(read)) == 0);
+	CHECK(eeprom.busyNacks == nacks);
+
+	// A second page write polls for the first one's cycle too
+	CHECK(EEPROM_WriteAt(4 * EEPROM_PAGE_LENGTH, data, sizeof(data)) == 0);
+	CHECK(EEPROM_WriteAt(5 * EEPROM_PAGE_LENGTH, data, sizeof(data)) == 0);
+	CHECK(eeprom.pageWrites == 3 && eeprom.busyNacks > nacks);
+	CHECK(memcmp(eeprom.memory + 5 * EEPROM_PAGE_LENGTH, data, sizeof(data)) == 0);
+}
+
+static void testGiveUp(void) {
+	reset();
+	char data[EEPROM_PAGE_LENGTH], read[EEPROM_PAGE_LENGTH];
+	fill(data, sizeof(data), 2);
+
+	CHECK(EEPROM_WriteAt(0, data, sizeof(data)) == 0);
+	eeprom.busyUntil = shimNs + 50000000; // Never done in time: 50 ms
+
+	uint64_t start = shimNs;
+	CHECK(EEPROM_ReadAt(EEPROM_PAGE_LENGTH, read, 1) == -1);
+	uint64_t waited = shimNs - start;
+	CHECK(waited > (uint64_t) EEPROM_WRITE_CYCLE_MS * 1000000);
+	CHECK(waited <= (uint64_t) (EEPROM_WRITE_CYCLE_MS + 2) * 1000000);
+	printf("give up: after %.3f ms, %u NACKs\n", waited / 1e6, eeprom.busyNacks);
+
+	shimNs = eeprom.busyUntil; // Cycle over: works again
+	CHECK(EEPROM_ReadAt(0, read, sizeof(read)) == 0);
+	CHECK(memcmp(read, data, sizeof(data)) == 0);
+}
+
+static uint32_t busBytes(void) { // Bytes on the bus since the last call
+	static uint32_t last;
+	uint32_t bytes = shimI2C1Bus.bytes - last;
+	last = shimI2C1Bus.bytes;
+	return bytes;
+}
+
+static void testBusTraffic(void) {
+	reset();
+	eeprom.writeCycleNs = 0; // Only the bytes of each access: no polling
+	char data[EEPROM_PAGE_LENGTH], read[EEPROM_PAGE_LENGTH];
+	fill(data, sizeof(data), 3);
+	shimI2C1Bus.bytes = 0;
+	busBytes();
+
+	// Unchanged data costs nothing, page cached or not
+	CHECK(EEPROM_WriteAt(0, data, 8) == 0);
+	CHECK(busBytes() == PAGE_READ_BYTES + PAGE_WRITE_BYTES); // Partial: page read, then written through
+	CHECK(EEPROM_WriteAt(0, data, 8) == 0);
+	CHECK(EEPROM_WriteCached(2, data + 2, 4) == 0);
+	CHECK(EEPROM_Flush() == 0);
+	CHECK(busBytes() == 0);
+	CHECK(eeprom.pageWrites == 1);
+
+	// A whole page is written without reading it
+	CHECK(EEPROM_WriteCached(7 * EEPROM_PAGE_LENGTH, data, EEPROM_PAGE_LENGTH) == 0);
+	CHECK(busBytes() == 0);
+	CHECK(EEPROM_Flush() == 0);
+	CHECK(busBytes() == PAGE_WRITE_BYTES);
+	CHECK(memcmp(eeprom.memory + 7 * EEPROM_PAGE_LENGTH, data, EEPROM_PAGE_LENGTH) == 0);
+
+	// Least recently used page is written back first
+	reset();
+	eeprom.writeCycleNs = 0;
+	busBytes();
+	for (int page = 0; page < EEPROM_CACHE_PAGES; page++) { // Fills the cache with dirty pages
+		CHECK(EEPROM_WriteCached(page * EEPROM_PAGE_LENGTH + 1, data, 1) == 0);
+	}
+	CHECK(busBytes() == EEPROM_CACHE_PAGES * PAGE_READ_BYTES);
+	CHECK(EEPROM_ReadAt(0, read, 1) == 0); // Page 0 used again: page 1 is the oldest now
+	CHECK(EEPROM_ReadAt(20 * EEPROM_PAGE_LENGTH, read, EEPROM_PAGE_LENGTH) == 0); // Whole page: not cached
+	CHECK(busBytes() == PAGE_READ_BYTES && eeprom.pageWrites == 0);
+
+	uint32_t evicted[] = {1, 2, 3, 0}; // Each new page evicts these, in order
+	for (int i = 0; i < EEPROM_CACHE_PAGES; i++) {
+		CHECK(EEPROM_WriteCached((10 + i) * EEPROM_PAGE_LENGTH + 1, data, 1) == 0);
+		CHECK(busBytes() == PAGE_WRITE_BYTES + PAGE_READ_BYTES); // Written back, then new page read
+		CHECK(eeprom.pageWrites == i + 1);
+		CHECK(eeprom.memory[evicted[i] * EEPROM_PAGE_LENGTH + 1] == (uint8_t) data[0]);
+		if (i + 1 < EEPROM_CACHE_PAGES) CHECK(eeprom.memory[evicted[i + 1] * EEPROM_PAGE_LENGTH + 1] == 0xFF);
+	}
+	CHECK(EEPROM_Flush() == 0);
+	CHECK(busBytes() == EEPROM_CACHE_PAGES * PAGE_WRITE_BYTES);
+	CHECK(EEPROM_Flush() == 0); // Nothing dirty left
+	CHECK(busBytes() == 0);
+
+	// EEPROM_WriteAt() writes through: on the EEPROM when it returns, across pages
+	CHECK(EEPROM_WriteAt(30 * EEPROM_PAGE_LENGTH - 3, data, 8) == 0);
+	CHECK(memcmp(eeprom.memory + 30 * EEPROM_PAGE_LENGTH - 3, data, 8) == 0);
+	CHECK(busBytes() == 2 * (PAGE_READ_BYTES + PAGE_WRITE_BYTES));
+	CHECK(EEPROM_Flush() == 0);
+	CHECK(busBytes() == 0);
+	CHECK(EEPROM_ReadAt(30 * EEPROM_PAGE_LENGTH - 3, read, 8) == 0); // From the cache
+	CHECK(memcmp(read, data, 8) == 0 && busBytes() == 0);
+}
+
+
+int main(void) {
+	testAcknowledgePolling();
+	testGiveUp();
+	testBusTraffic();
+
+	return TEST_Result("eeprom_test");
+}
@@ -0,0 +1,175 @@
+/*
+ * flash_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Flash driver (flash.c) on the simulated IAP of the shim (shim.h), which logs every command with the interrupt state
+ *  it ran with. Each erase and copy comes right after the prepare of its sector, with CCLK in kHz. Erases go one
+ *  sector per IAP call, with progress after each. BUSY is retried. During a command, only interrupts whose handler is
+ *  in flash are masked (and SysTick and PendSV likewise), and everything is restored after.
+ *
+ *  Built with -no-pie, so the vector tables have 32-bit addresses (SCB->VTOR): handlers of the test are above
+ *  FLASH_SIZE, as RAM functions on the target. Handlers "in flash" are addresses below it, never called.
+ */
+
+#include "test.h"
+#include "shim.h"
+
+#include "../LEETC_SE1/src/flash.c" // iap_entry is static
+
+
+#define IN_FLASH ((void (*)(void)) 0x00001235) // Thumb address in sector 1
+
+static void (*flashTable[FLASH_VECTOR_COUNT])(void); // Vector table at reset
+
+static uint8_t data[FLASH_MINIMAL_WRITE_SIZE] __attribute__((aligned(4)));
+
+static unsigned int progressDone[32], progressTotal[32], progressCalls[32]; // Arguments, and IAP calls so far
+static int progressCount;
+
+
+static void ramHandler(void) {
+}
+
+static void progress(unsigned int done, unsigned int total) {
+	if (progressCount < 32) {
+		progressDone[progressCount] = done;
+		progressTotal[progressCount] = total;
+		progressCalls[progressCount] = shimIAPCount;
+	}
+	progressCount++;
+}
+
+static void reset(void) {
+	SHIM_Reset();
+	iap_entry = SHIM_IAP;
+	for (int i = 0; i < FLASH_VECTOR_COUNT; i++) {
+		flashTable[i] = ramHandler;
+	}
+	SCB->VTOR = (uint32_t) (uintptr_t) flashTable;
+	progressCount = 0;
+}
+
+static bool logged(int call, unsigned int c0, unsigned int c1, unsigned int c2) { // Command and its first parameters
+	unsigned int *command = shimIAPCalls[call].command;
+	return (command[0] == c0) && (command[1] == c1) && (command[2] == c2);
+}
+
+
+static void testWrite(void) {
+	reset();
+	unsigned int source = (unsigned int) (uintptr_t) data;
+
+	CHECK(FLASH_WriteData(29, (void *) FLASH_START_ADDRESS_29, data, sizeof(data)) == CMD_SUCCESS);
+	CHECK(shimIAPCount == 2);
+	CHECK(logged(0, PREPARE_SECTORS, 29, 29));
+	CHECK(logged(1, COPY_RAM_TO_FLASH, FLASH_START_ADDRESS_29, source) && shimIAPCalls[1].command[3] == sizeof(data));
+	CHECK(shimIAPCalls[1].command[4] == 100000); // CCLK in kHz
+
+	SystemCoreClock = 24000000; // CLOCK_REDUCED
+	CHECK(FLASH_WriteData(29, (void *) (FLASH_START_ADDRESS_29 + 256), data, sizeof(data)) == CMD_SUCCESS);
+	CHECK(shimIAPCount == 4 && shimIAPCalls[2].command[0] == PREPARE_SECTORS);
+	CHECK(shimIAPCalls[3].command[0] == COPY_RAM_TO_FLASH && shimIAPCalls[3].command[4] == 24000);
+
+	// Sector given is the one prepared: a write elsewhere is refused by the IAP
+	CHECK(FLASH_WriteData(28, (void *) FLASH_START_ADDRESS_29, data, sizeof(data)) == SECTOR_NOT_PREPARED_FOR_WRITE_OPERATION);
+	CHECK(FLASH_WriteData(30, (void *) FLASH_START_ADDRESS_29, data, sizeof(data)) == INVALID_SECTOR);
+	CHECK(shimIAPCount == 7); // Not copied after a failed prepare
+}
+
+static void testErase(void) {
+	reset();
+
+	CHECK(FLASH_EraseSectorsProgress(20, 23, progress) == CMD_SUCCESS);
+	CHECK(shimIAPCount == 8);
+	for (unsigned int i = 0; i < 4; i++) { // One sector per call, right after its prepare
+		CHECK(logged(2 * i, PREPARE_SECTORS, 20 + i, 20 + i));
+		CHECK(logged(2 * i + 1, ERASE_SECTORS, 20 + i, 20 + i) && shimIAPCalls[2 * i + 1].command[3] == 100000);
+	}
+	CHECK(progressCount == 4);
+	for (int i = 0; i < 4 && i < progressCount; i++) { // After each erase
+		CHECK(progressDone[i] == i + 1 && progressTotal[i] == 4 && progressCalls[i] == 2 * (i + 1));
+	}
+
+	reset();
+	CHECK(FLASH_EraseSectors(29, 29) == CMD_SUCCESS);
+	CHECK(shimIAPCount == 2 && logged(1, ERASE_SECTORS, 29, 29));
+
+	reset();
+	CHECK(FLASH_EraseSectorsProgress(5, 4, progress) == INVALID_SECTOR);
+	CHECK(shimIAPCount == 0 && progressCount == 0);
+
+	reset();
+	CHECK(FLASH_EraseSectorsProgress(28, 31, progress) == INVALID_SECTOR); // Stops at the first invalid sector
+	CHECK(shimIAPCount == 5 && progressCount == 2);
+}
+
+static void testBusy(void) {
+	reset();
+	shimIAPBusy = 3;
+
+	CHECK(FLASH_VerifyData((void *) FLASH_START_ADDRESS_29, data, sizeof(data)) == CMD_SUCCESS);
+	CHECK(shimIAPCount == 4);
+	for (int i = 0; i < 4; i++) {
+		CHECK(logged(i, COMPARE_ADDRESSES, FLASH_START_ADDRESS_29, (unsigned int) (uintptr_t) data));
+	}
+	CHECK(shimIAPCalls[2].status == BUSY && shimIAPCalls[3].status == CMD_SUCCESS);
+}
+
+static void testMasks(void) {
+	reset();
+	flashTable[16 + TIMER0_IRQn] = IN_FLASH;
+	flashTable[16 + RTC_IRQn] = IN_FLASH;
+	flashTable[14] = IN_FLASH; // PendSV
+	flashTable[15] = IN_FLASH; // SysTick
+	SCB->SHP[10] = 0xE0; // PendSV priority
+	NVIC_EnableIRQ(TIMER0_IRQn);
+	NVIC_EnableIRQ(UART2_IRQn);
+	NVIC_EnableIRQ(USBActivity_IRQn); // In ISER[1]
+	SysTick_Config(100000);
+	uint32_t iser[2] = {NVIC->ISER[0], NVIC->ISER[1]};
+
+	CHECK(FLASH_VerifyData((void *) FLASH_START_ADDRESS_29, data, sizeof(data)) == CMD_SUCCESS);
+	SHIM_IAP_CALL *call = &shimIAPCalls[0];
+	CHECK((call->iser[0] & (1UL << TIMER0_IRQn)) == 0); // Handler in flash
+	CHECK((call->iser[0] & (1UL << UART2_IRQn)) != 0); // Handler in RAM
+	CHECK((call->iser[1] & (1UL << (USBActivity_IRQn - 32))) != 0);
+	CHECK((call->sysTickCtrl & SysTick_CTRL_TICKINT_Msk) == 0);
+	CHECK(call->basepri == 0xE0 && call->primask == 0);
+	CHECK(NVIC->ISER[0] == iser[0] && NVIC->ISER[1] == iser[1]); // All back
+	CHECK((SysTick->CTRL & SysTick_CTRL_TICKINT_Msk) != 0);
+	CHECK(__get_BASEPRI() == 0 && __get_PRIMASK() == 0);
+
+	// Handlers moved to RAM run during the command
+	FLASH_Init();
+	CHECK(SCB->VTOR == (uint32_t) (uintptr_t) vectors);
+	CHECK(FLASH_SetHandler(TIMER0_IRQn, ramHandler) == 0);
+	CHECK(FLASH_SetHandler(SysTick_IRQn, ramHandler) == 0);
+	CHECK(FLASH_SetHandler(FLASH_VECTOR_COUNT - 16, ramHandler) == -1);
+	CHECK(FLASH_VerifyData((void *) FLASH_START_ADDRESS_29, data, sizeof(data)) == CMD_SUCCESS);
+	call = &shimIAPCalls[1];
+	CHECK((call->iser[0] & (1UL << TIMER0_IRQn)) != 0);
+	CHECK((call->sysTickCtrl & SysTick_CTRL_TICKINT_Msk) != 0);
+	CHECK(call->basepri == 0xE0); // PendSV still in flash
+
+	// A caller that masked interrupts keeps them masked
+	__disable_irq();
+	__set_BASEPRI(0x40); // Already above PendSV's
+	CHECK(FLASH_VerifyData((void *) FLASH_START_ADDRESS_29, data, sizeof(data)) == CMD_SUCCESS);
+	call = &shimIAPCalls[2];
+	CHECK(call->primask == 1 && call->basepri == 0x40);
+	CHECK(__get_PRIMASK() == 1 && __get_BASEPRI() == 0x40);
+	__set_BASEPRI(0);
+	__enable_irq();
+}
+
+
+int main(void) {
+	testWrite();
+	testErase();
+	testBusy();
+	testMasks();
+
+	return TEST_Result("flash_test");
+}
@@ -0,0 +1,221 @@
+/*
+ * format_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Formatter (format.c) against the host's snprintf(): every specifier (%d %u %x %X %c %s %%), with the '-' and '0'
+ *  flags, widths and 'l', as used in the tree, then 200000 random formats of them. Output bounded at the 80 chars of
+ *  LCDText_Printf() is the first 80 of snprintf()'s, and the return values are as format.h documents (chars given to
+ *  the sink, chars written): not snprintf()'s length of the whole output. Then the time per call of both.
+ */
+
+#include "test.h"
+
+#include "format.h"
+#include "lcd.h"
+
+#include <limits.h>
+#include <stdarg.h>
+#include <string.h>
+
+
+#define LCD_LIMIT (LCD_DDRAM_LENGTH * LCD_DISPLAY_ROWS) // As LCDText_Printf()
+#define RANDOM_FORMATS 200000
+#define BENCH_CALLS 1000000
+
+typedef struct {
+	char text[256];
+	int length;
+} SINK_BUFFER;
+
+static uint32_t seed = 2463534242u;
+
+
+static void sink(void * context, char ch) {
+	SINK_BUFFER *buffer = context;
+	if (buffer->length < (int) sizeof(buffer->text) - 1) buffer->text[buffer->length] = ch;
+	buffer->length++;
+}
+
+static int print(SINK_BUFFER *buffer, int limit, const char *format, ...) { // FORMAT_Print() into buffer
+	va_list args;
+	va_start(args, format);
+	buffer->length = 0;
+	int count = FORMAT_Print(sink, buffer, limit, format, args);
+	va_end(args);
+	buffer->text[(buffer->length < (int) sizeof(buffer->text)) ? buffer->length : (int) sizeof(buffer->text) - 1] = '\0';
+	return count;
+}
+
+static int formatString(char *buffer, int size, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	int count = FORMAT_String(buffer, size, format, args);
+	va_end(args);
+	return count;
+}
+
+/*
+ * Both formatters, unbounded: same output, and FORMAT_Print() returns its length.
+ */
+#define SAME(format, ...) \
+	do { \
+		SINK_BUFFER out; \
+		char expected[256]; \
+		int count = print(&out, FORMAT_UNBOUNDED, format, __VA_ARGS__); \
+		snprintf(expected, sizeof(expected), format, __VA_ARGS__); \
+		if ((strcmp(out.text, expected) != 0) || (count != (int) strlen(expected)) || (count != out.length)) { \
+			printf("%s:%d: \"%s\": \"%s\" (%d), snprintf() \"%s\"\n", __FILE__, __LINE__, format, out.text, count, expected); \
+			testFailures++; \
+		} \
+	} while (0)
+
+
+static void testSpecifiers(void) {
+	SAME("%d", 0);
+	SAME("%d %d %d", 5, -3, 123456789);
+	SAME("%d %d", INT_MAX, INT_MIN);
+	SAME("%u %u %u", 0U, 3000000000U, UINT_MAX);
+	SAME("%u", -3); // As unsigned
+	SAME("%x %x %X %X", 0xFFU, 0xDEADBEEFU, 0xABCDEFU, 0U);
+	SAME("%c%c%c", 'a', 'Z', ' ');
+	SAME("%s is %s", "Hello world!", "");
+	SAME("100%% %s", "done");
+	SAME("%ld %lu %lx", -7L, 7UL, 255UL); // 'l' ignored: long is int on the target
+	SAME("%s", "no format");
+
+	// Flags and widths:
+	SAME("\"%-10s\" \"%10s\"", "left", "right");
+	SAME("%04d|%-4d|%4d", 3, 3, 3);
+	SAME("%05d|%-5d|%5d", -42, -42, -42);
+	SAME("%02x|%02X|%08x", 0U, 0xAU, 0xBEEFU);
+	SAME("%02u:%02u:%02u", 9U, 5U, 59U); // Clock
+	SAME("%3c|%-3c|", 'x', 'y');
+	SAME("%2d|%2s|%1u", 12345, "longer", 99U); // Wider than the field
+	SAME("%012d|%-12u|", INT_MIN, UINT_MAX);
+	SAME("%d. %s %u", 1, "Pedro", 1234U); // Leaderboard line
+	SAME("scored %d!", 17);
+
+	// Not in C: a NULL string, and a trailing '%'
+	SINK_BUFFER out;
+	CHECK(print(&out, FORMAT_UNBOUNDED, "[%s]", (char *) NULL) == 8 && strcmp(out.text, "[(null)]") == 0);
+	CHECK(print(&out, FORMAT_UNBOUNDED, "50%", 0) == 2 && strcmp(out.text, "50") == 0);
+}
+
+static uint32_t xorshift(void) {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static void testRandom(void) { // One conversion each, with random flags and width
+	static const char specifiers[] = "duxXcs";
+	static const char *strings[] = {"", "a", "Car", "Runner RTOS", "0123456789abcdef"};
+	int wrong = 0;
+
+	for (int i = 0; i < RANDOM_FORMATS; i++) {
+		char format[16], *at = format;
+		char specifier = specifiers[xorshift() % (sizeof(specifiers) - 1)];
+		uint32_t flags = xorshift();
+
+		*at++ = '<';
+		*at++ = '%';
+		if (flags & 1) *at++ = '-';
+		if ((flags & 2) && (specifier != 'c') && (specifier != 's')) *at++ = '0'; // Undefined for these in C
+		if (flags & 4) at += sprintf(at, "%u", (unsigned) (xorshift() % 16));
+		if ((flags & 8) && (specifier != 'c') && (specifier != 's')) *at++ = 'l';
+		*at++ = specifier;
+		*at++ = '>';
+		*at = '\0';
+
+		SINK_BUFFER out;
+		char expected[64];
+		uint32_t value = xorshift() >> (xorshift() % 32);
+		if (specifier == 's') {
+			const char *str = strings[value % (sizeof(strings) / sizeof(strings[0]))];
+			print(&out, FORMAT_UNBOUNDED, format, str);
+			snprintf(expected, sizeof(expected), format, str);
+		}
+		else if (specifier == 'c') {
+			char ch = ' ' + value % 95;
+			print(&out, FORMAT_UNBOUNDED, format, ch);
+			snprintf(expected, sizeof(expected), format, ch);
+		}
+		else if (strchr(format, 'l') != NULL) {
+			long number = (specifier == 'd') ? (long) (int32_t) value : (long) value; // 32 bits on the target
+			print(&out, FORMAT_UNBOUNDED, format, (int) number);
+			snprintf(expected, sizeof(expected), format, number);
+		}
+		else {
+			print(&out, FORMAT_UNBOUNDED, format, value);
+			snprintf(expected, sizeof(expected), format, value);
+		}
+
+		if (strcmp(out.text, expected) != 0) {
+			if (wrong++ < 10) printf("\"%s\": \"%s\", snprintf() \"%s\"\n", format, out.text, expected);
+		}
+	}
+
+	CHECK(wrong == 0);
+	printf("random: %d formats, %d differ from snprintf()\n", RANDOM_FORMATS, wrong);
+}
+
+static void testLimit(void) {
+	SINK_BUFFER out;
+	char expected[256], buffer[LCD_LIMIT + 1];
+	const char *format = "%s %d %-12s|%08x %u %s";
+	const char *name = "Car Runner on an LCD of 2 rows of 40 columns";
+	int whole = snprintf(expected, sizeof(expected), format, name, -123, "left", 0xC0FFEEU, 4000000000U, name);
+	CHECK(whole > LCD_LIMIT);
+
+	// At the limit, as LCDText_Printf(): the first 80 chars, and 80 returned
+	CHECK(print(&out, LCD_LIMIT, format, name, -123, "left", 0xC0FFEEU, 4000000000U, name) == LCD_LIMIT);
+	CHECK(out.length == LCD_LIMIT && strncmp(out.text, expected, LCD_LIMIT) == 0);
+
+	// Cut anywhere: inside a number, its padding, or a string
+	for (int limit = 0; limit <= whole; limit++) {
+		int count = print(&out, limit, format, name, -123, "left", 0xC0FFEEU, 4000000000U, name);
+		CHECK(count == limit && out.length == limit && strncmp(out.text, expected, limit) == 0);
+	}
+	CHECK(print(&out, whole + 10, format, name, -123, "left", 0xC0FFEEU, 4000000000U, name) == whole); // Under it
+
+	// FORMAT_String(): terminated, and returns the chars written (snprintf() returns the whole length)
+	memset(buffer, 'x', sizeof(buffer));
+	CHECK(formatString(buffer, sizeof(buffer), format, name, -123, "left", 0xC0FFEEU, 4000000000U, name) == LCD_LIMIT);
+	CHECK(buffer[LCD_LIMIT] == '\0' && strncmp(buffer, expected, LCD_LIMIT) == 0);
+	CHECK(formatString(buffer, 6, "%d", -1234567) == 5 && strcmp(buffer, "-1234") == 0);
+	CHECK(formatString(buffer, 1, "%s", "none") == 0 && buffer[0] == '\0');
+	buffer[0] = 'x';
+	CHECK(formatString(buffer, 0, "%s", "none") == 0 && buffer[0] == 'x'); // Untouched
+}
+
+static void bench(void) {
+	char buffer[LCD_LIMIT + 1];
+	volatile int sink = 0;
+
+	uint64_t start = TEST_Ns();
+	for (int i = 0; i < BENCH_CALLS; i++) {
+		sink += formatString(buffer, sizeof(buffer), "%d. %-6s %5u %02u:%02u", i % 10, "Pedro", (unsigned) i, 12U, 34U);
+	}
+	uint64_t format = TEST_Ns() - start;
+
+	start = TEST_Ns();
+	for (int i = 0; i < BENCH_CALLS; i++) {
+		sink += snprintf(buffer, sizeof(buffer), "%d. %-6s %5u %02u:%02u", i % 10, "Pedro", (unsigned) i, 12U, 34U);
+	}
+	uint64_t libc = TEST_Ns() - start;
+
+	printf("ns per call: FORMAT_String %.1f, snprintf %.1f\n", (double) format / BENCH_CALLS, (double) libc / BENCH_CALLS);
+}
+
+
+int main(void) {
+	testSpecifiers();
+	testRandom();
+	testLimit();
+	bench();
+
+	return TEST_Result("format_test");
+}
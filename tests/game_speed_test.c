@@ -0,0 +1,145 @@
+/*
+ * game_speed_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Frame timing of Car_Runner_RTOS (car_runner_rtos.c), built twice: as is (game_speed_test) and with
+ *  GAME_SPEED_STRESS (game_speed_stress_test). On the single threaded shim, game() runs on the test's thread, and
+ *  while it waits for each frame (shimSleep) the test plays the Update Game task: takes the frames it sent, and
+ *  scores points. TIMER1, the frame timing counter, moves on with the ticks.
+ *
+ *  First the calibration: the fastest period is twice the LCD flush time, rounded up to the ms, within GAME_RATE_MIN
+ *  and GAME_RATE. Then a game: each frame comes one period after the last, with the period for the points scored so
+ *  far (one GAME_RATE_STEP faster every GAME_SPEED_POINTS, down to the calibrated one; always that one when
+ *  stressing). No jitter is recorded when time is exact, and a frame the update task has not taken yet is an overrun.
+ *
+ *  Linked with --gc-sections: only game() and the frame timing are kept of car_runner_rtos.c.
+ */
+
+#include "test.h"
+#include "shim.h"
+
+#define main CAR_RUNNER_RTOS_Main
+#include "../Car_Runner_RTOS/src/car_runner_rtos.c"
+#undef main
+
+
+#define COUNTS_PER_MS (FRAME_TIMER_HZ / 1000)
+#define FLUSH_COUNTS 555 // 55.5 ms: 111 ms fastest period
+#define FRAMES 80 // Played (after the init frame)
+#define POINTS_PER_FRAME 3
+#define LATE_FRAME 40 // Left in the queue for a period
+
+static uint32_t flush; // LCD flush time, in timer counts
+
+static GAME_INFO frames[FRAMES + 1];
+static int frameCount;
+static bool lateDone;
+
+
+/*
+ * Stubs of the devices (calibrateFrameRate() renders, game() samples input):
+ */
+
+void LCDText_Locate(int row, int column) {
+}
+
+void LCDText_WriteChar(char ch) {
+}
+
+void LCDText_WriteString(char *str) {
+}
+
+void LCDText_ShiftDisplay(LCD_SHIFT_DIR dir) {
+}
+
+void LCDText_Sync(void) {
+	LPC_TIM1->TC += flush;
+}
+
+AXIS ADXL_GetAxis() {
+	AXIS level = {0, 0, 0};
+	return level;
+}
+
+
+static void updateGame(uint32_t ticks) { // While game() waits: time goes by, and the Update Game task runs
+	LPC_TIM1->TC += ticks * COUNTS_PER_MS; // 1 ms ticks
+
+	if ((frameCount == LATE_FRAME) && !lateDone) { // Busy: this frame waits for the next period
+		lateDone = true;
+		return;
+	}
+
+	GAME_INFO info;
+	while (xQueueReceive(queueUPDATE_GAME, &info, 0) == pdPASS) {
+		if (frameCount <= FRAMES) frames[frameCount] = info;
+		if (!info.init) gameState.points += POINTS_PER_FRAME;
+		if (++frameCount > FRAMES) gameState.ended = true;
+	}
+}
+
+static uint32_t expectedPeriod(uint32_t points) {
+	if (GAME_SPEED_STRESS) return frameRateMin;
+
+	uint32_t period = GAME_RATE - (points / GAME_SPEED_POINTS) * GAME_RATE_STEP;
+	return (period > frameRateMin && period <= GAME_RATE) ? period : frameRateMin;
+}
+
+static uint32_t calibrate(uint32_t flushCounts) {
+	flush = flushCounts;
+	calibrateFrameRate();
+	return frameRateMin;
+}
+
+
+static void testCalibration(void) {
+	SHIM_Reset();
+
+	CHECK(calibrate(300) == GAME_RATE_MIN); // 60 ms: not below the minimum
+	CHECK(calibrate(800) == 160);
+	CHECK(calibrate(801) == 161); // Rounded up
+	CHECK(calibrate(1600) == GAME_RATE); // 320 ms: never slower than the start
+	CHECK(calibrate(5000) == GAME_RATE);
+	CHECK(calibrate(FLUSH_COUNTS) == 111);
+}
+
+static void testGame(void) {
+	SHIM_Reset();
+	shimSleep = updateGame;
+	queueUPDATE_GAME = xQueueCreate(UPDATE_GAME_QUEUE_LENGTH, sizeof(GAME_INFO));
+	calibrate(FLUSH_COUNTS);
+	gameState.points = 1234; // Last game's: reset by game()
+
+	game();
+
+	CHECK(frameCount == FRAMES + 1);
+	CHECK(frames[0].init && frames[0].period == (GAME_SPEED_STRESS ? frameRateMin : GAME_RATE));
+
+	int reached = 0; // Frame that first ran at the fastest period
+	for (int i = 1; i <= FRAMES; i++) {
+		CHECK(!frames[i].init);
+		int simulated = (i == LATE_FRAME + 1) ? i - 2 : i - 1; // Frames simulated when it was sent (not the late one)
+		CHECK(frames[i].period == expectedPeriod(1 + simulated * POINTS_PER_FRAME)); // For the points scored so far
+		CHECK(frames[i].time - frames[i - 1].time == frames[i - 1].period * COUNTS_PER_MS); // One period after the last
+		CHECK(frames[i].period <= frames[i - 1].period && frames[i].period >= frameRateMin); // Only faster, not past it
+		if ((reached == 0) && (frames[i].period == frameRateMin)) reached = i;
+	}
+	CHECK(reached != 0 && frames[FRAMES].period == frameRateMin);
+	CHECK(GAME_SPEED_STRESS ? (reached == 1) : (reached > LATE_FRAME / 2));
+
+	CHECK(frameStats.frames == FRAMES + 1); // And the start of the one that saw the end
+	CHECK(frameStats.overruns == 1);
+	CHECK(frameStats.maxJitter == 0 && frameStats.jitter[0] == frameStats.frames);
+	printf("%s: fastest period %u ms from frame %d, %u frames, %u overruns\n", GAME_SPEED_STRESS ? "stress" : "speed-up",
+			(unsigned) frameRateMin, reached, (unsigned) frameStats.frames, (unsigned) frameStats.overruns);
+}
+
+
+int main(void) {
+	testCalibration();
+	testGame();
+
+	return TEST_Result(GAME_SPEED_STRESS ? "game_speed_stress_test" : "game_speed_test");
+}
@@ -0,0 +1,280 @@
+/*
+ * game_state_stress.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Game state of Car_Runner_RTOS (car_runner_rtos.c) under concurrent access, on the threaded FreeRTOS shim
+ *  (freertos_pthread.c): game() sends frames, the real taskUPDATE_GAME simulates them on its own thread, and reader
+ *  threads load the GAME_STATE fields without locks, as the other tasks do. Ticks are 10 us, so a game is over in
+ *  well under a second.
+ *
+ *  Readers check every sample: fuel within 0 to MAX_FUEL, points never going down but for the reset of a new game,
+ *  and nothing moving once the game has ended. After each game: the end was by running out of fuel (the road has
+ *  fuel galleons, no obstacles), the score was saved once, with the final points, and it is what the player sees.
+ *  Some games have a slow renderer, so frames queue up behind the end of the game.
+ */
+
+#include "test.h"
+#include "shim.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+
+#define main CAR_RUNNER_RTOS_Main // Tasks are started by the test
+#include "../Car_Runner_RTOS/src/car_runner_rtos.c"
+#undef main
+
+
+#define TICK_NS 10000 // 100 times as fast as the target
+#define GAMES 8
+#define SLOW_GAMES 3 // Last ones, with frames taking SLOW_FRAME_TICKS to render
+#define SLOW_FRAME_TICKS (2 * GAME_RATE)
+#define READERS 3
+#define FUEL_SEGMENTS 2 // Segments with a fuel galleon, at the start of each game
+#define FUEL_GALLEON_BIT 12 // Column in the segment (past INITIAL_OBSTACLE_GAP), row 1
+
+typedef struct {
+	pthread_t thread;
+	uint32_t samples;
+	uint32_t resets; // Points went down: a new game
+	uint32_t failures;
+} READER;
+
+static READER readers[READERS];
+static volatile bool stop;
+
+static LEVEL_SEGMENT road, fuelRoad;
+static int swaps; // Segments taken in this game
+
+static volatile bool slow;
+static int saves;
+static uint32_t savedScore;
+static char shown[2 * LCD_DDRAM_LENGTH + 1]; // Last LCDText_Printf()
+
+
+/*
+ * Stubs of the devices (only taskUPDATE_GAME, game() and postgame() run):
+ */
+
+int32_t LCDText_Init(void) {
+	return 0;
+}
+
+void LCDText_WriteChar(char ch) {
+}
+
+void LCDText_WriteString(char *str) {
+}
+
+void LCDText_Clear(void) {
+}
+
+void LCDText_Home(void) {
+}
+
+void LCDText_Locate(int row, int column) {
+}
+
+void LCDText_CreateChar(unsigned char location, const unsigned char charmap[]) {
+}
+
+void LCDText_Printf(char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(shown, sizeof(shown), fmt, args);
+	va_end(args);
+}
+
+void LCDText_ShiftDisplay(LCD_SHIFT_DIR dir) { // Last call of each frame's render
+	if (slow) vTaskDelay(SLOW_FRAME_TICKS);
+}
+
+void LCDText_Sync(void) {
+}
+
+int32_t ADXL_Init(int frequency, int dataResolution) {
+	return 0;
+}
+
+AXIS ADXL_GetAxis() {
+	AXIS level = {0, 0, 0}; // Car stays on row 1
+	return level;
+}
+
+int32_t BUTTON_Hit(void) {
+	return 0;
+}
+
+int32_t BUTTON_Read(void) {
+	return 0;
+}
+
+uint32_t BUTTON_GetButtonsPushEvents(uint32_t * current) {
+	return 0;
+}
+
+uint32_t BUTTON_GetButtonsReleaseEvents(uint32_t * current) {
+	return 0;
+}
+
+void BUTTON_WaitRelease(void (*f)(void)) {
+}
+
+bool LEVEL_Init(char obstacleChar, char fuelChar) {
+	return true;
+}
+
+void LEVEL_Restart(void) {
+	swaps = 0;
+}
+
+const LEVEL_SEGMENT * LEVEL_Swap(uint32_t points) {
+	return (swaps++ < FUEL_SEGMENTS) ? &fuelRoad : &road;
+}
+
+bool NETWORK_Init(void) {
+	return true;
+}
+
+bool NETWORK_ConnectToAP(char * ssid, char * password) {
+	return true;
+}
+
+uint32_t NETWORK_GetSeconds(void) {
+	return 0;
+}
+
+void RTC_Init(time_t seconds) {
+}
+
+void RTC_SetInterrupt(RTC_INTERRUPT_FIELD fields, RTC_HANDLER handler) {
+}
+
+void RTC_GetValue(struct tm *dateTime) {
+	memset(dateTime, 0, sizeof(*dateTime));
+}
+
+void RTC_SetSeconds(time_t seconds) {
+}
+
+void RTC_Enable(void) {
+}
+
+void RTC_Disable(void) {
+}
+
+void RTC_IncrementField(RTC_TIME_FIELD field) {
+}
+
+void RTC_DecrementField(RTC_TIME_FIELD field) {
+}
+
+bool SCORE_Init(MEMORY_DEVICE device) {
+	return true;
+}
+
+int SCORE_Get(Score * score, int n) {
+	return 0;
+}
+
+void SCORE_Save(uint32_t score, char * username) {
+	saves++;
+	savedScore = score;
+}
+
+void SCORE_Erase(void) {
+}
+
+int32_t WAIT_Init(WAIT mode) {
+	return 0;
+}
+
+void WAIT_SYS_Ms(uint32_t millis) {
+}
+
+uint32_t WAIT_SYS_GetElapsedMs(uint32_t start) {
+	return 0;
+}
+
+
+static void *reader(void *parameters) {
+	READER *self = parameters;
+	uint32_t points = gameState.points, ended = gameState.ended;
+
+	while (!stop) {
+		// In the reverse order of game()'s reset (points, fuel, ended): a new ended comes with new points
+		uint32_t nowEnded = gameState.ended;
+		uint32_t fuel = gameState.fuel;
+		uint32_t nowPoints = gameState.points;
+
+		bool fine = (fuel <= MAX_FUEL) && (nowEnded <= 1);
+		if (nowPoints < points) self->resets++;
+		else if (ended && nowEnded) fine = fine && (nowPoints == points); // Nothing scored after the end
+		if (!fine) self->failures++;
+
+		points = nowPoints;
+		ended = nowEnded;
+		if ((++self->samples % 64) == 0) sched_yield(); // Let the game run on a single core too
+	}
+
+	return NULL;
+}
+
+static void waitForUpdateTask(void) { // Frames queued behind the end simulated
+	while (uxQueueMessagesWaiting(queueUPDATE_GAME) != 0) vTaskDelay(GAME_RATE);
+	vTaskDelay(2 * SLOW_FRAME_TICKS);
+}
+
+
+int main(void) {
+	shimTickNs = TICK_NS;
+	frameRateMin = GAME_RATE_MIN; // As calibrateFrameRate() sets it
+	strcpy(username, "Tester");
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		memset(road.text[row], ' ', LEVEL_SEGMENT_LENGTH);
+	}
+	fuelRoad = road;
+	fuelRoad.fuel[0] = 1UL << FUEL_GALLEON_BIT;
+
+	queueUPDATE_GAME = xQueueCreate(UPDATE_GAME_QUEUE_LENGTH, sizeof(GAME_INFO));
+	CHECK(xTaskCreate(taskUPDATE_GAME, "UpdateGame", TASK_UPDATE_GAME_STACK_SIZE, NULL, TASK_UPDATE_GAME_PRIORITY, NULL) == pdPASS);
+	for (int i = 0; i < READERS; i++) {
+		pthread_create(&readers[i].thread, NULL, reader, &readers[i]);
+	}
+
+	uint64_t start = TEST_Ns();
+	uint32_t minPoints = 1 + MAX_FUEL * FUEL_RATE / POINTS_RATE; // Run out of fuel, not refilled
+	for (int i = 0; i < GAMES; i++) {
+		slow = (i >= GAMES - SLOW_GAMES);
+		saves = 0;
+
+		game();
+		waitForUpdateTask();
+
+		CHECK(gameState.ended && gameState.fuel == 0);
+		CHECK(saves == 1);
+		CHECK(savedScore == gameState.points);
+		CHECK(gameState.points >= minPoints);
+
+		postgame();
+		char expected[sizeof(shown)];
+		snprintf(expected, sizeof(expected), "scored %d!", (int) gameState.points);
+		CHECK(strcmp(shown, expected) == 0);
+		printf("game %d%s: %u points, %u frames, %u overruns\n", i + 1, slow ? " (slow)" : "", (unsigned) gameState.points,
+				(unsigned) frameStats.frames, (unsigned) frameStats.overruns);
+	}
+
+	stop = true;
+	uint32_t samples = 0;
+	for (int i = 0; i < READERS; i++) {
+		pthread_join(readers[i].thread, NULL);
+		CHECK(readers[i].failures == 0);
+		CHECK(readers[i].resets <= GAMES); // A drop per new game, no more
+		samples += readers[i].samples;
+	}
+	printf("%d games in %.2f s, %u samples by %d readers\n", GAMES, (TEST_Ns() - start) / 1e9, (unsigned) samples, READERS);
+
+	return TEST_Result("game_state_stress");
+}
@@ -0,0 +1,298 @@
+/*
+ * i2c_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  I2C1 transaction queue of i2c.c (bare metal) on the simulated bus of the shim (shim.h), with register slaves that
+ *  log what they get, and a 24LC32 EEPROM (eeprom24.h). Transactions queued while the handler can't run, and a full
+ *  queue. NACK on the address (write and read) and on data. Read after write on the EEPROM. I2C1_Cancel() of a
+ *  queued transaction, of one held on the bus by a slave, and by I2C1_Transfer() when it times out.
+ */
+
+#include "test.h"
+#include "shim.h"
+#include "eeprom24.h"
+
+#include "i2c.h"
+
+
+#define FREQUENCY 400000
+#define REGISTER_A 0x20
+#define REGISTER_B 0x21
+#define EEPROM 0x50
+#define ABSENT 0x33
+#define IDLE_NS 100000 // Virtual time a __WFI() takes
+
+typedef struct {
+	SHIM_I2C_SLAVE slave; // First: callbacks get it back
+	uint8_t received[64];
+	int receivedCount;
+	uint8_t next; // Next byte read
+	int ackBytes; // Data bytes it acknowledges before a NACK (-1 for every one)
+	int holdAfter; // Holds the bus after this many data bytes (-1 never)
+	int stops;
+} REGISTER;
+
+static REGISTER registerA, registerB;
+static SHIM_EEPROM eeprom;
+
+static bool (*eepromModelAddressed)(SHIM_I2C_SLAVE *slave, bool read);
+
+static uint8_t order[32]; // Slaves in the order they acknowledged their address
+static int orderCount;
+
+
+/*
+ * Stubs of the modules i2c.c uses (not under test):
+ */
+
+int32_t WAIT_Init(WAIT mode) {
+	return 0;
+}
+
+uint32_t WAIT_SYS_GetElapsedMs(uint32_t start) {
+	return (uint32_t) (shimNs / 1000000) - start;
+}
+
+int32_t CLOCK_AddHandler(void (*handler)(void)) {
+	return 0;
+}
+
+void CLOCK_SetPCLK(CLOCK_PERIPHERAL peripheral, CLOCK_DIVIDER divider) {
+}
+
+uint32_t CLOCK_GetPCLK(CLOCK_PERIPHERAL peripheral) {
+	return SystemCoreClock / 4;
+}
+
+
+static bool registerAddressed(SHIM_I2C_SLAVE *slave, bool read) {
+	if (orderCount < sizeof(order)) order[orderCount++] = slave->address;
+	return true;
+}
+
+static bool registerWrite(SHIM_I2C_SLAVE *slave, uint8_t data) {
+	REGISTER *reg = (REGISTER *) slave;
+	if (reg->ackBytes == 0) return false;
+	if (reg->ackBytes > 0) reg->ackBytes--;
+	if (reg->receivedCount < sizeof(reg->received)) reg->received[reg->receivedCount++] = data;
+	if ((reg->holdAfter >= 0) && (reg->receivedCount >= reg->holdAfter)) shimI2C1Bus.hold = true;
+	return true;
+}
+
+static uint8_t registerRead(SHIM_I2C_SLAVE *slave) {
+	return ((REGISTER *) slave)->next++;
+}
+
+static void registerStop(SHIM_I2C_SLAVE *slave) {
+	((REGISTER *) slave)->stops++;
+}
+
+static void registerAttach(REGISTER *reg, uint8_t address) {
+	memset(reg, 0, sizeof(REGISTER));
+	reg->slave = (SHIM_I2C_SLAVE) {address, registerAddressed, registerWrite, registerRead, registerStop};
+	reg->ackBytes = -1;
+	reg->holdAfter = -1;
+	SHIM_I2CAttach(&reg->slave);
+}
+
+static bool eepromAddressed(SHIM_I2C_SLAVE *slave, bool read) { // Logs, then the model's own
+	if (orderCount < sizeof(order)) order[orderCount++] = slave->address;
+	return eepromModelAddressed(slave, read);
+}
+
+static void idle(void) {
+	shimNs += IDLE_NS;
+}
+
+static void reset(void) {
+	SHIM_Reset();
+	shimIdle = idle;
+	registerAttach(&registerA, REGISTER_A);
+	registerAttach(&registerB, REGISTER_B);
+	SHIM_EEPROM_Attach(&eeprom, EEPROM);
+	eepromModelAddressed = eeprom.slave.addressed;
+	eeprom.slave.addressed = eepromAddressed;
+	orderCount = 0;
+	I2C1_Init();
+}
+
+static I2C_TRANSACTION transaction(uint8_t address, const char *wBuffer, int wSize, char *rBuffer, int rSize) {
+	return (I2C_TRANSACTION) {
+		.address = address,
+		.frequency = FREQUENCY,
+		.wBuffer = wBuffer,
+		.wSize = wSize,
+		.rBuffer = rBuffer,
+		.rSize = rSize
+	};
+}
+
+
+static void testQueue(void) {
+	reset();
+	char rBuffer[3], eepromRead[2];
+	const char wBuffer[] = {0x12, 0x34}, eepromAddress[] = {0x00, 0x10};
+	I2C_TRANSACTION t[3] = {
+		transaction(REGISTER_A, wBuffer, 2, NULL, 0),
+		transaction(REGISTER_B, NULL, 0, rBuffer, 3),
+		transaction(EEPROM, eepromAddress, 2, eepromRead, 2)
+	};
+	registerB.next = 0x40;
+
+	__disable_irq(); // Handler can't run: everything waits in the queue
+	for (int i = 0; i < 3; i++) {
+		CHECK(I2C1_Submit(&t[i]) == 0);
+	}
+	for (int i = 0; i < 3; i++) {
+		CHECK(t[i].result == I2C_TRANSFER_PENDING);
+	}
+	CHECK(shimI2C1Bus.bytes == 0);
+	__enable_irq();
+
+	for (int i = 0; i < 3; i++) {
+		CHECK(t[i].result == I2C_TRANSFER_DONE);
+	}
+	CHECK(orderCount == 4 && order[0] == REGISTER_A && order[1] == REGISTER_B && order[2] == EEPROM && order[3] == EEPROM);
+	CHECK(registerA.receivedCount == 2 && registerA.received[0] == 0x12 && registerA.received[1] == 0x34);
+	CHECK(rBuffer[0] == 0x40 && rBuffer[1] == 0x41 && rBuffer[2] == 0x42);
+	CHECK(eepromRead[0] == (char) 0xFF && eepromRead[1] == (char) 0xFF); // Erased
+	CHECK(shimI2C1Bus.starts == 4 && shimI2C1Bus.stops == 3); // EEPROM read after a repeated START
+	CHECK(shimI2C1Bus.bytes == 3 + 4 + 6); // Addresses included
+	CHECK(registerA.stops == 1 && registerB.stops == 1);
+
+	// A full queue refuses one more:
+	I2C_TRANSACTION full[I2C_QUEUE_LENGTH + 1];
+	__disable_irq();
+	for (int i = 0; i < I2C_QUEUE_LENGTH; i++) {
+		full[i] = transaction(REGISTER_A, wBuffer, 1, NULL, 0);
+		CHECK(I2C1_Submit(&full[i]) == 0);
+	}
+	full[I2C_QUEUE_LENGTH] = transaction(REGISTER_A, wBuffer, 1, NULL, 0);
+	CHECK(I2C1_Submit(&full[I2C_QUEUE_LENGTH]) == -1);
+	CHECK(full[I2C_QUEUE_LENGTH].result == I2C_TRANSFER_ERROR);
+	__enable_irq();
+	for (int i = 0; i < I2C_QUEUE_LENGTH; i++) {
+		CHECK(full[i].result == I2C_TRANSFER_DONE);
+	}
+	CHECK(registerA.receivedCount == 2 + I2C_QUEUE_LENGTH);
+
+	// Invalid arguments:
+	I2C_TRANSACTION invalid = transaction(REGISTER_A, NULL, 1, NULL, 0);
+	CHECK(I2C1_Submit(&invalid) == -1);
+	invalid = transaction(REGISTER_A, wBuffer, 1, NULL, 0);
+	invalid.frequency = 0;
+	CHECK(I2C1_Submit(&invalid) == -1);
+}
+
+static void testNack(void) {
+	reset();
+	char rBuffer[2];
+	const char wBuffer[] = {1, 2, 3};
+
+	I2C_TRANSACTION t = transaction(ABSENT, wBuffer, 3, NULL, 0);
+	CHECK(I2C1_Transfer(&t) == I2C_TRANSFER_NACK); // SLA + W
+	CHECK(shimI2C1Bus.nacks == 1 && shimI2C1Bus.stops == 1 && shimI2C1Bus.bytes == 1);
+
+	t = transaction(ABSENT, NULL, 0, rBuffer, 2);
+	CHECK(I2C1_Transfer(&t) == I2C_TRANSFER_NACK); // SLA + R
+	CHECK(shimI2C1Bus.nacks == 2 && shimI2C1Bus.stops == 2);
+
+	registerA.ackBytes = 1;
+	t = transaction(REGISTER_A, wBuffer, 3, NULL, 0);
+	CHECK(I2C1_Transfer(&t) == I2C_TRANSFER_ERROR); // Data NACK
+	CHECK(registerA.receivedCount == 1 && registerA.stops == 1);
+
+	registerA.ackBytes = -1;
+	t = transaction(REGISTER_A, wBuffer, 3, NULL, 0);
+	CHECK(I2C1_Transfer(&t) == I2C_TRANSFER_DONE); // Bus is fine after every NACK
+	CHECK(registerA.receivedCount == 4);
+}
+
+static void testReadAfterWrite(void) {
+	reset();
+	char wBuffer[2 + 10], rBuffer[10];
+	wBuffer[0] = 0x01;
+	wBuffer[1] = 0x42;
+	for (int i = 0; i < 10; i++) {
+		wBuffer[2 + i] = (char) (0xA0 + i);
+	}
+
+	I2C_TRANSACTION t = transaction(EEPROM, wBuffer, sizeof(wBuffer), NULL, 0);
+	CHECK(I2C1_Transfer(&t) == I2C_TRANSFER_DONE);
+	CHECK(eeprom.pageWrites == 1);
+	CHECK(memcmp(eeprom.memory + 0x142, wBuffer + 2, 10) == 0);
+
+	t = transaction(EEPROM, wBuffer, 2, rBuffer, sizeof(rBuffer)); // Address, repeated START, read
+	CHECK(I2C1_Transfer(&t) == I2C_TRANSFER_DONE);
+	CHECK(memcmp(rBuffer, wBuffer + 2, 10) == 0);
+	CHECK(eeprom.pageWrites == 1); // Setting the address writes nothing
+
+	t = transaction(EEPROM, NULL, 0, rBuffer, 1); // Read only: goes on from the address pointer
+	CHECK(I2C1_Transfer(&t) == I2C_TRANSFER_DONE);
+	CHECK(rBuffer[0] == (char) 0xFF);
+
+	I2C1_Configure(FREQUENCY, 4, (char []) {EEPROM << 1, 0x01, 0x44}, 3); // Compatibility API, same bus
+	CHECK(I2C1_Engine() == 0);
+	I2C1_GetBuffer(rBuffer);
+	CHECK(memcmp(rBuffer, wBuffer + 4, 4) == 0);
+}
+
+static void testCancel(void) {
+	reset();
+	const char wBuffer[] = {1, 2, 3, 4};
+
+	// Still queued: taken out, the others go on
+	I2C_TRANSACTION t[3] = {
+		transaction(REGISTER_A, wBuffer, 1, NULL, 0),
+		transaction(REGISTER_B, wBuffer, 1, NULL, 0),
+		transaction(REGISTER_A, wBuffer, 2, NULL, 0)
+	};
+	__disable_irq();
+	for (int i = 0; i < 3; i++) {
+		CHECK(I2C1_Submit(&t[i]) == 0);
+	}
+	CHECK(I2C1_Cancel(&t[1]) == I2C_TRANSFER_ERROR);
+	__enable_irq();
+	CHECK(t[0].result == I2C_TRANSFER_DONE && t[1].result == I2C_TRANSFER_ERROR && t[2].result == I2C_TRANSFER_DONE);
+	CHECK(registerB.receivedCount == 0 && orderCount == 2);
+	CHECK(I2C1_Cancel(&t[0]) == I2C_TRANSFER_DONE); // Already ended: only its result
+
+	// On the bus, held by the slave after one byte: STOP, then the next one starts
+	reset();
+	registerA.holdAfter = 1;
+	t[0] = transaction(REGISTER_A, wBuffer, 4, NULL, 0);
+	t[1] = transaction(REGISTER_B, wBuffer, 2, NULL, 0);
+	CHECK(I2C1_Submit(&t[0]) == 0 && I2C1_Submit(&t[1]) == 0);
+	CHECK(t[0].result == I2C_TRANSFER_PENDING && registerA.receivedCount == 1);
+	CHECK(I2C1_Cancel(&t[0]) == I2C_TRANSFER_ERROR);
+	shimI2C1Bus.hold = false;
+	SHIM_Dispatch();
+	CHECK(registerA.stops == 1 && registerA.receivedCount == 1);
+	CHECK(t[1].result == I2C_TRANSFER_DONE && registerB.receivedCount == 2);
+
+	// By I2C1_Transfer(), timed out while the slave holds the bus
+	reset();
+	registerA.holdAfter = 0;
+	t[0] = transaction(REGISTER_A, wBuffer, 4, NULL, 0);
+	uint64_t start = shimNs;
+	CHECK(I2C1_Transfer(&t[0]) == I2C_TRANSFER_ERROR);
+	uint64_t waited = (shimNs - start) / 1000000;
+	CHECK(waited > I2C_TIMEOUT_MS && waited <= I2C_TIMEOUT_MS + 2);
+	shimI2C1Bus.hold = false;
+	registerA.holdAfter = -1;
+	t[0] = transaction(REGISTER_A, wBuffer, 4, NULL, 0);
+	CHECK(I2C1_Transfer(&t[0]) == I2C_TRANSFER_DONE);
+	CHECK(registerA.stops == 2);
+}
+
+
+int main(void) {
+	testQueue();
+	testNack();
+	testReadAfterWrite();
+	testCancel();
+
+	return TEST_Result("i2c_test");
+}
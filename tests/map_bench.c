@@ -0,0 +1,151 @@
+/*
+ * map_bench.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Game map of Car_Runner_RTOS (car_runner_rtos.c): the bit-packed GAME_MAP against the int map[2][40] it replaced,
+ *  kept below as it was. Both play the same random road for FRAMES frames (segments merged in as the display wraps,
+ *  car moved and checked for fuel and obstacles each frame) and must agree on every grab and crash. Prints the time
+ *  per frame (best of RUNS), and the stack each map takes.
+ *
+ *  Linked with --gc-sections: only the map functions are kept of car_runner_rtos.c, and they need no stubs.
+ */
+
+#include "test.h"
+
+#define main CAR_RUNNER_RTOS_Main
+#include "../Car_Runner_RTOS/src/car_runner_rtos.c"
+#undef main
+
+
+#define FRAMES 1000000
+#define SEGMENTS 64 // Road, played in a loop
+#define RUNS 5
+
+static LEVEL_SEGMENT road[SEGMENTS];
+static uint32_t seed = 2463534242u;
+
+
+/*
+ * As before the bit-packed map: 1 for an obstacle, 2 for a fuel galleon, 0 for nothing.
+ */
+
+static uint32_t intFuel;
+
+static void intMergeSegment(int from, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH], const LEVEL_SEGMENT *segment) {
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+		for (int i = 0; i < LEVEL_SEGMENT_LENGTH; i++) {
+			int object = 0;
+			if (segment->obstacles[row] & (1UL << i)) object = 1;
+			else if (segment->fuel[row] & (1UL << i)) object = 2;
+			map[row][from - 1 + i] = object;
+		}
+	}
+}
+
+static void intCheckForFuelGrab(CAR *car, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]) {
+	if ((map[car->row-1][car->back_column-1] == 2)) {
+		intFuel = (intFuel + 3 > MAX_FUEL) ? MAX_FUEL : intFuel + 3;
+		map[car->row-1][car->back_column-1] = 0;
+	}
+	else if ((map[car->row-1][car->front_column-1] == 2)) {
+		intFuel = (intFuel + 3 > MAX_FUEL) ? MAX_FUEL : intFuel + 3;
+		map[car->row-1][car->front_column-1] = 0;
+	}
+}
+
+static bool intCheckForLoss(CAR *car, int map[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH]) {
+	return (map[car->row-1][car->back_column-1] == 1) || (map[car->row-1][car->front_column-1] == 1) || (intFuel == 0);
+}
+
+
+static uint32_t xorshift(void) {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static void makeRoad(void) {
+	for (int i = 0; i < SEGMENTS; i++) {
+		for (int row = 0; row < LCD_DISPLAY_ROWS; row++) {
+			road[i].obstacles[row] = xorshift() & xorshift() & 0xFFFF; // A quarter of the columns
+			road[i].fuel[row] = xorshift() & xorshift() & xorshift() & ~road[i].obstacles[row] & 0xFFFF;
+		}
+	}
+}
+
+static int rowOf(uint32_t frame) { // Car's row on a frame, the same for both maps
+	return 1 + ((frame * 2654435761u) >> 31);
+}
+
+
+static GAME_MAP map;
+static int intMap[LCD_DISPLAY_ROWS][LCD_DDRAM_LENGTH];
+static uint32_t grabs, losses, intGrabs, intLosses;
+
+static uint64_t playBits(void) { // With the functions of car_runner_rtos.c; returns the time taken
+	CAR car = {.row = 1, .front_column = CAR_POSITION + 1, .back_column = CAR_POSITION};
+	uint32_t segment = 0;
+	memset(&map, 0, sizeof(map));
+	grabs = losses = 0;
+
+	uint64_t start = TEST_Ns();
+	for (uint32_t frame = 0; frame < FRAMES; frame++) {
+		if (car.back_column == CAR_POSITION + (LCD_DDRAM_LENGTH/2)) mergeSegment(1, &map, &road[segment++ % SEGMENTS]);
+		if (car.back_column == CAR_POSITION) mergeSegment((LCD_DDRAM_LENGTH/2) + 1, &map, &road[segment++ % SEGMENTS]);
+		moveCar(&car, rowOf(frame));
+		gameState.fuel = 1;
+		checkForFuelGrab(&car, &map);
+		grabs += (gameState.fuel != 1);
+		losses += checkForLoss(&car, &map);
+	}
+	return TEST_Ns() - start;
+}
+
+static uint64_t playInts(void) {
+	CAR car = {.row = 1, .front_column = CAR_POSITION + 1, .back_column = CAR_POSITION};
+	uint32_t segment = 0;
+	memset(intMap, 0, sizeof(intMap));
+	intGrabs = intLosses = 0;
+
+	uint64_t start = TEST_Ns();
+	for (uint32_t frame = 0; frame < FRAMES; frame++) {
+		if (car.back_column == CAR_POSITION + (LCD_DDRAM_LENGTH/2)) intMergeSegment(1, intMap, &road[segment++ % SEGMENTS]);
+		if (car.back_column == CAR_POSITION) intMergeSegment((LCD_DDRAM_LENGTH/2) + 1, intMap, &road[segment++ % SEGMENTS]);
+		moveCar(&car, rowOf(frame));
+		intFuel = 1;
+		intCheckForFuelGrab(&car, intMap);
+		intGrabs += (intFuel != 1);
+		intLosses += intCheckForLoss(&car, intMap);
+	}
+	return TEST_Ns() - start;
+}
+
+
+int main(void) {
+	makeRoad();
+
+	uint64_t bits = UINT64_MAX, ints = UINT64_MAX;
+	for (int i = 0; i < RUNS; i++) { // Best of, on a busy host
+		uint64_t ns = playBits();
+		if (ns < bits) bits = ns;
+		ns = playInts();
+		if (ns < ints) ints = ns;
+	}
+
+	CHECK(grabs == intGrabs && losses == intLosses);
+	CHECK(grabs > 0 && losses > 0 && losses < FRAMES);
+	for (int row = 0; row < LCD_DISPLAY_ROWS; row++) { // Same map in the end
+		for (int col = 1; col <= LCD_DDRAM_LENGTH; col++) {
+			int object = (map.obstacles[row] & MAP_COLUMN(col)) ? 1 : (map.fuel[row] & MAP_COLUMN(col)) ? 2 : 0;
+			CHECK(object == intMap[row][col - 1]);
+		}
+	}
+
+	printf("%d frames (%u grabs, %u crashes): ns per frame %.1f bit-packed (%zu bytes), %.1f int map (%zu bytes)\n", FRAMES,
+			(unsigned) grabs, (unsigned) losses, (double) bits / FRAMES, sizeof(map), (double) ints / FRAMES, sizeof(intMap));
+
+	return TEST_Result("map_bench");
+}
@@ -0,0 +1,139 @@
+/*
+ * prng_bench.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Pseudo-random number generator (prng.c). PRNG_Range() and PRNG_Between() stay within their bounds (multiply and
+ *  shift, for ranges from 1 to 2^32 - 1), reach both ends, and spread evenly. Seeds never leave the state at 0. Then
+ *  the time per call, against rand() % n, as the level generator used before.
+ */
+
+#include "test.h"
+
+#include "prng.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+
+#define SAMPLES 1000000
+#define BENCH_CALLS 10000000
+#define BUCKETS 40 // A row of DDRAM
+
+static const uint32_t ranges[] = {1, 2, 3, 7, 16, 40, 100, 1000, 65536, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF};
+
+
+static void testRange(void) {
+	PRNG_STATE prng;
+	PRNG_Seed(&prng, 1);
+
+	for (int i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+		uint32_t n = ranges[i], lowest = UINT32_MAX, highest = 0;
+		for (int j = 0; j < SAMPLES; j++) {
+			uint32_t value = PRNG_Range(&prng, n);
+			if (value < lowest) lowest = value;
+			if (value > highest) highest = value;
+		}
+		CHECK(highest < n);
+		CHECK(lowest <= n / 1000 && highest >= n - 1 - n / 1000); // Ends reached (or nearly, for wide ranges)
+	}
+
+	CHECK(PRNG_Range(&prng, 0) == 0);
+}
+
+static void testBetween(void) {
+	PRNG_STATE prng;
+	PRNG_Seed(&prng, 2);
+	int bounds[][2] = {{0, 0}, {3, 5}, {-4, 4}, {-100, -90}, {1, 40}, {-(1 << 30), 1 << 30}};
+
+	for (int i = 0; i < sizeof(bounds) / sizeof(bounds[0]); i++) {
+		int min = bounds[i][0], max = bounds[i][1], lowest = max, highest = min;
+		bool inside = true;
+		for (int j = 0; j < SAMPLES; j++) {
+			int value = PRNG_Between(&prng, min, max);
+			if ((value < min) || (value > max)) inside = false;
+			if (value < lowest) lowest = value;
+			if (value > highest) highest = value;
+		}
+		CHECK(inside);
+		if ((int64_t) max - min < 1000) CHECK(lowest == min && highest == max);
+	}
+}
+
+static void testSpread(void) {
+	PRNG_STATE prng;
+	PRNG_Seed(&prng, 3);
+	uint32_t counts[BUCKETS] = {0}, outside = 0;
+
+	for (int i = 0; i < BUCKETS * 100000; i++) {
+		uint32_t value = PRNG_Range(&prng, BUCKETS);
+		if (value < BUCKETS) counts[value]++;
+		else outside++;
+	}
+	CHECK(outside == 0);
+
+	double chiSquare = 0;
+	for (int i = 0; i < BUCKETS; i++) {
+		double deviation = counts[i] - 100000.0;
+		chiSquare += deviation * deviation / 100000.0;
+	}
+	CHECK(chiSquare < 80); // 39 degrees of freedom: above 80 once in 10000 for a fair die
+	printf("spread over %d buckets: chi-square %.1f\n", BUCKETS, chiSquare);
+}
+
+static void testSeed(void) {
+	PRNG_STATE prng;
+	for (uint32_t seed = 0; seed < 100000; seed++) {
+		PRNG_Seed(&prng, seed);
+		CHECK(prng.state != 0);
+	}
+
+	PRNG_STATE a, b; // Neighbouring seeds: unrelated sequences
+	PRNG_Seed(&a, 1000);
+	PRNG_Seed(&b, 1001);
+	int same = 0;
+	for (int i = 0; i < 1000; i++) {
+		same += (PRNG_Range(&a, 2) == PRNG_Range(&b, 2));
+	}
+	CHECK(same > 400 && same < 600);
+}
+
+static void bench(void) {
+	PRNG_STATE prng;
+	PRNG_Seed(&prng, 4);
+	srand(4);
+	volatile uint32_t sink = 0;
+
+	uint64_t start = TEST_Ns();
+	for (int i = 0; i < BENCH_CALLS; i++) {
+		sink += PRNG_Range(&prng, BUCKETS);
+	}
+	uint64_t range = TEST_Ns() - start;
+
+	start = TEST_Ns();
+	for (int i = 0; i < BENCH_CALLS; i++) {
+		sink += rand() % BUCKETS;
+	}
+	uint64_t libc = TEST_Ns() - start;
+
+	start = TEST_Ns();
+	for (int i = 0; i < BENCH_CALLS; i++) {
+		sink += PRNG_Next(&prng);
+	}
+	uint64_t next = TEST_Ns() - start;
+
+	printf("ns per call: PRNG_Range %.2f (rand() %% n %.2f), PRNG_Next %.2f\n", (double) range / BENCH_CALLS,
+			(double) libc / BENCH_CALLS, (double) next / BENCH_CALLS);
+}
+
+
+int main(void) {
+	testRange();
+	testBetween();
+	testSpread();
+	testSeed();
+	bench();
+
+	return TEST_Result("prng_bench");
+}
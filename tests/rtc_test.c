@@ -0,0 +1,146 @@
+/*
+ * rtc_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  UTC conversions of rtc.c (RTC_ToSeconds(), RTC_FromSeconds()) against glibc's timegm() and gmtime_r(): every day
+ *  from 1900 to 2100 at its first and last second, and a time about every hour in between. Days in month against the
+ *  length glibc gives each month, up to 2400. Then the cost of each conversion, next to glibc's.
+ */
+
+#define _GNU_SOURCE // timegm()
+
+#ifdef __x86_64__
+#include <x86intrin.h> // Before the shim: its __I macro is a parameter name in there
+#endif
+
+#include "test.h"
+
+#include "../LEETC_SE1/src/rtc.c" // daysInMonth() is static
+
+#include <string.h>
+
+
+#define FIRST_YEAR 1900
+#define LAST_YEAR 2100
+#define HOUR_STEP 3607 // Seconds: a prime, so the time of day moves around
+#define BENCH_CALLS 1000000
+
+static volatile int64_t sink; // Keeps benchmarked results
+
+
+static time_t yearStart(int year) {
+	struct tm fields = {.tm_year = year - 1900, .tm_mday = 1};
+	return timegm(&fields);
+}
+
+static bool sameFields(const struct tm *a, const struct tm *b) {
+	return a->tm_sec == b->tm_sec && a->tm_min == b->tm_min && a->tm_hour == b->tm_hour && a->tm_mday == b->tm_mday
+			&& a->tm_mon == b->tm_mon && a->tm_year == b->tm_year && a->tm_wday == b->tm_wday && a->tm_yday == b->tm_yday
+			&& a->tm_isdst == b->tm_isdst;
+}
+
+static uint32_t checkSeconds(time_t seconds) { // Returns 1 on a mismatch
+	struct tm expected, fields;
+	gmtime_r(&seconds, &expected);
+	memset(&fields, 0xA5, sizeof(fields)); // Every field must be written
+	RTC_FromSeconds(seconds, &fields);
+	if (!sameFields(&fields, &expected)) {
+		printf("RTC_FromSeconds(%lld) is %04d-%02d-%02d %02d:%02d:%02d (wday %d, yday %d)\n", (long long) seconds,
+				fields.tm_year + 1900, fields.tm_mon + 1, fields.tm_mday, fields.tm_hour, fields.tm_min, fields.tm_sec,
+				fields.tm_wday, fields.tm_yday);
+		return 1;
+	}
+	if (RTC_ToSeconds(&expected) != seconds) {
+		printf("RTC_ToSeconds() of %lld is %lld\n", (long long) seconds, (long long) RTC_ToSeconds(&expected));
+		return 1;
+	}
+	return 0;
+}
+
+static void testConversions(void) {
+	uint32_t wrong = 0, checked = 0;
+	time_t end = yearStart(LAST_YEAR + 1);
+
+	for (time_t day = yearStart(FIRST_YEAR); day < end; day += 86400) { // First and last second of each day
+		wrong += checkSeconds(day);
+		wrong += checkSeconds(day + 86399);
+		checked += 2;
+	}
+	for (time_t seconds = yearStart(FIRST_YEAR); seconds < end; seconds += HOUR_STEP) {
+		wrong += checkSeconds(seconds);
+		checked++;
+	}
+	CHECK(wrong == 0);
+	CHECK(RTC_ToSeconds(&(struct tm) {.tm_year = 70, .tm_mday = 1}) == 0);
+	printf("conversions: %u times checked, %u wrong\n", checked, wrong);
+}
+
+static void testDaysInMonth(void) {
+	uint32_t wrong = 0;
+	for (int year = FIRST_YEAR; year <= 2400; year++) {
+		for (int month = 0; month < 12; month++) {
+			struct tm start = {.tm_year = year - 1900, .tm_mon = month, .tm_mday = 1};
+			struct tm next = {.tm_year = year - 1900 + (month == 11), .tm_mon = (month + 1) % 12, .tm_mday = 1};
+			int days = (int) ((timegm(&next) - timegm(&start)) / 86400);
+			if (daysInMonth(year, month + 1) != days) wrong++;
+		}
+	}
+	CHECK(wrong == 0);
+}
+
+static uint64_t cycles(void) { // Host time stamp counter, or ns elsewhere
+	#ifdef __x86_64__
+		return __rdtsc();
+	#else
+		return TEST_Ns();
+	#endif
+}
+
+static void benchmark(void) {
+	time_t start = yearStart(1970), span = yearStart(LAST_YEAR + 1) - start;
+	uint64_t step = (uint64_t) span / BENCH_CALLS; // Spread over the whole range
+	struct tm fields;
+	int64_t sum = 0;
+	uint64_t t0, t1, t2, t3, t4;
+
+	t0 = cycles();
+	for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+		RTC_FromSeconds(start + i * step, &fields);
+		sum += fields.tm_mday;
+	}
+	t1 = cycles();
+	for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+		time_t seconds = start + i * step;
+		gmtime_r(&seconds, &fields);
+		sum += fields.tm_mday;
+	}
+	t2 = cycles();
+	for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+		fields.tm_mday = 1 + i % 28;
+		fields.tm_year = 70 + i % 130;
+		sum += RTC_ToSeconds(&fields);
+	}
+	t3 = cycles();
+	for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+		fields.tm_mday = 1 + i % 28;
+		fields.tm_year = 70 + i % 130;
+		sum += timegm(&fields);
+	}
+	t4 = cycles();
+	sink = sum;
+
+	printf("cycles per call: RTC_FromSeconds %.1f (gmtime_r %.1f), RTC_ToSeconds %.1f (timegm %.1f)\n",
+			(double) (t1 - t0) / BENCH_CALLS, (double) (t2 - t1) / BENCH_CALLS,
+			(double) (t3 - t2) / BENCH_CALLS, (double) (t4 - t3) / BENCH_CALLS);
+}
+
+
+int main(void) {
+	testConversions();
+	testDaysInMonth();
+	benchmark();
+
+	return TEST_Result("rtc_test");
+}
@@ -0,0 +1,170 @@
+/*
+ * score_bench.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Leaderboard of Car_Runner_RTOS (score.c) on an EEPROM kept in RAM. Inserts 10000 scores of 1000 users, checks the
+ *  board against each user's best score, reloads it from the EEPROM image, and prints the time and the EEPROM bytes
+ *  written per insert.
+ */
+
+#include "test.h"
+
+#include "../Car_Runner_RTOS/src/score.c" // SCORE_Load() and SCORE_SaveLocally() are static
+
+
+#define INSERTS 10000
+#define USERS 1000
+#define MAX_TEST_SCORE (1 << 20) // Above 16 bits
+
+static char memory[EEPROM_SIZE];
+static uint32_t written; // Bytes written to memory
+
+static uint32_t best[USERS]; // Best score of each user (0 if none)
+static uint32_t seed = 2463534242u;
+
+
+/*
+ * EEPROM (and unused Flash and network) stubs:
+ */
+
+void EEPROM_Init() {
+}
+
+int EEPROM_ReadAt(int address, char * buffer, int size) {
+	if ((address < 0) || (address + size > EEPROM_SIZE)) return -1;
+	memcpy(buffer, memory + address, size);
+	return 0;
+}
+
+int EEPROM_WriteCached(int address, char * buffer, int size) {
+	if ((address < 0) || (address + size > EEPROM_SIZE)) return -1;
+	memcpy(memory + address, buffer, size);
+	written += size;
+	return 0;
+}
+
+int EEPROM_Flush() {
+	return 0;
+}
+
+void FLASH_Init() {
+}
+
+unsigned int FLASH_EraseSectors(unsigned int startSector, unsigned int endSector) {
+	return 0;
+}
+
+unsigned int FLASH_WriteData(unsigned int sector, void *dstAddr, void *srcAddr, unsigned int size) {
+	return 0;
+}
+
+unsigned int FLASH_VerifyData(void *dstAddr, void *srcAddr, unsigned int size) {
+	return 0;
+}
+
+void NETWORK_PublishScore(int scoreSend) {
+}
+
+
+static uint32_t random32(void) { // xorshift32
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static void userName(int user, char * name) {
+	snprintf(name, NAME_LENGTH+1, "user%03d", user);
+}
+
+static int compareDown(const void * a, const void * b) {
+	uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+	return (x < y) - (x > y);
+}
+
+static int boardUsers(void) {
+	int users = 0;
+	for (int i = 0; i < USERS; i++) {
+		if (best[i] != 0) users++;
+	}
+	return users;
+}
+
+static void checkBoard(void) {
+	static uint32_t expected[USERS];
+	int size = boardUsers() < SCORE_BOARD_SIZE ? boardUsers() : SCORE_BOARD_SIZE;
+
+	memcpy(expected, best, sizeof(best));
+	qsort(expected, USERS, sizeof(uint32_t), compareDown); // Board holds the best 'size' of these
+
+	CHECK(count == size);
+
+	bool seen[USERS] = {false};
+	Score score;
+	for (int n = 0; n < SCORE_BOARD_SIZE; n++) {
+		CHECK(SCORE_Get(&score, n) == 0);
+		if (n >= size) {
+			CHECK(score.score == 0);
+			continue;
+		}
+		int user = atoi(score.name + 4);
+		CHECK((user >= 0) && (user < USERS) && !seen[user]); // Once per user
+		seen[user] = true;
+		CHECK(score.score == best[user]); // With his best score
+		CHECK(score.score == expected[n]); // In order
+		CHECK(SCORE_IndexFind(score.name, SCORE_Hash(score.name)) == rank[n]);
+	}
+}
+
+
+int main(void) {
+	char name[NAME_LENGTH+1];
+
+	CHECK(SCORE_Init(EEPROM));
+	SCORE_Load(); // Formats the empty EEPROM
+	CHECK(count == 0);
+
+	// Scores above 16 bits keep their order:
+	userName(0, name);
+	CHECK(SCORE_SaveLocally(65536 + 5, name) == 0);
+	userName(1, name);
+	CHECK(SCORE_SaveLocally(70000, name) == 0);
+	userName(2, name);
+	CHECK(SCORE_SaveLocally(65535, name) == 2);
+	best[0] = 65536 + 5;
+	best[1] = 70000;
+	best[2] = 65535;
+	checkBoard();
+
+	// A score of 0 takes no place (it would show as an empty one):
+	userName(3, name);
+	CHECK(SCORE_SaveLocally(0, name) == -1 && count == 3);
+	checkBoard();
+
+	written = 0;
+	uint64_t start = TEST_Ns();
+	for (int i = 0; i < INSERTS; i++) {
+		int user = random32() % USERS;
+		uint32_t score = 1 + random32() % MAX_TEST_SCORE;
+		userName(user, name);
+		SCORE_SaveLocally(score, name);
+		if (score > best[user]) best[user] = score;
+	}
+	uint64_t elapsed = TEST_Ns() - start;
+	checkBoard();
+
+	// Reload from the EEPROM image:
+	memset(rank, 0, sizeof(rank));
+	memset(slotScore, 0, sizeof(slotScore));
+	memset(slotHash, 0, sizeof(slotHash));
+	loaded = false;
+	SCORE_Load();
+	checkBoard();
+
+	printf("%d inserts (%d users, board of %d): %.0f ns and %.1f EEPROM bytes per insert\n", INSERTS, USERS,
+			SCORE_BOARD_SIZE, (double) elapsed / INSERTS, (double) written / INSERTS);
+
+	return TEST_Result("score_bench");
+}
@@ -0,0 +1,205 @@
+/*
+ * LPC17xx.h
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Host shim of CMSIS LPC17xx.h, for tests/. Register layouts and IRQ numbers come from the real header
+ *  (CMSIS_CORE_LPC17xx/inc): only the Cortex-M3 core (inline assembly) is replaced. Peripherals are plain variables
+ *  (lpc17xx.c), so a test reads and writes their registers, and simulates interrupts with SHIM_Raise() (shim.h).
+ *
+ *  I2C1 is the exception: its bus is simulated, with slaves attached by the test (shim.h). Each LPC_I2C1 access goes
+ *  through SHIM_I2C1(), which first applies the previous one (I2CONSET and I2CONCLR are write-only here, as set and
+ *  clear registers: they read 0). NVIC works the same way, so that ISER and ICER are set and clear registers too.
+ */
+
+#ifndef SHIM_LPC17XX_H_
+#define SHIM_LPC17XX_H_
+
+#include <stdint.h>
+
+#define __CORE_CM3_H_GENERIC // Skip core_cm3.h and system_LPC17xx.h: their host versions are below
+#define __CORE_CM3_H_DEPENDANT
+#define __SYSTEM_LPC17xx_H
+
+#define __I volatile // Writable, so tests can set status registers
+#define __O volatile
+#define __IO volatile
+
+#include "../../CMSIS_CORE_LPC17xx/inc/LPC17xx.h"
+
+
+/*
+ * Core peripherals (as core_cm3.h):
+ */
+
+typedef struct {
+	__IO uint32_t ISER[8];
+	__IO uint32_t ICER[8];
+	__IO uint32_t ISPR[8];
+	__IO uint32_t ICPR[8];
+	__IO uint32_t IABR[8];
+	__IO uint8_t IP[240];
+} NVIC_Type;
+
+typedef struct {
+	__IO uint32_t CTRL;
+	__IO uint32_t LOAD;
+	__IO uint32_t VAL;
+	__I uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct {
+	__IO uint32_t ICSR;
+	__IO uint32_t VTOR; // 32 bits, as on the target: tests that point it at a table link with -no-pie
+	__IO uint32_t AIRCR;
+	__IO uint32_t SCR;
+	__IO uint8_t SHP[12];
+} SCB_Type;
+
+typedef struct {
+	__IO uint32_t DHCSR;
+	__O uint32_t DCRSR;
+	__IO uint32_t DCRDR;
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+	__IO uint32_t CTRL;
+	__IO uint32_t CYCCNT; // Counts virtual time (shimNs, see shim.h) while enabled
+} DWT_Type;
+
+extern NVIC_Type shimNVIC;
+
+NVIC_Type *SHIM_NVIC(void);
+DWT_Type *SHIM_DWT(void);
+extern SysTick_Type shimSysTick;
+extern SCB_Type shimSCB;
+extern CoreDebug_Type shimCoreDebug;
+extern DWT_Type shimDWT;
+
+#define NVIC (SHIM_NVIC())
+#define SysTick (&shimSysTick)
+#define SCB (&shimSCB)
+#define CoreDebug (&shimCoreDebug)
+#define DWT (SHIM_DWT())
+
+#define SysTick_CTRL_CLKSOURCE_Msk (1UL << 2)
+#define SysTick_CTRL_TICKINT_Msk (1UL << 1)
+#define SysTick_CTRL_ENABLE_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type IRQn);
+uint32_t SysTick_Config(uint32_t ticks);
+
+void __enable_irq(void);
+void __disable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+uint32_t __get_BASEPRI(void);
+void __set_BASEPRI(uint32_t basePri);
+void __WFI(void);
+
+#define __NOP()
+#define __DSB()
+#define __ISB()
+#define __DMB()
+#define __CLZ(value) ((uint32_t) ((value) == 0 ? 32 : __builtin_clz(value)))
+
+static inline uint32_t __RBIT(uint32_t value) {
+	uint32_t result = 0;
+	for (int i = 0; i < 32; i++, value >>= 1) {
+		result = (result << 1) | (value & 1);
+	}
+	return result;
+}
+
+
+/*
+ * System (as system_LPC17xx.h):
+ */
+
+extern uint32_t SystemCoreClock;
+
+void SystemInit(void);
+void SystemCoreClockUpdate(void);
+
+
+/*
+ * I2C1 bus (see shim.h):
+ */
+
+LPC_I2C_TypeDef *SHIM_I2C1(void);
+
+
+/*
+ * SPI (see shim.h):
+ */
+
+LPC_SPI_TypeDef *SHIM_SPI(void);
+
+
+/*
+ * Peripherals:
+ */
+
+extern LPC_SC_TypeDef shimSC;
+extern LPC_GPIO_TypeDef shimGPIO[5];
+extern LPC_TIM_TypeDef shimTIM[4];
+extern LPC_UART_TypeDef shimUART2;
+extern LPC_UART_TypeDef *const shimUART2Registers; // &shimUART2, out of the compiler's sight (see LPC_UART2)
+extern LPC_UART_TypeDef shimUART3;
+extern LPC_I2C_TypeDef shimI2C[3];
+extern LPC_SPI_TypeDef shimSPI;
+extern LPC_RTC_TypeDef shimRTC;
+extern LPC_GPIOINT_TypeDef shimGPIOINT;
+extern LPC_PINCON_TypeDef shimPINCON;
+
+#undef LPC_SC
+#undef LPC_GPIO0
+#undef LPC_GPIO1
+#undef LPC_GPIO2
+#undef LPC_GPIO3
+#undef LPC_GPIO4
+#undef LPC_TIM0
+#undef LPC_TIM1
+#undef LPC_TIM2
+#undef LPC_TIM3
+#undef LPC_UART2
+#undef LPC_UART3
+#undef LPC_I2C0
+#undef LPC_I2C1
+#undef LPC_I2C2
+#undef LPC_SPI
+#undef LPC_RTC
+#undef LPC_GPIOINT
+#undef LPC_PINCON
+
+#define LPC_SC (&shimSC)
+#define LPC_GPIO0 (&shimGPIO[0])
+#define LPC_GPIO1 (&shimGPIO[1])
+#define LPC_GPIO2 (&shimGPIO[2])
+#define LPC_GPIO3 (&shimGPIO[3])
+#define LPC_GPIO4 (&shimGPIO[4])
+#define LPC_TIM0 (&shimTIM[0])
+#define LPC_TIM1 (&shimTIM[1])
+#define LPC_TIM2 (&shimTIM[2])
+#define LPC_TIM3 (&shimTIM[3])
+#define LPC_UART2 (shimUART2Registers) // Accesses through a pointer, which WATCH sees (see shim.h)
+#define LPC_UART3 (&shimUART3)
+#define LPC_I2C0 (&shimI2C[0])
+#define LPC_I2C1 (SHIM_I2C1())
+#define LPC_I2C2 (&shimI2C[2])
+#define LPC_SPI (SHIM_SPI())
+#define LPC_RTC (&shimRTC)
+#define LPC_GPIOINT (&shimGPIOINT)
+#define LPC_PINCON (&shimPINCON)
+
+#endif /* SHIM_LPC17XX_H_ */
@@ -0,0 +1,13 @@
+/*
+ * cr_section_macros.h
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Host shim of the MCUXpresso section macros header: nothing is placed in a named section on the host.
+ */
+
+#ifndef SHIM_CR_SECTION_MACROS_H_
+#define SHIM_CR_SECTION_MACROS_H_
+
+#endif /* SHIM_CR_SECTION_MACROS_H_ */
@@ -0,0 +1,68 @@
+/*
+ * eeprom24.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  24LC32 EEPROM model on the I2C1 bus (see eeprom24.h).
+ */
+
+#include "eeprom24.h"
+
+#include <string.h>
+
+
+static bool SHIM_EEPROM_Addressed(SHIM_I2C_SLAVE *slave, bool read) {
+	SHIM_EEPROM *eeprom = (SHIM_EEPROM *) slave;
+	if (shimNs < eeprom->busyUntil) { // Writing a page: ignores the bus
+		eeprom->busyNacks++;
+		return false;
+	}
+	if (!read) eeprom->addressBytes = 0;
+	return true;
+}
+
+static bool SHIM_EEPROM_Write(SHIM_I2C_SLAVE *slave, uint8_t data) {
+	SHIM_EEPROM *eeprom = (SHIM_EEPROM *) slave;
+	if (eeprom->addressBytes < 2) { // Address high byte, then low byte
+		eeprom->pointer = ((eeprom->pointer << 8) | data) % SHIM_EEPROM_SIZE;
+		eeprom->addressBytes++;
+		return true;
+	}
+	uint32_t offset = eeprom->pointer % SHIM_EEPROM_PAGE;
+	eeprom->latch[offset] = data;
+	eeprom->latched |= 1UL << offset;
+	eeprom->pointer = eeprom->pointer - offset + (offset + 1) % SHIM_EEPROM_PAGE; // Rolls over within the page
+	return true;
+}
+
+static uint8_t SHIM_EEPROM_Read(SHIM_I2C_SLAVE *slave) {
+	SHIM_EEPROM *eeprom = (SHIM_EEPROM *) slave;
+	uint8_t data = eeprom->memory[eeprom->pointer];
+	eeprom->pointer = (eeprom->pointer + 1) % SHIM_EEPROM_SIZE;
+	return data;
+}
+
+static void SHIM_EEPROM_Stop(SHIM_I2C_SLAVE *slave) {
+	SHIM_EEPROM *eeprom = (SHIM_EEPROM *) slave;
+	if (eeprom->latched == 0) return; // Address only (or a read)
+
+	uint32_t page = eeprom->pointer - eeprom->pointer % SHIM_EEPROM_PAGE;
+	for (int i = 0; i < SHIM_EEPROM_PAGE; i++) {
+		if (eeprom->latched & (1UL << i)) eeprom->memory[page + i] = eeprom->latch[i];
+	}
+	eeprom->latched = 0;
+	eeprom->pageWrites++;
+	eeprom->busyUntil = shimNs + eeprom->writeCycleNs;
+}
+
+void SHIM_EEPROM_Attach(SHIM_EEPROM *eeprom, uint8_t address) {
+	memset(eeprom, 0, sizeof(SHIM_EEPROM));
+	memset(eeprom->memory, 0xFF, sizeof(eeprom->memory));
+	eeprom->slave.address = address;
+	eeprom->slave.addressed = SHIM_EEPROM_Addressed;
+	eeprom->slave.write = SHIM_EEPROM_Write;
+	eeprom->slave.read = SHIM_EEPROM_Read;
+	eeprom->slave.stop = SHIM_EEPROM_Stop;
+	SHIM_I2CAttach(&eeprom->slave);
+}
@@ -0,0 +1,44 @@
+/*
+ * eeprom24.h
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Model of a 24LC32 EEPROM on the I2C1 bus (shim.h): 4 KB, 32-byte pages, two address bytes. A write sets the
+ *  address pointer, and latches the data that follows into the page, rolling over within it. The page is written
+ *  at STOP. Reads continue from the address pointer, across pages.
+ *
+ *  Writing the page takes writeCycleNs of virtual time (shimNs), during which the EEPROM doesn't acknowledge its
+ *  address: the master has to poll it (acknowledge polling) until it does.
+ */
+
+#ifndef SHIM_EEPROM24_H_
+#define SHIM_EEPROM24_H_
+
+#include "shim.h"
+
+
+#define SHIM_EEPROM_SIZE 4096
+#define SHIM_EEPROM_PAGE 32
+
+typedef struct {
+	SHIM_I2C_SLAVE slave; // First: callbacks get the model back
+	uint8_t memory[SHIM_EEPROM_SIZE];
+	uint32_t pointer; // Address pointer
+	int addressBytes; // Address bytes received since SLA + W
+	uint8_t latch[SHIM_EEPROM_PAGE]; // Page being written
+	uint32_t latched; // Bit per latched byte of the page
+	uint32_t pageWrites; // Pages written (at STOP)
+	uint64_t writeCycleNs; // Time a page write takes (0 by default)
+	uint64_t busyUntil; // End of the write cycle (shimNs)
+	uint32_t busyNacks; // Addresses not acknowledged during write cycles
+} SHIM_EEPROM;
+
+/**
+ * @brief	Erases the EEPROM (0xFF) and puts it on the I2C1 bus.
+ * @param	eeprom: -> Model.
+ * @param	address: -> 7-bit address.
+ */
+void SHIM_EEPROM_Attach(SHIM_EEPROM *eeprom, uint8_t address);
+
+#endif /* SHIM_EEPROM24_H_ */
@@ -0,0 +1,142 @@
+/*
+ * freertos.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Host shim of the FreeRTOS kernel calls used by the code under test (see portmacro.h). Single threaded: created
+ *  tasks never run, and queues and semaphores never block (an empty queue or taken semaphore fails at once). Delays
+ *  only move the tick count on (calling shimSleep, see shim.h).
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "shim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct QueueDefinition { // Handles are opaque: any definition will do
+	UBaseType_t length;
+	UBaseType_t itemSize; // 0 for semaphores
+	UBaseType_t count;
+	UBaseType_t head;
+	uint8_t *items;
+} SHIM_QUEUE;
+
+typedef struct tskTaskControlBlock {
+	TaskFunction_t function;
+	const char *name;
+} SHIM_TASK;
+
+static TickType_t ticks;
+
+void (*shimSleep)(uint32_t ticks);
+
+
+static QueueHandle_t SHIM_QueueCreate(UBaseType_t length, UBaseType_t itemSize, UBaseType_t count) {
+	SHIM_QUEUE *queue = calloc(1, sizeof(SHIM_QUEUE));
+	queue->length = length;
+	queue->itemSize = itemSize;
+	queue->count = count;
+	queue->items = (itemSize > 0) ? calloc(length, itemSize) : NULL;
+	return queue;
+}
+
+QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType) {
+	return SHIM_QueueCreate(uxQueueLength, uxItemSize, 0);
+}
+
+QueueHandle_t xQueueGenericCreateStatic(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize,
+		uint8_t *pucQueueStorage, StaticQueue_t *pxStaticQueue, const uint8_t ucQueueType) {
+	return SHIM_QueueCreate(uxQueueLength, uxItemSize, 0);
+}
+
+QueueHandle_t xQueueCreateMutex(const uint8_t ucQueueType) {
+	return SHIM_QueueCreate(1, 0, 1);
+}
+
+QueueHandle_t xQueueCreateMutexStatic(const uint8_t ucQueueType, StaticQueue_t *pxStaticQueue) {
+	return SHIM_QueueCreate(1, 0, 1);
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition) {
+	if ((xQueue == NULL) || (xQueue->count >= xQueue->length)) return errQUEUE_FULL;
+	if (xQueue->itemSize > 0) {
+		UBaseType_t tail = (xQueue->head + xQueue->count) % xQueue->length;
+		memcpy(xQueue->items + tail * xQueue->itemSize, pvItemToQueue, xQueue->itemSize);
+	}
+	xQueue->count++;
+	return pdPASS;
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition) {
+	if (pxHigherPriorityTaskWoken != NULL) *pxHigherPriorityTaskWoken = pdFALSE;
+	return xQueueGenericSend(xQueue, pvItemToQueue, 0, xCopyPosition);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait) {
+	if ((xQueue == NULL) || (xQueue->count == 0)) return errQUEUE_EMPTY;
+	if (xQueue->itemSize > 0) {
+		memcpy(pvBuffer, xQueue->items + xQueue->head * xQueue->itemSize, xQueue->itemSize);
+		xQueue->head = (xQueue->head + 1) % xQueue->length;
+	}
+	xQueue->count--;
+	return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue) {
+	return xQueue->count;
+}
+
+BaseType_t xQueueSemaphoreTake(QueueHandle_t xQueue, TickType_t xTicksToWait) {
+	if (xQueue == NULL) return pdTRUE; // Not created (e.g. the test skipped the init): nothing to take
+	if (xQueue->count == 0) return pdFALSE;
+	xQueue->count--;
+	return pdTRUE;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, const configSTACK_DEPTH_TYPE usStackDepth,
+		void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask) {
+	SHIM_TASK *task = calloc(1, sizeof(SHIM_TASK));
+	task->function = pxTaskCode;
+	task->name = pcName;
+	if (pxCreatedTask != NULL) *pxCreatedTask = task;
+	return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char * const pcName, const uint32_t ulStackDepth,
+		void * const pvParameters, UBaseType_t uxPriority, StackType_t * const puxStackBuffer, StaticTask_t * const pxTaskBuffer) {
+	TaskHandle_t task;
+	xTaskCreate(pxTaskCode, pcName, 0, pvParameters, uxPriority, &task);
+	return task;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+	ticks += xTicksToDelay;
+	if (shimSleep != NULL) shimSleep(xTicksToDelay);
+}
+
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement) {
+	*pxPreviousWakeTime += xTimeIncrement;
+	if ((int32_t) (*pxPreviousWakeTime - ticks) > 0) vTaskDelay(*pxPreviousWakeTime - ticks); // Late: at once
+}
+
+TickType_t xTaskGetTickCount(void) {
+	return ticks;
+}
+
+void *pvPortMalloc(size_t xSize) {
+	return malloc(xSize);
+}
+
+void vPortFree(void *pv) {
+	free(pv);
+}
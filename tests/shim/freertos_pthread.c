@@ -0,0 +1,300 @@
+/*
+ * freertos_pthread.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Host shim of the FreeRTOS kernel calls used by the code under test (see portmacro.h), on POSIX threads: each task
+ *  is a thread, and queues, semaphores and notifications block. Priorities are ignored, so tasks run truly in
+ *  parallel, a harsher schedule than the target's. A tick is shimTickNs of host time (see shim.h). In place of
+ *  freertos.c, for tests of code shared between tasks.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "shim.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+typedef struct QueueDefinition { // Handles are opaque: any definition will do
+	UBaseType_t length;
+	UBaseType_t itemSize; // 0 for semaphores
+	UBaseType_t count;
+	UBaseType_t head;
+	uint8_t *items;
+	pthread_cond_t changed; // Item sent or received
+} SHIM_QUEUE;
+
+typedef struct tskTaskControlBlock {
+	pthread_t thread;
+	TaskFunction_t function;
+	void *parameters;
+	const char *name;
+	uint32_t notification;
+	pthread_cond_t notified;
+} SHIM_TASK;
+
+uint32_t shimTickNs = 1000000; // 1 ms, as configTICK_RATE_HZ
+
+static pthread_mutex_t kernel = PTHREAD_MUTEX_INITIALIZER; // Guards every queue and task
+static pthread_once_t started = PTHREAD_ONCE_INIT;
+static struct timespec epoch; // Tick 0
+
+static __thread SHIM_TASK *current; // NULL on threads not created by xTaskCreate()
+
+
+static void SHIM_Start(void) {
+	clock_gettime(CLOCK_MONOTONIC, &epoch);
+}
+
+static uint64_t SHIM_ElapsedNs(void) {
+	struct timespec now;
+	pthread_once(&started, SHIM_Start);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) (now.tv_sec - epoch.tv_sec) * 1000000000 + now.tv_nsec - epoch.tv_nsec;
+}
+
+static void SHIM_CondInit(pthread_cond_t *cond) {
+	pthread_condattr_t attributes;
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attributes);
+	pthread_condattr_destroy(&attributes);
+}
+
+/*
+ * Waits on cond (kernel held) until signalled or deadline (host ns since tick 0). Returns false on timeout.
+ */
+static bool SHIM_Wait(pthread_cond_t *cond, TickType_t ticksToWait, uint64_t deadline) {
+	if (ticksToWait == 0) return false;
+	if (ticksToWait == portMAX_DELAY) return pthread_cond_wait(cond, &kernel) == 0;
+
+	uint64_t at = (uint64_t) epoch.tv_sec * 1000000000 + epoch.tv_nsec + deadline;
+	struct timespec until = {.tv_sec = at / 1000000000, .tv_nsec = at % 1000000000};
+	return pthread_cond_timedwait(cond, &kernel, &until) == 0;
+}
+
+static uint64_t SHIM_Deadline(TickType_t ticksToWait) {
+	return SHIM_ElapsedNs() + (uint64_t) ticksToWait * shimTickNs;
+}
+
+static void SHIM_SleepUntil(uint64_t deadline) {
+	uint64_t at = (uint64_t) epoch.tv_sec * 1000000000 + epoch.tv_nsec + deadline;
+	struct timespec until = {.tv_sec = at / 1000000000, .tv_nsec = at % 1000000000};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) != 0);
+}
+
+static QueueHandle_t SHIM_QueueCreate(UBaseType_t length, UBaseType_t itemSize, UBaseType_t count) {
+	SHIM_QUEUE *queue = calloc(1, sizeof(SHIM_QUEUE));
+	queue->length = length;
+	queue->itemSize = itemSize;
+	queue->count = count;
+	queue->items = (itemSize > 0) ? calloc(length, itemSize) : NULL;
+	SHIM_CondInit(&queue->changed);
+	pthread_once(&started, SHIM_Start);
+	return queue;
+}
+
+QueueHandle_t xQueueGenericCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, const uint8_t ucQueueType) {
+	return SHIM_QueueCreate(uxQueueLength, uxItemSize, 0);
+}
+
+QueueHandle_t xQueueGenericCreateStatic(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize,
+		uint8_t *pucQueueStorage, StaticQueue_t *pxStaticQueue, const uint8_t ucQueueType) {
+	return SHIM_QueueCreate(uxQueueLength, uxItemSize, 0);
+}
+
+QueueHandle_t xQueueCreateMutex(const uint8_t ucQueueType) {
+	return SHIM_QueueCreate(1, 0, 1);
+}
+
+QueueHandle_t xQueueCreateMutexStatic(const uint8_t ucQueueType, StaticQueue_t *pxStaticQueue) {
+	return SHIM_QueueCreate(1, 0, 1);
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait, const BaseType_t xCopyPosition) {
+	if (xQueue == NULL) return errQUEUE_FULL;
+	uint64_t deadline = SHIM_Deadline(xTicksToWait);
+
+	pthread_mutex_lock(&kernel);
+	if (xCopyPosition == queueOVERWRITE) xQueue->count = 0; // Queues of length 1 only
+	while (xQueue->count >= xQueue->length) {
+		if (!SHIM_Wait(&xQueue->changed, xTicksToWait, deadline) && (xQueue->count >= xQueue->length)) {
+			pthread_mutex_unlock(&kernel);
+			return errQUEUE_FULL;
+		}
+	}
+	if (xQueue->itemSize > 0) {
+		UBaseType_t tail = (xQueue->head + xQueue->count) % xQueue->length;
+		memcpy(xQueue->items + tail * xQueue->itemSize, pvItemToQueue, xQueue->itemSize);
+	}
+	xQueue->count++;
+	pthread_cond_broadcast(&xQueue->changed);
+	pthread_mutex_unlock(&kernel);
+	return pdPASS;
+}
+
+BaseType_t xQueueGenericSendFromISR(QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition) {
+	if (pxHigherPriorityTaskWoken != NULL) *pxHigherPriorityTaskWoken = pdFALSE;
+	return xQueueGenericSend(xQueue, pvItemToQueue, 0, xCopyPosition);
+}
+
+static BaseType_t SHIM_QueueTake(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait, bool remove) {
+	if (xQueue == NULL) return errQUEUE_EMPTY;
+	uint64_t deadline = SHIM_Deadline(xTicksToWait);
+
+	pthread_mutex_lock(&kernel);
+	while (xQueue->count == 0) {
+		if (!SHIM_Wait(&xQueue->changed, xTicksToWait, deadline) && (xQueue->count == 0)) {
+			pthread_mutex_unlock(&kernel);
+			return errQUEUE_EMPTY;
+		}
+	}
+	if (xQueue->itemSize > 0) memcpy(pvBuffer, xQueue->items + xQueue->head * xQueue->itemSize, xQueue->itemSize);
+	if (remove) {
+		xQueue->head = (xQueue->head + 1) % xQueue->length;
+		xQueue->count--;
+		pthread_cond_broadcast(&xQueue->changed);
+	}
+	pthread_mutex_unlock(&kernel);
+	return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait) {
+	return SHIM_QueueTake(xQueue, pvBuffer, xTicksToWait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait) {
+	return SHIM_QueueTake(xQueue, pvBuffer, xTicksToWait, false);
+}
+
+BaseType_t xQueueSemaphoreTake(QueueHandle_t xQueue, TickType_t xTicksToWait) {
+	if (xQueue == NULL) return pdTRUE; // Not created (e.g. the test skipped the init): nothing to take
+	return SHIM_QueueTake(xQueue, NULL, xTicksToWait, true);
+}
+
+BaseType_t xQueueGenericReset(QueueHandle_t xQueue, BaseType_t xNewQueue) {
+	pthread_mutex_lock(&kernel);
+	xQueue->count = 0;
+	xQueue->head = 0;
+	pthread_cond_broadcast(&xQueue->changed);
+	pthread_mutex_unlock(&kernel);
+	return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue) {
+	pthread_mutex_lock(&kernel);
+	UBaseType_t count = xQueue->count;
+	pthread_mutex_unlock(&kernel);
+	return count;
+}
+
+static void *SHIM_TaskRun(void *task) {
+	current = task;
+	current->function(current->parameters);
+	return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName, const configSTACK_DEPTH_TYPE usStackDepth,
+		void * const pvParameters, UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask) {
+	SHIM_TASK *task = calloc(1, sizeof(SHIM_TASK));
+	task->function = pxTaskCode;
+	task->parameters = pvParameters;
+	task->name = pcName;
+	SHIM_CondInit(&task->notified);
+	pthread_once(&started, SHIM_Start);
+	if (pthread_create(&task->thread, NULL, SHIM_TaskRun, task) != 0) {
+		free(task);
+		return errCOULD_NOT_ALLOCATE_REQUIRED_MEMORY;
+	}
+	pthread_detach(task->thread);
+	if (pxCreatedTask != NULL) *pxCreatedTask = task;
+	return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char * const pcName, const uint32_t ulStackDepth,
+		void * const pvParameters, UBaseType_t uxPriority, StackType_t * const puxStackBuffer, StaticTask_t * const pxTaskBuffer) {
+	TaskHandle_t task = NULL;
+	xTaskCreate(pxTaskCode, pcName, 0, pvParameters, uxPriority, &task);
+	return task;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+	if ((xTaskToDelete == NULL) && (current != NULL)) pthread_exit(NULL); // Other tasks are not stopped
+}
+
+void vTaskStartScheduler(void) {
+	for (;;) pause(); // Tasks already run
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+	SHIM_SleepUntil(SHIM_Deadline(xTicksToDelay));
+}
+
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement) {
+	*pxPreviousWakeTime += xTimeIncrement;
+	SHIM_SleepUntil((uint64_t) *pxPreviousWakeTime * shimTickNs); // Late: at once
+}
+
+TickType_t xTaskGetTickCount(void) {
+	return (TickType_t) (SHIM_ElapsedNs() / shimTickNs);
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue) {
+	pthread_mutex_lock(&kernel);
+	if (pulPreviousNotificationValue != NULL) *pulPreviousNotificationValue = xTaskToNotify->notification;
+	switch (eAction) {
+		case eSetBits:
+			xTaskToNotify->notification |= ulValue;
+			break;
+		case eIncrement:
+			xTaskToNotify->notification++;
+			break;
+		case eSetValueWithOverwrite:
+		case eSetValueWithoutOverwrite: // Overwrites too: no pending state is kept
+			xTaskToNotify->notification = ulValue;
+			break;
+		default:
+			break;
+	}
+	pthread_cond_broadcast(&xTaskToNotify->notified);
+	pthread_mutex_unlock(&kernel);
+	return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken) {
+	if (pxHigherPriorityTaskWoken != NULL) *pxHigherPriorityTaskWoken = pdFALSE;
+	xTaskGenericNotify(xTaskToNotify, 0, eIncrement, NULL);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+	uint64_t deadline = SHIM_Deadline(xTicksToWait);
+
+	pthread_mutex_lock(&kernel);
+	while ((current->notification == 0) && SHIM_Wait(&current->notified, xTicksToWait, deadline));
+	uint32_t value = current->notification;
+	if (value != 0) current->notification = xClearCountOnExit ? 0 : value - 1;
+	pthread_mutex_unlock(&kernel);
+	return value;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime) {
+	if (pulTotalRunTime != NULL) *pulTotalRunTime = 0;
+	return 0; // No stack usage to report
+}
+
+void *pvPortMalloc(size_t xSize) {
+	return malloc(xSize);
+}
+
+void vPortFree(void *pv) {
+	free(pv);
+}
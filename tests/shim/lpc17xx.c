@@ -0,0 +1,744 @@
+/*
+ * lpc17xx.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Host shim of the LPC1769 core and peripherals (see LPC17xx.h and shim.h).
+ */
+
+#include "shim.h"
+
+#include <stddef.h>
+#include <string.h>
+
+
+#define SHIM_IRQS 35 // WDT_IRQn to CANActivity_IRQn
+
+#define WEAK __attribute__ ((weak))
+
+WEAK void SysTick_Handler(void);
+WEAK void WDT_IRQHandler(void);
+WEAK void TIMER0_IRQHandler(void);
+WEAK void TIMER1_IRQHandler(void);
+WEAK void TIMER2_IRQHandler(void);
+WEAK void TIMER3_IRQHandler(void);
+WEAK void UART0_IRQHandler(void);
+WEAK void UART1_IRQHandler(void);
+WEAK void UART2_IRQHandler(void);
+WEAK void UART3_IRQHandler(void);
+WEAK void PWM1_IRQHandler(void);
+WEAK void I2C0_IRQHandler(void);
+WEAK void I2C1_IRQHandler(void);
+WEAK void I2C2_IRQHandler(void);
+WEAK void SPI_IRQHandler(void);
+WEAK void SSP0_IRQHandler(void);
+WEAK void SSP1_IRQHandler(void);
+WEAK void PLL0_IRQHandler(void);
+WEAK void RTC_IRQHandler(void);
+WEAK void EINT0_IRQHandler(void);
+WEAK void EINT1_IRQHandler(void);
+WEAK void EINT2_IRQHandler(void);
+WEAK void EINT3_IRQHandler(void);
+WEAK void ADC_IRQHandler(void);
+WEAK void BOD_IRQHandler(void);
+WEAK void USB_IRQHandler(void);
+WEAK void CAN_IRQHandler(void);
+WEAK void DMA_IRQHandler(void);
+WEAK void I2S_IRQHandler(void);
+WEAK void ENET_IRQHandler(void);
+WEAK void RIT_IRQHandler(void);
+WEAK void MCPWM_IRQHandler(void);
+WEAK void QEI_IRQHandler(void);
+WEAK void PLL1_IRQHandler(void);
+WEAK void USBActivity_IRQHandler(void);
+WEAK void CANActivity_IRQHandler(void);
+
+static void (* const vectors[SHIM_IRQS])(void) = { // NULL if the test does not link the handler
+	WDT_IRQHandler, TIMER0_IRQHandler, TIMER1_IRQHandler, TIMER2_IRQHandler, TIMER3_IRQHandler,
+	UART0_IRQHandler, UART1_IRQHandler, UART2_IRQHandler, UART3_IRQHandler, PWM1_IRQHandler,
+	I2C0_IRQHandler, I2C1_IRQHandler, I2C2_IRQHandler, SPI_IRQHandler, SSP0_IRQHandler, SSP1_IRQHandler,
+	PLL0_IRQHandler, RTC_IRQHandler, EINT0_IRQHandler, EINT1_IRQHandler, EINT2_IRQHandler, EINT3_IRQHandler,
+	ADC_IRQHandler, BOD_IRQHandler, USB_IRQHandler, CAN_IRQHandler, DMA_IRQHandler, I2S_IRQHandler,
+	ENET_IRQHandler, RIT_IRQHandler, MCPWM_IRQHandler, QEI_IRQHandler, PLL1_IRQHandler,
+	USBActivity_IRQHandler, CANActivity_IRQHandler
+};
+
+NVIC_Type shimNVIC;
+SysTick_Type shimSysTick;
+SCB_Type shimSCB;
+CoreDebug_Type shimCoreDebug;
+DWT_Type shimDWT;
+
+LPC_SC_TypeDef shimSC;
+LPC_GPIO_TypeDef shimGPIO[5];
+LPC_TIM_TypeDef shimTIM[4];
+LPC_UART_TypeDef shimUART2;
+LPC_UART_TypeDef *const shimUART2Registers = &shimUART2;
+LPC_UART_TypeDef shimUART3;
+LPC_I2C_TypeDef shimI2C[3];
+LPC_SPI_TypeDef shimSPI;
+LPC_RTC_TypeDef shimRTC;
+LPC_GPIOINT_TypeDef shimGPIOINT;
+LPC_PINCON_TypeDef shimPINCON;
+
+uint32_t SystemCoreClock = 100000000;
+
+void (*shimIdle)(void);
+
+SHIM_I2C_BUS shimI2C1Bus;
+uint64_t shimNs;
+
+SHIM_UART_LINE shimUART2Line;
+
+SHIM_IAP_CALL shimIAPCalls[SHIM_IAP_CALLS];
+uint32_t shimIAPCount;
+uint32_t shimIAPBusy;
+
+static uint32_t nvicEnabled[2]; // Interrupts enabled: ISER, as written through ISER and ICER
+static uint32_t primask;
+static uint32_t basepri;
+static bool handling; // A handler is running (no nesting)
+static bool sysTickPending;
+
+#define BIT(IRQn) (1UL << ((uint32_t) (IRQn) & 0x1F))
+#define WORD(IRQn) ((uint32_t) (IRQn) >> 5)
+
+#define I2C_AA (1 << 2) // I2CON bits
+#define I2C_SI (1 << 3)
+#define I2C_STO (1 << 4)
+#define I2C_STA (1 << 5)
+#define I2C_I2EN (1 << 6)
+
+#define I2C_DAT_UNWRITTEN 0xA5A5A500 // Upper bits of I2DAT as SHIM_I2C1() hands it out: a write clears them
+
+typedef enum {
+	I2C_BUS_IDLE, // No START
+	I2C_BUS_START, // START sent, waiting for SLA + R/W in I2DAT
+	I2C_BUS_WRITE, // Slave addressed for write
+	I2C_BUS_READ, // Slave addressed for read
+	I2C_BUS_WAIT // NACKed, or last byte read: nothing but STOP or START
+} I2C_BUS_STATE;
+
+static uint32_t i2cControl; // I2CON
+static uint32_t i2cStatus = 0xF8; // I2STAT
+static uint32_t i2cData; // I2DAT
+static bool i2cDataWritten; // I2DAT holds a byte for the bus
+static I2C_BUS_STATE i2cBus;
+static SHIM_I2C_SLAVE *i2cSlaves[SHIM_I2C_SLAVES];
+static SHIM_I2C_SLAVE *i2cSlave; // Acknowledged its address since the last STOP
+
+#define SPI_DAT_UNWRITTEN 0xA5A50000 // Upper bits of SPDR as SHIM_SPI() hands it out: a write clears them
+#define SPI_SPIF (1 << 7)
+
+static uint32_t dwtCount; // CYCCNT as SHIM_DWT() last handed it out
+static uint32_t dwtBase; // CYCCNT written (or when stopped)
+static uint64_t dwtBaseNs; // shimNs then
+
+#define UART_FIFO 16
+#define UART_LCR_DLAB (1 << 7)
+#define UART_TER_TXEN (1 << 7)
+#define UART_NO_WRITE (-1)
+
+static uint8_t uartRx[UART_FIFO]; // RX FIFO, oldest first
+static uint32_t uartRxCount;
+static uint8_t uartTx[UART_FIFO];
+static uint32_t uartTxCount;
+static uint8_t uartDll, uartDlm; // Behind RBR/THR and IER while DLAB is set
+static uint32_t uartIer;
+static uint32_t uartTrigger = 1; // RX trigger level (FCR)
+static bool uartFifos; // FCR FIFO enable
+static bool uartThre; // THRE interrupt due (until IIR is read with it, or THR written)
+static bool uartOverrun; // LSR OE
+static int uartWrite = UART_NO_WRITE; // Offset of the register written by the last access, still to apply
+
+static uint32_t iapPrepared; // Sectors prepared for the next erase or copy
+
+
+void SHIM_Reset(void) {
+	memset((void *) &shimNVIC, 0, sizeof(shimNVIC));
+	memset(nvicEnabled, 0, sizeof(nvicEnabled));
+	memset((void *) &shimSysTick, 0, sizeof(shimSysTick));
+	memset((void *) &shimSCB, 0, sizeof(shimSCB));
+	memset((void *) &shimCoreDebug, 0, sizeof(shimCoreDebug));
+	memset((void *) &shimDWT, 0, sizeof(shimDWT));
+	memset((void *) &shimSC, 0, sizeof(shimSC));
+	memset((void *) shimGPIO, 0, sizeof(shimGPIO));
+	memset((void *) shimTIM, 0, sizeof(shimTIM));
+	memset((void *) &shimUART2, 0, sizeof(shimUART2));
+	memset((void *) &shimUART3, 0, sizeof(shimUART3));
+	memset((void *) shimI2C, 0, sizeof(shimI2C));
+	memset((void *) &shimSPI, 0, sizeof(shimSPI));
+	memset((void *) &shimRTC, 0, sizeof(shimRTC));
+	memset((void *) &shimGPIOINT, 0, sizeof(shimGPIOINT));
+	memset((void *) &shimPINCON, 0, sizeof(shimPINCON));
+	SystemCoreClock = 100000000;
+	shimIdle = NULL;
+	primask = 0;
+	basepri = 0;
+	handling = false;
+	sysTickPending = false;
+
+	memset(&shimI2C1Bus, 0, sizeof(shimI2C1Bus));
+	memset(i2cSlaves, 0, sizeof(i2cSlaves));
+	shimNs = 0;
+	i2cControl = 0;
+	i2cStatus = 0xF8;
+	i2cData = 0;
+	i2cDataWritten = false;
+	i2cBus = I2C_BUS_IDLE;
+	i2cSlave = NULL;
+	shimI2C[1].I2DAT = I2C_DAT_UNWRITTEN;
+	shimI2C[1].I2STAT = i2cStatus;
+
+	shimSPI.SPDR = SPI_DAT_UNWRITTEN | 0xFF;
+	dwtCount = 0;
+	dwtBase = 0;
+	dwtBaseNs = 0;
+
+	memset(&shimUART2Line, 0, sizeof(shimUART2Line));
+	uartRxCount = 0;
+	uartTxCount = 0;
+	uartDll = 0;
+	uartDlm = 0;
+	uartIer = 0;
+	uartTrigger = 1;
+	uartFifos = false;
+	uartThre = false;
+	uartOverrun = false;
+	uartWrite = UART_NO_WRITE;
+
+	memset(shimIAPCalls, 0, sizeof(shimIAPCalls));
+	shimIAPCount = 0;
+	shimIAPBusy = 0;
+	iapPrepared = 0;
+}
+
+static void SHIM_I2CFlush(void);
+static void SHIM_UARTFlush(void);
+
+static void SHIM_NVICFlush(void) { // Applies the last write to ISER or ICER, as set and clear registers
+	for (int word = 0; word < 2; word++) {
+		if (shimNVIC.ICER[word] != 0) nvicEnabled[word] &= ~shimNVIC.ICER[word];
+		else nvicEnabled[word] |= shimNVIC.ISER[word];
+		shimNVIC.ICER[word] = 0;
+		shimNVIC.ISER[word] = nvicEnabled[word];
+	}
+}
+
+NVIC_Type *SHIM_NVIC(void) {
+	SHIM_NVICFlush();
+	return &shimNVIC;
+}
+
+void SHIM_Dispatch(void) {
+	bool ran = true;
+	while (ran && (primask == 0) && !handling) {
+		SHIM_NVICFlush();
+		SHIM_I2CFlush(); // Last register write of a handler (or task): the bus may move on
+		SHIM_UARTFlush();
+		ran = false;
+		if (sysTickPending && (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk)) {
+			sysTickPending = false;
+			handling = true;
+			if (SysTick_Handler != NULL) SysTick_Handler();
+			handling = false;
+			ran = true;
+			continue;
+		}
+		for (int irq = 0; irq < SHIM_IRQS; irq++) {
+			if ((shimNVIC.ISPR[WORD(irq)] & nvicEnabled[WORD(irq)] & BIT(irq)) == 0) continue;
+			shimNVIC.ISPR[WORD(irq)] &= ~BIT(irq);
+			handling = true;
+			if (vectors[irq] != NULL) vectors[irq]();
+			handling = false;
+			ran = true;
+			break; // Lowest number first, again
+		}
+	}
+}
+
+void SHIM_Raise(IRQn_Type IRQn) {
+	if (IRQn == SysTick_IRQn) sysTickPending = true;
+	else if (IRQn >= 0) shimNVIC.ISPR[WORD(IRQn)] |= BIT(IRQn);
+	SHIM_Dispatch();
+}
+
+void SHIM_TimerAdvance(LPC_TIM_TypeDef *timer, uint32_t counts) {
+	static const IRQn_Type irqs[] = {TIMER0_IRQn, TIMER1_IRQn, TIMER2_IRQn, TIMER3_IRQn};
+	IRQn_Type irq = irqs[timer - shimTIM];
+
+	while (counts > 0) {
+		if ((timer->TCR & 0x03) != 0x01) return; // Disabled, or held in reset
+
+		uint32_t toMatch = timer->MR0 - timer->TC; // 0: a whole wrap around away
+		if ((toMatch == 0) || (toMatch > counts)) {
+			timer->TC += counts;
+			return;
+		}
+		timer->TC += toMatch;
+		counts -= toMatch;
+
+		if (timer->MCR & 0x02) timer->TC = 0; // Reset on match
+		if (timer->MCR & 0x04) timer->TCR &= ~0x01; // Stop on match
+		if (timer->MCR & 0x01) { // Interrupt on match
+			timer->IR |= 0x01;
+			SHIM_Raise(irq);
+		}
+	}
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn) {
+	SHIM_NVICFlush();
+	nvicEnabled[WORD(IRQn)] |= BIT(IRQn);
+	shimNVIC.ISER[WORD(IRQn)] = nvicEnabled[WORD(IRQn)];
+	SHIM_Dispatch();
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn) {
+	SHIM_NVICFlush();
+	nvicEnabled[WORD(IRQn)] &= ~BIT(IRQn);
+	shimNVIC.ISER[WORD(IRQn)] = nvicEnabled[WORD(IRQn)];
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn) {
+	SHIM_Raise(IRQn);
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn) {
+	shimNVIC.ISPR[WORD(IRQn)] &= ~BIT(IRQn);
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn) {
+	return (shimNVIC.ISPR[WORD(IRQn)] & BIT(IRQn)) ? 1 : 0;
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority) {
+	if (IRQn >= 0) NVIC->IP[IRQn] = (uint8_t) (priority << (8 - __NVIC_PRIO_BITS));
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type IRQn) {
+	return (IRQn >= 0) ? (NVIC->IP[IRQn] >> (8 - __NVIC_PRIO_BITS)) : 0;
+}
+
+uint32_t SysTick_Config(uint32_t ticks) {
+	if ((ticks - 1) > 0xFFFFFF) return 1;
+	SysTick->LOAD = ticks - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+	return 0;
+}
+
+void __enable_irq(void) {
+	primask = 0;
+	SHIM_Dispatch();
+}
+
+void __disable_irq(void) {
+	primask = 1;
+}
+
+uint32_t __get_PRIMASK(void) {
+	return primask;
+}
+
+void __set_PRIMASK(uint32_t priMask) {
+	primask = priMask;
+	SHIM_Dispatch();
+}
+
+uint32_t __get_BASEPRI(void) {
+	return basepri;
+}
+
+void __set_BASEPRI(uint32_t basePri) { // Only recorded: interrupts have no priorities here
+	basepri = basePri;
+}
+
+DWT_Type *SHIM_DWT(void) { // Applies a write to CYCCNT (a value other than the one handed out), and counts
+	if ((shimDWT.CYCCNT != dwtCount) || !(shimDWT.CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+		dwtBase = shimDWT.CYCCNT;
+		dwtBaseNs = shimNs;
+	}
+	dwtCount = dwtBase + (uint32_t) ((shimNs - dwtBaseNs) * (SystemCoreClock / 1000000) / 1000);
+	shimDWT.CYCCNT = dwtCount;
+	return &shimDWT;
+}
+
+void __WFI(void) {
+	SHIM_Dispatch();
+	if (shimIdle != NULL) shimIdle();
+}
+
+void SystemInit(void) {
+}
+
+void SystemCoreClockUpdate(void) { // SystemCoreClock is whatever the test set
+}
+
+
+/*
+ * I2C1 bus:
+ */
+
+static void SHIM_I2CBits(uint32_t bits) { // Virtual time of some SCL periods
+	uint32_t scl = shimI2C[1].I2SCLH + shimI2C[1].I2SCLL; // PCLK counts per period
+	if (scl == 0) scl = 250; // Not set yet: 100 kHz
+	shimNs += (uint64_t) bits * scl * 1000000000 / (SystemCoreClock / 4);
+}
+
+static void SHIM_I2CInterrupt(uint32_t status) {
+	i2cStatus = status;
+	i2cControl |= I2C_SI;
+	shimNVIC.ISPR[WORD(I2C1_IRQn)] |= BIT(I2C1_IRQn); // Level: pending until SI is cleared
+}
+
+static void SHIM_I2CAddress(void) { // SLA + R/W in I2DAT
+	bool read = i2cData & 1;
+	SHIM_I2C_SLAVE *slave = NULL;
+
+	shimI2C1Bus.bytes++;
+	SHIM_I2CBits(9);
+	for (int i = 0; i < SHIM_I2C_SLAVES; i++) {
+		if ((i2cSlaves[i] != NULL) && (i2cSlaves[i]->address == (i2cData >> 1))) slave = i2cSlaves[i];
+	}
+	if ((slave == NULL) || ((slave->addressed != NULL) && !slave->addressed(slave, read))) {
+		shimI2C1Bus.nacks++;
+		i2cBus = I2C_BUS_WAIT;
+		SHIM_I2CInterrupt(read ? 0x48 : 0x20); // SLA + R or SLA + W, NACK
+		return;
+	}
+	i2cSlave = slave;
+	i2cBus = read ? I2C_BUS_READ : I2C_BUS_WRITE;
+	SHIM_I2CInterrupt(read ? 0x40 : 0x18);
+}
+
+static void SHIM_I2CStep(void) { // Does what the control bits ask, until SI is set again
+	while (((i2cControl & (I2C_I2EN | I2C_SI)) == I2C_I2EN) && !shimI2C1Bus.hold) {
+		if (i2cControl & I2C_STO) {
+			i2cControl &= ~I2C_STO; // Cleared by hardware once STOP is out
+			if (i2cBus != I2C_BUS_IDLE) {
+				shimI2C1Bus.stops++;
+				SHIM_I2CBits(1);
+				if ((i2cSlave != NULL) && (i2cSlave->stop != NULL)) i2cSlave->stop(i2cSlave);
+				i2cSlave = NULL;
+				i2cBus = I2C_BUS_IDLE;
+			}
+			continue;
+		}
+		if (i2cControl & I2C_STA) {
+			uint32_t status = (i2cBus == I2C_BUS_IDLE) ? 0x08 : 0x10; // START, repeated START
+			shimI2C1Bus.starts++;
+			SHIM_I2CBits(1);
+			i2cBus = I2C_BUS_START;
+			i2cDataWritten = false;
+			SHIM_I2CInterrupt(status);
+			return;
+		}
+		switch (i2cBus) {
+			case I2C_BUS_START:
+				if (!i2cDataWritten) return;
+				i2cDataWritten = false;
+				SHIM_I2CAddress();
+				return;
+
+			case I2C_BUS_WRITE:
+				if (!i2cDataWritten) return;
+				i2cDataWritten = false;
+				shimI2C1Bus.bytes++;
+				SHIM_I2CBits(9);
+				if ((i2cSlave->write != NULL) && !i2cSlave->write(i2cSlave, i2cData)) {
+					i2cBus = I2C_BUS_WAIT;
+					SHIM_I2CInterrupt(0x30); // Data, NACK
+					return;
+				}
+				SHIM_I2CInterrupt(0x28);
+				return;
+
+			case I2C_BUS_READ:
+				shimI2C1Bus.bytes++;
+				SHIM_I2CBits(9);
+				i2cData = (i2cSlave->read != NULL) ? i2cSlave->read(i2cSlave) : 0xFF;
+				if ((i2cControl & I2C_AA) == 0) { // Master NACKs the last byte
+					i2cBus = I2C_BUS_WAIT;
+					SHIM_I2CInterrupt(0x58);
+					return;
+				}
+				SHIM_I2CInterrupt(0x50);
+				return;
+
+			default:
+				return;
+		}
+	}
+}
+
+static void SHIM_I2CFlush(void) { // Applies the last register access, then lets the bus move on
+	LPC_I2C_TypeDef *i2c = &shimI2C[1];
+
+	i2cControl |= i2c->I2CONSET & (I2C_AA | I2C_SI | I2C_STO | I2C_STA | I2C_I2EN);
+	if (i2c->I2CONCLR & I2C_SI) shimNVIC.ISPR[WORD(I2C1_IRQn)] &= ~BIT(I2C1_IRQn);
+	i2cControl &= ~(i2c->I2CONCLR & (I2C_AA | I2C_SI | I2C_STA | I2C_I2EN)); // STO can't be cleared
+	if ((i2c->I2DAT & 0xFFFFFF00) != I2C_DAT_UNWRITTEN) {
+		i2cData = i2c->I2DAT & 0xFF;
+		i2cDataWritten = true;
+	}
+
+	SHIM_I2CStep();
+
+	i2c->I2CONSET = 0;
+	i2c->I2CONCLR = 0;
+	i2c->I2DAT = I2C_DAT_UNWRITTEN | i2cData;
+	i2c->I2STAT = i2cStatus;
+}
+
+LPC_I2C_TypeDef *SHIM_I2C1(void) {
+	SHIM_I2CFlush();
+	return &shimI2C[1];
+}
+
+void SHIM_I2CAttach(SHIM_I2C_SLAVE *slave) {
+	for (int i = 0; i < SHIM_I2C_SLAVES; i++) {
+		if (i2cSlaves[i] == NULL) {
+			i2cSlaves[i] = slave;
+			return;
+		}
+	}
+}
+
+
+/*
+ * SPI:
+ */
+
+static void SHIM_SPIFlush(void) { // Applies the last register write: a byte written to SPDR goes out
+	if ((shimSPI.SPDR & 0xFFFF0000) == SPI_DAT_UNWRITTEN) return;
+
+	uint32_t sck = shimSPI.SPCCR; // PCLK counts per SCK period
+	if (sck < 8) sck = 8; // Not set yet (or not valid): the fastest
+	shimNs += (uint64_t) 8 * sck * 1000000000 / (SystemCoreClock / 4);
+	shimSPI.SPSR |= SPI_SPIF;
+	shimSPI.SPDR = SPI_DAT_UNWRITTEN | 0xFF;
+}
+
+LPC_SPI_TypeDef *SHIM_SPI(void) {
+	SHIM_SPIFlush();
+	return &shimSPI;
+}
+
+
+/*
+ * UART2:
+ */
+
+static uint64_t SHIM_UARTByteNs(void) { // 10 bit times (start, 8 data, stop), at the baud rate of the divisors
+	static const uint32_t dividers[] = {4, 1, 2, 8}; // PCLKSEL1 bits 17:16
+	uint32_t pclk = SystemCoreClock / dividers[(shimSC.PCLKSEL1 >> 16) & 0x03];
+	uint32_t divisor = ((uint32_t) uartDlm << 8) | uartDll;
+	uint32_t divAddVal = shimUART2.FDR & 0x0F, mulVal = shimUART2.FDR >> 4;
+
+	if (divisor == 0) divisor = 1;
+	if (mulVal == 0) mulVal = 1;
+	return (uint64_t) 10 * 16 * divisor * (mulVal + divAddVal) * 1000000000 / ((uint64_t) pclk * mulVal);
+}
+
+static uint32_t SHIM_UARTId(void) { // IIR interrupt identification, highest priority first
+	if ((uartIer & 0x04) && uartOverrun) return 0x06; // RLS
+	if ((uartIer & 0x01) && (uartRxCount >= uartTrigger)) return 0x04; // RDA
+	if ((uartIer & 0x01) && (uartRxCount > 0)) return 0x0C; // CTI
+	if ((uartIer & 0x02) && uartThre) return 0x02; // THRE
+	return 0x01; // None pending
+}
+
+static void SHIM_UARTInterrupt(void) { // UART2_IRQn follows the interrupt line (level)
+	if (SHIM_UARTId() != 0x01) shimNVIC.ISPR[WORD(UART2_IRQn)] |= BIT(UART2_IRQn);
+	else shimNVIC.ISPR[WORD(UART2_IRQn)] &= ~BIT(UART2_IRQn);
+}
+
+static void SHIM_UARTIn(uint8_t byte) {
+	if (uartRxCount == UART_FIFO) { // Overrun: the byte is lost
+		uartOverrun = true;
+		shimUART2Line.lost++;
+		return;
+	}
+	uartRx[uartRxCount++] = byte;
+}
+
+static void SHIM_UARTOut(void) { // The TX FIFO goes out, if TXEN
+	if (!(shimUART2.TER & UART_TER_TXEN) || (uartTxCount == 0)) return;
+
+	for (uint32_t i = 0; i < uartTxCount; i++) {
+		if (shimUART2Line.sent < SHIM_UART_LOG) shimUART2Line.log[shimUART2Line.sent] = uartTx[i];
+		shimUART2Line.sent++;
+		shimNs += SHIM_UARTByteNs();
+		if (shimUART2Line.loopback) SHIM_UARTIn(uartTx[i]);
+	}
+	uartTxCount = 0;
+	uartThre = true;
+}
+
+static void SHIM_UARTFlush(void) { // Applies the last register write
+	int offset = uartWrite;
+	if (offset == UART_NO_WRITE) return;
+	uartWrite = UART_NO_WRITE;
+
+	bool dlab = shimUART2.LCR & UART_LCR_DLAB;
+	uint8_t value = ((volatile uint8_t *) &shimUART2)[offset];
+	if (offset == offsetof(LPC_UART_TypeDef, THR)) {
+		if (dlab) uartDll = value;
+		else {
+			if (uartTxCount < UART_FIFO) uartTx[uartTxCount++] = value;
+			uartThre = false;
+		}
+	}
+	else if (offset == offsetof(LPC_UART_TypeDef, IER)) {
+		if (dlab) uartDlm = value;
+		else uartIer = shimUART2.IER & 0x307;
+	}
+	else if (offset == offsetof(LPC_UART_TypeDef, FCR)) {
+		static const uint32_t triggers[] = {1, 4, 8, 14};
+		uartFifos = value & 0x01;
+		if (value & 0x02) uartRxCount = 0;
+		if (value & 0x04) uartTxCount = 0;
+		uartTrigger = triggers[value >> 6];
+	}
+
+	SHIM_UARTOut();
+	SHIM_UARTInterrupt();
+}
+
+static void SHIM_UARTRead(int offset) { // Value of the register about to be read, and its side effects
+	bool dlab = shimUART2.LCR & UART_LCR_DLAB;
+	if (offset == offsetof(LPC_UART_TypeDef, RBR)) {
+		if (dlab) shimUART2.DLL = uartDll;
+		else if (uartRxCount > 0) {
+			shimUART2.RBR = uartRx[0];
+			memmove(uartRx, uartRx + 1, --uartRxCount);
+		}
+	}
+	else if (offset == offsetof(LPC_UART_TypeDef, IER)) {
+		shimUART2.IER = dlab ? uartDlm : uartIer;
+	}
+	else if (offset == offsetof(LPC_UART_TypeDef, IIR)) {
+		uint32_t id = SHIM_UARTId();
+		if (id == 0x02) uartThre = false; // Reading IIR clears the THRE interrupt
+		shimUART2.IIR = id | (uartFifos ? 0xC0 : 0);
+	}
+	else if (offset == offsetof(LPC_UART_TypeDef, LSR)) {
+		shimUART2.LSR = ((uartRxCount > 0) ? 0x01 : 0) | (uartOverrun ? 0x02 : 0) | ((uartTxCount == 0) ? 0x60 : 0);
+		uartOverrun = false; // Reading LSR clears OE
+	}
+	SHIM_UARTInterrupt();
+}
+
+void SHIM_UARTReceive(uint8_t byte) {
+	SHIM_UARTFlush();
+	SHIM_UARTIn(byte);
+	SHIM_UARTInterrupt();
+	SHIM_Dispatch();
+}
+
+
+/*
+ * Watched accesses (code built with WATCH, see shim.h):
+ */
+
+static void SHIM_Watch(const volatile void *address, bool write) { // Before each load or store
+	SHIM_UARTFlush();
+
+	bool pending = sysTickPending || (shimNVIC.ISPR[0] & nvicEnabled[0]) || (shimNVIC.ISPR[1] & nvicEnabled[1]);
+	if (pending && !handling && (primask == 0)) {
+		SHIM_Dispatch(); // An interrupt comes in before this access
+	}
+
+	ptrdiff_t offset = (const volatile uint8_t *) address - (const volatile uint8_t *) &shimUART2;
+	if ((offset < 0) || (offset >= (ptrdiff_t) sizeof(shimUART2))) return;
+	if (write) uartWrite = (int) offset;
+	else SHIM_UARTRead((int) offset);
+}
+
+void __asan_load1_noabort(void *address) { SHIM_Watch(address, false); }
+void __asan_load2_noabort(void *address) { SHIM_Watch(address, false); }
+void __asan_load4_noabort(void *address) { SHIM_Watch(address, false); }
+void __asan_load8_noabort(void *address) { SHIM_Watch(address, false); }
+void __asan_load16_noabort(void *address) { SHIM_Watch(address, false); }
+void __asan_loadN_noabort(void *address, long size) { SHIM_Watch(address, false); }
+void __asan_store1_noabort(void *address) { SHIM_Watch(address, true); }
+void __asan_store2_noabort(void *address) { SHIM_Watch(address, true); }
+void __asan_store4_noabort(void *address) { SHIM_Watch(address, true); }
+void __asan_store8_noabort(void *address) { SHIM_Watch(address, true); }
+void __asan_store16_noabort(void *address) { SHIM_Watch(address, true); }
+void __asan_storeN_noabort(void *address, long size) { SHIM_Watch(address, true); }
+void __asan_handle_no_return(void) { }
+
+
+/*
+ * IAP:
+ */
+
+#define IAP_SECTORS 30
+
+static int SHIM_IAPSector(unsigned int address) { // -1 if not in flash
+	if (address < 0x10000) return address / 0x1000; // 16 sectors of 4 KB
+	if (address < 0x80000) return 16 + (address - 0x10000) / 0x8000; // 14 of 32 KB
+	return -1;
+}
+
+static uint32_t SHIM_IAPSectors(unsigned int start, unsigned int end) { // Bit per sector
+	return ((1UL << (end + 1)) - 1) & ~((1UL << start) - 1);
+}
+
+static unsigned int SHIM_IAPPrepared(unsigned int start, unsigned int end) { // Takes the preparation of sectors
+	if ((start > end) || (end >= IAP_SECTORS)) return 7; // INVALID_SECTOR
+	uint32_t sectors = SHIM_IAPSectors(start, end);
+	bool prepared = (iapPrepared & sectors) == sectors;
+	iapPrepared = 0;
+	return prepared ? 0 : 9; // CMD_SUCCESS, SECTOR_NOT_PREPARED_FOR_WRITE_OPERATION
+}
+
+static unsigned int SHIM_IAPRun(unsigned int command[]) {
+	switch (command[0]) {
+		case 50: // Prepare sectors
+			if ((command[1] > command[2]) || (command[2] >= IAP_SECTORS)) return 7;
+			iapPrepared |= SHIM_IAPSectors(command[1], command[2]);
+			return 0;
+
+		case 51: { // Copy RAM to flash
+			int sector = SHIM_IAPSector(command[1]);
+			if (command[2] & 0x03) return 2; // SRC_ADDR_ERROR
+			if (command[1] & 0xFF) return 3; // DST_ADDR_ERROR
+			if ((command[3] != 256) && (command[3] != 512) && (command[3] != 1024) && (command[3] != 4096)) return 6;
+			if ((sector < 0) || (SHIM_IAPSector(command[1] + command[3] - 1) != sector)) return 5; // DST_ADDR_NOT_MAPPED
+			return SHIM_IAPPrepared(sector, sector);
+		}
+
+		case 52: // Erase sectors
+			return SHIM_IAPPrepared(command[1], command[2]);
+
+		case 56: // Compare
+			return ((command[3] & 0x03) != 0) ? 6 : 0;
+
+		default:
+			return 1; // INVALID_COMMAND
+	}
+}
+
+void SHIM_IAP(unsigned int command[], unsigned int output[]) {
+	unsigned int status = 11; // BUSY
+	if (shimIAPBusy > 0) shimIAPBusy--;
+	else status = SHIM_IAPRun(command);
+	output[0] = status;
+
+	if (shimIAPCount < SHIM_IAP_CALLS) {
+		SHIM_IAP_CALL *call = &shimIAPCalls[shimIAPCount];
+		memcpy(call->command, command, sizeof(call->command));
+		call->status = status;
+		SHIM_NVICFlush();
+		call->iser[0] = nvicEnabled[0];
+		call->iser[1] = nvicEnabled[1];
+		call->primask = primask;
+		call->basepri = basepri;
+		call->sysTickCtrl = SysTick->CTRL;
+	}
+	shimIAPCount++;
+}
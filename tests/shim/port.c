@@ -0,0 +1,24 @@
+/*
+ * port.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Host stand-in of the FreeRTOS Cortex-M3 port (portable/GCC/ARM_CM3), so that the real kernel links with an
+ *  application, for link checks (see Makefile). Nothing here runs: the scheduler never starts.
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+StackType_t *pxPortInitialiseStack(StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters) {
+	return pxTopOfStack;
+}
+
+BaseType_t xPortStartScheduler(void) {
+	return pdFALSE;
+}
+
+void vPortEndScheduler(void) {
+}
@@ -0,0 +1,207 @@
+/*
+ * shim.h
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Test side of the CMSIS shim (LPC17xx.h): simulated interrupts, timers, I2C1 bus, SPI, DWT, UART2 and IAP. And of
+ *  the FreeRTOS shims (freertos.c, freertos_pthread.c).
+ *
+ *  Handlers are found by name, as in the target's vector table (TIMER2_IRQHandler(), ...), if the test links them.
+ *  A raised interrupt runs at once if it is enabled (NVIC_EnableIRQ()) and interrupts are not disabled
+ *  (__disable_irq()), and there is no handler running. Otherwise it stays pending, and runs as soon as that changes.
+ */
+
+#ifndef SHIM_H_
+#define SHIM_H_
+
+#include "LPC17xx.h"
+
+#include <stdbool.h>
+
+
+/**
+ * @brief	Clears every peripheral and the interrupt state (SystemCoreClock back to 100 MHz).
+ */
+void SHIM_Reset(void);
+
+/**
+ * @brief	Raises an interrupt (SysTick_IRQn included).
+ * @param	IRQn: -> Interrupt.
+ */
+void SHIM_Raise(IRQn_Type IRQn);
+
+/**
+ * @brief	Runs every pending interrupt that may run now.
+ */
+void SHIM_Dispatch(void);
+
+/**
+ * @brief	Called by __WFI() (after running pending interrupts): advances time, raises interrupts...
+ * @note	Without one, __WFI() only runs pending interrupts.
+ */
+extern void (*shimIdle)(void);
+
+/**
+ * @brief	Advances a timer by some counts (TC after the prescaler), with its MR0 match actions (MCR: interrupt,
+ * 			reset, stop). Match interrupts run at the count they match, in order.
+ * @param	timer: -> LPC_TIM0 to LPC_TIM3.
+ * @param	counts: -> Counts to advance.
+ */
+void SHIM_TimerAdvance(LPC_TIM_TypeDef *timer, uint32_t counts);
+
+
+/*
+ * I2C1 bus:
+ *
+ * The master is the driver, on the I2C1 registers. Each time it clears SI, the bus does what the control bits ask
+ * (STOP, then START, or the next byte), sets I2STAT and SI, and raises I2C1_IRQn. Bytes take 9 SCL periods of
+ * virtual time (shimNs), from I2SCLH and I2SCLL at PCLK = CCLK/4, as I2C1_Init() sets.
+ */
+
+#define SHIM_I2C_SLAVES 4 // Slaves on the bus at the same time
+
+/**
+ * @brief	A slave on the I2C1 bus. Callbacks left NULL always acknowledge (and read 0xFF).
+ * @note	Embed it as the first member of the device model, to get the model back from the callbacks.
+ */
+typedef struct SHIM_I2C_SLAVE {
+	uint8_t address; /*!< 7-bit address. */
+	bool (*addressed)(struct SHIM_I2C_SLAVE *slave, bool read); /*!< After START: returns ACK. */
+	bool (*write)(struct SHIM_I2C_SLAVE *slave, uint8_t data); /*!< Byte from the master: returns ACK. */
+	uint8_t (*read)(struct SHIM_I2C_SLAVE *slave); /*!< Byte to the master. */
+	void (*stop)(struct SHIM_I2C_SLAVE *slave); /*!< STOP, if it was addressed (and acknowledged) since the last one. */
+} SHIM_I2C_SLAVE;
+
+/**
+ * @brief	What went on the I2C1 bus since SHIM_Reset().
+ */
+typedef struct {
+	uint32_t starts; /*!< STARTs and repeated STARTs. */
+	uint32_t stops;
+	uint32_t bytes; /*!< Bytes on the wire, in either direction: addresses included. */
+	uint32_t nacks; /*!< Addresses nobody acknowledged. */
+	bool hold; /*!< A slave holds SCL low (clock stretching): the bus stops until the test clears it. */
+} SHIM_I2C_BUS;
+
+extern SHIM_I2C_BUS shimI2C1Bus;
+
+/**
+ * @brief	Virtual time (ns), advanced by the I2C1 bus, SPI and UART2, and by tests. Cleared by SHIM_Reset().
+ */
+extern uint64_t shimNs;
+
+/**
+ * @brief	Puts a slave on the I2C1 bus (until SHIM_Reset()).
+ * @param	slave: -> Slave, which must stay valid.
+ */
+void SHIM_I2CAttach(SHIM_I2C_SLAVE *slave);
+
+
+/*
+ * SPI:
+ *
+ * A byte written to SPDR is out at once: SPIF is set, SPDR reads 0xFF (nothing drives MISO), and virtual time
+ * (shimNs) moves on by its 8 SCK periods, from SPCCR at PCLK = CCLK/4, as SPI_Init() sets. The read that clears SPIF
+ * on the target is not seen: it stays set.
+ */
+
+
+/*
+ * DWT:
+ *
+ * CYCCNT counts virtual time (shimNs) at SystemCoreClock while CYCCNTENA is set, from whatever was last written to it.
+ */
+
+
+/*
+ * UART2, on watched accesses:
+ *
+ * uart.c keeps a pointer to its registers, and its reads have side effects (RBR pops the RX FIFO, LSR clears OE, IIR
+ * clears the THRE interrupt), which an accessor as SHIM_I2C1() cannot see. So code driving UART2 is built with
+ * WATCH (see the Makefile): -fsanitize=kernel-address, whose checks call hooks of lpc17xx.c (built without it) before
+ * every load and store, with the address. A read of a UART2 register gets its value then, and a write is applied at
+ * the next access (or SHIM_Dispatch()). Pending interrupts also run at the next access, as between instructions.
+ *
+ * The FIFOs are 16 bytes deep, with the RX trigger level of FCR (RDA), and the character time-out (CTI) as soon as
+ * fewer bytes are waiting. Bytes written while TER.TXEN is set go out at once, each taking 10 bit times of virtual
+ * time at the baud rate of the divisors (and PCLKSEL1), and the THRE interrupt is due when the TX FIFO is empty again.
+ * A byte coming in to a full RX FIFO is lost, and sets OE. The interrupt line (UART2_IRQn) follows IER and IIR.
+ */
+
+#define SHIM_UART_LOG 8192 // Bytes logged
+
+/**
+ * @brief	The UART2 line, since SHIM_Reset().
+ */
+typedef struct {
+	bool loopback; /*!< TXD wired to RXD (as the TestBenchmark jumper). */
+	uint32_t sent; /*!< Bytes out of TXD. */
+	uint32_t lost; /*!< Bytes that came in to a full RX FIFO. */
+	uint8_t log[SHIM_UART_LOG]; /*!< Bytes out of TXD (only the first SHIM_UART_LOG). */
+} SHIM_UART_LINE;
+
+extern SHIM_UART_LINE shimUART2Line;
+
+/**
+ * @brief	A byte from the other end of the UART2 line, into the RX FIFO (interrupts it raises run at once).
+ * @param	byte: -> Byte received.
+ */
+void SHIM_UARTReceive(uint8_t byte);
+
+
+/*
+ * IAP (flash programming in the boot ROM):
+ *
+ * SHIM_IAP() stands for the ROM entry point (flash.c's iap_entry). It logs each command, with the interrupt state it
+ * ran with, and answers as the LPC1769 does for sectors 0 to 29: erase and copy need every sector they touch prepared
+ * by the previous command, and leave them protected again. Nothing is written.
+ */
+
+#define SHIM_IAP_CALLS 64 // Calls logged
+
+/**
+ * @brief	An IAP call, as SHIM_IAP() got it.
+ */
+typedef struct {
+	unsigned int command[5];
+	unsigned int status; /*!< output[0] returned. */
+	uint32_t iser[2]; /*!< NVIC->ISER during the call. */
+	uint32_t primask;
+	uint32_t basepri;
+	uint32_t sysTickCtrl;
+} SHIM_IAP_CALL;
+
+extern SHIM_IAP_CALL shimIAPCalls[SHIM_IAP_CALLS];
+extern uint32_t shimIAPCount; /*!< Calls since SHIM_Reset() (only the first SHIM_IAP_CALLS are logged). */
+extern uint32_t shimIAPBusy; /*!< Calls still to answer BUSY, without running the command. */
+
+/**
+ * @brief	IAP entry point.
+ * @param	command: -> Command code and parameters.
+ * @param	output: -> Status code and results.
+ */
+void SHIM_IAP(unsigned int command[], unsigned int output[]);
+
+
+/*
+ * FreeRTOS, single threaded (freertos.c):
+ */
+
+/**
+ * @brief	Called when a task delays (vTaskDelay(), vTaskDelayUntil()), once the tick count has moved on by 'ticks': to
+ * 			move other clocks along, or play the tasks that would run meanwhile.
+ */
+extern void (*shimSleep)(uint32_t ticks);
+
+
+/*
+ * FreeRTOS on threads (freertos_pthread.c, in place of freertos.c):
+ */
+
+/**
+ * @brief	Host time a tick takes, in ns (1 ms by default). Set before the first kernel call, to run faster.
+ */
+extern uint32_t shimTickNs;
+
+#endif /* SHIM_H_ */
@@ -0,0 +1,45 @@
+/*
+ * test.h
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Checks for the host tests: a failed CHECK() prints itself and the test goes on. main() returns TEST_Result().
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+
+static int testFailures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			testFailures++; \
+		} \
+	} while (0)
+
+/*
+ * Exit status of the test (and its verdict, printed).
+ */
+static inline int TEST_Result(const char *name) {
+	printf("%s: %s (%d failed)\n", name, (testFailures == 0) ? "passed" : "FAILED", testFailures);
+	return (testFailures == 0) ? 0 : 1;
+}
+
+/*
+ * Host monotonic time, in nanoseconds, for benchmarks.
+ */
+static inline uint64_t TEST_Ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+#endif /* TEST_H_ */
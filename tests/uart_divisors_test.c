@@ -0,0 +1,130 @@
+/*
+ * uart_divisors_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  UART divisors: the integer fallback search of uart.c (UART_SearchDivisors()) against every entry of the generated
+ *  table (uart_divisors.c, tools/uart_divisors.py), which must agree field by field. Then UART_ChooseDivisors() at
+ *  both clock profiles, which must pick table entries within UART_MAX_BAUD_ERROR, and the cost of a table hit next to
+ *  a search.
+ */
+
+#include "test.h"
+#include "shim.h"
+
+#include "../LEETC_SE1/src/uart.c" // UART_SearchDivisors() and UART_ChooseDivisors() are static
+
+
+#define BENCH_CALLS 100000
+
+static const uint32_t bauds[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+static const uint32_t cclks[] = {100000000, 24000000}; // CLOCK_FULL, CLOCK_REDUCED
+
+static volatile int32_t sink; // Keeps benchmarked results
+
+
+/*
+ * Stubs of the modules uart.c uses (not under test):
+ */
+
+int32_t CLOCK_AddHandler(void (*handler)(void)) {
+	return 0;
+}
+
+void CLOCK_SetPCLK(CLOCK_PERIPHERAL peripheral, CLOCK_DIVIDER divider) {
+}
+
+int32_t WAIT_Init(WAIT mode) {
+	return 0;
+}
+
+uint32_t WAIT_SYS_GetElapsedMs(uint32_t start) {
+	return 0;
+}
+
+int FORMAT_Print(FORMAT_SINK sink, void * context, int limit, const char * format, va_list args) {
+	return 0;
+}
+
+
+static void testTable(void) {
+	uint32_t wrong = 0;
+	for (uint32_t i = 0; i < uartDivisorTableLength; i++) {
+		const UART_DIVISORS *entry = &uartDivisorTable[i];
+		UART_DIVISORS found;
+		if (UART_SearchDivisors(entry->pclk, entry->baud, &found) < 0 || found.pclk != entry->pclk
+				|| found.baud != entry->baud || found.divisor != entry->divisor || found.divAddVal != entry->divAddVal
+				|| found.mulVal != entry->mulVal || found.error != entry->error) {
+			printf("%u Hz, %u baud: table %u %u/%u (%d ppm), search %u %u/%u (%d ppm)\n", entry->pclk, entry->baud,
+					entry->divisor, entry->divAddVal, entry->mulVal, entry->error,
+					found.divisor, found.divAddVal, found.mulVal, found.error);
+			wrong++;
+		}
+	}
+	CHECK(uartDivisorTableLength == 2 * 4 * 8); // Every profile, PCLK divider and standard baud rate
+	CHECK(wrong == 0);
+	printf("table: %u entries, %u differ from the search\n", uartDivisorTableLength, wrong);
+}
+
+static bool inTable(const UART_DIVISORS *divisors) {
+	for (uint32_t i = 0; i < uartDivisorTableLength; i++) {
+		if (memcmp(&uartDivisorTable[i], divisors, sizeof(UART_DIVISORS)) == 0) return true;
+	}
+	return false;
+}
+
+static void testChoose(void) {
+	for (int c = 0; c < sizeof(cclks) / sizeof(cclks[0]); c++) {
+		SystemCoreClock = cclks[c];
+		for (int b = 0; b < sizeof(bauds) / sizeof(bauds[0]); b++) {
+			CLOCK_DIVIDER divider;
+			UART_DIVISORS divisors;
+			if (UART_ChooseDivisors(bauds[b], &divider, &divisors) < 0) {
+				CHECK(!UART_IsBaudReachable(bauds[b]));
+				continue;
+			}
+			CHECK(UART_IsBaudReachable(bauds[b]));
+			CHECK(inTable(&divisors));
+			CHECK(divisors.error <= UART_MAX_BAUD_ERROR && divisors.error >= -UART_MAX_BAUD_ERROR);
+		}
+	}
+	SystemCoreClock = cclks[0];
+	CHECK(UART_IsBaudReachable(921600)); // As uart.h says
+	CHECK(!UART_IsBaudReachable(UART_MAX_BAUD + 1));
+
+	UART_DIVISORS divisors; // Not in the table: searched
+	CHECK(UART_FindDivisors(25000000, 74880, &divisors) == 0 && !inTable(&divisors));
+	CHECK(divisors.error <= UART_MAX_BAUD_ERROR && divisors.error >= -UART_MAX_BAUD_ERROR);
+}
+
+static void benchmark(void) {
+	UART_DIVISORS divisors;
+	int32_t sum = 0;
+
+	uint64_t t0 = TEST_Ns();
+	for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+		const UART_DIVISORS *entry = &uartDivisorTable[i % uartDivisorTableLength];
+		UART_FindDivisors(entry->pclk, entry->baud, &divisors);
+		sum += divisors.divisor;
+	}
+	uint64_t t1 = TEST_Ns();
+	for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+		const UART_DIVISORS *entry = &uartDivisorTable[i % uartDivisorTableLength];
+		UART_SearchDivisors(entry->pclk, entry->baud, &divisors);
+		sum += divisors.divisor;
+	}
+	uint64_t t2 = TEST_Ns();
+	sink = sum;
+
+	printf("ns per call: table %.1f, search %.1f\n", (double) (t1 - t0) / BENCH_CALLS, (double) (t2 - t1) / BENCH_CALLS);
+}
+
+
+int main(void) {
+	testTable();
+	testChoose();
+	benchmark();
+
+	return TEST_Result("uart_divisors_test");
+}
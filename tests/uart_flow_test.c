@@ -0,0 +1,196 @@
+/*
+ * uart_flow_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  UART2 driver (uart.c) on the simulated UART2 of the shim (shim.h), built with WATCH. Software flow control, with
+ *  TX wired to RX: XOFF goes out once the RX Ring Buffer fills to UART_XOFF_LEVEL, ahead of all but the data already
+ *  in the TX FIFO, and pauses the sender. XON goes out once the reader drains it to UART_XON_LEVEL, and no data goes
+ *  out in between. Then with the other end pausing us: our own XOFF still goes out first while paused. Then the bytes
+ *  lost, and counted: to a full Ring Buffer (no flow control), and to a full RX FIFO while the interrupt is held off.
+ */
+
+#include "test.h"
+#include "shim.h"
+
+#include "../LEETC_SE1/src/uart.c" // Ring Buffers and flow control state are static
+
+
+#define DATA_BYTES 4000 // More than the RX and TX Ring Buffers hold
+#define PEER_BYTES 1600 // Past UART_XOFF_LEVEL
+#define FIFO_BYTES 16 // RX FIFO depth
+
+static unsigned char data[DATA_BYTES];
+
+
+/*
+ * Stubs of the modules uart.c uses (not under test):
+ */
+
+int32_t CLOCK_AddHandler(void (*handler)(void)) {
+	return 0;
+}
+
+void CLOCK_SetPCLK(CLOCK_PERIPHERAL peripheral, CLOCK_DIVIDER divider) {
+}
+
+int32_t WAIT_Init(WAIT mode) {
+	return 0;
+}
+
+uint32_t WAIT_SYS_GetElapsedMs(uint32_t start) {
+	return (uint32_t) (shimNs / 1000000) - start;
+}
+
+int FORMAT_Print(FORMAT_SINK sink, void * context, int limit, const char * format, va_list args) {
+	return 0;
+}
+
+
+static void reset(bool loopback, UART_FLOW flow) {
+	SHIM_Reset();
+	shimUART2Line.loopback = loopback;
+	UART_Init(115200);
+	UART_SetFlowControl(flow);
+	for (int i = 0; i < DATA_BYTES; i++) {
+		data[i] = 'A' + i % 26; // Text: never XON or XOFF
+	}
+}
+
+static uint32_t rxFill(void) {
+	return RBUF_FILL(rbuffer.rxWrite, rbuffer.rxRead);
+}
+
+static uint32_t countSent(unsigned char byte, uint32_t from, uint32_t to) { // In the line log
+	uint32_t count = 0;
+	for (uint32_t i = from; i < to; i++) {
+		count += (shimUART2Line.log[i] == byte);
+	}
+	return count;
+}
+
+
+static void testLoopback(void) {
+	reset(true, UART_FLOW_XONXOFF);
+	uint32_t queued = 0, received = 0, xonFill = 0;
+	unsigned char ch;
+
+	// Nobody reads: XOFF at UART_XOFF_LEVEL, and it comes back and pauses us (until the TX Ring Buffer is full)
+	while (queued < DATA_BYTES) {
+		uint32_t bytes = UART_WriteBuffer(&data[queued], DATA_BYTES - queued);
+		if (bytes == 0) break;
+		queued += bytes;
+	}
+	uint32_t pausedFill = rxFill(), pausedAt = shimUART2Line.sent;
+	CHECK(queued < DATA_BYTES && txPaused && xoffSent);
+	CHECK(countSent(UART_XOFF, 0, pausedAt) == 1 && shimUART2Line.log[UART_XOFF_LEVEL] == UART_XOFF); // Once UART_XOFF_LEVEL came in
+	CHECK(pausedFill == pausedAt - 1 && pausedFill <= UART_XOFF_LEVEL + UART_TX_FIFO_SIZE - 1); // And the FIFO with it
+
+	// Read it all: XON once drained to UART_XON_LEVEL, and the rest of the data after it
+	for (int misses = 0; (received < DATA_BYTES) && (misses < DATA_BYTES); ) { // Gives up if stuck (both paused)
+		if (queued < DATA_BYTES) queued += UART_WriteBuffer(&data[queued], DATA_BYTES - queued);
+		if (!UART_GetChar(&ch)) {
+			misses++;
+			continue;
+		}
+		misses = 0;
+		CHECK(ch == data[received]);
+		received++;
+		if ((xonFill == 0) && (countSent(UART_XON, 0, shimUART2Line.sent) > 0)) { // This read sent the first XON
+			uint32_t at = 0;
+			while (shimUART2Line.log[at] != UART_XON) at++;
+			// Data that came in before it, less what was read (the line is instant: what XON let through is in since)
+			xonFill = at - countSent(UART_XOFF, 0, at) - received;
+		}
+	}
+	CHECK(received == DATA_BYTES && xonFill == UART_XON_LEVEL);
+
+	// Controls in pairs: XOFF, at most a TX FIFO of data (less XOFF) sent with it, nothing while paused, then XON
+	uint32_t sent = shimUART2Line.sent, xoff = 0, xon = 0;
+	CHECK(sent <= SHIM_UART_LOG && sent == DATA_BYTES + countSent(UART_XOFF, 0, sent) + countSent(UART_XON, 0, sent));
+	for (uint32_t i = 0; i < sent; i++) {
+		if (shimUART2Line.log[i] == UART_XOFF) xoff = i;
+		if (shimUART2Line.log[i] != UART_XON) continue;
+		xon = i;
+		CHECK(xoff < xon && xon - xoff - 1 <= UART_TX_FIFO_SIZE - 1);
+	}
+	CHECK(xon != 0 && countSent(UART_XOFF, 0, sent) == countSent(UART_XON, 0, sent));
+	CHECK(UART_GetOverruns() == 0 && shimUART2Line.lost == 0 && !txPaused && !xoffSent);
+	printf("loopback: paused at fill %u, XON at fill %u, %u bytes out (%u controls), %.1f ms of line\n", (unsigned) pausedFill,
+			(unsigned) xonFill, (unsigned) sent, (unsigned) (sent - DATA_BYTES), (double) shimNs / 1000000);
+}
+
+static void testPeerPause(void) {
+	reset(false, UART_FLOW_XONXOFF);
+	unsigned char ch;
+
+	// The other end pauses us: data waits
+	SHIM_UARTReceive(UART_XOFF);
+	CHECK(UART_WriteBuffer(data, 100) == 100);
+	CHECK(txPaused && shimUART2Line.sent == 0);
+
+	// It sends past UART_XOFF_LEVEL: our XOFF goes out, though we are paused
+	for (int i = 0; i < PEER_BYTES; i++) {
+		SHIM_UARTReceive(data[i]);
+	}
+	CHECK(rxFill() == PEER_BYTES && xoffSent);
+	CHECK(shimUART2Line.sent == 1 && shimUART2Line.log[0] == UART_XOFF);
+
+	// XON from the other end: the data follows
+	SHIM_UARTReceive(UART_XON);
+	CHECK(!txPaused && shimUART2Line.sent == 101 && memcmp(&shimUART2Line.log[1], data, 100) == 0);
+
+	// Drained: our XON, and every byte in order
+	for (int i = 0; i < PEER_BYTES; i++) {
+		CHECK(UART_GetChar(&ch) && ch == data[i]);
+	}
+	CHECK(shimUART2Line.sent == 102 && shimUART2Line.log[101] == UART_XON);
+	CHECK(!UART_GetChar(&ch) && UART_GetOverruns() == 0);
+}
+
+static void testRingFull(void) {
+	reset(false, UART_FLOW_NONE);
+	unsigned char ch;
+	uint32_t capacity = UART_RBUFSIZE - 1;
+
+	for (int i = 0; i < DATA_BYTES; i++) { // Nobody reads, nobody pauses
+		SHIM_UARTReceive(data[i]);
+	}
+	CHECK(UART_GetOverruns() == DATA_BYTES - capacity);
+	CHECK(shimUART2Line.lost == 0 && shimUART2Line.sent == 0);
+
+	uint32_t received = 0;
+	while (UART_GetChar(&ch)) {
+		CHECK(ch == data[received]);
+		received++;
+	}
+	CHECK(received == capacity); // The first ones
+}
+
+static void testFifoOverrun(void) {
+	reset(false, UART_FLOW_NONE);
+	unsigned char ch;
+
+	NVIC_DisableIRQ(UART2_IRQn); // Held off: the RX FIFO fills
+	for (int i = 0; i < FIFO_BYTES + 4; i++) {
+		SHIM_UARTReceive(data[i]);
+	}
+	CHECK(shimUART2Line.lost == 4 && rxFill() == 0);
+
+	NVIC_EnableIRQ(UART2_IRQn); // OE: counted once (at least a byte lost), and the FIFO read
+	CHECK(UART_GetOverruns() == 1 && rxFill() == FIFO_BYTES);
+	for (int i = 0; i < FIFO_BYTES; i++) {
+		CHECK(UART_GetChar(&ch) && ch == data[i]);
+	}
+}
+
+
+int main(void) {
+	testLoopback();
+	testPeerPause();
+	testRingFull();
+	testFifoOverrun();
+
+	return TEST_Result("uart_flow_test");
+}
@@ -0,0 +1,248 @@
+/*
+ * wait_wheel_test.c
+ *
+ *  Created on: Oct 2026
+ *      Author: PedroG
+ *
+ *  Timer wheel of wait.c, on a virtual clock: timer2's TC only moves with SHIM_TimerAdvance(), which raises the MR0
+ *  match interrupt at the exact count it matches. Every expiry logs TC, so each test checks when its timers expired,
+ *  not only that they did: one shot, periodic, stop, restart, a start from a callback, the 2^32 us wrap, and many
+ *  random timers against a reference (every expected expiry, sorted).
+ */
+
+#include "test.h"
+#include "shim.h"
+
+#include "../LEETC_SE1/src/wait.c" // wheelCount and wheelUsed are static
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#define RANDOM_TIMERS 1000
+#define MAX_EXPIRIES 20000
+
+static uint32_t expiries[MAX_EXPIRIES]; // TC at each expiry, in order
+static uint32_t expired;
+
+static uint32_t expected[MAX_EXPIRIES];
+static uint32_t expectedCount;
+
+static WAIT_TIMER timers[RANDOM_TIMERS];
+static uint32_t seed = 2463534242u;
+
+
+/*
+ * Clock and timestamp stubs (not under test):
+ */
+
+int32_t CLOCK_AddHandler(void (*handler)(void)) {
+	return 0;
+}
+
+uint64_t TIMESTAMP_Get(void) {
+	return 0;
+}
+
+
+static uint32_t random32(void) { // xorshift32
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+static void onExpiry(void) {
+	if (expired < MAX_EXPIRIES) expiries[expired] = LPC_TIM2->TC;
+	expired++;
+}
+
+static void advance(uint32_t micros) {
+	SHIM_TimerAdvance(LPC_TIM2, micros);
+}
+
+static void reset(void) {
+	SHIM_Reset();
+	memset(wheel, 0, sizeof(wheel));
+	memset(wheelUsed, 0, sizeof(wheelUsed));
+	memset(timers, 0, sizeof(timers));
+	memset((void *) busy, 0, sizeof(busy));
+	wheelNow = 0;
+	wheelCount = 0;
+	wheelTim2 = false;
+	expired = 0;
+	expectedCount = 0;
+
+	CHECK(WAIT_Init(WHEEL) == 0);
+}
+
+static void expect(uint32_t tc) {
+	if (expectedCount < MAX_EXPIRIES) expected[expectedCount] = tc;
+	expectedCount++;
+}
+
+static int compareUp(const void * a, const void * b) {
+	uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+	return (x > y) - (x < y);
+}
+
+static void checkExpected(uint32_t origin) { // Logged expiries are the expected ones, in time order (from 'origin')
+	CHECK(expired == expectedCount);
+	if (expired != expectedCount) return;
+
+	for (uint32_t i = 0; i < expectedCount; i++) {
+		expected[i] -= origin; // Sort by time since origin, which does not wrap
+	}
+	qsort(expected, expectedCount, sizeof(uint32_t), compareUp);
+
+	uint32_t wrong = 0;
+	for (uint32_t i = 0; i < expired; i++) {
+		if (expiries[i] - origin != expected[i]) wrong++;
+	}
+	CHECK(wrong == 0);
+}
+
+
+static void testOneShot(void) {
+	reset();
+	advance(1000);
+
+	WAIT_WHEEL_Start(&timers[0], 100, 0, onExpiry);
+	CHECK(WAIT_WHEEL_IsActive(&timers[0]));
+	advance(99);
+	CHECK(expired == 0);
+	advance(1);
+	CHECK(expired == 1 && expiries[0] == 1100);
+	CHECK(!WAIT_WHEEL_IsActive(&timers[0]));
+	advance(100000);
+	CHECK(expired == 1);
+	CHECK(wheelCount == 0);
+}
+
+static void testZeroDelay(void) {
+	reset();
+	advance(5);
+
+	WAIT_WHEEL_Start(&timers[0], 0, 0, onExpiry); // Already due: runs as it starts
+	CHECK(expired == 1 && expiries[0] == 5);
+	CHECK(!WAIT_WHEEL_IsActive(&timers[0]));
+}
+
+static void testPeriodic(void) {
+	reset();
+
+	WAIT_WHEEL_Start(&timers[0], 50, 30, onExpiry);
+	advance(200); // 50, 80, ..., 200
+	CHECK(expired == 6);
+	for (uint32_t i = 0; i < expired && i < 6; i++) {
+		CHECK(expiries[i] == 50 + 30 * i);
+	}
+	CHECK(WAIT_WHEEL_IsActive(&timers[0]));
+
+	WAIT_WHEEL_Stop(&timers[0]);
+	CHECK(!WAIT_WHEEL_IsActive(&timers[0]));
+	advance(1000);
+	CHECK(expired == 6);
+	CHECK(wheelCount == 0);
+}
+
+static void testStopAndRestart(void) {
+	reset();
+
+	WAIT_WHEEL_Start(&timers[0], 100, 0, onExpiry);
+	WAIT_WHEEL_Start(&timers[1], 200, 0, onExpiry);
+	WAIT_WHEEL_Start(&timers[2], 300, 0, onExpiry);
+	WAIT_WHEEL_Stop(&timers[1]);
+	WAIT_WHEEL_Stop(&timers[1]); // Stopping a stopped timer does nothing
+	WAIT_WHEEL_Start(&timers[2], 50, 0, onExpiry); // Restarting an active one replaces it
+	CHECK(wheelCount == 2);
+
+	advance(1000);
+	CHECK(expired == 2 && expiries[0] == 50 && expiries[1] == 100);
+	CHECK(wheelCount == 0);
+}
+
+static void onExpiryStartAnother(void) {
+	onExpiry();
+	WAIT_WHEEL_Start(&timers[1], 0, 0, onExpiry); // Due now: same run
+	WAIT_WHEEL_Start(&timers[2], 10, 0, onExpiry);
+}
+
+static void testStartFromCallback(void) {
+	reset();
+
+	WAIT_WHEEL_Start(&timers[0], 100, 0, onExpiryStartAnother);
+	advance(100);
+	CHECK(expired == 2 && expiries[0] == 100 && expiries[1] == 100);
+	advance(10);
+	CHECK(expired == 3 && expiries[2] == 110);
+	CHECK(wheelCount == 0);
+}
+
+static void testWrap(void) {
+	reset();
+	LPC_TIM2->TC = 0xFFFFFF00; // 256 us before the 32-bit wrap
+
+	WAIT_WHEEL_Start(&timers[0], 0x80, 0, onExpiry); // Before
+	WAIT_WHEEL_Start(&timers[1], 0x100, 0, onExpiry); // At
+	WAIT_WHEEL_Start(&timers[2], 0x180, 0, onExpiry); // After
+	WAIT_WHEEL_Start(&timers[3], 0x40, 0x40, onExpiry); // Periodic, across it
+	advance(0x200);
+	WAIT_WHEEL_Stop(&timers[3]);
+
+	uint32_t order[] = {0xFFFFFF40, 0xFFFFFF80, 0xFFFFFF80, 0xFFFFFFC0, 0, 0, 0x40, 0x80, 0x80, 0xC0, 0x100};
+	CHECK(expired == sizeof(order) / sizeof(order[0]));
+	for (uint32_t i = 0; i < expired && i < sizeof(order) / sizeof(order[0]); i++) {
+		CHECK(expiries[i] == order[i]);
+	}
+}
+
+static void testRandom(void) {
+	reset();
+	uint32_t origin = 12345;
+	advance(origin);
+
+	uint32_t horizon = origin + (1u << 26); // About 67 s
+	uint32_t started = 0;
+	while (LPC_TIM2->TC != horizon) {
+		if (started < RANDOM_TIMERS) { // Start a few timers now, with delays on every level of the wheel
+			for (int n = random32() % 4; n > 0 && started < RANDOM_TIMERS; n--, started++) {
+				uint32_t delay = random32() >> (random32() % 32);
+				if (delay > WHEEL_MAX_US) delay >>= 1;
+				uint32_t period = (random32() % 8 == 0) ? (1u << 20) + random32() % (1u << 22) : 0; // Some periodic, under 64 expiries each
+
+				uint32_t at = LPC_TIM2->TC + delay;
+				for (; (int32_t) (horizon - at) >= 0; at += period) {
+					expect(at);
+					if (period == 0) break;
+				}
+				WAIT_WHEEL_Start(&timers[started], delay, period, onExpiry);
+			}
+		}
+
+		uint32_t step = random32() >> (12 + random32() % 20);
+		if (step > horizon - LPC_TIM2->TC) step = horizon - LPC_TIM2->TC;
+		advance(step);
+	}
+
+	for (uint32_t i = 0; i < started; i++) { // Timers past the horizon
+		WAIT_WHEEL_Stop(&timers[i]);
+	}
+	CHECK(wheelCount == 0);
+	CHECK(expired <= MAX_EXPIRIES);
+	checkExpected(origin);
+	printf("random: %u timers, %u expiries\n", started, expired);
+}
+
+
+int main(void) {
+	testOneShot();
+	testZeroDelay();
+	testPeriodic();
+	testStopAndRestart();
+	testStartFromCallback();
+	testWrap();
+	testRandom();
+
+	return TEST_Result("wait_wheel_test");
+}
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+ram_report.py
+
+Total RAM per object file (and, with -s, per symbol), from a GNU ld map file
+(e.g. Car_Runner_RTOS/Debug/Car_Runner_RTOS.map).
+
+Only input sections placed in RAM regions are counted (.data, .bss, COMMON,
+and anything else, such as .ramfunc or the RAM vector table). Build with
+-fdata-sections (MCUXpresso default) to get one entry per static object; with
+configSUPPORT_STATIC_ALLOCATION, task stacks and control blocks show up as
+<name>Stack and <name>Tcb.
+
+	usage: ram_report.py [-s] file.map
+"""
+
+import re
+import sys
+from collections import defaultdict
+
+
+REGION = re.compile(r'^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(\s+\S+)?\s*$')
+SECTION = re.compile(r'^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+NAME_ONLY = re.compile(r'^ (\S+)\s*$')
+
+
+def regions(lines):
+	"""RAM regions from 'Memory Configuration' (anything not named Flash)."""
+	ram = []
+	inside = False
+	for line in lines:
+		if line.startswith('Memory Configuration'):
+			inside = True
+			continue
+		if inside and line.startswith('Linker script and memory map'):
+			break
+		match = REGION.match(line) if inside else None
+		if match and match.group(1) not in ('Name', '*default*') and 'flash' not in match.group(1).lower():
+			origin, length = int(match.group(2), 16), int(match.group(3), 16)
+			ram.append((match.group(1), origin, origin + length))
+	return ram
+
+
+def sections(lines):
+	"""(section, address, size, object) of every input section in the memory map."""
+	inside = False
+	pending = None
+	for line in lines:
+		if line.startswith('Linker script and memory map'):
+			inside = True
+			continue
+		if not inside:
+			continue
+		match = SECTION.match(line)
+		if match:
+			name = match.group(1) or pending
+			pending = None
+			if name and not name.startswith('*'):
+				yield name, int(match.group(2), 16), int(match.group(3), 16), match.group(4).strip()
+			continue
+		match = NAME_ONLY.match(line)
+		pending = match.group(1) if match else None
+
+
+def main(argv):
+	symbols = '-s' in argv
+	paths = [arg for arg in argv if arg != '-s']
+	if len(paths) != 1:
+		print(__doc__.strip().splitlines()[-1].strip(), file=sys.stderr)
+		return 2
+
+	with open(paths[0], errors='replace') as f:
+		lines = f.read().splitlines()
+
+	ram = regions(lines)
+	perObject = defaultdict(int)
+	perSymbol = defaultdict(int)
+	perRegion = defaultdict(int)
+	for name, address, size, obj in sections(lines):
+		region = next((r for r, start, end in ram if start <= address < end), None)
+		if region is None or size == 0:
+			continue
+		perObject[obj] += size
+		perRegion[region] += size
+		perSymbol[(obj, name)] += size
+
+	print('%8s  %s' % ('bytes', 'object'))
+	for obj, size in sorted(perObject.items(), key=lambda item: -item[1]):
+		print('%8d  %s' % (size, obj))
+		if symbols:
+			for (owner, name), symbolSize in sorted(perSymbol.items(), key=lambda item: -item[1]):
+				if owner == obj:
+					print('%8d      %s' % (symbolSize, name))
+	print()
+	for region, size in sorted(perRegion.items()):
+		print('%8d  total in %s' % (size, region))
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
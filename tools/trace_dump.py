@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""
+trace_dump.py
+
+Chrome trace JSON (for chrome://tracing or ui.perfetto.dev) from a RAM dump of
+'traceRing' (see LEETC_SE1/inc/trace.h), e.g. taken in gdb, with the target
+halted, by:
+
+	dump binary value trace.bin traceRing
+
+A larger dump (e.g. the whole RAM) works too: the ring is found by its magic.
+Record types, function names and sizes are read from trace.h, so this script
+never goes out of date with it.
+
+Output has one track per task (driver calls made by it), an 'interrupts' track
+(traced interrupt handlers), and a 'CPU' track showing which task was running.
+Bare metal traces only have the 'main' track.
+
+	usage: trace_dump.py [-H trace.h] trace.bin > trace.json
+"""
+
+import json
+import os
+import re
+import struct
+import sys
+
+
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'LEETC_SE1', 'inc', 'trace.h')
+
+MAIN_TID = 0
+INTERRUPTS_TID = 1000
+CPU_TID = 1001
+
+
+def definitions(path):
+	"""(#defines, {enum name: {value: member}}) from trace.h."""
+	with open(path) as f:
+		text = f.read()
+	defines = {name: int(value, 0) for name, value in re.findall(r'#define\s+(TRACE_\w+)\s+(0x[0-9a-fA-F]+|\d+)\s*$', text, re.M)}
+	enums = {}
+	for body, name in re.findall(r'typedef enum\s*\{(.*?)\}\s*(\w+)\s*;', text, re.S):
+		members = {}
+		value = 0
+		for member, explicit in re.findall(r'^\s*(TRACE_\w+)(?:\s*=\s*(\d+))?', body, re.M):
+			value = int(explicit) if explicit else value
+			members[value] = member
+			value += 1
+		enums[name] = members
+	return defines, enums
+
+
+def ring(data, defines):
+	"""(hz, count, task names, records in order) of the ring found in data."""
+	magic = struct.pack('<I', defines['TRACE_MAGIC'])
+	nameLength = defines['TRACE_NAME_LENGTH']
+	tasks = defines['TRACE_MAX_TASKS']
+
+	for offset in range(0, len(data) - 16, 4):
+		if data[offset:offset + 4] != magic:
+			continue
+		hz, length, count = struct.unpack_from('<III', data, offset + 4)
+		namesAt = offset + 16
+		recordsAt = namesAt + tasks * nameLength
+		if length == 0 or recordsAt + length * 8 > len(data):
+			continue
+
+		names = {}
+		for number in range(tasks):
+			raw = data[namesAt + number * nameLength:namesAt + (number + 1) * nameLength]
+			name = raw.split(b'\0')[0].decode('ascii', 'replace')
+			if name:
+				names[number] = name
+
+		first = count - length if count > length else 0
+		records = []
+		for index in range(first, count):
+			records.append(struct.unpack_from('<IBBH', data, recordsAt + (index % length) * 8))
+		return hz, count, names, records
+	return None
+
+
+def events(hz, names, records, types, ids):
+	"""Chrome trace events from records."""
+	def taskName(number):
+		return names.get(number, 'task %d' % number)
+
+	out = [{'ph': 'M', 'name': 'process_name', 'pid': 1, 'args': {'name': 'LPC1769'}}]
+	threads = {MAIN_TID: 'main', INTERRUPTS_TID: 'interrupts', CPU_TID: 'CPU'}
+
+	now = 0
+	previous = None
+	current = MAIN_TID # Task running (by task number)
+	running = None # (task, start) on the CPU track
+	stacks = {} # Open function entries, per track: [(name, start, arg)]
+
+	def complete(tid, name, start, end, args=None):
+		event = {'ph': 'X', 'pid': 1, 'tid': tid, 'name': name, 'ts': round(start, 3), 'dur': round(max(end - start, 0), 3)}
+		if args:
+			event['args'] = args
+		out.append(event)
+
+	for cycles, kind, ident, arg in records:
+		if previous is not None:
+			now += (cycles - previous) & 0xFFFFFFFF # Unwrap the 32-bit counter
+		previous = cycles
+		ts = now * 1e6 / hz
+		kindName = types.get(kind, str(kind))
+		idName = ids.get(ident, str(ident)).replace('TRACE_', '')
+
+		if kindName == 'TRACE_TASK_IN':
+			current = arg
+			threads[current] = taskName(current)
+			running = (current, ts)
+		elif kindName == 'TRACE_TASK_OUT':
+			if running is not None:
+				complete(CPU_TID, taskName(running[0]), running[1], ts)
+			running = None
+		elif kindName in ('TRACE_FUNCTION_ENTER', 'TRACE_INTERRUPT_ENTER'):
+			tid = current if kindName == 'TRACE_FUNCTION_ENTER' else INTERRUPTS_TID
+			stacks.setdefault(tid, []).append((idName, ts, arg))
+		elif kindName in ('TRACE_FUNCTION_EXIT', 'TRACE_INTERRUPT_EXIT'):
+			tid = current if kindName == 'TRACE_FUNCTION_EXIT' else INTERRUPTS_TID
+			stack = stacks.get(tid, [])
+			while stack: # Entries lost to the ring wrap (or to a missed exit) are dropped
+				name, start, entryArg = stack.pop()
+				if name == idName:
+					complete(tid, name, start, ts, {'arg': entryArg})
+					break
+		else:
+			if kindName == 'TRACE_NOTIFY':
+				name = 'notify %s' % taskName(arg)
+			else:
+				name = '%s 0x%04x' % (kindName.replace('TRACE_', '').lower(), arg)
+			out.append({'ph': 'i', 's': 't', 'pid': 1, 'tid': current, 'name': name, 'ts': round(ts, 3)})
+
+	if running is not None:
+		complete(CPU_TID, taskName(running[0]), running[1], now * 1e6 / hz)
+
+	for tid, name in threads.items():
+		out.append({'ph': 'M', 'name': 'thread_name', 'pid': 1, 'tid': tid, 'args': {'name': name}})
+	return out
+
+
+def main(argv):
+	header = HEADER
+	if len(argv) >= 2 and argv[0] == '-H':
+		header = argv[1]
+		argv = argv[2:]
+	if len(argv) != 1:
+		print(__doc__.strip().splitlines()[-1].strip(), file=sys.stderr)
+		return 2
+
+	defines, enums = definitions(header)
+	with open(argv[0], 'rb') as f:
+		data = f.read()
+
+	found = ring(data, defines)
+	if found is None:
+		print('%s: no trace ring found (was TRACE_Init() called?)' % argv[0], file=sys.stderr)
+		return 1
+	hz, count, names, records = found
+
+	trace = {
+		'traceEvents': events(hz, names, records, enums['TRACE_TYPE'], enums['TRACE_ID']),
+		'displayTimeUnit': 'ns',
+		'otherData': {'hz': hz, 'records': len(records), 'overwritten': count - len(records)},
+	}
+	json.dump(trace, sys.stdout, indent=1)
+	print()
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))
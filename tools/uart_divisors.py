@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""
+uart_divisors.py
+
+UART divisor table (LEETC_SE1/src/uart_divisors.c) for every UART PCLK the
+clock profiles can give (CCLK of each profile in LEETC_SE1/src/clock.c, divided
+by 1, 2, 4 or 8) and every standard baud rate, including those out of
+UART_MAX_BAUD_ERROR (uart.h), so that UART_Init() finds every PCLK divider it
+tries in the table. Run it again after changing a clock profile:
+UART_FindDivisors() falls back to a (slower) search for any PCLK and baud rate
+missing from the table.
+
+The search is the same as the fallback in uart.c: for each fraction (DIVADDVAL,
+MULVAL), the two divisors (DLM:DLL) around the exact one, keeping the first
+candidate with the smallest error. So table and fallback always agree.
+
+With -c, prints the error of each entry next to the error of the previous
+search (the double precision one uart.c had before the table), and the entries
+where it did worse or gave invalid divisors, instead of writing the table.
+
+	usage: uart_divisors.py [-c] [-o uart_divisors.c]
+"""
+
+import os
+import re
+import sys
+
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'LEETC_SE1')
+CLOCK_H = os.path.join(ROOT, 'inc', 'clock.h')
+CLOCK_C = os.path.join(ROOT, 'src', 'clock.c')
+UART_H = os.path.join(ROOT, 'inc', 'uart.h')
+OUTPUT = os.path.join(ROOT, 'src', 'uart_divisors.c')
+
+BAUDS = [9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600]
+PCLK_DIVIDERS = [1, 2, 4, 8]
+
+
+def cclks():
+	"""CCLK of each profile in clock.c, in table order."""
+	with open(CLOCK_H) as f:
+		oscillator = int(re.search(r'#define\s+CLOCK_OSCILLATOR\s+(\d+)', f.read()).group(1))
+	with open(CLOCK_C) as f:
+		text = f.read()
+	profiles = re.findall(r'\[(CLOCK_\w+)\]\s*=\s*\{\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*,', text)
+	return [(name, 2 * int(m) * oscillator // (int(n) * int(divider))) for name, m, n, divider in profiles]
+
+
+def maximumError():
+	"""UART_MAX_BAUD_ERROR, in ppm."""
+	with open(UART_H) as f:
+		return int(re.search(r'#define\s+UART_MAX_BAUD_ERROR\s+(\d+)', f.read()).group(1))
+
+
+def truncate(numerator, denominator):
+	"""numerator / denominator, rounded towards zero (as C integer division)."""
+	quotient = abs(numerator) // abs(denominator)
+	return quotient if (numerator >= 0) == (denominator > 0) else -quotient
+
+
+def error(pclk, baud, divisor, add, mul):
+	"""Achieved baud rate error, in ppm (as UART_BaudError() in uart.c)."""
+	numerator = pclk * mul
+	denominator = 16 * divisor * (mul + add)
+	return truncate((numerator - baud * denominator) * 1000000, baud * denominator)
+
+
+def search(pclk, baud):
+	"""(divisor, DIVADDVAL, MULVAL) with the smallest error, or None (as UART_SearchDivisors() in uart.c)."""
+	best = None
+	bestDiff, bestDenominator = 1, 0 # Worse than anything
+	for mul in range(1, 16):
+		for add in range(0, mul):
+			if add == 0 and mul > 1:
+				continue # No fraction: once only
+			numerator = pclk * mul
+			exact = numerator // (16 * baud * (mul + add))
+			for divisor in (exact, exact + 1):
+				if divisor < (1 if add == 0 else 3) or divisor > 0xFFFF:
+					continue
+				denominator = 16 * divisor * (mul + add)
+				diff = abs(numerator - baud * denominator)
+				if diff * bestDenominator < bestDiff * denominator: # diff / denominator < bestDiff / bestDenominator
+					best = (divisor, add, mul)
+					bestDiff, bestDenominator = diff, denominator
+	return best
+
+
+def previous(pclk, baud):
+	"""(divisor, DIVADDVAL, MULVAL) of the double precision search uart.c had before the table."""
+	d = pclk / (16 * baud)
+	i = int(d)
+	best = (0, 0, 1)
+	bestMargin = float(0xFFFFFFFF)
+	for intVal in range(i // 2, i + 1):
+		if intVal == 0:
+			continue
+		fraction = (d - intVal) / intVal
+		for add in range(0, 15):
+			for mul in range(add + 1, 16):
+				margin = abs(fraction - add / mul)
+				if margin < bestMargin:
+					best = (intVal, add, mul)
+					bestMargin = margin
+	return best
+
+
+def entries():
+	"""(profile, pclk, baud, divisor, DIVADDVAL, MULVAL, error) of every table entry."""
+	out = []
+	seen = set()
+	for profile, cclk in cclks():
+		for divider in PCLK_DIVIDERS:
+			pclk = cclk // divider
+			if pclk in seen:
+				continue
+			seen.add(pclk)
+			for baud in BAUDS:
+				found = search(pclk, baud)
+				if found is not None:
+					out.append((profile, pclk, baud) + found + (error(pclk, baud, *found),))
+	return out
+
+
+def compare(table):
+	worse = 0
+	print('%10s %7s %16s %10s %16s %10s' % ('pclk', 'baud', 'table', 'error', 'previous', 'error'))
+	for profile, pclk, baud, divisor, add, mul, ppm in table:
+		old = previous(pclk, baud)
+		valid = old[0] >= (1 if old[1] == 0 else 3)
+		oldPpm = error(pclk, baud, *old) if old[0] > 0 else None
+		mark = ''
+		if not valid:
+			mark = ' invalid'
+		elif abs(oldPpm) < abs(ppm):
+			mark = ' BETTER' # Never: the table search covers every fraction
+		elif abs(oldPpm) > abs(ppm):
+			mark = ' worse'
+		if mark:
+			worse += 1
+		print('%10d %7d %5d %2d/%-2d %8s %10d %5d %2d/%-2d %8s %10s%s' % (pclk, baud, divisor, add, mul, '', ppm,
+				old[0], old[1], old[2], '', oldPpm if oldPpm is not None else '-', mark))
+	print('%d of %d entries differ (UART_Init() refuses over %d ppm)' % (worse, len(table), maximumError()))
+	return 0
+
+
+def write(table, path):
+	with open(path, 'w') as f:
+		f.write('/*\n * uart_divisors.c\n *\n *  Generated by tools/uart_divisors.py: do not edit.\n */\n\n')
+		f.write('#ifdef __USE_CMSIS\n#include "LPC17xx.h"\n#endif\n\n#include "uart.h"\n\n\n')
+		f.write('const UART_DIVISORS uartDivisorTable[] = {\n')
+		profile = None
+		for entry in table:
+			if entry[0] != profile:
+				profile = entry[0]
+				f.write('\t// %s:\n' % profile)
+			f.write('\t{%d, %d, %d, %d, %d, %d},\n' % entry[1:])
+		f.write('};\n\n')
+		f.write('const uint32_t uartDivisorTableLength = sizeof(uartDivisorTable) / sizeof(uartDivisorTable[0]);\n')
+
+
+def main(argv):
+	check = False
+	path = OUTPUT
+	while argv:
+		if argv[0] == '-c':
+			check = True
+			argv = argv[1:]
+		elif argv[0] == '-o' and len(argv) >= 2:
+			path = argv[1]
+			argv = argv[2:]
+		else:
+			print(__doc__.strip().splitlines()[-1].strip(), file=sys.stderr)
+			return 2
+
+	table = entries()
+	if check:
+		return compare(table)
+	write(table, path)
+	return 0
+
+
+if __name__ == '__main__':
+	sys.exit(main(sys.argv[1:]))